@@ -239,7 +239,17 @@ void application::exec() {
      sigpipe_set->cancel();
    });
 
-   io_serv->run();
+   {
+      // drain everything asio has ready into the priority queue, then run the handler of the highest priority
+      auto& ios = *io_serv;
+      boost::asio::io_service::work work( ios );
+      (void)work;
+      bool more = true;
+      while( more || ios.run_one() ) {
+         while( ios.poll_one() ) {}
+         more = pri_queue.execute_highest();
+      }
+   }
 
    shutdown(); /// perform synchronous shutdown
 }
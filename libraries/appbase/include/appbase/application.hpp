@@ -2,6 +2,7 @@
 #include <appbase/plugin.hpp>
 #include <appbase/channel.hpp>
 #include <appbase/method.hpp>
+#include <appbase/execution_priority_queue.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/core/demangle.hpp>
 #include <typeindex>
@@ -151,6 +152,24 @@ namespace appbase {
          }
 
          boost::asio::io_service& get_io_service() { return *io_serv; }
+
+         /**
+          * Post func to run on the application thread before any waiting handler of a lower priority
+          *
+          * @param priority a level of @ref appbase::priority, or any int in between
+          * @param func the function to run
+          */
+         template <typename Func>
+         auto post( int priority, Func&& func ) {
+            return boost::asio::post( *io_serv, pri_queue.wrap( priority, execution_priority_queue::clock_type::now(), std::forward<Func>( func ) ) );
+         }
+
+         /**
+          * The queue handlers wrapped with a priority wait in on the application thread. Bind completion handlers
+          * to it with get_priority_queue().wrap( priority, handler ); its statistics may only be read from the
+          * application thread.
+          */
+         execution_priority_queue& get_priority_queue() { return pri_queue; }
       protected:
          template<typename Impl>
          friend class plugin;
@@ -175,6 +194,7 @@ namespace appbase {
          map<std::type_index, erased_channel_ptr>  channels;
 
          std::shared_ptr<boost::asio::io_service>  io_serv;
+         execution_priority_queue                  pri_queue;
 
          void set_program_options();
          void write_default_config(const bfs::path& cfg_file);
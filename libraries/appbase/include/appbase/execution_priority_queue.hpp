@@ -0,0 +1,179 @@
+#pragma once
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+namespace appbase {
+
+   /**
+    * Priorities handlers can be posted to the application with, see application::post. Any int can be used, these
+    * are the levels the plugins agree on.
+    */
+   struct priority {
+      static constexpr int lowest  = std::numeric_limits<int>::min();
+      static constexpr int low     = 10;   ///< http api requests
+      static constexpr int medium  = 50;   ///< p2p messages and transactions
+      static constexpr int high    = 100;  ///< blocks and block production
+      static constexpr int highest = std::numeric_limits<int>::max();
+   };
+
+   /**
+    * Queue of the handlers waiting to run on the application thread, ordered by priority and, within a priority,
+    * by the order they were added in.
+    *
+    * It is an asio execution context: a handler bound to one of its executors with wrap() is added to the queue when
+    * asio would otherwise have run it. application::exec drains the io_service into the queue before running each
+    * handler, so a handler of higher priority always runs before those of lower priorities that were waiting with it.
+    *
+    * The queue is only touched from the application thread, which also keeps the per-priority statistics.
+    */
+   class execution_priority_queue : public boost::asio::execution_context {
+      public:
+         using clock_type = std::chrono::steady_clock;
+
+         struct queue_stats {
+            size_t                    depth     = 0; ///< handlers waiting to run
+            size_t                    max_depth = 0; ///< the most handlers that were ever waiting at once
+            uint64_t                  executed  = 0; ///< handlers run
+            std::chrono::microseconds total_latency{0}; ///< summed time from the post of handlers to their run
+            std::chrono::microseconds max_latency{0};   ///< the longest time from the post of a handler to its run
+         };
+
+         /// Adds function with priority prio; its latency is measured from posted_at
+         template<typename Function>
+         void add( int prio, Function function, clock_type::time_point posted_at = clock_type::now() ) {
+            auto& s = stats[prio];
+            s.max_depth = std::max( s.max_depth, ++s.depth );
+            handlers.emplace_back( new queued_handler<Function>( prio, --order, posted_at, std::move( function ) ) );
+            std::push_heap( handlers.begin(), handlers.end(), handler_less() );
+         }
+
+         /// Runs the handler of the highest priority, returns whether more are waiting
+         bool execute_highest() {
+            if( !handlers.empty() ) {
+               std::pop_heap( handlers.begin(), handlers.end(), handler_less() );
+               std::unique_ptr<queued_handler_base> h = std::move( handlers.back() );
+               handlers.pop_back();
+
+               auto& s = stats[h->priority()];
+               auto waited = std::chrono::duration_cast<std::chrono::microseconds>( clock_type::now() - h->posted_at() );
+               --s.depth;
+               ++s.executed;
+               s.total_latency += waited;
+               s.max_latency = std::max( s.max_latency, waited );
+
+               h->execute();
+            }
+            return !handlers.empty();
+         }
+
+         size_t size()const { return handlers.size(); }
+
+         /// Statistics of every priority handlers were added with
+         const std::map<int, queue_stats>& get_stats()const { return stats; }
+
+         /**
+          * Adds the handlers bound to it to the queue. Their latency is measured from posted_at when it is set, from
+          * the time asio hands them to the executor otherwise.
+          */
+         class executor {
+            public:
+               executor( execution_priority_queue& q, int p, clock_type::time_point posted_at = clock_type::time_point() )
+               :context_(q), priority_(p), posted_at_(posted_at) {}
+
+               execution_priority_queue& context()const noexcept { return context_; }
+
+               template<typename Function, typename Allocator>
+               void dispatch( Function f, const Allocator& )const { add( std::move( f ) ); }
+
+               template<typename Function, typename Allocator>
+               void post( Function f, const Allocator& )const { add( std::move( f ) ); }
+
+               template<typename Function, typename Allocator>
+               void defer( Function f, const Allocator& )const { add( std::move( f ) ); }
+
+               void on_work_started()const noexcept {}
+               void on_work_finished()const noexcept {}
+
+               bool operator==( const executor& other )const noexcept {
+                  return &context_ == &other.context_ && priority_ == other.priority_;
+               }
+
+               bool operator!=( const executor& other )const noexcept {
+                  return !operator==( other );
+               }
+
+            private:
+               template<typename Function>
+               void add( Function f )const {
+                  context_.add( priority_, std::move( f ), posted_at_ == clock_type::time_point() ? clock_type::now() : posted_at_ );
+               }
+
+               execution_priority_queue& context_;
+               int                       priority_;
+               clock_type::time_point    posted_at_;
+         };
+
+         /// Binds func to this queue, so that asio adds it with priority prio instead of running it
+         template<typename Function>
+         boost::asio::executor_binder<std::decay_t<Function>, executor> wrap( int prio, Function&& func ) {
+            return boost::asio::bind_executor( executor( *this, prio ), std::forward<Function>( func ) );
+         }
+
+         /// As wrap( prio, func ), for a func posted at posted_at; its latency includes the time before it reached the queue
+         template<typename Function>
+         boost::asio::executor_binder<std::decay_t<Function>, executor> wrap( int prio, clock_type::time_point posted_at, Function&& func ) {
+            return boost::asio::bind_executor( executor( *this, prio, posted_at ), std::forward<Function>( func ) );
+         }
+
+      private:
+         class queued_handler_base {
+            public:
+               queued_handler_base( int p, size_t order, clock_type::time_point posted_at )
+               :priority_(p), order_(order), posted_at_(posted_at) {}
+
+               virtual ~queued_handler_base() = default;
+
+               virtual void execute() = 0;
+
+               int                    priority()const  { return priority_; }
+               size_t                 order()const     { return order_; }
+               clock_type::time_point posted_at()const { return posted_at_; }
+
+            private:
+               int                    priority_;
+               size_t                 order_;
+               clock_type::time_point posted_at_;
+         };
+
+         template<typename Function>
+         class queued_handler : public queued_handler_base {
+            public:
+               queued_handler( int p, size_t order, clock_type::time_point posted_at, Function f )
+               :queued_handler_base(p, order, posted_at), function_(std::move(f)) {}
+
+               void execute() override { function_(); }
+
+            private:
+               Function function_;
+         };
+
+         /// orders the heap so its top is the highest priority, and the oldest handler of that priority
+         struct handler_less {
+            bool operator()( const std::unique_ptr<queued_handler_base>& a, const std::unique_ptr<queued_handler_base>& b )const {
+               return std::make_tuple( a->priority(), a->order() ) < std::make_tuple( b->priority(), b->order() );
+            }
+         };
+
+         std::vector<std::unique_ptr<queued_handler_base>> handlers;
+         size_t                                            order = std::numeric_limits<size_t>::max(); ///< counts down, so older handlers compare greater
+         std::map<int, queue_stats>                        stats;
+   };
+
+} // appbase
@@ -0,0 +1,90 @@
+#define BOOST_TEST_MODULE execution_priority_queue
+#include <boost/test/unit_test.hpp>
+
+#include <appbase/application.hpp>
+
+#include <thread>
+#include <vector>
+
+using namespace appbase;
+
+namespace {
+
+   /// drains io into q before running each handler, as application::exec does
+   void run_all( boost::asio::io_service& io, execution_priority_queue& q ) {
+      io.restart();
+      bool more = true;
+      while( more ) {
+         while( io.poll_one() );
+         more = q.execute_highest();
+      }
+   }
+
+}
+
+BOOST_AUTO_TEST_SUITE(execution_priority_queue_tests)
+
+BOOST_AUTO_TEST_CASE(priority_order) {
+   execution_priority_queue q;
+   std::vector<int> ran;
+   for( int prio : {priority::low, priority::high, priority::medium, priority::lowest, priority::highest} )
+      q.add( prio, [&ran, prio]() { ran.push_back( prio ); } );
+
+   BOOST_CHECK_EQUAL( q.size(), 5u );
+   while( q.execute_highest() );
+   BOOST_CHECK( ran == std::vector<int>({priority::highest, priority::high, priority::medium, priority::low, priority::lowest}) );
+   BOOST_CHECK_EQUAL( q.size(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE(fifo_within_priority) {
+   execution_priority_queue q;
+   std::vector<int> ran;
+   for( int i = 0; i < 10; ++i ) {
+      q.add( priority::medium, [&ran, i]() { ran.push_back( i ); } );
+      q.add( priority::low, [&ran, i]() { ran.push_back( 100 + i ); } );
+   }
+
+   while( q.execute_highest() );
+   std::vector<int> expected;
+   for( int i = 0; i < 10; ++i ) expected.push_back( i );
+   for( int i = 0; i < 10; ++i ) expected.push_back( 100 + i );
+   BOOST_CHECK( ran == expected );
+
+   BOOST_CHECK_EQUAL( q.get_stats().at( priority::medium ).executed, 10u );
+   BOOST_CHECK_EQUAL( q.get_stats().at( priority::medium ).max_depth, 10u );
+   BOOST_CHECK_EQUAL( q.get_stats().at( priority::low ).depth, 0u );
+}
+
+BOOST_AUTO_TEST_CASE(wrapped_handlers) {
+   // handlers posted through asio keep both orders once drained into the queue
+   boost::asio::io_service io;
+   execution_priority_queue q;
+   std::vector<int> ran;
+   for( int i = 0; i < 5; ++i ) {
+      boost::asio::post( io, q.wrap( priority::low, [&ran, i]() { ran.push_back( 100 + i ); } ) );
+      boost::asio::post( io, q.wrap( priority::high, [&ran, i]() { ran.push_back( i ); } ) );
+   }
+
+   run_all( io, q );
+   BOOST_CHECK( ran == std::vector<int>({0, 1, 2, 3, 4, 100, 101, 102, 103, 104}) );
+}
+
+BOOST_AUTO_TEST_CASE(latency_from_post) {
+   // a priority of its own, as the application's queue is shared by the test cases
+   const int prio = priority::low + 1;
+   auto& q = app().get_priority_queue();
+
+   bool ran = false;
+   app().post( prio, [&ran]() { ran = true; } );
+   // the handler sits in the io_service, not the queue, while the application is busy
+   std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+   run_all( app().get_io_service(), q );
+
+   BOOST_REQUIRE( ran );
+   const auto& s = q.get_stats().at( prio );
+   BOOST_CHECK_EQUAL( s.executed, 1u );
+   BOOST_CHECK( s.max_latency >= std::chrono::milliseconds( 20 ) );
+   BOOST_CHECK( s.total_latency == s.max_latency );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
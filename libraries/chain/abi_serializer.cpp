@@ -58,6 +58,8 @@ namespace besio { namespace chain {
    void abi_serializer::add_specialized_unpack_pack( const string& name,
                                                      std::pair<abi_serializer::unpack_function, abi_serializer::pack_function> unpack_pack ) {
       built_in_types[name] = std::move( unpack_pack );
+      // compiled plans hold their own copy of the codecs, rebuild them against the new set of built in types
+      compile_types( fc::time_point::maximum(), fc::microseconds::maximum() );
    }
 
    void abi_serializer::configure_built_in_types() {
@@ -109,6 +111,7 @@ namespace besio { namespace chain {
       structs.clear();
       actions.clear();
       tables.clear();
+      table_index_types.clear();
       error_messages.clear();
 
       for( const auto& st : abi.structs )
@@ -123,8 +126,10 @@ namespace besio { namespace chain {
       for( const auto& a : abi.actions )
          actions[a.name] = a.type;
 
-      for( const auto& t : abi.tables )
+      for( const auto& t : abi.tables ) {
          tables[t.name] = t.type;
+         table_index_types[t.name] = t.index_type;
+      }
 
       for( const auto& e : abi.error_messages )
          error_messages[e.error_code] = e.error_msg;
@@ -140,6 +145,80 @@ namespace besio { namespace chain {
       BES_ASSERT( error_messages.size() == abi.error_messages.size(), duplicate_abi_err_msg_def_exception, "duplicate error message definition detected" );
 
       validate(deadline, max_serialization_time);
+      compile_types(deadline, max_serialization_time);
+   }
+
+   uint32_t abi_serializer::compiled_type_id(const type_name& type, vector<uint32_t>& pending) {
+      auto itr = compiled_type_ids.find(type);
+      if( itr != compiled_type_ids.end() ) return itr->second;
+      uint32_t id = compiled_types.size();
+      compiled_types.emplace_back();
+      compiled_types.back().name = type;
+      compiled_type_ids.emplace(type, id);
+      pending.push_back(id);
+      return id;
+   }
+
+   void abi_serializer::compile_types(const fc::time_point& deadline, const fc::microseconds& max_serialization_time) {
+      compiled_types.clear();
+      compiled_type_ids.clear();
+
+      vector<uint32_t> pending;
+      for( const auto& s : structs )
+         compiled_type_id(s.first, pending);
+      for( const auto& t : typedefs )
+         compiled_type_id(t.first, pending);
+      for( const auto& a : actions )
+         compiled_type_id(a.second, pending);
+      for( const auto& t : tables )
+         compiled_type_id(t.second, pending);
+
+      // worklist rather than recursion, nesting depth of an ABI is only bounded at serialization time
+      while( !pending.empty() ) {
+         BES_ASSERT( fc::time_point::now() < deadline, abi_serialization_deadline_exception, "serialization time limit ${t}us exceeded", ("t", max_serialization_time) );
+         const uint32_t id = pending.back();
+         pending.pop_back();
+
+         compiled_type ct;
+         ct.name = compiled_types[id].name;
+         const type_name rtype = resolve_type(ct.name);
+         ct.resolved_name = rtype;
+         const type_name ftype = fundamental_type(rtype);
+         auto btype = built_in_types.find(ftype);
+         if( btype != built_in_types.end() ) {
+            ct.kind = compiled_type::builtin_kind;
+            ct.builtin_array = is_array(rtype);
+            ct.builtin_optional = is_optional(rtype);
+            ct.codec = btype->second;
+         } else if( is_array(rtype) ) {
+            ct.kind = compiled_type::array_kind;
+            ct.element_id = compiled_type_id(ftype, pending);
+         } else if( is_optional(rtype) ) {
+            ct.kind = compiled_type::optional_kind;
+            ct.element_id = compiled_type_id(ftype, pending);
+         } else {
+            auto st = structs.find(rtype);
+            if( st != structs.end() ) {
+               ct.kind = compiled_type::struct_kind;
+               if( st->second.base != type_name() ) {
+                  ct.has_base = true;
+                  ct.base_id = compiled_type_id(resolve_type(st->second.base), pending);
+               }
+               ct.fields.reserve(st->second.fields.size());
+               for( const auto& field : st->second.fields )
+                  ct.fields.push_back( compiled_field{field.name, compiled_type_id(field.type, pending)} );
+            }
+         }
+         compiled_types[id] = std::move(ct);
+      }
+   }
+
+   const abi_serializer::compiled_type* abi_serializer::find_compiled_type(const type_name& type)const {
+      if( !use_compiled_types ) return nullptr;
+      auto itr = compiled_type_ids.find(type);
+      if( itr == compiled_type_ids.end() ) return nullptr;
+      const auto& ct = compiled_types[itr->second];
+      return ct.kind == compiled_type::unresolved_kind ? nullptr : &ct;
    }
 
    bool abi_serializer::is_builtin_type(const type_name& type)const {
@@ -271,6 +350,9 @@ namespace besio { namespace chain {
    fc::variant abi_serializer::_binary_to_variant( const type_name& type, fc::datastream<const char *>& stream,
                                                    size_t recursion_depth, const fc::time_point& deadline, const fc::microseconds& max_serialization_time )const
    {
+      if( const auto* ct = find_compiled_type(type) )
+         return _binary_to_variant(*ct, stream, recursion_depth, deadline, max_serialization_time);
+
       BES_ASSERT( ++recursion_depth < max_recursion_depth, abi_recursion_depth_exception, "recursive definition, max_recursion_depth ${r} ", ("r", max_recursion_depth) );
       BES_ASSERT( fc::time_point::now() < deadline, abi_serialization_deadline_exception, "serialization time limit ${t}us exceeded", ("t", max_serialization_time) );
       type_name rtype = resolve_type(type);
@@ -305,6 +387,67 @@ namespace besio { namespace chain {
       return fc::variant( std::move(mvo) );
    }
 
+   /**
+    *  The compiled paths keep the recursion depth accounting of the type name based paths above. The clock
+    *  is only read for arrays and structs, a built in codec or an optional flag cannot run away on its own.
+    */
+   void abi_serializer::_binary_to_variant( const compiled_type& ct, fc::datastream<const char *>& stream,
+                                            fc::mutable_variant_object& obj, size_t recursion_depth,
+                                            const fc::time_point& deadline, const fc::microseconds& max_serialization_time )const
+   {
+      BES_ASSERT( ++recursion_depth < max_recursion_depth, abi_recursion_depth_exception, "recursive definition, max_recursion_depth ${r} ", ("r", max_recursion_depth) );
+      BES_ASSERT( ct.kind == compiled_type::struct_kind, invalid_type_inside_abi, "Unknown struct ${type}", ("type",ct.name) );
+      if( ct.has_base ) {
+         _binary_to_variant(compiled_types[ct.base_id], stream, obj, recursion_depth, deadline, max_serialization_time);
+      }
+      for( const auto& field : ct.fields ) {
+         obj( field.name, _binary_to_variant(compiled_types[field.type_id], stream, recursion_depth, deadline, max_serialization_time) );
+      }
+   }
+
+   fc::variant abi_serializer::_binary_to_variant( const compiled_type& ct, fc::datastream<const char *>& stream,
+                                                   size_t recursion_depth, const fc::time_point& deadline, const fc::microseconds& max_serialization_time )const
+   {
+      if( ct.kind == compiled_type::unresolved_kind )
+         return _binary_to_variant(ct.name, stream, recursion_depth, deadline, max_serialization_time);
+
+      BES_ASSERT( ++recursion_depth < max_recursion_depth, abi_recursion_depth_exception, "recursive definition, max_recursion_depth ${r} ", ("r", max_recursion_depth) );
+      switch( ct.kind ) {
+         case compiled_type::builtin_kind:
+            return ct.codec.first(stream, ct.builtin_array, ct.builtin_optional);
+         case compiled_type::array_kind: {
+            BES_ASSERT( fc::time_point::now() < deadline, abi_serialization_deadline_exception, "serialization time limit ${t}us exceeded", ("t", max_serialization_time) );
+            const auto& element = compiled_types[ct.element_id];
+            fc::unsigned_int size;
+            fc::raw::unpack(stream, size);
+            vector<fc::variant> vars;
+            vars.reserve( std::min<size_t>(size.value, stream.remaining()) );
+            for( decltype(size.value) i = 0; i < size; ++i ) {
+               auto v = _binary_to_variant(element, stream, recursion_depth, deadline, max_serialization_time);
+               BES_ASSERT( !v.is_null(), unpack_exception, "Invalid packed array" );
+               vars.emplace_back(std::move(v));
+            }
+            BES_ASSERT( vars.size() == size.value,
+                        unpack_exception,
+                        "packed size does not match unpacked array size, packed size ${p} actual size ${a}",
+                        ("p", size)("a", vars.size()) );
+            return fc::variant( std::move(vars) );
+         }
+         case compiled_type::optional_kind: {
+            char flag;
+            fc::raw::unpack(stream, flag);
+            return flag ? _binary_to_variant(compiled_types[ct.element_id], stream, recursion_depth, deadline, max_serialization_time) : fc::variant();
+         }
+         default: {
+            BES_ASSERT( fc::time_point::now() < deadline, abi_serialization_deadline_exception, "serialization time limit ${t}us exceeded", ("t", max_serialization_time) );
+            fc::mutable_variant_object mvo;
+            _binary_to_variant(ct, stream, mvo, recursion_depth, deadline, max_serialization_time);
+            BES_ASSERT( mvo.size() > 0, unpack_exception, "Unable to unpack stream ${type}", ("type", ct.name) );
+            return fc::variant( std::move(mvo) );
+         }
+      }
+   }
+
    fc::variant abi_serializer::_binary_to_variant( const type_name& type, const bytes& binary,
                                                    size_t recursion_depth, const fc::time_point& deadline, const fc::microseconds& max_serialization_time )const
    {
@@ -317,6 +460,11 @@ namespace besio { namespace chain {
    void abi_serializer::_variant_to_binary( const type_name& type, const fc::variant& var, fc::datastream<char *>& ds,
                                             size_t recursion_depth, const fc::time_point& deadline, const fc::microseconds& max_serialization_time )const
    { try {
+      if( const auto* ct = find_compiled_type(type) ) {
+         _variant_to_binary(*ct, var, ds, recursion_depth, deadline, max_serialization_time);
+         return;
+      }
+
       BES_ASSERT( ++recursion_depth < max_recursion_depth, abi_recursion_depth_exception, "recursive definition, max_recursion_depth ${r} ", ("r", max_recursion_depth) );
       BES_ASSERT( fc::time_point::now() < deadline, abi_serialization_deadline_exception, "serialization time limit ${t}us exceeded", ("t", max_serialization_time) );
       auto rtype = resolve_type(type);
@@ -366,6 +514,69 @@ namespace besio { namespace chain {
       }
    } FC_CAPTURE_AND_RETHROW( (type)(var) ) }
 
+   void abi_serializer::_variant_to_binary( const compiled_type& ct, const fc::variant& var, fc::datastream<char *>& ds,
+                                            size_t recursion_depth, const fc::time_point& deadline, const fc::microseconds& max_serialization_time )const
+   {
+      if( ct.kind == compiled_type::unresolved_kind ) {
+         _variant_to_binary(ct.name, var, ds, recursion_depth, deadline, max_serialization_time);
+         return;
+      }
+
+      const auto& type = ct.name;
+      try {
+         BES_ASSERT( ++recursion_depth < max_recursion_depth, abi_recursion_depth_exception, "recursive definition, max_recursion_depth ${r} ", ("r", max_recursion_depth) );
+         if( ct.kind == compiled_type::builtin_kind ) {
+            ct.codec.second(var, ds, ct.builtin_array, ct.builtin_optional);
+            return;
+         }
+         if( ct.kind == compiled_type::optional_kind ) {
+            get_struct(ct.resolved_name); // optional structs cannot be packed yet, report them as the type name based path does
+            return;
+         }
+
+         BES_ASSERT( fc::time_point::now() < deadline, abi_serialization_deadline_exception, "serialization time limit ${t}us exceeded", ("t", max_serialization_time) );
+         if( ct.kind == compiled_type::array_kind ) {
+            const auto& element = compiled_types[ct.element_id];
+            const auto& vars = var.get_array();
+            fc::raw::pack(ds, (fc::unsigned_int)vars.size());
+            for( const auto& v : vars ) {
+               _variant_to_binary(element, v, ds, recursion_depth, deadline, max_serialization_time);
+            }
+         } else if( var.is_object() ) {
+            const auto& vo = var.get_object();
+
+            if( ct.has_base ) {
+               _variant_to_binary(compiled_types[ct.base_id], var, ds, recursion_depth, deadline, max_serialization_time);
+            }
+            for( const auto& field : ct.fields ) {
+               const auto& field_type = compiled_types[field.type_id];
+               auto itr = vo.find( field.name );
+               if( itr != vo.end() ) {
+                  _variant_to_binary(field_type, itr->value(), ds, recursion_depth, deadline, max_serialization_time);
+               }
+               else {
+                  _variant_to_binary(field_type, fc::variant(), ds, recursion_depth, deadline, max_serialization_time);
+                  /// TODO: default construct field and write it out
+                  BES_THROW( pack_exception, "Missing '${f}' in variant object", ("f",field.name) );
+               }
+            }
+         } else if( var.is_array() ) {
+            const auto& va = var.get_array();
+            BES_ASSERT( !ct.has_base, invalid_type_inside_abi, "support for base class as array not yet implemented" );
+            uint32_t i = 0;
+            if (va.size() > 0) {
+               for( const auto& field : ct.fields ) {
+                  if( va.size() > i )
+                     _variant_to_binary(compiled_types[field.type_id], va[i], ds, recursion_depth, deadline, max_serialization_time);
+                  else
+                     _variant_to_binary(compiled_types[field.type_id], fc::variant(), ds, recursion_depth, deadline, max_serialization_time);
+                  ++i;
+               }
+            }
+         }
+      } FC_CAPTURE_AND_RETHROW( (type)(var) )
+   }
+
    bytes abi_serializer::_variant_to_binary( const type_name& type, const fc::variant& var,
                                              size_t recursion_depth, const fc::time_point& deadline, const fc::microseconds& max_serialization_time )const
    { try {
@@ -393,6 +604,12 @@ namespace besio { namespace chain {
       return type_name();
    }
 
+   type_name abi_serializer::get_table_index_type(name table)const {
+      auto itr = table_index_types.find(table);
+      if( itr != table_index_types.end() ) return itr->second;
+      return type_name();
+   }
+
    optional<string> abi_serializer::get_error_message( uint64_t error_code )const {
       auto itr = error_messages.find( error_code );
       if( itr == error_messages.end() )
@@ -352,8 +352,13 @@ vector<account_name> apply_context::get_active_producers() const {
 }
 
 void apply_context::reset_console() {
-   _pending_console_output = std::ostringstream();
-   _pending_console_output.setf( std::ios::scientific, std::ios::floatfield );
+   // reuse the stream and its buffer instead of constructing a new one for every action
+   _pending_console_output.str( std::string() );
+   _pending_console_output.clear();
+   _pending_console_output.flags( std::ios::dec | std::ios::skipws | std::ios::scientific );
+   _pending_console_output.precision( 6 );
+   _pending_console_output.width( 0 );
+   _pending_console_output.fill( ' ' );
 }
 
 bytes apply_context::get_packed_transaction() {
@@ -12,22 +12,39 @@
 #include <besio/chain/global_property_object.hpp>
 #include <besio/chain/contract_types.hpp>
 #include <besio/chain/generated_transaction_object.hpp>
+#include <besio/chain/database_utils.hpp>
+
+BES_SNAPSHOT_ROW( besio::chain::permission_object, (id)(usage_id)(parent)(owner)(name)(last_updated)(auth) )
+BES_SNAPSHOT_ROW( besio::chain::permission_usage_object, (id)(last_used) )
+BES_SNAPSHOT_ROW( besio::chain::permission_link_object, (id)(account)(code)(message_type)(required_permission) )
 
 namespace besio { namespace chain {
 
+   using authorization_index_set = index_set<
+      permission_index,
+      permission_usage_index,
+      permission_link_index
+   >;
+
    authorization_manager::authorization_manager(controller& c, database& d)
    :_control(c),_db(d){}
 
    void authorization_manager::add_indices() {
-      _db.add_index<permission_index>();
-      _db.add_index<permission_usage_index>();
-      _db.add_index<permission_link_index>();
+      authorization_index_set::add_indices( _db );
    }
 
    void authorization_manager::initialize_database() {
       _db.create<permission_object>([](auto&){}); /// reserve perm 0 (used else where)
    }
 
+   void authorization_manager::add_to_snapshot( snapshot_writer& snapshot )const {
+      authorization_index_set::add_to_snapshot( _db, snapshot );
+   }
+
+   void authorization_manager::read_from_snapshot( snapshot_reader& snapshot ) {
+      authorization_index_set::read_from_snapshot( _db, snapshot );
+   }
+
    const permission_object& authorization_manager::create_permission( account_name account,
                                                                       permission_name name,
                                                                       permission_id_type parent,
@@ -194,6 +194,7 @@ void apply_besio_setabi(apply_context& context) {
    db.modify( account_sequence, [&]( auto& aso ) {
       aso.abi_sequence += 1;
    });
+   context.control.invalidate_abi_serializer( act.account );
 
    if (new_size != old_size) {
       context.trx_context.add_ram_usage( act.account, new_size - old_size );
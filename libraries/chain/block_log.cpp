@@ -4,19 +4,320 @@
  */
 #include <besio/chain/block_log.hpp>
 #include <besio/chain/exceptions.hpp>
+#include <besio/chain/config.hpp>
+#include <besio/chain/multi_index_includes.hpp>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <fc/io/raw.hpp>
+#include <fc/io/fstream.hpp>
+#include <fc/compress/zlib.hpp>
+#include <fc/scoped_exit.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 #define LOG_READ  (std::ios::in | std::ios::binary)
 #define LOG_WRITE (std::ios::out | std::ios::binary | std::ios::app)
+#define LOG_RDWR  (std::ios::in | std::ios::out | std::ios::binary)
 
 namespace besio { namespace chain {
 
    const uint32_t block_log::supported_version = 1;
+   const uint32_t block_log::chunked_version = 2;
 
    namespace detail {
-      class block_log_impl {
+      namespace bip = boost::interprocess;
+
+      /**
+       *  Read only memory map of one of the append only block log files.
+       *  The map covers the file as it was when last mapped and is only rebuilt when a read needs bytes past its end.
+       */
+      class mapped_log_file {
+         public:
+            void reset() {
+               region = bip::mapped_region();
+               mapping.reset();
+            }
+
+            /// ensures bytes [0, end) of the file are mapped; returns false if the file is shorter than end
+            bool ensure_mapped( const fc::path& file, uint64_t end ) {
+               if( end <= region.get_size() )
+                  return true;
+               auto file_size = fc::file_size( file );
+               if( file_size < end )
+                  return false;
+               reset();
+               mapping.reset( new bip::file_mapping( file.generic_string().c_str(), bip::read_only ) );
+               region = bip::mapped_region( *mapping, bip::read_only, 0, file_size );
+               return true;
+            }
+
+            const char* data()const { return static_cast<const char*>( region.get_address() ); }
+
+         private:
+            std::unique_ptr<bip::file_mapping> mapping;
+            bip::mapped_region                 region;
+      };
+
+      struct cached_block {
+         uint32_t         block_num;
+         signed_block_ptr block;
+      };
+
+      struct by_block_num;
+      typedef boost::multi_index_container<
+         cached_block,
+         indexed_by<
+            bmi::sequenced<>,
+            bmi::hashed_unique< tag<by_block_num>, member<cached_block, uint32_t, &cached_block::block_num> >
+         >
+      > block_cache_index;
+
+      /// Precedes the compressed payload of every chunk of a chunked block log
+      struct chunk_header {
+         uint32_t first_block_num = 0;
+         uint32_t block_count     = 0;
+         uint32_t flags           = 0;
+         uint32_t payload_size    = 0; ///< bytes of compressed payload following the header
+         uint32_t raw_size        = 0; ///< bytes of the payload once inflated
+         uint32_t slot_size       = 0; ///< bytes reserved for the payload; larger than payload_size once pruned
+
+         static const uint32_t pruned = 1;
+
+         uint32_t last_block_num()const { return first_block_num + block_count - 1; }
+
+         /// size of the whole chunk in the file: header, payload slot and trailing position
+         uint64_t entry_size()const { return sizeof(chunk_header) + slot_size + sizeof(uint64_t); }
+      };
+      static_assert( sizeof(chunk_header) == 24, "chunk_header is written to the block log as is" );
+
+      /**
+       *  Inflated payload of a chunk: the offsets of its blocks within the payload (plus the end of the last block),
+       *  followed by the serialized blocks.
+       */
+      struct chunk_data {
+         uint64_t      pos = block_log::npos;
+         chunk_header  header;
+         string        raw;
+
+         bool valid()const {
+            uint64_t table_size = sizeof(uint32_t) * (uint64_t(header.block_count) + 1);
+            if( raw.size() != header.raw_size || raw.size() < table_size )
+               return false;
+            uint32_t prev = table_size;
+            for( uint32_t i = 0; i <= header.block_count; ++i ) {
+               uint32_t offset;
+               memcpy( &offset, raw.data() + sizeof(uint32_t) * i, sizeof(offset) );
+               if( offset < prev || offset > raw.size() )
+                  return false;
+               prev = offset;
+            }
+            return prev == raw.size();
+         }
+
+         std::pair<const char*, size_t> block( uint32_t block_num )const {
+            uint32_t offsets[2];
+            memcpy( offsets, raw.data() + sizeof(uint32_t) * (block_num - header.first_block_num), sizeof(offsets) );
+            return {raw.data() + offsets[0], offsets[1] - offsets[0]};
+         }
+      };
+
+      string make_chunk_payload( const vector<vector<char>>& blocks ) {
+         string raw( sizeof(uint32_t) * (blocks.size() + 1), '\0' );
+         uint32_t offset = raw.size();
+         for( size_t i = 0; i < blocks.size(); ++i ) {
+            memcpy( &raw[sizeof(uint32_t) * i], &offset, sizeof(offset) );
+            raw.append( blocks[i].data(), blocks[i].size() );
+            offset += blocks[i].size();
+         }
+         memcpy( &raw[sizeof(uint32_t) * blocks.size()], &offset, sizeof(offset) );
+         return raw;
+      }
+
+      void write_pending_entry( std::ostream& out, const vector<char>& data ) {
+         uint32_t size = data.size();
+         out.write( (char*)&size, sizeof(size) );
+         out.write( data.data(), data.size() );
+      }
+
+      /**
+       *  Reads the entries of a blocks.pending file which continue the chain after block last_block_num, stopping at
+       *  the first entry that is torn or does not follow. Entries the log already holds in chunks are skipped.
+       *  Returns true if every entry of the file was consumed.
+       */
+      bool read_pending_entries( const fc::path& file, uint32_t last_block_num, vector<vector<char>>& blocks ) {
+         string content;
+         fc::read_file_contents( file, content );
+         size_t pos = 0;
+         while( pos + sizeof(uint32_t) <= content.size() ) {
+            uint32_t size;
+            memcpy( &size, content.data() + pos, sizeof(size) );
+            if( size > content.size() - pos - sizeof(size) )
+               break;
+            const char* data = content.data() + pos + sizeof(size);
+            uint32_t block_num = 0;
+            try {
+               fc::datastream<const char*> ds( data, size );
+               signed_block_header h;
+               fc::raw::unpack( ds, h );
+               block_num = h.block_num();
+            } catch( ... ) {
+               break;
+            }
+            if( block_num == last_block_num + blocks.size() + 1 )
+               blocks.emplace_back( data, data + size );
+            else if( !blocks.empty() || block_num > last_block_num )
+               break;
+            pos += sizeof(size) + size;
+         }
+         return pos == content.size();
+      }
+
+      void write_log_header( std::ostream& out, uint32_t version, uint32_t first_block_num, uint32_t chunk_blocks,
+                             const vector<char>& genesis_data ) {
+         out.write( (char*)&version, sizeof(version) );
+         if( version == block_log::chunked_version ) {
+            out.write( (char*)&first_block_num, sizeof(first_block_num) );
+            out.write( (char*)&chunk_blocks, sizeof(chunk_blocks) );
+         }
+         out.write( genesis_data.data(), genesis_data.size() );
+      }
+
+      /// A chunk rewritten by pruning: its new header and payload, written at pos over the old ones
+      struct pruned_chunk {
+         uint64_t     pos = 0;
+         chunk_header header;
+         string       payload;
+      };
+
+      fc::path prune_journal_path( const fc::path& block_file ) {
+         return fc::path( block_file.generic_string() + ".prune" );
+      }
+
+      /// Flushes file, or the entries of a directory, to disk
+      void sync_path( const fc::path& file ) {
+         int fd = ::open( file.generic_string().c_str(), O_RDONLY );
+         BES_ASSERT( fd >= 0, block_log_exception, "Unable to open ${file} to sync it", ("file", file) );
+         int r = ::fsync( fd );
+         ::close( fd );
+         BES_ASSERT( r == 0, block_log_exception, "Unable to sync ${file}", ("file", file) );
+      }
+
+      /**
+       *  Writes the chunks about to be pruned in place to the journal of block_file. The journal is written under a
+       *  temporary name and renamed once it is on disk, so it is either complete or absent.
+       */
+      void write_prune_journal( const fc::path& block_file, const vector<pruned_chunk>& chunks ) {
+         auto journal = prune_journal_path( block_file );
+         fc::path tmp( journal.generic_string() + ".tmp" );
+         {
+            std::ofstream out;
+            out.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+            out.open( tmp.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+            for( const auto& c : chunks ) {
+               out.write( (char*)&c.pos, sizeof(c.pos) );
+               out.write( (char*)&c.header, sizeof(c.header) );
+               out.write( c.payload.data(), c.payload.size() );
+            }
+         }
+         sync_path( tmp );
+         fc::rename( tmp, journal );
+         sync_path( block_file.parent_path() );
+      }
+
+      /**
+       *  Rewrites the chunks recorded in the journal of block_file in place, each payload before its header, syncs the
+       *  file and then removes the journal. A prune that was interrupted, wherever it was, is finished by running this
+       *  again; a journal that never got its final name is discarded, as nothing was rewritten yet.
+       */
+      void apply_prune_journal( const fc::path& block_file ) {
+         auto journal = prune_journal_path( block_file );
+         fc::path tmp( journal.generic_string() + ".tmp" );
+         if( fc::exists( tmp ) )
+            fc::remove( tmp );
+         if( !fc::exists( journal ) )
+            return;
+
+         string content;
+         fc::read_file_contents( journal, content );
+         int fd = ::open( block_file.generic_string().c_str(), O_WRONLY );
+         BES_ASSERT( fd >= 0, block_log_exception, "Unable to open ${file} to prune it", ("file", block_file) );
+         auto close_fd = fc::make_scoped_exit( [fd]() { ::close( fd ); } );
+
+         auto write_at = [&]( const char* data, size_t size, uint64_t pos ) {
+            while( size > 0 ) {
+               auto written = ::pwrite( fd, data, size, pos );
+               BES_ASSERT( written > 0, block_log_exception, "Unable to write pruned chunk at ${pos} of ${file}",
+                           ("pos", pos)("file", block_file) );
+               data += written;
+               size -= written;
+               pos += written;
+            }
+         };
+
+         vector<std::pair<uint64_t, uint64_t>> unused; // tails of the slots freed by pruning
+         size_t offset = 0;
+         while( offset < content.size() ) {
+            pruned_chunk c;
+            BES_ASSERT( content.size() - offset >= sizeof(c.pos) + sizeof(c.header), block_log_exception,
+                        "Prune journal ${file} is corrupt", ("file", journal) );
+            memcpy( &c.pos, content.data() + offset, sizeof(c.pos) );
+            memcpy( &c.header, content.data() + offset + sizeof(c.pos), sizeof(c.header) );
+            offset += sizeof(c.pos) + sizeof(c.header);
+            BES_ASSERT( c.header.payload_size <= c.header.slot_size && content.size() - offset >= c.header.payload_size,
+                        block_log_exception, "Prune journal ${file} is corrupt", ("file", journal) );
+            write_at( content.data() + offset, c.header.payload_size, c.pos + sizeof(chunk_header) );
+            write_at( (const char*)&c.header, sizeof(c.header), c.pos );
+            offset += c.header.payload_size;
+            if( c.header.payload_size < c.header.slot_size )
+               unused.emplace_back( c.pos + sizeof(chunk_header) + c.header.payload_size, c.header.slot_size - c.header.payload_size );
+         }
+         BES_ASSERT( ::fsync( fd ) == 0, block_log_exception, "Unable to sync ${file}", ("file", block_file) );
+
+#ifdef __linux__
+         // the file keeps its size, the unused tails of the slots are returned to the file system
+         for( const auto& u : unused ) {
+            if( ::fallocate( fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, u.first, u.second ) != 0 )
+               dlog( "Unable to release ${size} bytes of pruned blocks at ${pos} in the block log", ("size", u.second)("pos", u.first) );
+         }
+#endif
+         fc::remove( journal );
+      }
+
+      string segment_name( uint32_t first_block_num, uint32_t last_block_num ) {
+         char name[64];
+         snprintf( name, sizeof(name), "blocks-%010u-%010u", first_block_num, last_block_num );
+         return name;
+      }
+
+      bool parse_segment_name( const string& name, uint32_t& first_block_num, uint32_t& last_block_num ) {
+         int end = 0;
+         return sscanf( name.c_str(), "blocks-%10u-%10u.log%n", &first_block_num, &last_block_num, &end ) == 2 &&
+                end == int(name.size());
+      }
+
+      /**
+       *  One blocks.log with its index: the active segment blocks are appended to, or a sealed segment of a rotating
+       *  block log.
+       */
+      class log_file {
          public:
+            log_file() {
+               block_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
+               index_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
+               pending_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
+            }
+
             signed_block_ptr         head;
             block_id_type            head_id;
             std::fstream             block_stream;
@@ -26,6 +327,36 @@ namespace besio { namespace chain {
             bool                     block_write;
             bool                     index_write;
             bool                     genesis_written_to_block_log = false;
+            uint64_t                 block_file_end = 0; ///< size of blocks.log including everything appended so far
+
+            mapped_log_file          block_map;
+            mapped_log_file          index_map;
+            block_cache_index        block_cache; ///< most recently read blocks, front is newest
+
+            uint32_t                 version = block_log::supported_version;
+            uint32_t                 first_block_num = 1;
+            uint32_t                 chunk_blocks = 0;   ///< as recorded in the header of a version 2 log, 0 if uncompressed
+            uint64_t                 entries_begin = 0;  ///< position of the first block or chunk, right after the header
+            vector<char>             genesis_data;       ///< packed genesis_state from the header
+
+            fc::path                 pending_file;       ///< empty for a sealed segment
+            std::fstream             pending_stream;
+            vector<vector<char>>     pending;            ///< blocks appended to a chunked log since its last chunk
+            uint64_t                 pending_bytes = 0;
+            uint32_t                 last_sealed_block_num = 0;
+            uint32_t                 first_unpruned_block_num = 1;
+            chunk_data               chunk_cache;        ///< most recently inflated chunk
+
+            bool chunked()const { return version == block_log::chunked_version && chunk_blocks > 0; }
+
+            uint32_t head_num()const { return head ? block_header::num_from_id(head_id) : first_block_num - 1; }
+
+            void reset_read_state() {
+               block_map.reset();
+               index_map.reset();
+               block_cache.clear();
+               chunk_cache = chunk_data();
+            }
 
             inline void check_block_read() {
                if (block_write) {
@@ -61,13 +392,1156 @@ namespace besio { namespace chain {
                   index_write = true;
                }
             }
+
+            void close() {
+               reset_read_state();
+               if (block_stream.is_open())
+                  block_stream.close();
+               if (index_stream.is_open())
+                  index_stream.close();
+               if (pending_stream.is_open())
+                  pending_stream.close();
+            }
+
+            void open( const fc::path& block_path, const fc::path& index_path, const fc::path& pending_path ) {
+               close();
+               block_file = block_path;
+               index_file = index_path;
+               pending_file = pending_path;
+
+               if( fc::exists( block_file ) )
+                  apply_prune_journal( block_file );
+
+               head.reset();
+               head_id = block_id_type();
+               genesis_written_to_block_log = false;
+               version = block_log::supported_version;
+               first_block_num = 1;
+               chunk_blocks = 0;
+               entries_begin = 0;
+               genesis_data.clear();
+               pending.clear();
+               pending_bytes = 0;
+               last_sealed_block_num = 0;
+               first_unpruned_block_num = 1;
+
+               //ilog("Opening block log at ${path}", ("path", block_file.generic_string()));
+               block_stream.open(block_file.generic_string().c_str(), LOG_WRITE);
+               index_stream.open(index_file.generic_string().c_str(), LOG_WRITE);
+               block_write = true;
+               index_write = true;
+
+               /* On startup of the block log, there are several states the log file and the index file can be
+                * in relation to each other.
+                *
+                *                          Block Log
+                *                     Exists       Is New
+                *                 +------------+------------+
+                *          Exists |    Check   |   Delete   |
+                *   Index         |    Head    |    Index   |
+                *    File         +------------+------------+
+                *          Is New |   Replay   |     Do     |
+                *                 |    Log     |   Nothing  |
+                *                 +------------+------------+
+                *
+                * Checking the heads of the files has several conditions as well.
+                *  - If they are the same, do nothing.
+                *  - If the index file head is not in the log file, delete the index and replay.
+                *  - If the index file head is in the log, but not up to date, replay from index head.
+                */
+               auto log_size = fc::file_size(block_file);
+               auto index_size = fc::file_size(index_file);
+               block_file_end = log_size;
+
+               if (log_size) {
+                  ilog("Log is nonempty");
+                  check_block_read();
+                  block_stream.seekg( 0 );
+                  block_stream.read( (char*)&version, sizeof(version) );
+                  BES_ASSERT( version > 0, block_log_exception, "Block log was not setup properly with genesis information." );
+                  BES_ASSERT( version == block_log::supported_version || version == block_log::chunked_version,
+                             block_log_unsupported_version,
+                             "Unsupported version of block log. Block log version is ${version} while code supports version ${supported}",
+                             ("version", version)("supported", block_log::supported_version) );
+
+                  if (version == block_log::chunked_version) {
+                     block_stream.read( (char*)&first_block_num, sizeof(first_block_num) );
+                     block_stream.read( (char*)&chunk_blocks, sizeof(chunk_blocks) );
+                  }
+                  genesis_state gs;
+                  fc::raw::unpack( block_stream, gs );
+                  genesis_data = fc::raw::pack( gs );
+                  entries_begin = block_stream.tellg();
+                  if (chunked())
+                     open_chunked();
+
+                  genesis_written_to_block_log = true; // Assume it was constructed properly.
+                  head = read_head();
+                  if (head)
+                     head_id = head->id();
+
+                  if (chunked()) {
+                     uint64_t expected_size = sizeof(uint64_t) * (uint64_t(last_sealed_block_num) + 1 - first_block_num);
+                     if (index_size != expected_size) {
+                        ilog("Index does not match the chunks of the block log");
+                        construct_index();
+                     }
+                     find_first_unpruned();
+                  } else if (!head) {
+                     if (index_size) {
+                        ilog("Log holds no blocks, recreate the index");
+                        construct_index();
+                     }
+                  } else if (index_size) {
+                     check_block_read();
+                     check_index_read();
+
+                     ilog("Index is nonempty");
+                     uint64_t block_pos;
+                     block_stream.seekg(-sizeof(uint64_t), std::ios::end);
+                     block_stream.read((char*)&block_pos, sizeof(block_pos));
+
+                     uint64_t index_pos;
+                     index_stream.seekg(-sizeof(uint64_t), std::ios::end);
+                     index_stream.read((char*)&index_pos, sizeof(index_pos));
+
+                     if (block_pos < index_pos) {
+                        ilog("block_pos < index_pos, close and reopen index_stream");
+                        construct_index();
+                     } else if (block_pos > index_pos) {
+                        ilog("Index is incomplete");
+                        construct_index();
+                     }
+                  } else {
+                     ilog("Index is empty");
+                     construct_index();
+                  }
+               } else if (index_size) {
+                  ilog("Index is nonempty, remove and recreate it");
+                  index_stream.close();
+                  fc::remove_all(index_file);
+                  index_stream.open(index_file.generic_string().c_str(), LOG_WRITE);
+                  index_write = true;
+               }
+            }
+
+            void construct_index() {
+               ilog("Reconstructing Block Log Index...");
+               index_stream.close();
+               fc::remove_all(index_file);
+               index_stream.open(index_file.generic_string().c_str(), LOG_WRITE);
+               index_write = true;
+               index_map.reset();
+
+               if (chunked()) {
+                  chunk_header h;
+                  for (uint64_t pos = entries_begin; pos < block_file_end; pos += h.entry_size()) {
+                     BES_ASSERT( read_chunk_header( pos, h ), block_log_exception,
+                                 "Block log chunk at ${pos} is corrupt", ("pos", pos) );
+                     for (uint32_t i = 0; i < h.block_count; ++i)
+                        index_stream.write((char*)&pos, sizeof(pos));
+                  }
+                  index_stream.flush();
+                  return;
+               }
+
+               if (block_file_end <= entries_begin)
+                  return;
+
+               uint64_t end_pos;
+               check_block_read();
+
+               block_stream.seekg(-sizeof( uint64_t), std::ios::end);
+               block_stream.read((char*)&end_pos, sizeof(end_pos));
+               signed_block tmp;
+
+               uint64_t pos = entries_begin; // Skip the header which should have already been checked.
+               block_stream.seekg(pos);
+
+               while( pos < end_pos ) {
+                  fc::raw::unpack(block_stream, tmp);
+                  block_stream.read((char*)&pos, sizeof(pos));
+                  index_stream.write((char*)&pos, sizeof(pos));
+               }
+               index_stream.flush();
+            } // construct_index
+
+            uint64_t append( const signed_block_ptr& b ) {
+               BES_ASSERT( genesis_written_to_block_log, block_log_append_fail, "Cannot append to block log until the genesis is first written" );
+
+               if (chunked()) {
+                  uint32_t expected = last_sealed_block_num + pending.size() + 1;
+                  BES_ASSERT( b->block_num() == expected, block_log_append_fail,
+                              "Append to block log occuring at wrong position.",
+                              ("block_num", b->block_num())("expected", expected) );
+                  auto data = fc::raw::pack(*b);
+                  write_pending_entry( pending_stream, data );
+                  pending_stream.flush();
+                  pending_bytes += data.size();
+                  pending.emplace_back( std::move(data) );
+                  head = b;
+                  head_id = b->id();
+
+                  if (pending.size() < chunk_blocks && pending_bytes < config::block_log_max_chunk_bytes)
+                     return block_log::npos;
+                  return seal_chunk();
+               }
+
+               check_block_write();
+               check_index_write();
+
+               uint64_t pos = block_stream.tellp();
+               BES_ASSERT(index_stream.tellp() == sizeof(uint64_t) * (b->block_num() - first_block_num),
+                         block_log_append_fail,
+                         "Append to index file occuring at wrong position.",
+                         ("position", (uint64_t) index_stream.tellp())
+                         ("expected", (b->block_num() - first_block_num) * sizeof(uint64_t)));
+               auto data = fc::raw::pack(*b);
+               block_stream.write(data.data(), data.size());
+               block_stream.write((char*)&pos, sizeof(pos));
+               index_stream.write((char*)&pos, sizeof(pos));
+               block_file_end = pos + data.size() + sizeof(pos);
+               head = b;
+               head_id = b->id();
+
+               flush();
+
+               return pos;
+            }
+
+            void flush() {
+               if (block_stream.is_open())
+                  block_stream.flush();
+               if (index_stream.is_open())
+                  index_stream.flush();
+               if (pending_stream.is_open())
+                  pending_stream.flush();
+            }
+
+            /// Writes out the pending blocks and closes the files, which from then on form a sealed segment
+            void seal() {
+               if (chunked() && !pending.empty())
+                  seal_chunk();
+               close();
+               if (pending_file != fc::path())
+                  fc::remove_all( pending_file );
+               pending_file = fc::path();
+            }
+
+            uint64_t reset( const genesis_state& gs, const signed_block_ptr& genesis_block, uint32_t new_chunk_blocks ) {
+               close();
+
+               fc::remove_all( block_file );
+               fc::remove_all( index_file );
+               fc::remove_all( pending_file );
+
+               version = new_chunk_blocks ? block_log::chunked_version : block_log::supported_version;
+               first_block_num = 1;
+               chunk_blocks = new_chunk_blocks;
+               pending.clear();
+               pending_bytes = 0;
+               last_sealed_block_num = 0;
+               first_unpruned_block_num = 1;
+               genesis_data = fc::raw::pack( gs );
+
+               block_stream.open(block_file.generic_string().c_str(), LOG_WRITE);
+               index_stream.open(index_file.generic_string().c_str(), LOG_WRITE);
+               block_write = true;
+               index_write = true;
+               if( chunked() )
+                  open_pending_stream();
+
+               uint32_t invalid = 0; // version of 0 is invalid; it indicates that the genesis was not properly written to the block log
+               block_stream.write( (char*)&invalid, sizeof(invalid) );
+               entries_begin = sizeof(invalid);
+               if( version == block_log::chunked_version ) {
+                  block_stream.write( (char*)&first_block_num, sizeof(first_block_num) );
+                  block_stream.write( (char*)&chunk_blocks, sizeof(chunk_blocks) );
+                  entries_begin += sizeof(first_block_num) + sizeof(chunk_blocks);
+               }
+               block_stream.write( genesis_data.data(), genesis_data.size() );
+               entries_begin += genesis_data.size();
+               block_file_end = entries_begin;
+               genesis_written_to_block_log = true;
+
+               auto ret = append( genesis_block );
+
+               block_stream.flush();
+               auto pos = block_stream.tellp();
+
+               block_stream.close();
+               block_stream.open(block_file.generic_string().c_str(), LOG_RDWR ); // Bypass append-only writing just once
+
+               static_assert( block_log::supported_version > 0, "a version number of zero is not supported" );
+               block_stream.seekp( 0 );
+               block_stream.write( (char*)&version, sizeof(version) ); // Finally write actual version to disk.
+               block_stream.seekp( pos );
+               flush();
+
+               block_write = false;
+               check_block_write(); // Reset to append-only writing.
+
+               return ret;
+            }
+
+            /**
+             *  Maps the index and block files of a sealed log through last_block_num in full, so that reading it never
+             *  opens its files by path again until the maps are reset
+             */
+            void map_sealed( uint32_t last_block_num ) {
+               uint64_t index_end = sizeof(uint64_t) * (uint64_t(last_block_num - first_block_num) + 1);
+               BES_ASSERT( index_map.ensure_mapped( index_file, index_end ) && block_map.ensure_mapped( block_file, block_file_end ),
+                           block_log_exception, "Block log segment ${file} is shorter than expected", ("file", block_file) );
+            }
+
+            uint64_t index_entry( uint32_t block_num ) {
+               uint64_t index_end = sizeof(uint64_t) * (uint64_t(block_num - first_block_num) + 1);
+               BES_ASSERT( index_map.ensure_mapped( index_file, index_end ), block_log_exception,
+                           "Block log index does not contain block ${num}", ("num", block_num) );
+               uint64_t pos;
+               memcpy(&pos, index_map.data() + index_end - sizeof(pos), sizeof(pos));
+               return pos;
+            }
+
+            std::pair<signed_block_ptr, uint64_t> read_block( uint64_t pos ) {
+               BES_ASSERT( !chunked(), block_log_exception, "Blocks of a chunked block log cannot be read by position" );
+               BES_ASSERT( pos < block_file_end && block_map.ensure_mapped( block_file, block_file_end ),
+                           block_log_exception, "Block position ${pos} is beyond the end of the block log", ("pos", pos) );
+
+               fc::datastream<const char*> ds( block_map.data() + pos, block_file_end - pos );
+               std::pair<signed_block_ptr,uint64_t> result;
+               result.first = std::make_shared<signed_block>();
+               fc::raw::unpack(ds, *result.first);
+               result.second = pos + ds.tellp() + 8;
+               return result;
+            }
+
+            signed_block_ptr read_block_by_num( uint32_t block_num ) {
+               auto& idx = block_cache.get<by_block_num>();
+               auto itr = idx.find( block_num );
+               if( itr != idx.end() ) {
+                  block_cache.relocate( block_cache.begin(), block_cache.project<0>( itr ) );
+                  return itr->block;
+               }
+
+               signed_block_ptr b;
+               if (chunked()) {
+                  auto data = read_serialized_block_by_num(block_num);
+                  if (data.first) {
+                     fc::datastream<const char*> ds( data.first, data.second );
+                     b = std::make_shared<signed_block>();
+                     fc::raw::unpack(ds, *b);
+                  }
+               } else {
+                  uint64_t pos = get_block_pos(block_num);
+                  if (pos != block_log::npos)
+                     b = read_block(pos).first;
+               }
+               if (b) {
+                  BES_ASSERT(b->block_num() == block_num, reversible_blocks_exception,
+                            "Wrong block was read from block log.", ("returned", b->block_num())("expected", block_num));
+
+                  block_cache.push_front( cached_block{ block_num, b } );
+                  if( block_cache.size() > config::block_log_cache_size )
+                     block_cache.pop_back();
+               }
+               return b;
+            }
+
+            std::pair<const char*, size_t> read_serialized_block_by_num( uint32_t block_num ) {
+               if (chunked()) {
+                  if (!(head && block_num <= head_num() && block_num >= first_block_num))
+                     return {nullptr, 0};
+                  if (block_num > last_sealed_block_num) {
+                     const auto& data = pending[block_num - last_sealed_block_num - 1];
+                     return {data.data(), data.size()};
+                  }
+                  const auto& c = load_chunk( index_entry( block_num ) );
+                  if (c.header.flags & chunk_header::pruned)
+                     return {nullptr, 0};
+                  return c.block( block_num );
+               }
+
+               uint64_t pos = get_block_pos(block_num);
+               if (pos == block_log::npos)
+                  return {nullptr, 0};
+
+               // the serialized block runs up to the copy of its own position that follows it
+               uint64_t end = (block_num == head_num()) ? block_file_end : get_block_pos(block_num + 1);
+               end -= sizeof(uint64_t);
+               BES_ASSERT( pos < end && end <= block_file_end && block_map.ensure_mapped( block_file, block_file_end ),
+                           block_log_exception, "Block log index entry for block ${num} is corrupt", ("num", block_num) );
+               return {block_map.data() + pos, end - pos};
+            }
+
+            optional<signed_block_header> read_block_header_by_num( uint32_t block_num ) {
+               std::pair<const char*, size_t> data{nullptr, 0};
+               if (chunked() && head && block_num >= first_block_num && block_num <= last_sealed_block_num)
+                  data = load_chunk( index_entry( block_num ) ).block( block_num );
+               else
+                  data = read_serialized_block_by_num(block_num);
+
+               optional<signed_block_header> result;
+               if (data.first) {
+                  fc::datastream<const char*> ds( data.first, data.second );
+                  signed_block_header h;
+                  fc::raw::unpack(ds, h);
+                  result = h;
+               }
+               return result;
+            }
+
+            uint64_t get_block_pos( uint32_t block_num ) {
+               if (!(head && block_num <= head_num() && block_num >= first_block_num))
+                  return block_log::npos;
+               if (chunked() && block_num > last_sealed_block_num)
+                  return block_log::npos;
+               return index_entry( block_num );
+            }
+
+            signed_block_ptr read_head() {
+               uint64_t pos;
+
+               if (chunked()) {
+                  if (!pending.empty()) {
+                     fc::datastream<const char*> ds( pending.back().data(), pending.back().size() );
+                     auto b = std::make_shared<signed_block>();
+                     fc::raw::unpack(ds, *b);
+                     return b;
+                  }
+                  if (last_sealed_block_num < first_block_num)
+                     return {};
+                  BES_ASSERT( block_map.ensure_mapped( block_file, block_file_end ), block_log_exception,
+                              "Block log is shorter than expected" );
+                  memcpy(&pos, block_map.data() + block_file_end - sizeof(pos), sizeof(pos));
+                  const auto& c = load_chunk( pos );
+                  BES_ASSERT( !(c.header.flags & chunk_header::pruned), block_log_exception,
+                              "The head block of the block log has been pruned" );
+                  auto data = c.block( last_sealed_block_num );
+                  fc::datastream<const char*> ds( data.first, data.second );
+                  auto b = std::make_shared<signed_block>();
+                  fc::raw::unpack(ds, *b);
+                  return b;
+               }
+
+               // Check that the file holds a block
+               if (block_file_end <= entries_begin)
+                  return {};
+
+               BES_ASSERT( block_map.ensure_mapped( block_file, block_file_end ), block_log_exception,
+                           "Block log is shorter than expected" );
+               memcpy(&pos, block_map.data() + block_file_end - sizeof(pos), sizeof(pos));
+               return read_block(pos).first;
+            }
+
+            bool read_chunk_header( uint64_t pos, chunk_header& h ) {
+               if( pos < entries_begin || pos + sizeof(h) > block_file_end || !block_map.ensure_mapped( block_file, block_file_end ) )
+                  return false;
+               memcpy( &h, block_map.data() + pos, sizeof(h) );
+               if( h.block_count == 0 || h.payload_size > h.slot_size || pos + h.entry_size() > block_file_end )
+                  return false;
+               uint64_t trailer;
+               memcpy( &trailer, block_map.data() + pos + h.entry_size() - sizeof(trailer), sizeof(trailer) );
+               return trailer == pos;
+            }
+
+            const chunk_data& load_chunk( uint64_t pos ) {
+               if( chunk_cache.pos == pos )
+                  return chunk_cache;
+               chunk_data c;
+               BES_ASSERT( read_chunk_header( pos, c.header ), block_log_exception,
+                           "Block log chunk at ${pos} is corrupt", ("pos", pos) );
+               c.raw = fc::zlib_decompress( string( block_map.data() + pos + sizeof(chunk_header), c.header.payload_size ) );
+               BES_ASSERT( c.valid(), block_log_exception, "Block log chunk at ${pos} is corrupt", ("pos", pos) );
+               c.pos = pos;
+               chunk_cache = std::move( c );
+               return chunk_cache;
+            }
+
+            void open_pending_stream() {
+               if( pending_stream.is_open() )
+                  pending_stream.close();
+               pending_stream.open( pending_file.generic_string().c_str(), LOG_WRITE );
+            }
+
+            /**
+             *  Drops a chunk torn by a crash from the end of the log, along with everything after it, then loads the
+             *  pending blocks that follow the last complete chunk.
+             */
+            void open_chunked() {
+               chunk_header h;
+               uint64_t trailer = 0;
+               bool complete = block_file_end == entries_begin;
+               if( !complete && block_file_end >= entries_begin + sizeof(chunk_header) + sizeof(trailer) &&
+                   block_map.ensure_mapped( block_file, block_file_end ) ) {
+                  memcpy( &trailer, block_map.data() + block_file_end - sizeof(trailer), sizeof(trailer) );
+                  complete = read_chunk_header( trailer, h ) && trailer + h.entry_size() == block_file_end;
+               }
+
+               if( complete ) {
+                  last_sealed_block_num = block_file_end == entries_begin ? first_block_num - 1 : h.last_block_num();
+               } else {
+                  uint64_t pos = entries_begin;
+                  last_sealed_block_num = first_block_num - 1;
+                  while( read_chunk_header( pos, h ) && h.first_block_num == last_sealed_block_num + 1 ) {
+                     last_sealed_block_num = h.last_block_num();
+                     pos += h.entry_size();
+                  }
+                  wlog( "Block log ends with an incomplete chunk, truncating it after block ${num}", ("num", last_sealed_block_num) );
+                  reset_read_state();
+                  block_stream.close();
+                  fc::resize_file( block_file, pos );
+                  block_stream.open( block_file.generic_string().c_str(), LOG_READ );
+                  block_write = false;
+                  block_file_end = pos;
+               }
+
+               pending.clear();
+               pending_bytes = 0;
+               if( pending_file == fc::path() )
+                  return;
+               if( fc::exists( pending_file ) && !read_pending_entries( pending_file, last_sealed_block_num, pending ) ) {
+                  ilog( "Rewriting ${file} with the ${count} blocks following the block log",
+                        ("file", pending_file)("count", pending.size()) );
+                  std::fstream out( pending_file.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+                  for( const auto& b : pending )
+                     write_pending_entry( out, b );
+               }
+               for( const auto& b : pending )
+                  pending_bytes += b.size();
+               open_pending_stream();
+            }
+
+            /// Compresses the pending blocks into a new chunk at the end of the log
+            uint64_t seal_chunk() {
+               chunk_header h;
+               h.first_block_num = last_sealed_block_num + 1;
+               h.block_count = pending.size();
+               auto raw = make_chunk_payload( pending );
+               auto payload = fc::zlib_compress( raw );
+               h.raw_size = raw.size();
+               h.payload_size = h.slot_size = payload.size();
+
+               check_block_write();
+               check_index_write();
+               BES_ASSERT( index_stream.tellp() == sizeof(uint64_t) * (h.first_block_num - first_block_num),
+                           block_log_append_fail, "Append to index file occuring at wrong position.",
+                           ("position", (uint64_t) index_stream.tellp())
+                           ("expected", (h.first_block_num - first_block_num) * sizeof(uint64_t)) );
+
+               uint64_t pos = block_file_end;
+               block_stream.write( (char*)&h, sizeof(h) );
+               block_stream.write( payload.data(), payload.size() );
+               block_stream.write( (char*)&pos, sizeof(pos) );
+               for( uint32_t i = 0; i < h.block_count; ++i )
+                  index_stream.write( (char*)&pos, sizeof(pos) );
+               block_stream.flush();
+               index_stream.flush();
+               block_file_end = pos + h.entry_size();
+               last_sealed_block_num = h.last_block_num();
+
+               // the blocks are safe in the log now; should this be interrupted they are skipped on open
+               pending.clear();
+               pending_bytes = 0;
+               pending_stream.close();
+               fc::resize_file( pending_file, 0 );
+               open_pending_stream();
+               return pos;
+            }
+
+            /// First block whose chunk has not been pruned; pruned chunks always form a prefix of the log
+            void find_first_unpruned() {
+               uint32_t lo = first_block_num, hi = last_sealed_block_num + 1;
+               while( lo < hi ) {
+                  uint32_t mid = lo + (hi - lo) / 2;
+                  chunk_header h;
+                  BES_ASSERT( read_chunk_header( index_entry( mid ), h ), block_log_exception,
+                              "Block log chunk holding block ${num} is corrupt", ("num", mid) );
+                  if( h.flags & chunk_header::pruned )
+                     lo = mid + 1;
+                  else
+                     hi = mid;
+               }
+               first_unpruned_block_num = lo;
+            }
+
+            /**
+             *  Rewrites the chunks holding only blocks up to prune_through with just the headers of their blocks. The
+             *  chunks are first recorded in a journal, see apply_prune_journal, so a crash during the rewrite in place
+             *  never leaves a chunk half pruned.
+             */
+            void prune_chunks( uint32_t prune_through ) {
+               const size_t chunks_per_journal = 64;
+               vector<pruned_chunk> chunks;
+               bool pruned_any = false;
+               auto rewrite = [&]() {
+                  write_prune_journal( block_file, chunks );
+                  apply_prune_journal( block_file );
+                  chunks.clear();
+                  pruned_any = true;
+               };
+
+               while( first_unpruned_block_num <= last_sealed_block_num ) {
+                  uint64_t pos = index_entry( first_unpruned_block_num );
+                  chunk_header h;
+                  BES_ASSERT( read_chunk_header( pos, h ), block_log_exception,
+                              "Block log chunk at ${pos} is corrupt", ("pos", pos) );
+                  if( h.last_block_num() > prune_through )
+                     break;
+
+                  if( !(h.flags & chunk_header::pruned) ) {
+                     const auto& c = load_chunk( pos );
+                     vector<vector<char>> headers;
+                     headers.reserve( h.block_count );
+                     for( uint32_t n = h.first_block_num; n <= h.last_block_num(); ++n ) {
+                        auto b = c.block( n );
+                        fc::datastream<const char*> ds( b.first, b.second );
+                        signed_block_header bh;
+                        fc::raw::unpack( ds, bh );
+                        headers.emplace_back( fc::raw::pack( bh ) );
+                     }
+                     auto raw = make_chunk_payload( headers );
+                     auto payload = fc::zlib_compress( raw );
+
+                     // the headers of nearly empty blocks may not compress any smaller; such a chunk is left as it is
+                     if( payload.size() <= h.slot_size ) {
+                        pruned_chunk p;
+                        p.pos = pos;
+                        p.header = h;
+                        p.header.flags |= chunk_header::pruned;
+                        p.header.payload_size = payload.size();
+                        p.header.raw_size = raw.size();
+                        p.payload = std::move( payload );
+                        chunks.emplace_back( std::move( p ) );
+                        if( chunks.size() == chunks_per_journal )
+                           rewrite();
+                     }
+                  }
+                  first_unpruned_block_num = h.last_block_num() + 1;
+               }
+               if( !chunks.empty() )
+                  rewrite();
+               if( pruned_any )
+                  reset_read_state();
+            }
+      };
+
+      /// A sealed segment of a rotating block log, holding blocks first_block_num to last_block_num
+      struct log_segment {
+         uint32_t                  first_block_num = 0;
+         uint32_t                  last_block_num = 0;
+         fc::path                  block_file;
+         fc::path                  index_file;
+         bool                      archived = false; ///< the files are in the archive directory
+         std::unique_ptr<log_file> log; ///< opened when first read
+      };
+
+      /**
+       *  Moves sealed segments into the archive directory on a thread of its own. A segment is renamed when the archive
+       *  is on the same file system, and otherwise copied before the originals are removed. The files of a segment only
+       *  ever change location while mtx is held, and each move is reported through moved so that the owner can follow it.
+       */
+      class segment_archiver {
+         public:
+            struct moved_segment {
+               uint32_t first_block_num;
+               fc::path block_file;
+               fc::path index_file;
+            };
+
+            explicit segment_archiver( const fc::path& dir )
+            :archive_dir( dir ), thread( [this]() { run(); } ) {}
+
+            ~segment_archiver() {
+               stop();
+            }
+
+            /// Waits for the segment being moved, if any; segments still queued are left where they are
+            void stop() {
+               {
+                  std::lock_guard<std::mutex> g( mtx );
+                  stopping = true;
+               }
+               cv.notify_all();
+               if( thread.joinable() )
+                  thread.join();
+            }
+
+            void archive( const log_segment& s ) {
+               std::lock_guard<std::mutex> g( mtx );
+               queue.push_back( moved_segment{ s.first_block_num, s.block_file, s.index_file } );
+               cv.notify_one();
+            }
+
+            std::mutex              mtx;
+            vector<moved_segment>   moved; ///< segments archived since the owner last looked, guarded by mtx
+
+         private:
+            void run() {
+               std::unique_lock<std::mutex> lock( mtx );
+               while( true ) {
+                  cv.wait( lock, [this]() { return stopping || !queue.empty(); } );
+                  if( stopping )
+                     return;
+                  auto s = queue.front();
+                  queue.pop_front();
+                  try {
+                     move( s, lock );
+                  } catch( const fc::exception& e ) {
+                     elog( "Unable to archive block log segment ${file}: ${e}", ("file", s.block_file)("e", e.to_detail_string()) );
+                  } catch( const std::exception& e ) {
+                     elog( "Unable to archive block log segment ${file}: ${e}", ("file", s.block_file)("e", e.what()) );
+                  }
+               }
+            }
+
+            void move( const moved_segment& s, std::unique_lock<std::mutex>& lock ) {
+               moved_segment to{ s.first_block_num, archive_dir / s.block_file.filename(), archive_dir / s.index_file.filename() };
+
+               boost::system::error_code ec;
+               boost::filesystem::rename( s.index_file, to.index_file, ec );
+               if( !ec ) {
+                  boost::filesystem::rename( s.block_file, to.block_file, ec );
+                  if( ec ) {
+                     fc::rename( to.index_file, s.index_file );
+                     BES_THROW( block_log_exception, "Unable to move ${file}: ${e}", ("file", s.block_file)("e", ec.message()) );
+                  }
+               } else {
+                  // another file system: copy without holding up readers, then switch over
+                  auto tmp_index = archive_dir / (to.index_file.filename().generic_string() + ".tmp");
+                  auto tmp_block = archive_dir / (to.block_file.filename().generic_string() + ".tmp");
+                  lock.unlock();
+                  try {
+                     fc::remove( tmp_index );
+                     fc::remove( tmp_block );
+                     fc::copy( s.index_file, tmp_index );
+                     fc::copy( s.block_file, tmp_block );
+                  } catch( ... ) {
+                     lock.lock();
+                     throw;
+                  }
+                  lock.lock();
+                  fc::rename( tmp_index, to.index_file );
+                  fc::rename( tmp_block, to.block_file );
+                  fc::remove( s.index_file );
+                  fc::remove( s.block_file );
+               }
+               moved.push_back( to );
+               ilog( "Archived block log segment ${file}", ("file", to.block_file) );
+            }
+
+            fc::path                    archive_dir;
+            std::condition_variable     cv;
+            std::deque<moved_segment>   queue;
+            bool                        stopping = false;
+            std::thread                 thread;
+      };
+
+      class block_log_impl {
+         public:
+            block_log_config                     cfg;
+            fc::path                             data_dir;
+            fc::path                             archive_dir;      ///< empty unless sealed segments are archived
+            log_file                             active;           ///< blocks.log, where blocks are appended
+            vector<log_segment>                  segments;         ///< sealed segments, oldest first
+            size_t                               unpruned_segment = 0; ///< first segment pruning has not finished with
+            std::unique_ptr<segment_archiver>    archiver;
+            signed_block_ptr                     head;
+
+            ~block_log_impl() {
+               stop_archiver();
+            }
+
+            void open( const fc::path& dir ) {
+               stop_archiver();
+               data_dir = dir;
+               if (!fc::is_directory(data_dir))
+                  fc::create_directories(data_dir);
+               archive_dir = fc::path();
+               if (cfg.archive_dir != fc::path()) {
+                  archive_dir = cfg.archive_dir.is_relative() ? data_dir / cfg.archive_dir : cfg.archive_dir;
+                  if (!fc::is_directory(archive_dir))
+                     fc::create_directories(archive_dir);
+               }
+
+               find_segments();
+               active.open( data_dir / "blocks.log", data_dir / "blocks.index", data_dir / "blocks.pending" );
+               if (!segments.empty()) {
+                  const auto& last = segments.back();
+                  if (!active.genesis_written_to_block_log) {
+                     ilog("Starting blocks.log after the last block log segment");
+                     start_segment( last.last_block_num + 1, segment_log( segments.back() ).genesis_data );
+                  }
+                  BES_ASSERT( active.first_block_num == last.last_block_num + 1, block_log_exception,
+                              "blocks.log starts at block ${first} but the last block log segment ends at block ${last}",
+                              ("first", active.first_block_num)("last", last.last_block_num) );
+               }
+
+               if (archive_dir != fc::path()) {
+                  archiver.reset( new segment_archiver( archive_dir ) );
+                  if (!cfg.prune_blocks) {
+                     for (const auto& s : segments)
+                        archive( s );
+                  }
+               }
+               update_head();
+            }
+
+            /**
+             *  Finds the sealed segments in the blocks and archive directories, cleaning up after an archival that was
+             *  interrupted, and rebuilds the index of any segment whose index is damaged.
+             */
+            void find_segments() {
+               segments.clear();
+               unpruned_segment = 0;
+
+               std::map<uint32_t, log_segment> found;
+               auto scan = [&]( const fc::path& dir, bool archived ) {
+                  for (fc::directory_iterator itr( dir ), end; itr != end; ++itr) {
+                     auto name = (*itr).filename().generic_string();
+                     if (name.size() > 4 && name.compare( name.size() - 4, 4, ".tmp" ) == 0) {
+                        fc::remove( *itr );
+                        continue;
+                     }
+                     uint32_t first = 0, last = 0;
+                     if (!parse_segment_name( name, first, last ) || last < first)
+                        continue;
+                     auto& s = found[first];
+                     if (s.block_file != fc::path())
+                        fc::remove( s.block_file ); // left behind by an archival; the archived copy is complete
+                     s.first_block_num = first;
+                     s.last_block_num = last;
+                     s.block_file = *itr;
+                     s.archived = archived;
+                  }
+               };
+               scan( data_dir, false );
+               if (archive_dir != fc::path())
+                  scan( archive_dir, true );
+
+               for (auto& f : found) {
+                  auto& s = f.second;
+                  auto index_name = segment_name( s.first_block_num, s.last_block_num ) + ".index";
+                  s.index_file = (s.archived ? archive_dir : data_dir) / index_name;
+                  if (archive_dir != fc::path()) {
+                     auto other = (s.archived ? data_dir : archive_dir) / index_name;
+                     if (fc::exists( other )) {
+                        if (fc::exists( s.index_file ))
+                           fc::remove( other );
+                        else
+                           fc::rename( other, s.index_file );
+                     }
+                  }
+                  BES_ASSERT( segments.empty() || s.first_block_num == segments.back().last_block_num + 1, block_log_exception,
+                              "Block log segment ${file} does not follow block ${num}",
+                              ("file", s.block_file)("num", segments.back().last_block_num) );
+
+                  uint64_t index_size = sizeof(uint64_t) * (uint64_t(s.last_block_num) - s.first_block_num + 1);
+                  if (!fc::exists( s.index_file ) || fc::file_size( s.index_file ) != index_size) {
+                     ilog( "Index of block log segment ${file} is damaged", ("file", s.block_file) );
+                     log_file log;
+                     log.open( s.block_file, s.index_file, fc::path() );
+                     if (fc::file_size( s.index_file ) != index_size)
+                        log.construct_index();
+                     BES_ASSERT( log.head_num() == s.last_block_num, block_log_exception,
+                                 "Block log segment ${file} ends at block ${num}", ("file", s.block_file)("num", log.head_num()) );
+                  }
+                  segments.emplace_back( std::move(s) );
+               }
+            }
+
+            log_file& segment_log( log_segment& s ) {
+               std::unique_lock<std::mutex> lock;
+               if (archiver) {
+                  lock = std::unique_lock<std::mutex>( archiver->mtx );
+                  apply_moved( archiver->moved );
+               }
+               if (!s.log) {
+                  s.log.reset( new log_file() );
+                  s.log->open( s.block_file, s.index_file, fc::path() );
+               }
+               // mapped while the archiver cannot move the files; the maps stay valid wherever the files go after that
+               s.log->map_sealed( s.last_block_num );
+               return *s.log;
+            }
+
+            /// Follows segments to the archive; a segment that was open is reopened from there when next read
+            void apply_moved( vector<segment_archiver::moved_segment>& moved ) {
+               for (const auto& m : moved) {
+                  auto itr = find_segment( m.first_block_num );
+                  if (itr == segments.end() || itr->first_block_num != m.first_block_num)
+                     continue;
+                  itr->block_file = m.block_file;
+                  itr->index_file = m.index_file;
+                  itr->archived = true;
+                  itr->log.reset();
+               }
+               moved.clear();
+            }
+
+            void stop_archiver() {
+               if (!archiver)
+                  return;
+               archiver->stop();
+               apply_moved( archiver->moved );
+               archiver.reset();
+            }
+
+            void archive( const log_segment& s ) {
+               if (archiver && !s.archived)
+                  archiver->archive( s );
+            }
+
+            /// The segment holding block_num, or segments.end()
+            vector<log_segment>::iterator find_segment( uint32_t block_num ) {
+               auto itr = std::upper_bound( segments.begin(), segments.end(), block_num,
+                                            []( uint32_t n, const log_segment& s ) { return n < s.first_block_num; } );
+               if (itr == segments.begin())
+                  return segments.end();
+               --itr;
+               return block_num <= itr->last_block_num ? itr : segments.end();
+            }
+
+            /// The file holding block_num, or nullptr if it is older than the log
+            log_file* log_for( uint32_t block_num ) {
+               if (segments.empty() || block_num >= active.first_block_num)
+                  return &active;
+               auto itr = find_segment( block_num );
+               return itr == segments.end() ? nullptr : &segment_log( *itr );
+            }
+
+            void update_head() {
+               if (active.head || segments.empty())
+                  head = active.head;
+               else
+                  head = segment_log( segments.back() ).head;
+            }
+
+            /// Creates an empty blocks.log for the blocks starting at first_block_num
+            void start_segment( uint32_t first_block_num, const vector<char>& genesis_data ) {
+               active.close();
+               fc::remove_all( data_dir / "blocks.log" );
+               fc::remove_all( data_dir / "blocks.index" );
+               fc::remove_all( data_dir / "blocks.pending" );
+
+               auto tmp = data_dir / "blocks.log.tmp";
+               {
+                  std::fstream out( tmp.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+                  write_log_header( out, block_log::chunked_version, first_block_num, cfg.chunk_blocks, genesis_data );
+               }
+               fc::rename( tmp, data_dir / "blocks.log" );
+               active.open( data_dir / "blocks.log", data_dir / "blocks.index", data_dir / "blocks.pending" );
+            }
+
+            /// Seals blocks.log as a numbered segment and starts a new one after it
+            void rotate() {
+               auto first = active.first_block_num;
+               auto last = active.head_num();
+               auto genesis_data = active.genesis_data;
+               active.seal();
+
+               log_segment s;
+               s.first_block_num = first;
+               s.last_block_num = last;
+               auto name = segment_name( first, last );
+               s.block_file = data_dir / (name + ".log");
+               s.index_file = data_dir / (name + ".index");
+               fc::rename( data_dir / "blocks.index", s.index_file );
+               fc::rename( data_dir / "blocks.log", s.block_file );
+               ilog( "Sealed block log segment ${file}", ("file", s.block_file) );
+               segments.emplace_back( std::move(s) );
+
+               start_segment( last + 1, genesis_data );
+               if (!cfg.prune_blocks)
+                  archive( segments.back() );
+            }
+
+            /**
+             *  Prunes the chunks that fell prune_blocks behind the head, in the sealed segments and then in blocks.log.
+             *  A segment is archived once pruning is done with it.
+             */
+            void prune() {
+               auto head_num = block_header::num_from_id( head->id() );
+               if (head_num <= cfg.prune_blocks)
+                  return;
+               uint32_t prune_through = head_num - cfg.prune_blocks;
+
+               while (unpruned_segment < segments.size()) {
+                  auto& s = segments[unpruned_segment];
+                  if (s.first_block_num > prune_through)
+                     return;
+                  auto& log = segment_log( s );
+                  if (log.chunked()) {
+                     log.prune_chunks( prune_through );
+                     if (log.first_unpruned_block_num <= s.last_block_num)
+                        return;
+                  }
+                  s.log.reset();
+                  archive( s );
+                  ++unpruned_segment;
+               }
+               if (active.chunked())
+                  active.prune_chunks( prune_through );
+            }
+
+            uint64_t append( const signed_block_ptr& b ) {
+               auto pos = active.append( b );
+               head = b;
+               if (active.chunked() && pos != block_log::npos && cfg.prune_blocks)
+                  prune();
+               if (cfg.segment_blocks && b->block_num() % cfg.segment_blocks == 0)
+                  rotate();
+               return pos;
+            }
+
+            uint64_t reset_to_genesis( const genesis_state& gs, const signed_block_ptr& genesis_block ) {
+               stop_archiver();
+               for (auto& s : segments) {
+                  s.log.reset();
+                  fc::remove_all( s.block_file );
+                  fc::remove_all( s.index_file );
+               }
+               segments.clear();
+               unpruned_segment = 0;
+
+               auto ret = active.reset( gs, genesis_block, cfg.chunk_blocks );
+               head = active.head;
+               if (archive_dir != fc::path())
+                  archiver.reset( new segment_archiver( archive_dir ) );
+               return ret;
+            }
       };
+
+      /**
+       *  Copies the intact chunks of a chunked block log into a new log, compacting the slots of pruned chunks. The
+       *  blocks of a chunk cut short (by corruption or truncate_at_block) and the pending blocks that continue the old
+       *  log are written to the new blocks.pending.
+       */
+      void repair_chunked_log( std::fstream& old_stream, uint64_t end_pos, std::fstream& new_stream,
+                               uint32_t first_block_num, uint32_t chunk_blocks,
+                               const fc::path& backup_dir, const fc::path& blocks_dir, uint32_t truncate_at_block ) {
+         genesis_state gs;
+         fc::raw::unpack( old_stream, gs );
+         write_log_header( new_stream, block_log::chunked_version, first_block_num, chunk_blocks, fc::raw::pack( gs ) );
+
+         uint64_t pos = old_stream.tellg();
+         uint64_t new_pos = new_stream.tellp();
+         uint32_t block_num = first_block_num - 1;
+         block_id_type previous;
+         vector<vector<char>> tail;
+         bool stop = false;
+
+         while( !stop && pos + sizeof(chunk_header) <= end_pos ) {
+            chunk_data c;
+            old_stream.seekg( pos );
+            old_stream.read( (char*)&c.header, sizeof(c.header) );
+            const auto& h = c.header;
+            if( h.block_count == 0 || h.payload_size > h.slot_size || pos + h.entry_size() > end_pos ||
+                h.first_block_num != block_num + 1 ) {
+               elog( "Block log chunk at ${pos} is not a valid chunk following block ${num}", ("pos", pos)("num", block_num) );
+               break;
+            }
+            string payload( h.payload_size, '\0' );
+            old_stream.read( &payload[0], payload.size() );
+            uint64_t trailer = 0;
+            old_stream.seekg( pos + h.entry_size() - sizeof(trailer) );
+            old_stream.read( (char*)&trailer, sizeof(trailer) );
+            if( trailer != pos ) {
+               elog( "Block log chunk at ${pos} was not properly committed", ("pos", pos) );
+               break;
+            }
+            try {
+               c.raw = fc::zlib_decompress( payload );
+            } catch( ... ) {
+            }
+            if( !c.valid() ) {
+               elog( "Block log chunk at ${pos} could not be inflated", ("pos", pos) );
+               break;
+            }
+
+            uint32_t keep = 0;
+            bool linked = true;
+            for( uint32_t n = h.first_block_num; n <= h.last_block_num() && !stop; ++n ) {
+               auto b = c.block( n );
+               signed_block_header bh;
+               try {
+                  fc::datastream<const char*> ds( b.first, b.second );
+                  fc::raw::unpack( ds, bh );
+               } catch( ... ) {
+                  linked = false;
+                  break;
+               }
+               if( bh.block_num() != n || (n > first_block_num && bh.previous != previous) ) {
+                  elog( "Block ${num} does not link back to previous block ${previous}", ("num", n)("previous", previous) );
+                  linked = false;
+                  break;
+               }
+               previous = bh.id();
+               ++keep;
+               stop = n == truncate_at_block;
+            }
+
+            if( keep == h.block_count ) {
+               chunk_header compacted = h;
+               compacted.slot_size = compacted.payload_size;
+               new_stream.write( (char*)&compacted, sizeof(compacted) );
+               new_stream.write( payload.data(), payload.size() );
+               new_stream.write( (char*)&new_pos, sizeof(new_pos) );
+               new_pos += compacted.entry_size();
+               block_num = h.last_block_num();
+            } else if( h.flags & chunk_header::pruned ) {
+               // only the headers of a pruned chunk remain, they cannot be kept as pending blocks
+               elog( "Dropping the pruned blocks ${first} to ${last}", ("first", h.first_block_num)("last", h.last_block_num()) );
+               break;
+            } else {
+               for( uint32_t n = h.first_block_num; n < h.first_block_num + keep; ++n ) {
+                  auto b = c.block( n );
+                  tail.emplace_back( b.first, b.first + b.second );
+               }
+               block_num = h.first_block_num + keep - 1;
+            }
+            if( !linked )
+               break;
+            pos += h.entry_size();
+         }
+
+         bool complete = pos == end_pos;
+         auto old_pending = backup_dir / "blocks.pending";
+         if( complete && !stop && fc::exists( old_pending ) ) {
+            vector<vector<char>> pending;
+            read_pending_entries( old_pending, block_num, pending );
+            for( auto& b : pending ) {
+               signed_block_header bh;
+               fc::datastream<const char*> ds( b.data(), b.size() );
+               fc::raw::unpack( ds, bh );
+               if( block_num >= first_block_num && bh.previous != previous )
+                  break;
+               previous = bh.id();
+               block_num = bh.block_num();
+               tail.emplace_back( std::move(b) );
+               if( block_num == truncate_at_block )
+                  break;
+            }
+         }
+
+         if( !tail.empty() ) {
+            std::fstream pending_stream( (blocks_dir / "blocks.pending").generic_string().c_str(), LOG_WRITE );
+            for( const auto& b : tail )
+               write_pending_entry( pending_stream, b );
+         }
+
+         if( block_num == truncate_at_block )
+            ilog( "Stopped recovery of block log early at specified block number: ${stop}.", ("stop", truncate_at_block) );
+         else if( !complete )
+            ilog( "Recovered only up to block number ${num}. The block log is damaged after it.", ("num", block_num) );
+         else
+            ilog( "Recovered the block log up to block number ${num}.", ("num", block_num) );
+      }
    }
 
-   block_log::block_log(const fc::path& data_dir)
+   block_log::block_log(const fc::path& data_dir, const block_log_config& cfg)
    :my(new detail::block_log_impl()) {
-      my->block_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
-      my->index_stream.exceptions(std::fstream::failbit | std::fstream::badbit);
+      my->cfg = cfg;
       open(data_dir);
    }
 
@@ -83,244 +1557,60 @@ namespace besio { namespace chain {
    }
 
    void block_log::open(const fc::path& data_dir) {
-      if (my->block_stream.is_open())
-         my->block_stream.close();
-      if (my->index_stream.is_open())
-         my->index_stream.close();
-
-      if (!fc::is_directory(data_dir))
-         fc::create_directories(data_dir);
-      my->block_file = data_dir / "blocks.log";
-      my->index_file = data_dir / "blocks.index";
-
-      //ilog("Opening block log at ${path}", ("path", my->block_file.generic_string()));
-      my->block_stream.open(my->block_file.generic_string().c_str(), LOG_WRITE);
-      my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
-      my->block_write = true;
-      my->index_write = true;
-
-      /* On startup of the block log, there are several states the log file and the index file can be
-       * in relation to each other.
-       *
-       *                          Block Log
-       *                     Exists       Is New
-       *                 +------------+------------+
-       *          Exists |    Check   |   Delete   |
-       *   Index         |    Head    |    Index   |
-       *    File         +------------+------------+
-       *          Is New |   Replay   |     Do     |
-       *                 |    Log     |   Nothing  |
-       *                 +------------+------------+
-       *
-       * Checking the heads of the files has several conditions as well.
-       *  - If they are the same, do nothing.
-       *  - If the index file head is not in the log file, delete the index and replay.
-       *  - If the index file head is in the log, but not up to date, replay from index head.
-       */
-      auto log_size = fc::file_size(my->block_file);
-      auto index_size = fc::file_size(my->index_file);
-
-      if (log_size) {
-         ilog("Log is nonempty");
-         my->check_block_read();
-         my->block_stream.seekg( 0 );
-         uint32_t version = 0;
-         my->block_stream.read( (char*)&version, sizeof(version) );
-         BES_ASSERT( version > 0, block_log_exception, "Block log was not setup properly with genesis information." );
-         BES_ASSERT( version == block_log::supported_version, block_log_unsupported_version,
-                    "Unsupported version of block log. Block log version is ${version} while code supports version ${supported}",
-                    ("version", version)("supported", block_log::supported_version) );
-
-         my->genesis_written_to_block_log = true; // Assume it was constructed properly.
-         my->head = read_head();
-         my->head_id = my->head->id();
-
-         if (index_size) {
-            my->check_block_read();
-            my->check_index_read();
-
-            ilog("Index is nonempty");
-            uint64_t block_pos;
-            my->block_stream.seekg(-sizeof(uint64_t), std::ios::end);
-            my->block_stream.read((char*)&block_pos, sizeof(block_pos));
-
-            uint64_t index_pos;
-            my->index_stream.seekg(-sizeof(uint64_t), std::ios::end);
-            my->index_stream.read((char*)&index_pos, sizeof(index_pos));
-
-            if (block_pos < index_pos) {
-               ilog("block_pos < index_pos, close and reopen index_stream");
-               construct_index();
-            } else if (block_pos > index_pos) {
-               ilog("Index is incomplete");
-               construct_index();
-            }
-         } else {
-            ilog("Index is empty");
-            construct_index();
-         }
-      } else if (index_size) {
-         ilog("Index is nonempty, remove and recreate it");
-         my->index_stream.close();
-         fc::remove_all(my->index_file);
-         my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
-         my->index_write = true;
-      }
+      my->open(data_dir);
    }
 
    uint64_t block_log::append(const signed_block_ptr& b) {
       try {
-         BES_ASSERT( my->genesis_written_to_block_log, block_log_append_fail, "Cannot append to block log until the genesis is first written" );
-
-         my->check_block_write();
-         my->check_index_write();
-
-         uint64_t pos = my->block_stream.tellp();
-         BES_ASSERT(my->index_stream.tellp() == sizeof(uint64_t) * (b->block_num() - 1),
-                   block_log_append_fail,
-                   "Append to index file occuring at wrong position.",
-                   ("position", (uint64_t) my->index_stream.tellp())
-                   ("expected", (b->block_num() - 1) * sizeof(uint64_t)));
-         auto data = fc::raw::pack(*b);
-         my->block_stream.write(data.data(), data.size());
-         my->block_stream.write((char*)&pos, sizeof(pos));
-         my->index_stream.write((char*)&pos, sizeof(pos));
-         my->head = b;
-         my->head_id = b->id();
-
-         flush();
-
-         return pos;
+         return my->append(b);
       }
       FC_LOG_AND_RETHROW()
    }
 
    void block_log::flush() {
-      my->block_stream.flush();
-      my->index_stream.flush();
+      my->active.flush();
    }
 
    uint64_t block_log::reset_to_genesis( const genesis_state& gs, const signed_block_ptr& genesis_block ) {
-      if( my->block_stream.is_open() )
-         my->block_stream.close();
-      if( my->index_stream.is_open() )
-         my->index_stream.close();
-
-      fc::remove_all( my->block_file );
-      fc::remove_all( my->index_file );
-
-      my->block_stream.open(my->block_file.generic_string().c_str(), LOG_WRITE);
-      my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
-      my->block_write = true;
-      my->index_write = true;
-
-      auto data = fc::raw::pack( gs );
-      uint32_t version = 0; // version of 0 is invalid; it indicates that the genesis was not properly written to the block log
-      my->block_stream.write( (char*)&version, sizeof(version) );
-      my->block_stream.write( data.data(), data.size() );
-      my->genesis_written_to_block_log = true;
-
-      auto ret = append( genesis_block );
-
-      auto pos = my->block_stream.tellp();
-
-      my->block_stream.close();
-      my->block_stream.open(my->block_file.generic_string().c_str(), std::ios::in | std::ios::out | std::ios::binary ); // Bypass append-only writing just once
-
-      static_assert( block_log::supported_version > 0, "a version number of zero is not supported" );
-      version = block_log::supported_version;
-      my->block_stream.seekp( 0 );
-      my->block_stream.write( (char*)&version, sizeof(version) ); // Finally write actual version to disk.
-      my->block_stream.seekp( pos );
-      flush();
-
-      my->block_write = false;
-      my->check_block_write(); // Reset to append-only writing.
-
-      return ret;
+      return my->reset_to_genesis( gs, genesis_block );
    }
 
    std::pair<signed_block_ptr, uint64_t> block_log::read_block(uint64_t pos)const {
-      my->check_block_read();
-
-      my->block_stream.seekg(pos);
-      std::pair<signed_block_ptr,uint64_t> result;
-      result.first = std::make_shared<signed_block>();
-      fc::raw::unpack(my->block_stream, *result.first);
-      result.second = uint64_t(my->block_stream.tellg()) + 8;
-      return result;
+      return my->active.read_block(pos);
    }
 
    signed_block_ptr block_log::read_block_by_num(uint32_t block_num)const {
       try {
-         signed_block_ptr b;
-         uint64_t pos = get_block_pos(block_num);
-         if (pos != npos) {
-            b = read_block(pos).first;
-            BES_ASSERT(b->block_num() == block_num, reversible_blocks_exception,
-                      "Wrong block was read from block log.", ("returned", b->block_num())("expected", block_num));
-         }
-         return b;
+         auto log = my->log_for(block_num);
+         return log ? log->read_block_by_num(block_num) : signed_block_ptr();
       } FC_LOG_AND_RETHROW()
    }
 
-   uint64_t block_log::get_block_pos(uint32_t block_num) const {
-      my->check_index_read();
-
-      if (!(my->head && block_num <= block_header::num_from_id(my->head_id) && block_num > 0))
-         return npos;
-      my->index_stream.seekg(sizeof(uint64_t) * (block_num - 1));
-      uint64_t pos;
-      my->index_stream.read((char*)&pos, sizeof(pos));
-      return pos;
+   std::pair<const char*, size_t> block_log::read_serialized_block_by_num(uint32_t block_num)const {
+      auto log = my->log_for(block_num);
+      return log ? log->read_serialized_block_by_num(block_num) : std::pair<const char*, size_t>{nullptr, 0};
    }
 
-   signed_block_ptr block_log::read_head()const {
-      my->check_block_read();
-
-      uint64_t pos;
+   optional<signed_block_header> block_log::read_block_header_by_num(uint32_t block_num)const {
+      auto log = my->log_for(block_num);
+      return log ? log->read_block_header_by_num(block_num) : optional<signed_block_header>();
+   }
 
-      // Check that the file is not empty
-      my->block_stream.seekg(0, std::ios::end);
-      if (my->block_stream.tellg() <= sizeof(pos))
-         return {};
+   uint64_t block_log::get_block_pos(uint32_t block_num) const {
+      auto log = my->log_for(block_num);
+      return log ? log->get_block_pos(block_num) : npos;
+   }
 
-      my->block_stream.seekg(-sizeof(pos), std::ios::end);
-      my->block_stream.read((char*)&pos, sizeof(pos));
-      return read_block(pos).first;
+   signed_block_ptr block_log::read_head()const {
+      if (my->active.head || my->segments.empty())
+         return my->active.read_head();
+      return my->segment_log( my->segments.back() ).read_head();
    }
 
    const signed_block_ptr& block_log::head()const {
       return my->head;
    }
 
-   void block_log::construct_index() {
-      ilog("Reconstructing Block Log Index...");
-      my->index_stream.close();
-      fc::remove_all(my->index_file);
-      my->index_stream.open(my->index_file.generic_string().c_str(), LOG_WRITE);
-      my->index_write = true;
-
-      uint64_t end_pos;
-      my->check_block_read();
-
-      my->block_stream.seekg(-sizeof( uint64_t), std::ios::end);
-      my->block_stream.read((char*)&end_pos, sizeof(end_pos));
-      signed_block tmp;
-
-      uint64_t pos = 4; // Skip version which should have already been checked.
-      my->block_stream.seekg(pos);
-
-      genesis_state gs;
-      fc::raw::unpack(my->block_stream, gs);
-
-      while( pos < end_pos ) {
-         fc::raw::unpack(my->block_stream, tmp);
-         my->block_stream.read((char*)&pos, sizeof(pos));
-         my->index_stream.write((char*)&pos, sizeof(pos));
-      }
-   } // construct_index
-
    fc::path block_log::repair_log( const fc::path& data_dir, uint32_t truncate_at_block ) {
       ilog("Recovering Block Log...");
       BES_ASSERT( fc::is_directory(data_dir) && fc::is_regular_file(data_dir / "blocks.log"), block_log_not_found,
@@ -341,12 +1631,33 @@ namespace besio { namespace chain {
                  "Cannot move existing blocks directory to already existing directory '${new_blocks_dir}'",
                  ("new_blocks_dir", backup_dir) );
 
+      // finish any prune that was interrupted, so that no chunk is copied half rewritten
+      vector<fc::path> interrupted;
+      for( fc::directory_iterator itr( data_dir ), end; itr != end; ++itr ) {
+         auto name = (*itr).filename().generic_string();
+         if( name.size() > 6 && name.compare( name.size() - 6, 6, ".prune" ) == 0 && fc::exists( data_dir / name.substr( 0, name.size() - 6 ) ) )
+            interrupted.push_back( data_dir / name.substr( 0, name.size() - 6 ) );
+      }
+      for( const auto& block_file : interrupted )
+         detail::apply_prune_journal( block_file );
+
       fc::rename( blocks_dir, backup_dir );
       ilog( "Moved existing blocks directory to backup location: '${new_blocks_dir}'", ("new_blocks_dir", backup_dir) );
 
       fc::create_directories(blocks_dir);
       auto block_log_path = blocks_dir / "blocks.log";
 
+      // only blocks.log is repaired; sealed segments of a rotating block log and their archive are moved back as they are
+      for( fc::directory_iterator itr( backup_dir ), end; itr != end; ++itr ) {
+         auto name = (*itr).filename().generic_string();
+         uint32_t first = 0, last = 0;
+         if( detail::parse_segment_name( name, first, last ) ||
+             (name.size() > 6 && name.compare( name.size() - 6, 6, ".index" ) == 0 && name != "blocks.index") ||
+             (fc::is_directory( *itr ) && name != config::reversible_blocks_dir_name) ) {
+            fc::rename( *itr, blocks_dir / name );
+         }
+      }
+
       ilog( "Reconstructing '${new_block_log}' from backed up block log", ("new_block_log", block_log_path) );
 
       std::fstream  old_block_stream;
@@ -362,21 +1673,33 @@ namespace besio { namespace chain {
       uint32_t version = 0;
       old_block_stream.read( (char*)&version, sizeof(version) );
       BES_ASSERT( version > 0, block_log_exception, "Block log was not setup properly with genesis information." );
-      BES_ASSERT( version == block_log::supported_version, block_log_unsupported_version,
+      BES_ASSERT( version == block_log::supported_version || version == block_log::chunked_version,
+                 block_log_unsupported_version,
                  "Unsupported version of block log. Block log version is ${version} while code supports version ${supported}",
                  ("version", version)("supported", block_log::supported_version) );
 
+      uint32_t first_block_num = 1, chunk_blocks = 0;
+      if( version == block_log::chunked_version ) {
+         old_block_stream.read( (char*)&first_block_num, sizeof(first_block_num) );
+         old_block_stream.read( (char*)&chunk_blocks, sizeof(chunk_blocks) );
+      }
+      if( truncate_at_block && truncate_at_block < first_block_num )
+         wlog( "Block ${stop} is in a sealed block log segment, which cannot be truncated", ("stop", truncate_at_block) );
+      if( chunk_blocks ) {
+         detail::repair_chunked_log( old_block_stream, end_pos, new_block_stream, first_block_num, chunk_blocks,
+                                     backup_dir, blocks_dir, truncate_at_block );
+         return backup_dir;
+      }
+
       genesis_state gs;
       fc::raw::unpack(old_block_stream, gs);
 
-      auto data = fc::raw::pack( gs );
-      new_block_stream.write( (char*)&version, sizeof(version) );
-      new_block_stream.write( data.data(), data.size() );
+      detail::write_log_header( new_block_stream, version, first_block_num, chunk_blocks, fc::raw::pack( gs ) );
 
       std::exception_ptr     except_ptr;
       vector<char>           incomplete_block_data;
       optional<signed_block> bad_block;
-      uint32_t               block_num = 0;
+      uint32_t               block_num = first_block_num - 1;
 
       block_id_type previous;
 
@@ -394,12 +1717,14 @@ namespace besio { namespace chain {
          }
 
          auto id = tmp.id();
-         if( block_header::num_from_id(previous) + 1 != block_header::num_from_id(id) ) {
+         // the first block of a later segment of a rotating block log links back into the segment before it
+         bool links_to_segment = first_block_num > 1 && block_num < first_block_num;
+         if( !links_to_segment && block_header::num_from_id(previous) + 1 != block_header::num_from_id(id) ) {
             elog( "Block ${num} (${id}) skips blocks. Previous block in block log is block ${prev_num} (${previous})",
                   ("num", block_header::num_from_id(id))("id", id)
                   ("prev_num", block_header::num_from_id(previous))("previous", previous) );
          }
-         if( previous != tmp.previous ) {
+         if( !links_to_segment && previous != tmp.previous ) {
             elog( "Block ${num} (${id}) does not link back to previous block. "
                   "Expected previous: ${expected}. Actual previous: ${actual}.",
                   ("num", block_header::num_from_id(id))("id", id)("expected", previous)("actual", tmp.previous) );
@@ -473,9 +1798,12 @@ namespace besio { namespace chain {
       uint32_t version = 0;
       block_stream.read( (char*)&version, sizeof(version) );
       BES_ASSERT( version > 0, block_log_exception, "Block log was not setup properly with genesis information." );
-      BES_ASSERT( version == block_log::supported_version, block_log_unsupported_version,
+      BES_ASSERT( version == block_log::supported_version || version == block_log::chunked_version,
+                 block_log_unsupported_version,
                  "Unsupported version of block log. Block log version is ${version} while code supports version ${supported}",
                  ("version", version)("supported", block_log::supported_version) );
+      if( version == block_log::chunked_version )
+         block_stream.seekg( sizeof(version) + 2 * sizeof(uint32_t) ); // skip the first block number and chunk size
 
       genesis_state gs;
       fc::raw::unpack(block_stream, gs);
@@ -1,5 +1,6 @@
 #include <besio/chain/controller.hpp>
 #include <besio/chain/transaction_context.hpp>
+#include <besio/chain/thread_utils.hpp>
 
 #include <besio/chain/block_log.hpp>
 #include <besio/chain/fork_database.hpp>
@@ -15,17 +16,57 @@
 
 #include <besio/chain/authorization_manager.hpp>
 #include <besio/chain/resource_limits.hpp>
+#include <besio/chain/database_utils.hpp>
 
 #include <chainbase/chainbase.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
 #include <fc/io/json.hpp>
+#include <fc/io/fstream.hpp>
 #include <fc/scoped_exit.hpp>
 
 #include <besio/chain/besio_contract.hpp>
 
+BES_SNAPSHOT_ROW( besio::chain::account_object,
+                  (id)(name)(vm_type)(vm_version)(privileged)(last_code_update)(code_version)(creation_date)(code)(abi) )
+BES_SNAPSHOT_ROW( besio::chain::account_sequence_object,
+                  (id)(name)(recv_sequence)(auth_sequence)(code_sequence)(abi_sequence) )
+BES_SNAPSHOT_ROW( besio::chain::table_id_object, (id)(code)(scope)(table)(payer)(count) )
+BES_SNAPSHOT_ROW( besio::chain::key_value_object, (id)(t_id)(primary_key)(payer)(value) )
+BES_SNAPSHOT_ROW( besio::chain::index64_object, (id)(t_id)(primary_key)(payer)(secondary_key) )
+BES_SNAPSHOT_ROW( besio::chain::index128_object, (id)(t_id)(primary_key)(payer)(secondary_key) )
+BES_SNAPSHOT_ROW( besio::chain::index256_object, (id)(t_id)(primary_key)(payer)(secondary_key) )
+BES_SNAPSHOT_ROW( besio::chain::index_double_object, (id)(t_id)(primary_key)(payer)(secondary_key) )
+BES_SNAPSHOT_ROW( besio::chain::index_long_double_object, (id)(t_id)(primary_key)(payer)(secondary_key) )
+BES_SNAPSHOT_ROW( besio::chain::global_property_object,
+                  (id)(proposed_schedule_block_num)(proposed_schedule)(configuration) )
+BES_SNAPSHOT_ROW( besio::chain::dynamic_global_property_object, (id)(global_action_sequence) )
+BES_SNAPSHOT_ROW( besio::chain::block_summary_object, (id)(block_id) )
+BES_SNAPSHOT_ROW( besio::chain::transaction_object, (id)(expiration)(trx_id) )
+BES_SNAPSHOT_ROW( besio::chain::generated_transaction_object,
+                  (id)(trx_id)(sender)(sender_id)(payer)(delay_until)(expiration)(published)(packed_trx) )
+
 namespace besio { namespace chain {
 
 using resource_limits::resource_limits_manager;
 
+using controller_index_set = index_set<
+   account_index,
+   account_sequence_index,
+   table_id_multi_index,
+   key_value_index,
+   index64_index,
+   index128_index,
+   index256_index,
+   index_double_index,
+   index_long_double_index,
+   global_property_multi_index,
+   dynamic_global_property_multi_index,
+   block_summary_multi_index,
+   transaction_multi_index,
+   generated_transaction_multi_index
+>;
+
 class maybe_session {
    public:
       maybe_session() = default;
@@ -88,6 +129,24 @@ struct pending_state {
    }
 };
 
+const static uint32_t wasm_cache_magic = 0x31435742; ///< "BWC1", bumped whenever the layout of wasmcache.dat changes
+
+struct abi_cache_entry {
+   account_name         account;
+   uint64_t             abi_sequence = 0;
+   abi_serializer_ptr   serializer;
+};
+
+struct by_account;
+/// most recently used entries first
+typedef boost::multi_index_container<
+   abi_cache_entry,
+   indexed_by<
+      bmi::sequenced<>,
+      bmi::hashed_unique< tag<by_account>, member<abi_cache_entry, account_name, &abi_cache_entry::account>, std::hash<account_name> >
+   >
+> abi_cache_index;
+
 struct controller_impl {
    controller&                    self;
    chainbase::database            db;
@@ -103,9 +162,21 @@ struct controller_impl {
    chain_id_type                  chain_id;
    bool                           replaying= false;
    optional<fc::time_point>       replay_head_time;
+
+   /**
+    *  A block of the block log unpacked on the thread pool during replay, along with the metadata of its input
+    *  transactions whose signing keys have already been recovered when authorization is checked.
+    */
+   struct replay_block {
+      signed_block_ptr                  block;
+      vector<transaction_metadata_ptr>  transactions;
+   };
+   const replay_block*            replay_prepared = nullptr; ///< set while replay() pushes a prepared block
    db_read_mode                   read_mode = db_read_mode::SPECULATIVE;
    bool                           in_trx_requiring_checks = false; ///< if true, checks that are normally skipped on replay (e.g. auth checks) cannot be skipped
    optional<fc::microseconds>     subjective_cpu_leeway;
+   boost::asio::thread_pool       thread_pool;
+   abi_cache_index                abi_cache;
 
    typedef pair<scope_name,action_name>                   handler_key;
    map< account_name, map<handler_key, apply_handler> >   apply_handlers;
@@ -127,6 +198,15 @@ struct controller_impl {
       }
 
       if ( read_mode == db_read_mode::SPECULATIVE ) {
+         if( head->trxs.empty() ) {
+            // blocks read back from the fork database spill file come without their transaction metadata
+            for( const auto& receipt : head->block->transactions ) {
+               if( receipt.trx.contains<packed_transaction>() ) {
+                  auto mtrx = std::make_shared<transaction_metadata>( receipt.trx.get<packed_transaction>() );
+                  unapplied_transactions[mtrx->signed_id] = mtrx;
+               }
+            }
+         }
          for( const auto& t : head->trxs )
             unapplied_transactions[t->signed_id] = t;
       }
@@ -136,26 +216,62 @@ struct controller_impl {
    }
 
 
+   /**
+    *  Entries are keyed by account and validated against its abi_sequence. setabi also drops the entry, so an
+    *  abi_sequence that is reused after a fork switch or an aborted block never serves a stale serializer.
+    */
+   abi_serializer_ptr get_abi_serializer( account_name n, const fc::microseconds& max_serialization_time ) {
+      const auto& seq = db.get<account_sequence_object, by_name>( n );
+      auto& idx = abi_cache.get<by_account>();
+      auto itr = idx.find( n );
+      if( itr != idx.end() ) {
+         if( itr->abi_sequence == seq.abi_sequence ) {
+            abi_cache.relocate( abi_cache.begin(), abi_cache.project<0>( itr ) );
+            return itr->serializer;
+         }
+         idx.erase( itr );
+      }
+
+      abi_def abi;
+      if( !abi_serializer::to_abi( db.get<account_object, by_name>( n ).abi, abi ) )
+         return abi_serializer_ptr();
+
+      auto abis = std::make_shared<const abi_serializer>( abi, max_serialization_time );
+      abi_cache.push_front( abi_cache_entry{ n, seq.abi_sequence, abis } );
+      while( abi_cache.size() > conf.abi_cache_size )
+         abi_cache.pop_back();
+      return abis;
+   }
+
    void set_apply_handler( account_name receiver, account_name contract, action_name action, apply_handler v ) {
       apply_handlers[receiver][make_pair(contract,action)] = v;
    }
 
+   static database::map_options state_map_options( const controller::config& cfg ) {
+      database::map_options options;
+      options.hugepage_dir = cfg.state_hugepage_dir;
+      options.numa_node = cfg.state_numa_node;
+      return options;
+   }
+
    controller_impl( const controller::config& cfg, controller& s  )
    :self(s),
     db( cfg.state_dir,
         cfg.read_only ? database::read_only : database::read_write,
-        cfg.state_size ),
+        cfg.state_size, false, state_map_options( cfg ) ),
     reversible_blocks( cfg.blocks_dir/config::reversible_blocks_dir_name,
         cfg.read_only ? database::read_only : database::read_write,
         cfg.reversible_cache_size ),
-    blog( cfg.blocks_dir ),
-    fork_db( cfg.state_dir ),
-    wasmif( cfg.wasm_runtime ),
+    blog( cfg.blocks_dir, block_log_config{ cfg.block_log_chunk_blocks, cfg.block_log_prune_blocks,
+                                            cfg.block_log_segment_blocks, cfg.block_log_archive_dir } ),
+    fork_db( cfg.state_dir, cfg.fork_db_memory_budget ),
+    wasmif( cfg.wasm_runtime, cfg.wasm_cache_size, cfg.wasm_tiered_compile ),
     resource_limits( db ),
     authorization( s, db ),
     conf( cfg ),
     chain_id( cfg.genesis.compute_chain_id() ),
-    read_mode( cfg.read_mode )
+    read_mode( cfg.read_mode ),
+    thread_pool( cfg.thread_pool_size )
    {
 
 #define SET_APP_HANDLER( receiver, contract, action) \
@@ -244,52 +360,181 @@ struct controller_impl {
       emit( self.irreversible_block, s );
    }
 
-   void init() {
+   /**
+    *  Blocks of the block log up to conf.trusted_replay_block_num are replayed in trusted mode: their signatures,
+    *  authorizations and merkle roots are not checked, only that each block id matches the applied block.
+    */
+   bool trusted_block( uint32_t block_num, controller::block_status s )const {
+      return replaying && s == controller::block_status::irreversible && block_num <= conf.trusted_replay_block_num;
+   }
+
+   /**
+    *  Writes the state at head to conf.replay_checkpoint_file so that an interrupted replay can resume from it
+    *  by loading it as a snapshot. The file is replaced atomically.
+    */
+   void write_replay_checkpoint() {
+      auto start = fc::time_point::now();
+      fc::path temp_file = conf.replay_checkpoint_file.generic_string() + ".tmp";
+      {
+         std::ofstream out( temp_file.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc );
+         snapshot_writer writer( out, chain_id );
+         add_to_snapshot( writer );
+         writer.finalize();
+      }
+      fc::rename( temp_file, conf.replay_checkpoint_file );
+      ilog( "wrote replay checkpoint at block ${n} in ${ms} ms",
+            ("n", head->block_num)("ms", (fc::time_point::now() - start).count() / 1000) );
+   }
+
+   static replay_block prepare_replay_block( const vector<char>& serialized, bool recover_keys, const chain_id_type& chain_id ) {
+      replay_block r;
+      r.block = std::make_shared<signed_block>();
+      fc::datastream<const char*> ds( serialized.data(), serialized.size() );
+      fc::raw::unpack( ds, *r.block );
+
+      r.transactions.reserve( r.block->transactions.size() );
+      for( const auto& receipt : r.block->transactions ) {
+         if( receipt.trx.contains<packed_transaction>() ) {
+            auto mtrx = std::make_shared<transaction_metadata>( receipt.trx.get<packed_transaction>() );
+            if( recover_keys )
+               mtrx->recover_keys( chain_id );
+            r.transactions.emplace_back( std::move(mtrx) );
+         }
+      }
+      return r;
+   }
+
+   /**
+    *  Applies the blocks of the block log past the current head as irreversible blocks, followed by any blocks
+    *  left in the reversible block database.
+    *
+    *  Irreversible blocks are replayed through a pipeline: the main thread copies up to conf.replay_read_ahead
+    *  serialized blocks out of the block log and the thread pool unpacks them, hashes their transactions and,
+    *  when authorization is not skipped, recovers the signing keys. The main thread then only applies them.
+    */
+   void replay() {
+      auto blog_head = blog.read_head();
+      if( !blog_head )
+         return;
+
+      auto start_block_num = head->block_num;
+      auto last_block_num = blog_head->block_num();
+      replaying = true;
+      replay_head_time = blog_head->timestamp.to_time_point();
+      ilog( "existing block log, attempting to replay from ${s} to ${n} blocks",
+            ("s", start_block_num + 1)("n", last_block_num) );
+
+      if( conf.trusted_replay_block_num > start_block_num )
+         ilog( "replaying blocks up to ${n} in trusted mode", ("n", std::min(conf.trusted_replay_block_num, last_block_num)) );
+
+      std::deque<std::future<replay_block>> read_ahead;
+      uint32_t next_read = start_block_num + 1;
+      auto fill_read_ahead = [&]() {
+         while( next_read <= last_block_num && read_ahead.size() < conf.replay_read_ahead ) {
+            auto serialized = blog.read_serialized_block_by_num( next_read );
+            BES_ASSERT( serialized.first, block_log_exception, "block ${n} is missing from the block log", ("n", next_read) );
+            vector<char> data( serialized.first, serialized.first + serialized.second );
+            // irreversible blocks only need their signing keys when all checks are forced, see skip_auth_check()
+            bool recover_keys = conf.force_all_checks && next_read > conf.trusted_replay_block_num;
+            read_ahead.emplace_back( async_thread_pool( thread_pool, [data = std::move(data), recover_keys, cid = chain_id]() {
+               return prepare_replay_block( data, recover_keys, cid );
+            } ) );
+            ++next_read;
+         }
+      };
+
+      auto start = fc::time_point::now();
+      auto report_time = start;
+      uint32_t report_block_num = start_block_num;
+      fc::microseconds waited;
+      try {
+         fill_read_ahead();
+         while( !read_ahead.empty() ) {
+            auto wait_start = fc::time_point::now();
+            auto prepared = read_ahead.front().get();
+            waited += fc::time_point::now() - wait_start;
+            read_ahead.pop_front();
+            fill_read_ahead();
+
+            replay_prepared = &prepared;
+            auto reset_prepared = fc::make_scoped_exit( [this]() { replay_prepared = nullptr; } );
+            self.push_block( prepared.block, controller::block_status::irreversible );
+
+            if( conf.replay_checkpoint_interval && conf.replay_checkpoint_file != fc::path()
+                && head->block_num % conf.replay_checkpoint_interval == 0 && head->block_num < last_block_num ) {
+               write_replay_checkpoint();
+            }
+
+            if( head->block_num % 100 == 0 ) {
+               auto now = fc::time_point::now();
+               if( now - report_time >= fc::seconds(5) ) {
+                  auto bps = (head->block_num - report_block_num) * 1000000.0 / (now - report_time).count();
+                  std::cerr << std::setw(10) << head->block_num << " of " << last_block_num
+                            << " (" << std::setw(8) << std::fixed << std::setprecision(1) << bps << " blocks/s)\r";
+                  report_time = now;
+                  report_block_num = head->block_num;
+               }
+            }
+         }
+      } catch( ... ) {
+         // the pool threads still reference the pending blocks through their futures
+         for( auto& f : read_ahead ) f.wait();
+         replaying = false;
+         replay_head_time.reset();
+         throw;
+      }
+      std::cerr<< "\n";
+      ilog( "${n} blocks replayed, main thread waited ${w} ms for blocks to be prepared",
+            ("n", head->block_num - start_block_num)("w", waited.count() / 1000) );
+
+      // the replay is complete so there is nothing left to resume
+      if( conf.replay_checkpoint_file != fc::path() && fc::exists( conf.replay_checkpoint_file ) )
+         fc::remove( conf.replay_checkpoint_file );
+
+      // the irreverible log is played without undo sessions enabled, so we need to sync the
+      // revision ordinal to the appropriate expected value here.
+      db.set_revision(head->block_num);
+
+      int rev = 0;
+      while( auto obj = reversible_blocks.find<reversible_block_object,by_num>(head->block_num+1) ) {
+         ++rev;
+         self.push_block( obj->get_block(), controller::block_status::validated );
+      }
+
+      ilog( "${n} reversible blocks replayed", ("n",rev) );
+      auto end = fc::time_point::now();
+      auto replayed = std::max<uint32_t>( head->block_num - start_block_num, 1 );
+      ilog( "replayed ${n} blocks in ${duration} seconds, ${mspb} ms/block",
+            ("n", head->block_num - start_block_num)("duration", (end-start).count()/1000000)
+            ("mspb", ((end-start).count()/1000.0)/replayed)        );
+      replaying = false;
+      replay_head_time.reset();
+   }
+
+   void init( const std::shared_ptr<snapshot_reader>& snapshot ) {
 
       /**
       *  The fork database needs an initial block_state to be set before
       *  it can accept any new blocks. This initial block state can be found
-      *  in the database (whose head block state should be irreversible) or
-      *  it would be the genesis state.
+      *  in the database (whose head block state should be irreversible),
+      *  in a snapshot, or it would be the genesis state.
       */
-      if( !head ) {
+      if( snapshot ) {
+         BES_ASSERT( !head, fork_database_exception,
+                     "a snapshot can only be loaded into an empty state directory" );
+         ilog( "loading state from snapshot" );
+         auto start = fc::time_point::now();
+         read_from_snapshot( *snapshot );
+         ilog( "loaded snapshot of block ${n} (${bytes} bytes) in ${ms} ms",
+               ("n", head->block_num)("bytes", snapshot->size())("ms", (fc::time_point::now() - start).count() / 1000) );
+
+         replay();
+      } else if( !head ) {
          initialize_fork_db(); // set head to genesis state
 
          auto end = blog.read_head();
          if( end && end->block_num() > 1 ) {
-            auto end_time = end->timestamp.to_time_point();
-            replaying = true;
-            replay_head_time = end_time;
-            ilog( "existing block log, attempting to replay ${n} blocks", ("n",end->block_num()) );
-
-            auto start = fc::time_point::now();
-            while( auto next = blog.read_block_by_num( head->block_num + 1 ) ) {
-               self.push_block( next, controller::block_status::irreversible );
-               if( next->block_num() % 100 == 0 ) {
-                  std::cerr << std::setw(10) << next->block_num() << " of " << end->block_num() <<"\r";
-               }
-            }
-            std::cerr<< "\n";
-            ilog( "${n} blocks replayed", ("n", head->block_num) );
-
-            // the irreverible log is played without undo sessions enabled, so we need to sync the
-            // revision ordinal to the appropriate expected value here.
-            db.set_revision(head->block_num);
-
-            int rev = 0;
-            while( auto obj = reversible_blocks.find<reversible_block_object,by_num>(head->block_num+1) ) {
-               ++rev;
-               self.push_block( obj->get_block(), controller::block_status::validated );
-            }
-
-            ilog( "${n} reversible blocks replayed", ("n",rev) );
-            auto end = fc::time_point::now();
-            ilog( "replayed ${n} blocks in ${duration} seconds, ${mspb} ms/block",
-                  ("n", head->block_num)("duration", (end-start).count()/1000000)
-                  ("mspb", ((end-start).count()/1000.0)/head->block_num)        );
-            replaying = false;
-            replay_head_time.reset();
-
+            replay();
          } else if( !end ) {
             blog.reset_to_genesis( conf.genesis, head->block );
          }
@@ -323,36 +568,130 @@ struct controller_impl {
    }
 
    ~controller_impl() {
+      thread_pool.stop();
+      thread_pool.join();
+
       pending.reset();
 
-      db.flush();
+      // a read only node leaves the state directory as it found it
+      if( !conf.read_only ) {
+         try {
+            write_wasm_cache_index();
+         } FC_LOG_AND_DROP()
+      }
+
+      // the state database is written back, once, as it closes; flushing it here as well would copy a hugepage
+      // backed database back to shared_memory.bin twice
       reversible_blocks.flush();
    }
 
-   void add_indices() {
-      reversible_blocks.add_index<reversible_block_index>();
+   /**
+    *  WAVM output embeds the addresses of the memory, tables and intrinsics of the process that compiled it, so
+    *  the compiled modules themselves cannot be persisted. Instead the contracts held in the instantiation cache
+    *  at shutdown are recorded and compiled again on a background thread during startup, so that the compile
+    *  stall is mostly paid before the node starts applying blocks rather than on the first action sent to each
+    *  popular contract.
+    */
+   void write_wasm_cache_index() {
+      auto modules = wasmif.get_cached_modules();
+      if( modules.empty() ) return;
+
+      auto wasm_cache_dat = conf.state_dir / config::wasm_cache_filename;
+      std::ofstream out( wasm_cache_dat.generic_string().c_str(), std::ios::out | std::ios::binary | std::ofstream::trunc );
+      fc::raw::pack( out, wasm_cache_magic );
+      fc::raw::pack( out, conf.wasm_runtime );
+      fc::raw::pack( out, modules );
+   }
 
-      db.add_index<account_index>();
-      db.add_index<account_sequence_index>();
+   void warm_wasm_cache() {
+      auto wasm_cache_dat = conf.state_dir / config::wasm_cache_filename;
+      if( !fc::exists( wasm_cache_dat ) ) return;
 
-      db.add_index<table_id_multi_index>();
-      db.add_index<key_value_index>();
-      db.add_index<index64_index>();
-      db.add_index<index128_index>();
-      db.add_index<index256_index>();
-      db.add_index<index_double_index>();
-      db.add_index<index_long_double_index>();
+      string content;
+      fc::read_file_contents( wasm_cache_dat, content );
+      if( !conf.read_only )
+         fc::remove( wasm_cache_dat );
 
-      db.add_index<global_property_multi_index>();
-      db.add_index<dynamic_global_property_multi_index>();
-      db.add_index<block_summary_multi_index>();
-      db.add_index<transaction_multi_index>();
-      db.add_index<generated_transaction_multi_index>();
+      vector<pair<account_name, digest_type>> modules;
+      try {
+         fc::datastream<const char*> ds( content.data(), content.size() );
+         uint32_t magic = 0;
+         fc::raw::unpack( ds, magic );
+         wasm_interface::vm_type runtime;
+         fc::raw::unpack( ds, runtime );
+         if( magic != wasm_cache_magic || runtime != conf.wasm_runtime ) {
+            ilog( "ignoring ${f} written by a different wasm runtime", ("f", wasm_cache_dat.generic_string()) );
+            return;
+         }
+         fc::raw::unpack( ds, modules );
+      } catch( const fc::exception& e ) {
+         wlog( "unable to read ${f}: ${e}", ("f", wasm_cache_dat.generic_string())("e", e.to_detail_string()) );
+         return;
+      }
+
+      // only the lookups happen here; the compiles run on the wasm interface's compile thread and a contract whose
+      // compile fails is reported, and compiled again, by the first action that needs it
+      uint32_t queued = 0;
+      for( const auto& m : modules ) {
+         const auto* a = db.find<account_object, by_name>( m.first );
+         // contracts updated by a setcode that never ran before shutdown are left to be instantiated on demand
+         if( !a || a->code_version != m.second || a->code.size() == 0 ) continue;
+         wasmif.warm_up( a->code_version, a->code, a->name );
+         ++queued;
+      }
+      ilog( "compiling ${n} of ${t} cached contracts in the background", ("n", queued)("t", modules.size()) );
+   }
+
+   void add_indices() {
+      reversible_blocks.add_index<reversible_block_index>();
+
+      controller_index_set::add_indices( db );
 
       authorization.add_indices();
       resource_limits.add_indices();
    }
 
+   void add_to_snapshot( snapshot_writer& snapshot )const {
+      snapshot.begin_section( "besio::chain::block_header_state", 1 );
+      snapshot.add_row( static_cast<const block_header_state&>( *head ) );
+      snapshot.end_section();
+
+      controller_index_set::add_to_snapshot( db, snapshot );
+      authorization.add_to_snapshot( snapshot );
+      resource_limits.add_to_snapshot( snapshot );
+   }
+
+   /**
+    *  Recreates the state of a snapshot in the empty database and sets head to its block.
+    *  The block log has to already contain that block, because irreversible blocks are appended to it from there.
+    */
+   void read_from_snapshot( snapshot_reader& snapshot ) {
+      BES_ASSERT( snapshot.get_chain_id() == chain_id, snapshot_validation_exception,
+                  "snapshot is of chain ${s} but this node is configured for chain ${c}",
+                  ("s", snapshot.get_chain_id())("c", chain_id) );
+
+      block_header_state head_header_state;
+      auto header = snapshot.begin_section( "besio::chain::block_header_state" );
+      BES_ASSERT( header.row_count == 1, snapshot_exception, "snapshot must contain exactly one head block state" );
+      snapshot.read_row( head_header_state );
+      snapshot.end_section();
+
+      auto head_block = blog.read_block_by_num( head_header_state.block_num );
+      BES_ASSERT( head_block && head_block->id() == head_header_state.id, snapshot_validation_exception,
+                  "snapshot block ${n} (${id}) is not in the block log",
+                  ("n", head_header_state.block_num)("id", head_header_state.id) );
+
+      controller_index_set::read_from_snapshot( db, snapshot );
+      authorization.read_from_snapshot( snapshot );
+      resource_limits.read_from_snapshot( snapshot );
+      snapshot.finalize();
+
+      head = std::make_shared<block_state>( head_header_state );
+      head->block = head_block;
+      fork_db.set( head );
+      db.set_revision( head->block_num );
+   }
+
    void clear_all_undo() {
       // Rewind the database to the last irreversible block
       db.with_write_lock([&] {
@@ -808,10 +1147,8 @@ struct controller_impl {
                                  std::placeholders::_1)*/,
                        false
                );
-               auto onramusagetrx = std::make_shared<transaction_metadata>( get_on_upramusage_transaction(trx->trx.actions[0].authorization[0].actor) );
-               push_transaction( onramusagetrx, fc::time_point::maximum(), true, config::default_min_transaction_cpu_usage );
-     
             }
+
             trx_context.exec();
             trx_context.finalize(); // Automatically rounds up network and CPU usage in trace and bills payers if successful
 
@@ -958,14 +1295,30 @@ struct controller_impl {
          BES_ASSERT( b->block_extensions.size() == 0, block_validate_exception, "no supported extensions" );
          start_block( b->timestamp, b->confirmed, s );
 
+         // recover the signing keys of every input transaction of the block in batches on the thread pool while
+         // the transactions ahead of them are being applied
+         vector<transaction_metadata_ptr> packed_transactions;
+         if( replay_prepared && replay_prepared->block == b ) {
+            packed_transactions = replay_prepared->transactions;
+         } else {
+            packed_transactions.reserve( b->transactions.size() );
+            for( const auto& receipt : b->transactions ) {
+               if( receipt.trx.contains<packed_transaction>() ) {
+                  packed_transactions.emplace_back( std::make_shared<transaction_metadata>( receipt.trx.get<packed_transaction>() ) );
+               }
+            }
+            if( !self.skip_auth_check() ) {
+               transaction_metadata::recover_signing_keys( packed_transactions, thread_pool, chain_id );
+            }
+         }
+
          transaction_trace_ptr trace;
 
+         size_t packed_idx = 0;
          for( const auto& receipt : b->transactions ) {
             auto num_pending_receipts = pending->_pending_block_state->block->transactions.size();
             if( receipt.trx.contains<packed_transaction>() ) {
-               auto& pt = receipt.trx.get<packed_transaction>();
-               auto mtrx = std::make_shared<transaction_metadata>(pt);
-               trace = push_transaction( mtrx, fc::time_point::maximum(), receipt.cpu_usage_us, true );
+               trace = push_transaction( packed_transactions.at( packed_idx++ ), fc::time_point::maximum(), receipt.cpu_usage_us, true );
             } else if( receipt.trx.contains<transaction_id_type>() ) {
                trace = push_scheduled_transaction( receipt.trx.get<transaction_id_type>(), fc::time_point::maximum(), receipt.cpu_usage_us, true );
             } else {
@@ -993,7 +1346,7 @@ struct controller_impl {
                         ("producer_receipt", receipt)("validator_receipt", pending->_pending_block_state->block->transactions.back()) );
          }
 
-         finalize_block();
+         finalize_block( trusted_block( b->block_num(), s ) ? b.get() : nullptr );
 
          // this implicitly asserts that all header fields (less the signature) are identical
          BES_ASSERT(b->id() == pending->_pending_block_state->header.id(),
@@ -1027,7 +1380,8 @@ struct controller_impl {
          BES_ASSERT( b, block_validate_exception, "trying to push empty block" );
          BES_ASSERT( s != controller::block_status::incomplete, block_validate_exception, "invalid block status for a completed block" );
          emit( self.pre_accepted_block, b );
-         bool trust = !conf.force_all_checks && (s == controller::block_status::irreversible || s == controller::block_status::validated);
+         bool trust = ( !conf.force_all_checks && (s == controller::block_status::irreversible || s == controller::block_status::validated) )
+                      || trusted_block( b->block_num(), s );
          auto new_header_state = fork_db.add( b, trust );
          emit( self.accepted_block_header, new_header_state );
          // on replay irreversible is not emitted by fork database, so emit it explicitly here
@@ -1134,7 +1488,7 @@ struct controller_impl {
       for( const auto& a : pending->_actions )
          action_digests.emplace_back( a.digest() );
 
-      pending->_pending_block_state->header.action_mroot = merkle( move(action_digests) );
+      pending->_pending_block_state->header.action_mroot = merkle( move(action_digests), &thread_pool );
    }
 
    void set_trx_merkle() {
@@ -1144,11 +1498,15 @@ struct controller_impl {
       for( const auto& a : trxs )
          trx_digests.emplace_back( a.digest() );
 
-      pending->_pending_block_state->header.transaction_mroot = merkle( move(trx_digests) );
+      pending->_pending_block_state->header.transaction_mroot = merkle( move(trx_digests), &thread_pool );
    }
 
 
-   void finalize_block()
+   /**
+    *  @param trusted_header if given, the merkle roots are taken from this header instead of being computed; only
+    *  used for blocks replayed in trusted mode, where the block id check still covers the rest of the header
+    */
+   void finalize_block( const signed_block_header* trusted_header = nullptr )
    {
       BES_ASSERT(pending, block_validate_exception, "it is not valid to finalize when there is no pending block");
       try {
@@ -1179,8 +1537,13 @@ struct controller_impl {
       );
       resource_limits.process_block_usage(pending->_pending_block_state->block_num);
 
-      set_action_merkle();
-      set_trx_merkle();
+      if( trusted_header ) {
+         pending->_pending_block_state->header.action_mroot = trusted_header->action_mroot;
+         pending->_pending_block_state->header.transaction_mroot = trusted_header->transaction_mroot;
+      } else {
+         set_action_merkle();
+         set_trx_merkle();
+      }
 
       auto p = pending->_pending_block_state;
       p->id = p->header.id();
@@ -1338,24 +1701,6 @@ struct controller_impl {
       trx.expiration = self.pending_block_time() + fc::microseconds(999'999); // Round up to nearest second to avoid appearing expired
       return trx;
    }
-  /**
-    *  At the start of each transaction we notify the system contract with a transaction that passes
-    *  inthe block header of the prior block (which is currently our head block)
-    */
-   signed_transaction get_on_upramusage_transaction(account_name actor)
-   {
-      action on_upramusage_act;
-      on_upramusage_act.account = config::system_account_name;
-      on_upramusage_act.name = N(onramusage);
-      on_upramusage_act.authorization = vector<permission_level>{{actor, config::active_name}};
-      on_upramusage_act.data = fc::raw::pack(actor);
-
-      signed_transaction trx;
-      trx.actions.emplace_back(std::move(on_upramusage_act));
-      trx.set_reference_block(self.head_block_id());
-      trx.expiration = self.pending_block_time() + fc::microseconds(999'999); // Round up to nearest second to avoid appearing expired
-      return trx;
-   }
 
 }; /// controller_impl
 
@@ -1391,22 +1736,30 @@ controller::~controller() {
 }
 
 
-void controller::startup() {
+void controller::startup( const std::shared_ptr<snapshot_reader>& snapshot ) {
 
    // ilog( "${c}", ("c",fc::json::to_pretty_string(cfg)) );
    my->add_indices();
 
    my->head = my->fork_db.head();
-   if( !my->head ) {
+   if( !my->head && !snapshot ) {
       elog( "No head block in fork db, perhaps we need to replay" );
    }
-   my->init();
+   my->init( snapshot );
+   my->warm_wasm_cache();
+}
+
+void controller::write_snapshot( snapshot_writer& snapshot )const {
+   BES_ASSERT( !my->pending, block_validate_exception, "cannot write a snapshot while a block is pending" );
+   my->add_to_snapshot( snapshot );
 }
 
 chainbase::database& controller::db()const { return my->db; }
 
 fork_database& controller::fork_db()const { return my->fork_db; }
 
+boost::asio::thread_pool& controller::get_thread_pool() { return my->thread_pool; }
+
 
 void controller::start_block( block_timestamp_type when, uint16_t confirm_block_count) {
    validate_db_available_size();
@@ -1581,6 +1934,10 @@ signed_block_ptr controller::fetch_block_by_number( uint32_t block_num )const  {
    return my->blog.read_block_by_num(block_num);
 } FC_CAPTURE_AND_RETHROW( (block_num) ) }
 
+std::pair<const char*, size_t> controller::fetch_serialized_block_by_number( uint32_t block_num )const  { try {
+   return my->blog.read_serialized_block_by_num( block_num );
+} FC_CAPTURE_AND_RETHROW( (block_num) ) }
+
 block_state_ptr controller::fetch_block_state_by_id( block_id_type id )const {
    auto state = my->fork_db.get_block(id);
    return state;
@@ -1597,12 +1954,12 @@ block_id_type controller::get_block_id_for_num( uint32_t block_num )const { try
       return blk_state->id;
    }
 
-   auto signed_blk = my->blog.read_block_by_num(block_num);
+   auto header = my->blog.read_block_header_by_num(block_num);
 
-   BES_ASSERT( BOOST_LIKELY( signed_blk != nullptr ), unknown_block_exception,
+   BES_ASSERT( BOOST_LIKELY( header.valid() ), unknown_block_exception,
                "Could not find block: ${block}", ("block", block_num) );
 
-   return signed_blk->id();
+   return header->id();
 } FC_CAPTURE_AND_RETHROW( (block_num) ) }
 
 void controller::pop_block() {
@@ -1680,6 +2037,10 @@ bool controller::light_validation_allowed(bool replay_opts_disabled_by_policy) c
 
    auto pb_status = my->pending->_block_status;
 
+   // replaying a block the node was told to trust
+   if( my->trusted_block( my->pending->_pending_block_state->block_num, pb_status ) )
+      return true;
+
    // in a pending irreversible or previously validated block and we have forcing all checks
    bool consider_skipping_on_replay = (pb_status == block_status::irreversible || pb_status == block_status::validated) && !replay_opts_disabled_by_policy;
 
@@ -1748,6 +2109,19 @@ const account_object& controller::get_account( account_name name )const
    return my->db.get<account_object, by_name>(name);
 } FC_CAPTURE_AND_RETHROW( (name) ) }
 
+abi_serializer_ptr controller::get_abi_serializer( account_name n, const fc::microseconds& max_serialization_time )const {
+   if( n.good() ) {
+      try {
+         return my->get_abi_serializer( n, max_serialization_time );
+      } FC_CAPTURE_AND_LOG((n))
+   }
+   return abi_serializer_ptr();
+}
+
+void controller::invalidate_abi_serializer( account_name n ) {
+   my->abi_cache.get<by_account>().erase( n );
+}
+
 vector<transaction_metadata_ptr> controller::get_unapplied_transactions() const {
    vector<transaction_metadata_ptr> result;
    if ( my->read_mode == db_read_mode::SPECULATIVE ) {
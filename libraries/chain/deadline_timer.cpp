@@ -0,0 +1,120 @@
+/**
+ *  @file
+ *  @copyright defined in bes/LICENSE.txt
+ */
+#include <besio/chain/deadline_timer.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace besio { namespace chain {
+
+   namespace detail {
+
+      /**
+       *  Thread raising the flags of the deadline_timers whose deadlines have passed. The armed timers are kept ordered
+       *  by deadline and the thread sleeps until the earliest of them, or until a timer is armed with an earlier one.
+       */
+      class deadline_timer_service {
+         public:
+            static deadline_timer_service& instance() {
+               static deadline_timer_service service;
+               return service;
+            }
+
+            void start( deadline_timer& t, fc::time_point deadline ) {
+               const auto now = fc::time_point::now();
+               std::lock_guard<std::mutex> g( mtx );
+               disarm( t );
+               if( deadline == fc::time_point::maximum() ) {
+                  t._expired.store( false, std::memory_order_relaxed );
+                  return;
+               }
+               if( now > deadline ) {
+                  t._expired.store( true, std::memory_order_relaxed );
+                  return;
+               }
+               t._expired.store( false, std::memory_order_relaxed );
+               t._armed = true;
+               t._deadline = deadline;
+               auto itr = timers.emplace( deadline, &t ).first;
+               if( itr == timers.begin() )
+                  cv.notify_one();
+            }
+
+            void stop( deadline_timer& t ) {
+               std::lock_guard<std::mutex> g( mtx );
+               disarm( t );
+               t._expired.store( false, std::memory_order_relaxed );
+            }
+
+         private:
+            deadline_timer_service() {
+               thread = std::thread( [this]() { run(); } );
+            }
+
+            ~deadline_timer_service() {
+               {
+                  std::lock_guard<std::mutex> g( mtx );
+                  done = true;
+               }
+               cv.notify_one();
+               thread.join();
+            }
+
+            void disarm( deadline_timer& t ) {
+               if( t._armed ) {
+                  timers.erase( std::make_pair( t._deadline, &t ) );
+                  t._armed = false;
+               }
+            }
+
+            void run() {
+               std::unique_lock<std::mutex> lock( mtx );
+               while( !done ) {
+                  if( timers.empty() ) {
+                     cv.wait( lock );
+                     continue;
+                  }
+                  const auto now = fc::time_point::now();
+                  auto itr = timers.begin();
+                  for( ; itr != timers.end() && now > itr->first; itr = timers.erase( itr ) ) {
+                     itr->second->_armed = false;
+                     itr->second->_expired.store( true, std::memory_order_relaxed );
+                  }
+                  if( itr == timers.end() )
+                     continue;
+                  // sleep past the deadline, the flag is raised once now > deadline just as checktime compares it
+                  auto wait = std::min( itr->first - now, max_wait );
+                  cv.wait_for( lock, std::chrono::microseconds( wait.count() + 1 ) );
+               }
+            }
+
+            /// bounds a single sleep, so far away deadlines are not converted to durations that overflow
+            const fc::microseconds max_wait = fc::seconds( 60 );
+
+            std::mutex                                           mtx;
+            std::condition_variable                              cv;
+            std::set<std::pair<fc::time_point, deadline_timer*>> timers;
+            bool                                                 done = false;
+            std::thread                                          thread;
+      };
+
+   } // detail
+
+   deadline_timer::~deadline_timer() {
+      stop();
+   }
+
+   void deadline_timer::start( fc::time_point deadline ) {
+      detail::deadline_timer_service::instance().start( *this, deadline );
+   }
+
+   void deadline_timer::stop() {
+      detail::deadline_timer_service::instance().stop( *this );
+   }
+
+} } // besio::chain
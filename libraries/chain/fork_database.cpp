@@ -8,6 +8,9 @@
 #include <boost/multi_index/composite_key.hpp>
 #include <fc/io/fstream.hpp>
 #include <fstream>
+#include <limits>
+#include <set>
+#include <unordered_map>
 
 namespace besio { namespace chain {
    using boost::multi_index_container;
@@ -46,15 +49,187 @@ namespace besio { namespace chain {
       fork_multi_index_type index;
       block_state_ptr       head;
       fc::path              datadir;
+
+      /**
+       *  Blocks held in memory are tracked by an estimate of their size. Once they exceed memory_budget the oldest
+       *  states other than the head are appended to the spill file, block and header state alike, and replaced in the
+       *  index by a stub holding only what the index sorts by and what changes after a state is added. The producer
+       *  schedules, producer maps and block root merkle of a spilled state so leave memory with its block; resident
+       *  states keep their own copies, block_header_state being the value type forkdb.dat and snapshots serialize.
+       *
+       *  A stub is filled in again from the spill file the first time it is handed out. The original block_state
+       *  objects are never modified, so anybody still holding one keeps a complete state.
+       *
+       *  Validated or not makes no difference: in IRREVERSIBLE read mode no reversible block is ever validated, and
+       *  those are the blocks that pile up when irreversibility stalls.
+       */
+      struct spilled_block {
+         uint64_t offset = 0;
+         uint32_t size   = 0;
+      };
+
+      uint64_t                                                               memory_budget = 0;
+      uint64_t                                                               resident_bytes = 0;
+      std::unordered_map<block_id_type, uint32_t, std::hash<block_id_type>>  resident;
+      std::set<std::pair<uint32_t, block_id_type>>                           resident_by_num;
+      std::unordered_map<block_id_type, spilled_block, std::hash<block_id_type>> spilled;
+      std::fstream                                                           spill_stream;
+      uint64_t                                                               spill_end = 0;
+      uint64_t                                                               spilled_bytes = 0;
+
+      fc::path spill_file()const { return datadir / config::forkdb_spill_filename; }
+
+      /// what a block takes in memory, dominated by its packed transactions, without serializing it
+      static uint32_t estimated_size( const signed_block& b ) {
+         uint64_t size = sizeof(signed_block);
+         for( const auto& receipt : b.transactions ) {
+            size += sizeof(transaction_receipt);
+            if( receipt.trx.contains<packed_transaction>() ) {
+               const auto& trx = receipt.trx.get<packed_transaction>();
+               size += trx.packed_trx.size() + trx.packed_context_free_data.size() + trx.signatures.size() * sizeof(signature_type);
+            }
+         }
+         return static_cast<uint32_t>( std::min<uint64_t>( size, std::numeric_limits<uint32_t>::max() ) );
+      }
+
+      void track( const block_state_ptr& s ) {
+         if( !memory_budget || !s->block ) return;
+         auto size = estimated_size( *s->block );
+         if( !resident.emplace( s->id, size ).second ) return;
+         resident_by_num.emplace( s->block_num, s->id );
+         resident_bytes += size;
+      }
+
+      void untrack_resident( const block_id_type& id, uint32_t block_num ) {
+         auto itr = resident.find( id );
+         if( itr == resident.end() ) return;
+         resident_bytes -= itr->second;
+         resident_by_num.erase( std::make_pair( block_num, id ) );
+         resident.erase( itr );
+      }
+
+      /// forgets a block leaving the fork database; the spill file is dropped once nothing in it is referenced
+      void untrack( const block_id_type& id, uint32_t block_num ) {
+         untrack_resident( id, block_num );
+         auto itr = spilled.find( id );
+         if( itr == spilled.end() ) return;
+         spilled_bytes -= itr->second.size;
+         spilled.erase( itr );
+         if( spilled.empty() )
+            close_spill();
+         else if( spill_end > 2 * spilled_bytes && spill_end - spilled_bytes > min_spill_garbage )
+            compact_spill();
+      }
+
+      void close_spill() {
+         if( spill_stream.is_open() )
+            spill_stream.close();
+         spill_end = 0;
+         spilled_bytes = 0;
+         if( fc::exists( spill_file() ) )
+            fc::remove( spill_file() );
+      }
+
+      /// rewrites the spill file without the blocks that have left the fork database since they were spilled
+      void compact_spill() {
+         auto tmp = datadir / (string( config::forkdb_spill_filename ) + ".tmp");
+         std::fstream out( tmp.generic_string().c_str(), std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc );
+         out.exceptions( std::fstream::failbit | std::fstream::badbit );
+
+         vector<char> packed;
+         uint64_t end = 0;
+         for( auto& b : spilled ) {
+            packed.resize( b.second.size );
+            spill_stream.seekg( b.second.offset );
+            spill_stream.read( packed.data(), packed.size() );
+            out.write( packed.data(), packed.size() );
+            b.second.offset = end;
+            end += packed.size();
+         }
+
+         spill_stream.close();
+         fc::rename( tmp, spill_file() );
+         spill_stream = std::move( out );
+         spill_end = end;
+      }
+
+      static constexpr uint64_t min_spill_garbage = 64*1024*1024;
+
+      /// the complete state of a stub, as spilled and updated with what changed since
+      block_state read_spilled( const block_state& stub ) {
+         auto itr = spilled.find( stub.id );
+         BES_ASSERT( itr != spilled.end(), fork_database_exception, "block ${id} is neither in memory nor spilled", ("id", stub.id) );
+         vector<char> packed( itr->second.size );
+         spill_stream.seekg( itr->second.offset );
+         spill_stream.read( packed.data(), packed.size() );
+         block_state s;
+         fc::datastream<const char*> ds( packed.data(), packed.size() );
+         fc::raw::unpack( ds, s );
+         s.bft_irreversible_blocknum = stub.bft_irreversible_blocknum;
+         s.validated = stub.validated;
+         s.in_current_chain = stub.in_current_chain;
+         return s;
+      }
+
+      /// fills a stub in again; states handed out by the fork database are always complete
+      const block_state_ptr& load( const block_state_ptr& s ) {
+         if( s && !s->block ) {
+            *s = read_spilled( *s );
+            track( s );
+         }
+         return s;
+      }
+
+      void spill() {
+         if( !memory_budget ) return;
+         for( auto itr = resident_by_num.begin(); itr != resident_by_num.end() && resident_bytes > memory_budget; ) {
+            auto id = (itr++)->second;
+            auto sitr = index.find( id );
+            if( sitr == index.end() || *sitr == head ) continue;
+            const auto& s = *sitr;
+
+            if( !spill_stream.is_open() ) {
+               spill_stream.open( spill_file().generic_string().c_str(),
+                                  std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc );
+               spill_stream.exceptions( std::fstream::failbit | std::fstream::badbit );
+               spill_end = 0;
+            }
+            // a state read back since it was last spilled may have gained confirmations, so it is always written again
+            auto packed = fc::raw::pack( *s );
+            spill_stream.seekp( spill_end );
+            spill_stream.write( packed.data(), packed.size() );
+            auto& entry = spilled[id];
+            spilled_bytes -= entry.size;
+            entry = spilled_block{ spill_end, static_cast<uint32_t>( packed.size() ) };
+            spill_end += packed.size();
+            spilled_bytes += packed.size();
+
+            auto stub = std::make_shared<block_state>();
+            stub->id                         = s->id;
+            stub->block_num                  = s->block_num;
+            stub->header.previous            = s->header.previous;
+            stub->dpos_irreversible_blocknum = s->dpos_irreversible_blocknum;
+            stub->bft_irreversible_blocknum  = s->bft_irreversible_blocknum;
+            stub->validated                  = s->validated;
+            stub->in_current_chain           = s->in_current_chain;
+            untrack_resident( id, s->block_num );
+            index.replace( sitr, stub );
+         }
+      }
    };
 
 
-   fork_database::fork_database( const fc::path& data_dir ):my( new fork_database_impl() ) {
+   fork_database::fork_database( const fc::path& data_dir, uint64_t memory_budget ):my( new fork_database_impl() ) {
       my->datadir = data_dir;
+      my->memory_budget = memory_budget;
 
       if (!fc::is_directory(my->datadir))
          fc::create_directories(my->datadir);
 
+      // a spill file only lives as long as the process that wrote it
+      if( fc::exists( my->spill_file() ) )
+         fc::remove( my->spill_file() );
+
       auto fork_db_dat = my->datadir / config::forkdb_filename;
       if( fc::exists( fork_db_dat ) ) {
          string content;
@@ -84,7 +259,10 @@ namespace besio { namespace chain {
       uint32_t num_blocks_in_fork_db = my->index.size();
       fc::raw::pack( out, unsigned_int{num_blocks_in_fork_db} );
       for( const auto& s : my->index ) {
-         fc::raw::pack( out, *s );
+         if( s->block )
+            fc::raw::pack( out, *s );
+         else
+            fc::raw::pack( out, my->read_spilled( *s ) );
       }
       if( my->head )
          fc::raw::pack( out, my->head->id );
@@ -102,6 +280,11 @@ namespace besio { namespace chain {
       }
 
       my->index.clear();
+      my->resident.clear();
+      my->resident_by_num.clear();
+      my->resident_bytes = 0;
+      my->spilled.clear();
+      my->close_spill();
    }
 
    fork_database::~fork_database() {
@@ -116,6 +299,7 @@ namespace besio { namespace chain {
          //FC_ASSERT( s->block_num == s->header.block_num() );
 
       BES_ASSERT( result.second, fork_database_exception, "unable to insert block state, duplicate state detected" );
+      my->track( s );
       if( !my->head ) {
          my->head =  s;
       } else if( my->head->block_num < s->block_num ) {
@@ -126,8 +310,9 @@ namespace besio { namespace chain {
    block_state_ptr fork_database::add( block_state_ptr n ) {
       auto inserted = my->index.insert(n);
       BES_ASSERT( inserted.second, fork_database_exception, "duplicate block added?" );
+      my->track( n );
 
-      my->head = *my->index.get<by_lib_block_num>().begin();
+      my->head = my->load( *my->index.get<by_lib_block_num>().begin() );
 
       auto lib    = my->head->dpos_irreversible_blocknum;
       auto oldest = *my->index.get<by_block_num>().begin();
@@ -136,6 +321,8 @@ namespace besio { namespace chain {
          prune( oldest );
       }
 
+      my->spill();
+
       return n;
    }
 
@@ -150,7 +337,7 @@ namespace besio { namespace chain {
       auto prior = by_id_idx.find( b->previous );
       BES_ASSERT( prior != by_id_idx.end(), unlinkable_block_exception, "unlinkable block", ("id", string(b->id()))("previous", string(b->previous)) );
 
-      auto result = std::make_shared<block_state>( **prior, move(b), trust );
+      auto result = std::make_shared<block_state>( *my->load( *prior ), move(b), trust );
       BES_ASSERT( result, fork_database_exception , "fail to add new block state" );
       return add(result);
    }
@@ -206,8 +393,10 @@ namespace besio { namespace chain {
 
       for( uint32_t i = 0; i < remove_queue.size(); ++i ) {
          auto itr = my->index.find( remove_queue[i] );
-         if( itr != my->index.end() )
+         if( itr != my->index.end() ) {
+            my->untrack( (*itr)->id, (*itr)->block_num );
             my->index.erase(itr);
+         }
 
          auto& previdx = my->index.get<by_prev>();
          auto  previtr = previdx.lower_bound(remove_queue[i]);
@@ -217,7 +406,7 @@ namespace besio { namespace chain {
          }
       }
       //wdump((my->index.size()));
-      my->head = *my->index.get<by_lib_block_num>().begin();
+      my->head = my->load( *my->index.get<by_lib_block_num>().begin() );
    }
 
    void fork_database::set_validity( const block_state_ptr& h, bool valid ) {
@@ -226,17 +415,24 @@ namespace besio { namespace chain {
       } else {
          /// remove older than irreversible and mark block as valid
          h->validated = true;
+         // h may be a state the index no longer holds because it was spilled, so mark the one in the index as well
+         auto itr = my->index.find( h->id );
+         if( itr != my->index.end() )
+            (*itr)->validated = true;
       }
    }
 
    void fork_database::mark_in_current_chain( const block_state_ptr& h, bool in_current_chain ) {
-      if( h->in_current_chain == in_current_chain )
-         return;
-
       auto& by_id_idx = my->index.get<by_block_id>();
       auto itr = by_id_idx.find( h->id );
       BES_ASSERT( itr != by_id_idx.end(), fork_db_block_not_found, "could not find block in fork database" );
 
+      // h may be a state the index no longer holds because its block was spilled, so check the one in the index
+      if( *itr != h )
+         h->in_current_chain = in_current_chain;
+      if( (*itr)->in_current_chain == in_current_chain )
+         return;
+
       by_id_idx.modify( itr, [&]( auto& bsp ) { // Need to modify this way rather than directly so that Boost MultiIndex can re-sort
          bsp->in_current_chain = in_current_chain;
       });
@@ -254,7 +450,8 @@ namespace besio { namespace chain {
 
       auto itr = my->index.find( h->id );
       if( itr != my->index.end() ) {
-         irreversible(*itr);
+         irreversible( my->load( *itr ) );
+         my->untrack( (*itr)->id, (*itr)->block_num );
          my->index.erase(itr);
       }
 
@@ -271,7 +468,7 @@ namespace besio { namespace chain {
    block_state_ptr   fork_database::get_block(const block_id_type& id)const {
       auto itr = my->index.find( id );
       if( itr != my->index.end() )
-         return *itr;
+         return my->load( *itr );
       return block_state_ptr();
    }
 
@@ -285,7 +482,7 @@ namespace besio { namespace chain {
       //           "block (with block number ${block_num}) found in fork database is not in the current chain", ("block_num", n) );
       if( nitr == numidx.end() || (*nitr)->block_num != n || (*nitr)->in_current_chain != true )
          return block_state_ptr();
-      return *nitr;
+      return my->load( *nitr );
    }
 
    void fork_database::add( const header_confirmation& c ) {
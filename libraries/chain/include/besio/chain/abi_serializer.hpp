@@ -7,6 +7,7 @@
 #include <besio/chain/trace.hpp>
 #include <besio/chain/exceptions.hpp>
 #include <fc/variant_object.hpp>
+#include <unordered_map>
 
 namespace besio { namespace chain {
 
@@ -46,6 +47,7 @@ struct abi_serializer {
 
    type_name get_action_type(name action)const;
    type_name get_table_type(name action)const;
+   type_name get_table_index_type(name table)const;
 
    optional<string>  get_error_message( uint64_t error_code )const;
 
@@ -93,17 +95,67 @@ struct abi_serializer {
 
    static const size_t max_recursion_depth = 32; // arbitrary depth to prevent infinite recursion
 
+   /// when false, serialize through the type name based paths only; they are kept to check the compiled plans against
+   void set_use_compiled_types( bool use ) { use_compiled_types = use; }
+
 private:
 
    map<type_name, type_name>  typedefs;
    map<type_name, struct_def> structs;
    map<name,type_name>        actions;
    map<name,type_name>        tables;
+   map<name,type_name>        table_index_types;
    map<uint64_t, string>      error_messages;
 
    map<type_name, pair<unpack_function, pack_function>> built_in_types;
    void configure_built_in_types();
 
+   /**
+    *  Every type name reachable from the ABI is compiled once, in set_abi, into a flat plan that
+    *  refers to other plans by index. Serialization then walks the plans without resolving typedefs,
+    *  splitting "[]"/"?" suffixes or looking up structs by name for every field.
+    */
+   struct compiled_field {
+      field_name name;
+      uint32_t   type_id = 0;
+   };
+
+   struct compiled_type {
+      enum kind_type : uint8_t {
+         builtin_kind,     ///< built in codec, possibly applied to an array or optional of the built in
+         array_kind,       ///< array of element_id
+         optional_kind,    ///< optional of element_id
+         struct_kind,      ///< fields, preceded by the fields of base_id when has_base
+         unresolved_kind   ///< not resolvable by this ABI, serialized through the type name
+      };
+
+      type_name                             name;
+      type_name                             resolved_name;  ///< name with its typedefs resolved
+      kind_type                             kind = unresolved_kind;
+      bool                                  builtin_array = false;
+      bool                                  builtin_optional = false;
+      bool                                  has_base = false;
+      uint32_t                              element_id = 0;
+      uint32_t                              base_id = 0;
+      pair<unpack_function, pack_function>  codec;
+      vector<compiled_field>                fields;
+   };
+
+   bool                                       use_compiled_types = true;
+   vector<compiled_type>                      compiled_types;
+   std::unordered_map<type_name, uint32_t>    compiled_type_ids;
+
+   void     compile_types(const fc::time_point& deadline, const fc::microseconds& max_serialization_time);
+   uint32_t compiled_type_id(const type_name& type, vector<uint32_t>& pending);
+   const compiled_type* find_compiled_type(const type_name& type)const;
+
+   fc::variant _binary_to_variant(const compiled_type& ct, fc::datastream<const char*>& stream,
+                                  size_t recursion_depth, const fc::time_point& deadline, const fc::microseconds& max_serialization_time)const;
+   void        _binary_to_variant(const compiled_type& ct, fc::datastream<const char*>& stream, fc::mutable_variant_object& obj,
+                                  size_t recursion_depth, const fc::time_point& deadline, const fc::microseconds& max_serialization_time)const;
+   void        _variant_to_binary(const compiled_type& ct, const fc::variant& var, fc::datastream<char*>& ds,
+                                  size_t recursion_depth, const fc::time_point& deadline, const fc::microseconds& max_serialization_time)const;
+
    fc::variant _binary_to_variant(const type_name& type, const bytes& binary,
                                   size_t recursion_depth, const fc::time_point& deadline, const fc::microseconds& max_serialization_time)const;
    bytes       _variant_to_binary(const type_name& type, const fc::variant& var,
@@ -125,6 +177,12 @@ private:
    friend struct impl::abi_to_variant;
 };
 
+/**
+ *  Serializers handed out by shared caches, see controller::get_abi_serializer. Resolvers passed to
+ *  to_variant/from_variant may return either this or an optional<abi_serializer>.
+ */
+using abi_serializer_ptr = std::shared_ptr<const abi_serializer>;
+
 namespace impl {
    /**
     * Determine if a type contains ABI related info, perhaps deeply nested
@@ -287,7 +345,7 @@ namespace impl {
          mvo("authorization", act.authorization);
 
          auto abi = resolver(act.account);
-         if (abi.valid()) {
+         if (abi) {
             auto type = abi->get_action_type(act.name);
             if (!type.empty()) {
                try {
@@ -463,7 +521,7 @@ namespace impl {
                valid_empty_data = act.data.empty();
             } else if ( data.is_object() ) {
                auto abi = resolver(act.account);
-               if (abi.valid()) {
+               if (abi) {
                   auto type = abi->get_action_type(act.name);
                   if (!type.empty()) {
                      act.data = std::move( abi->_variant_to_binary( type, data, recursion_depth, deadline, max_serialization_time ));
@@ -6,6 +6,7 @@
 #include <besio/chain/controller.hpp>
 #include <besio/chain/transaction.hpp>
 #include <besio/chain/contract_table_objects.hpp>
+#include <besio/chain/transaction_context.hpp>
 #include <fc/utility.hpp>
 #include <sstream>
 #include <algorithm>
@@ -23,7 +24,12 @@ class apply_context {
       template<typename T>
       class iterator_cache {
          public:
-            iterator_cache(){
+            explicit iterator_cache( transaction_arena& arena )
+            :_table_cache( arena_allocator<char>(arena) )
+            ,_end_iterator_to_table( arena_allocator<char>(arena) )
+            ,_iterator_to_object( arena_allocator<char>(arena) )
+            ,_object_to_iterator( arena_allocator<char>(arena) )
+            {
                _end_iterator_to_table.reserve(8);
                _iterator_to_object.reserve(32);
             }
@@ -90,10 +96,10 @@ class apply_context {
             }
 
          private:
-            map<table_id_object::id_type, pair<const table_id_object*, int>> _table_cache;
-            vector<const table_id_object*>                  _end_iterator_to_table;
-            vector<const T*>                                _iterator_to_object;
-            map<const T*,int>                               _object_to_iterator;
+            arena_map<table_id_object::id_type, pair<const table_id_object*, int>> _table_cache;
+            arena_vector<const table_id_object*>            _end_iterator_to_table;
+            arena_vector<const T*>                          _iterator_to_object;
+            arena_map<const T*,int>                         _object_to_iterator;
 
             /// Precondition: std::numeric_limits<int>::min() < ei < -1
             /// Iterator of -1 is reserved for invalid iterators (i.e. when the appropriate table has not yet been created).
@@ -174,7 +180,7 @@ class apply_context {
 
             using secondary_key_helper_t = secondary_key_helper<secondary_key_type, secondary_key_proxy_type, secondary_key_proxy_const_type>;
 
-            generic_index( apply_context& c ):context(c){}
+            generic_index( apply_context& c ):context(c),itr_cache(c.trx_context.arena){}
 
             int store( uint64_t scope, uint64_t table, const account_name& payer,
                        uint64_t id, secondary_key_proxy_const_type value )
@@ -457,13 +463,17 @@ class apply_context {
       ,trx_context(trx_ctx)
       ,act(a)
       ,receiver(act.account)
-      ,used_authorizations(act.authorization.size(), false)
+      ,used_authorizations(act.authorization.size(), false, arena_allocator<bool>(trx_ctx.arena))
       ,recurse_depth(depth)
       ,idx64(*this)
       ,idx128(*this)
       ,idx256(*this)
       ,idx_double(*this)
       ,idx_long_double(*this)
+      ,keyval_cache(trx_ctx.arena)
+      ,_notified(arena_allocator<account_name>(trx_ctx.arena))
+      ,_inline_actions(arena_allocator<action>(trx_ctx.arena))
+      ,_cfa_inline_actions(arena_allocator<action>(trx_ctx.arena))
       {
          reset_console();
       }
@@ -586,7 +596,7 @@ class apply_context {
       transaction_context&          trx_context; ///< transaction context in which the action is running
       const action&                 act; ///< message being applied
       account_name                  receiver; ///< the code that is currently running
-      vector<bool> used_authorizations; ///< Parallel to act.authorization; tracks which permissions have been used while processing the message
+      arena_vector<bool> used_authorizations; ///< Parallel to act.authorization; tracks which permissions have been used while processing the message
       uint32_t                      recurse_depth; ///< how deep inline actions can recurse
       bool                          privileged   = false;
       bool                          context_free = false;
@@ -603,9 +613,9 @@ class apply_context {
    private:
 
       iterator_cache<key_value_object>    keyval_cache;
-      vector<account_name>                _notified; ///< keeps track of new accounts to be notifed of current message
-      vector<action>                      _inline_actions; ///< queued inline messages
-      vector<action>                      _cfa_inline_actions; ///< queued inline messages
+      arena_vector<account_name>          _notified; ///< keeps track of new accounts to be notifed of current message
+      arena_vector<action>                _inline_actions; ///< queued inline messages
+      arena_vector<action>                _cfa_inline_actions; ///< queued inline messages
       std::ostringstream                  _pending_console_output;
 
       //bytes                               _cached_trx;
@@ -13,6 +13,8 @@
 namespace besio { namespace chain {
 
    class controller;
+   class snapshot_writer;
+   class snapshot_reader;
    struct updateauth;
    struct deleteauth;
    struct linkauth;
@@ -27,6 +29,8 @@ namespace besio { namespace chain {
 
          void add_indices();
          void initialize_database();
+         void add_to_snapshot( snapshot_writer& snapshot )const;
+         void read_from_snapshot( snapshot_reader& snapshot );
 
          const permission_object& create_permission( account_name account,
                                                      permission_name name,
@@ -11,6 +11,13 @@ namespace besio { namespace chain {
 
    namespace detail { class block_log_impl; }
 
+   struct block_log_config {
+      uint32_t chunk_blocks = 0; ///< blocks per compressed chunk when a new block log is created, 0 for the uncompressed format
+      uint32_t prune_blocks = 0; ///< in a chunked block log, drop the transactions of blocks this many blocks behind the head, 0 to keep them
+      uint32_t segment_blocks = 0; ///< seal blocks.log into a numbered segment after every block number divisible by this, 0 to never rotate
+      fc::path archive_dir;        ///< directory sealed segments are moved to in the background (relative to the blocks directory), empty to keep them
+   };
+
    /* The block log is an external append only log of the blocks. Blocks should only be written
     * to the log after they irreverisble as the log is append only. The log is a doubly linked
     * list of blocks. There is a secondary index file of only block positions that enables O(1)
@@ -32,28 +39,73 @@ namespace besio { namespace chain {
     * Blocks can be accessed at random via block number through the index file. Seek to 8 * (block_num - 1)
     * to find the position of the block in the main file.
     *
+    * Both files are read through read only memory maps, and the most recently read blocks are kept unpacked
+    * in a small LRU cache so that peers syncing the same range do not unpack each block again.
+    *
     * The main file is the only file that needs to persist. The index file can be reconstructed during a
     * linear scan of the main file.
+    *
+    * A block log created with block_log_config::chunk_blocks set uses the chunked format (chunked_version)
+    * instead. Its header also holds the number of the first block and the chunk size, and the blocks are
+    * stored in zlib compressed chunks:
+    *
+    * +--------+-----------------+--------------+-----+--------------+
+    * | Header | Chunk (1 .. n)  | Pos of Chunk | ... | Pos of Chunk |
+    * +--------+-----------------+--------------+-----+--------------+
+    *
+    * Each chunk is a chunk_header followed by the compressed payload: a table of the offsets of its blocks
+    * followed by the blocks themselves. The index file keeps one entry per block, the position of the chunk
+    * holding it, so a block is found by reading one index entry and inflating one chunk. Blocks appended since
+    * the last chunk was sealed are kept in blocks.pending until there are enough of them to fill a chunk.
+    *
+    * With block_log_config::prune_blocks set, chunks whose blocks are all that many blocks behind the head are
+    * rewritten in place with only the block headers, and the space they no longer need is released to the file
+    * system. Pruned blocks can no longer be read as full blocks, only through read_block_header_by_num. The new chunks
+    * are first written to a journal next to the log, blocks.log.prune, as a sequence of the position of each chunk, its
+    * new chunk_header and its new payload; a rewrite interrupted by a crash is finished from it when the log is opened.
+    *
+    * With block_log_config::segment_blocks set, the log rotates: once blocks.log ends at a block number divisible by
+    * segment_blocks it is renamed to blocks-<first>-<last>.log (its index to blocks-<first>-<last>.index) and a new
+    * blocks.log is started after it. Each segment carries the header of the chunked version, with a chunk size of 0
+    * when its blocks are not compressed, so it can be read, checked and reindexed on its own. Reads are routed to the
+    * segment holding the block, and a background thread moves sealed segments to block_log_config::archive_dir.
     */
 
    class block_log {
       public:
-         block_log(const fc::path& data_dir);
+         block_log(const fc::path& data_dir, const block_log_config& cfg = block_log_config());
          block_log(block_log&& other);
          ~block_log();
 
+         /**
+          * Return the position of the block in the file; in a chunked log the position of the chunk holding it,
+          * or block_log::npos while the block is pending.
+          */
          uint64_t append(const signed_block_ptr& b);
          void flush();
          uint64_t reset_to_genesis( const genesis_state& gs, const signed_block_ptr& genesis_block );
 
+         /// Only for the uncompressed format
          std::pair<signed_block_ptr, uint64_t> read_block(uint64_t file_pos)const;
+         /// Return nullptr if block_num is not in the log or has been pruned
          signed_block_ptr read_block_by_num(uint32_t block_num)const;
          signed_block_ptr read_block_by_id(const block_id_type& id)const {
             return read_block_by_num(block_header::num_from_id(id));
          }
 
          /**
-          * Return offset of block in file, or block_log::npos if it does not exist.
+          * Return the bytes of block_num exactly as they are serialized in the log, or {nullptr, 0} if it is not in
+          * the log or has been pruned. The range points into the memory mapped log (into the inflated chunk of a
+          * chunked log) and stays valid until the next call on this block_log.
+          */
+         std::pair<const char*, size_t> read_serialized_block_by_num(uint32_t block_num)const;
+
+         /// Return the header of block_num, which is available even after the block has been pruned
+         optional<signed_block_header> read_block_header_by_num(uint32_t block_num)const;
+
+         /**
+          * Return offset of block in file (of the chunk holding it in a chunked log), or block_log::npos if it
+          * does not exist.
           */
          uint64_t get_block_pos(uint32_t block_num) const;
          signed_block_ptr        read_head()const;
@@ -62,6 +114,7 @@ namespace besio { namespace chain {
          static const uint64_t npos = std::numeric_limits<uint64_t>::max();
 
          static const uint32_t supported_version;
+         static const uint32_t chunked_version;
 
          static fc::path repair_log( const fc::path& data_dir, uint32_t truncate_at_block = 0 );
 
@@ -69,7 +122,6 @@ namespace besio { namespace chain {
 
       private:
          void open(const fc::path& data_dir);
-         void construct_index();
 
          std::unique_ptr<detail::block_log_impl> my;
    };
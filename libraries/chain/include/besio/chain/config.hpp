@@ -19,6 +19,9 @@ const static auto default_reversible_guard_size = 2*1024*1024ll;/// 1MB * 340 bl
 
 const static auto default_state_dir_name     = "state";
 const static auto forkdb_filename            = "forkdb.dat";
+const static auto forkdb_spill_filename      = "forkdb.spill";
+const static auto wasm_cache_filename        = "wasmcache.dat";
+const static auto replay_checkpoint_filename = "replay-checkpoint.bin";
 const static auto default_state_size            = 1*1024*1024*1024ll;
 const static auto default_state_guard_size      =    128*1024*1024ll;
 
@@ -95,6 +98,14 @@ const static uint32_t   hashing_checktime_block_size       = 10*1024;  /// call
 
 const static besio::chain::wasm_interface::vm_type default_wasm_runtime = besio::chain::wasm_interface::vm_type::binaryen;
 const static uint32_t   default_abi_serializer_max_time_ms = 15*1000; ///< default deadline for abi serialization methods
+const static uint16_t   default_controller_thread_pool_size = 2; ///< default number of threads used for signature recovery
+const static uint32_t   default_wasm_cache_size = 1024; ///< default maximum number of instantiated contracts kept by wasm_interface
+const static uint32_t   default_abi_cache_size = 1024; ///< default maximum number of abi serializers kept by the controller
+const static uint32_t   block_log_cache_size = 64; ///< number of unpacked blocks the block log keeps for repeated reads
+const static uint32_t   block_log_max_chunk_bytes = 8*1024*1024; ///< a chunk of a chunked block log is sealed once its blocks reach this size
+const static uint32_t   default_replay_read_ahead = 256; ///< default number of blocks decoded ahead of the block being applied during replay
+const static uint32_t   default_replay_checkpoint_interval = 0; ///< replay checkpoints are opt in, see chain_plugin's replay-checkpoint-interval
+const static uint64_t   default_fork_db_memory_budget = 1024*1024*1024ll; ///< default bytes of reversible blocks the fork database keeps in memory before spilling to disk
 
 /**
  *  The number of sequential blocks produced by a single producer
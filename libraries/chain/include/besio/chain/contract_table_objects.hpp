@@ -9,12 +9,28 @@
 #include <softfloat.hpp>
 
 #include <chainbase/chainbase.hpp>
+#ifdef BESIO_BTREE_CONTRACT_TABLES
+#include <chainbase/btree_index.hpp>
+#endif
 
 #include <array>
 #include <type_traits>
 
 namespace besio { namespace chain {
 
+   /**
+    *  Contract table rows make up most of the state and are walked in key order by the database intrinsics and the
+    *  table queries, so they can be kept in chainbase B+-tree indices instead of red-black trees. The choice changes
+    *  the layout of the state database, which has to be rebuilt (e.g. from a snapshot) when switching.
+    */
+#ifdef BESIO_BTREE_CONTRACT_TABLES
+   template<typename Object, typename... Args>
+   using contract_table_multi_index_container = chainbase::shared_btree_multi_index_container<Object, Args...>;
+#else
+   template<typename Object, typename... Args>
+   using contract_table_multi_index_container = chainbase::shared_multi_index_container<Object, Args...>;
+#endif
+
    /**
     * @brief The table_id_object class tracks the mapping of (scope, code, table) to an opaque identifier
     */
@@ -67,7 +83,7 @@ namespace besio { namespace chain {
       shared_string         value;
    };
 
-   using key_value_index = chainbase::shared_multi_index_container<
+   using key_value_index = contract_table_multi_index_container<
       key_value_object,
       indexed_by<
          ordered_unique<tag<by_id>, member<key_value_object, key_value_object::id_type, &key_value_object::id>>,
@@ -99,7 +115,7 @@ namespace besio { namespace chain {
       };
 
 
-      typedef chainbase::shared_multi_index_container<
+      typedef contract_table_multi_index_container<
          index_object,
          indexed_by<
             ordered_unique<tag<by_id>, member<index_object, typename index_object::id_type, &index_object::id>>,
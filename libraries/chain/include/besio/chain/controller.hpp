@@ -10,6 +10,9 @@
 namespace chainbase {
    class database;
 }
+namespace boost { namespace asio {
+   class thread_pool;
+}}
 
 
 namespace besio { namespace chain {
@@ -32,6 +35,8 @@ namespace besio { namespace chain {
    using apply_handler = std::function<void(apply_context&)>;
 
    class fork_database;
+   class snapshot_reader;
+   class snapshot_writer;
 
    enum class db_read_mode {
       SPECULATIVE,
@@ -56,11 +61,25 @@ namespace besio { namespace chain {
             flat_set< pair<account_name, action_name> > action_blacklist;
             flat_set<public_key_type> key_blacklist;
             path                     blocks_dir             =  chain::config::default_blocks_dir_name;
+            uint32_t                 block_log_chunk_blocks =  0; ///< blocks per compressed chunk of a newly created block log, 0 for the uncompressed format
+            uint32_t                 block_log_prune_blocks =  0; ///< prune the transactions of blocks this far behind the head of a chunked block log, 0 to keep them
+            uint32_t                 block_log_segment_blocks = 0; ///< rotate the block log into a new segment every this many blocks, 0 for a single file
+            path                     block_log_archive_dir; ///< where sealed block log segments are moved to, relative to blocks_dir; empty to leave them
             path                     state_dir              =  chain::config::default_state_dir_name;
             uint64_t                 state_size             =  chain::config::default_state_size;
             uint64_t                 state_guard_size       =  chain::config::default_state_guard_size;
+            path                     state_hugepage_dir; ///< hugetlbfs mount to hold the state database in, empty to map it from state_dir
+            int32_t                  state_numa_node        =  -1; ///< NUMA node to bind the state database to, -1 for none
             uint64_t                 reversible_cache_size  =  chain::config::default_reversible_cache_size;
             uint64_t                 reversible_guard_size  =  chain::config::default_reversible_guard_size;
+            uint64_t                 fork_db_memory_budget  =  chain::config::default_fork_db_memory_budget; ///< 0 keeps every reversible block in memory
+            uint16_t                 thread_pool_size       =  chain::config::default_controller_thread_pool_size;
+            uint32_t                 wasm_cache_size        =  chain::config::default_wasm_cache_size;
+            uint32_t                 abi_cache_size         =  chain::config::default_abi_cache_size;
+            uint32_t                 replay_read_ahead      =  chain::config::default_replay_read_ahead;
+            uint32_t                 trusted_replay_block_num = 0; ///< blocks of the block log up to this number are replayed without signature, authorization or merkle checks
+            uint32_t                 replay_checkpoint_interval = 0; ///< number of replayed blocks between replay checkpoints, 0 to disable
+            path                     replay_checkpoint_file;
             bool                     read_only              =  false;
             bool                     force_all_checks       =  false;
             bool                     disable_replay_opts    =  false;
@@ -69,6 +88,7 @@ namespace besio { namespace chain {
 
             genesis_state            genesis;
             wasm_interface::vm_type  wasm_runtime = chain::config::default_wasm_runtime;
+            bool                     wasm_tiered_compile    =  false;
 
             db_read_mode             read_mode              = db_read_mode::SPECULATIVE;
             validation_mode          block_validation_mode  = validation_mode::FULL;
@@ -86,7 +106,17 @@ namespace besio { namespace chain {
          controller( const config& cfg );
          ~controller();
 
-         void startup();
+         /**
+          *  Opens the chain state. When a snapshot is given the state directory must be empty; the state is loaded
+          *  from the snapshot and the block log is replayed from the snapshot block onwards.
+          */
+         void startup( const std::shared_ptr<snapshot_reader>& snapshot = nullptr );
+
+         /**
+          *  Writes the state of the head block to a snapshot. Any pending block must be aborted first. Only the rows are
+          *  written, the caller finalizes the snapshot and may do so on another thread once this returns.
+          */
+         void write_snapshot( snapshot_writer& snapshot )const;
 
          /**
           * Starts a new pending block session upon which new transactions can
@@ -147,6 +177,12 @@ namespace besio { namespace chain {
 
          fork_database& fork_db()const;
 
+         /**
+          *  Worker threads used for work that can run off the main thread, such as recovering
+          *  transaction signing keys ahead of execution.
+          */
+         boost::asio::thread_pool& get_thread_pool();
+
          const account_object&                 get_account( account_name n )const;
          const global_property_object&         get_global_properties()const;
          const dynamic_global_property_object& get_dynamic_global_properties()const;
@@ -194,6 +230,11 @@ namespace besio { namespace chain {
 
          signed_block_ptr fetch_block_by_number( uint32_t block_num )const;
          signed_block_ptr fetch_block_by_id( block_id_type id )const;
+         /**
+          *  Returns the packed signed_block straight from the block log without unpacking it, or {nullptr, 0} if
+          *  block_num is not in the block log yet. The bytes are only valid until the controller next touches the log.
+          */
+         std::pair<const char*, size_t> fetch_serialized_block_by_number( uint32_t block_num )const;
 
          block_state_ptr fetch_block_state_by_number( uint32_t block_num )const;
          block_state_ptr fetch_block_state_by_id( block_id_type id )const;
@@ -260,17 +301,13 @@ namespace besio { namespace chain {
          wasm_interface& get_wasm_interface();
 
 
-         optional<abi_serializer> get_abi_serializer( account_name n, const fc::microseconds& max_serialization_time )const {
-            if( n.good() ) {
-               try {
-                  const auto& a = get_account( n );
-                  abi_def abi;
-                  if( abi_serializer::to_abi( a.abi, abi ))
-                     return abi_serializer( abi, max_serialization_time );
-               } FC_CAPTURE_AND_LOG((n))
-            }
-            return optional<abi_serializer>();
-         }
+         /**
+          *  Returns the serializer for the current ABI of n, or an empty pointer if n has no usable ABI.
+          *  Serializers are cached per account and abi_sequence, up to config::abi_cache_size of them.
+          */
+         abi_serializer_ptr get_abi_serializer( account_name n, const fc::microseconds& max_serialization_time )const;
+         /// drops the cached serializer of n, called whenever setabi is applied to n
+         void invalidate_abi_serializer( account_name n );
 
          template<typename T>
          fc::variant to_variant_with_abi( const T& obj, const fc::microseconds& max_serialization_time ) {
@@ -297,12 +334,22 @@ FC_REFLECT( besio::chain::controller::config,
             (blocks_dir)
             (state_dir)
             (state_size)
+            (state_hugepage_dir)
+            (state_numa_node)
             (reversible_cache_size)
+            (thread_pool_size)
             (read_only)
             (force_all_checks)
             (disable_replay_opts)
             (contracts_console)
             (genesis)
             (wasm_runtime)
+            (wasm_cache_size)
+            (abi_cache_size)
+            (replay_read_ahead)
+            (trusted_replay_block_num)
+            (replay_checkpoint_interval)
+            (replay_checkpoint_file)
+            (wasm_tiered_compile)
             (resource_greylist)
           )
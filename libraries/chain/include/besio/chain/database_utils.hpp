@@ -0,0 +1,33 @@
+/**
+ *  @file
+ *  @copyright defined in bes/LICENSE.txt
+ */
+#pragma once
+
+#include <besio/chain/snapshot.hpp>
+#include <chainbase/chainbase.hpp>
+
+#include <initializer_list>
+
+namespace besio { namespace chain {
+
+   /**
+    *  A list of chainbase indices that are registered, written to snapshots and read back from them together, in
+    *  the order given.
+    */
+   template<typename... Indices>
+   struct index_set {
+      static void add_indices( chainbase::database& db ) {
+         (void)std::initializer_list<int>{ (db.add_index<Indices>(), 0)... };
+      }
+
+      static void add_to_snapshot( const chainbase::database& db, snapshot_writer& snapshot ) {
+         (void)std::initializer_list<int>{ (add_index_to_snapshot<Indices>( db, snapshot ), 0)... };
+      }
+
+      static void read_from_snapshot( chainbase::database& db, snapshot_reader& snapshot ) {
+         (void)std::initializer_list<int>{ (read_index_from_snapshot<Indices>( db, snapshot ), 0)... };
+      }
+   };
+
+} } // besio::chain
@@ -0,0 +1,45 @@
+/**
+ *  @file
+ *  @copyright defined in bes/LICENSE.txt
+ */
+#pragma once
+
+#include <fc/time.hpp>
+#include <boost/noncopyable.hpp>
+#include <atomic>
+
+namespace besio { namespace chain {
+
+   namespace detail { class deadline_timer_service; }
+
+   /**
+    *  Flag that is raised once a deadline has passed.
+    *
+    *  Checking a deadline by reading the clock costs a clock_gettime call each time, which adds up when checktime
+    *  runs on every iteration of a contract loop. A deadline_timer is armed with start() instead and a single timer
+    *  thread shared by every deadline_timer of the process raises its flag once the deadline has passed, so checking
+    *  it is one relaxed atomic load. The flag may be raised some microseconds late, depending on how fast the timer
+    *  thread is scheduled, but never early.
+    */
+   class deadline_timer : private boost::noncopyable {
+      public:
+         deadline_timer() = default;
+         ~deadline_timer();
+
+         /// Arms the timer for deadline, replacing any earlier deadline; a deadline already passed raises the flag at once
+         void start( fc::time_point deadline );
+
+         /// Disarms the timer and lowers the flag
+         void stop();
+
+         bool expired()const { return _expired.load( std::memory_order_relaxed ); }
+
+      private:
+         friend class detail::deadline_timer_service;
+
+         std::atomic<bool> _expired{false};
+         bool              _armed = false;  ///< guarded by the mutex of the timer service
+         fc::time_point    _deadline;       ///< guarded by the mutex of the timer service
+   };
+
+} } // besio::chain
@@ -95,6 +95,7 @@ namespace besio { namespace chain {
     *   |- resource_limit_exception
     *   |- mongo_db_exception
     *   |- contract_api_exception
+    *   |- snapshot_exception
     */
 
     FC_DECLARE_DERIVED_EXCEPTION( chain_type_exception, chain_exception,
@@ -452,6 +453,10 @@ namespace besio { namespace chain {
                                     3170004, "Producer schedule exception" )
       FC_DECLARE_DERIVED_EXCEPTION( producer_not_in_schedule,      producer_exception,
                                     3170006, "The producer is not part of current schedule" )
+      FC_DECLARE_DERIVED_EXCEPTION( snapshot_exists_exception,     producer_exception,
+                                    3170007, "The requested snapshot already exists" )
+      FC_DECLARE_DERIVED_EXCEPTION( snapshot_finalization_exception,   producer_exception,
+                                    3170008, "Snapshot Finalization Exception" )
 
    FC_DECLARE_DERIVED_EXCEPTION( reversible_blocks_exception,           chain_exception,
                                  3180000, "Reversible Blocks exception" )
@@ -506,4 +511,9 @@ namespace besio { namespace chain {
                                     3230002, "Database API Exception" )
       FC_DECLARE_DERIVED_EXCEPTION( arithmetic_exception,   contract_api_exception,
                                     3230003, "Arithmetic Exception" )
+
+   FC_DECLARE_DERIVED_EXCEPTION( snapshot_exception,    chain_exception,
+                                 3240000, "Snapshot exception" )
+      FC_DECLARE_DERIVED_EXCEPTION( snapshot_validation_exception,   snapshot_exception,
+                                    3240001, "Snapshot does not match this chain" )
 } } // besio::chain
@@ -18,11 +18,17 @@ namespace besio { namespace chain {
     * database tracks the longest chain and the last irreversible block number. All
     * blocks older than the last irreversible block are freed after emitting the
     * irreversible signal.
+    *
+    * When the blocks held in memory exceed the memory budget, typically because
+    * irreversibility stalls, the oldest validated blocks are written to a spill
+    * file next to forkdb.dat and only their header state is kept in memory. They
+    * are read back transparently when they are looked up or become irreversible.
     */
    class fork_database {
       public:
 
-         fork_database( const fc::path& data_dir );
+         /// @param memory_budget bytes of packed blocks to keep in memory, 0 for no limit
+         fork_database( const fc::path& data_dir, uint64_t memory_budget = 0 );
          ~fork_database();
 
          void close();
@@ -1,6 +1,8 @@
 #pragma once
 #include <besio/chain/types.hpp>
 
+namespace boost { namespace asio { class thread_pool; } }
+
 namespace besio { namespace chain {
 
    digest_type make_canonical_left(const digest_type& val);
@@ -16,7 +18,10 @@ namespace besio { namespace chain {
 
    /**
     *  Calculates the merkle root of a set of digests, if ids is odd it will duplicate the last id.
+    *
+    *  The pairs of a level are hashed several at a time where the CPU supports AVX2, and levels with many pairs are
+    *  split across thread_pool when one is given. The root does not depend on either.
     */
-   digest_type merkle( vector<digest_type> ids );
+   digest_type merkle( vector<digest_type> ids, boost::asio::thread_pool* thread_pool = nullptr );
 
 } } /// besio::chain
@@ -4,7 +4,11 @@
 #include <chainbase/chainbase.hpp>
 #include <set>
 
-namespace besio { namespace chain { namespace resource_limits {
+namespace besio { namespace chain {
+   class snapshot_writer;
+   class snapshot_reader;
+
+namespace resource_limits {
    namespace impl {
       template<typename T>
       struct ratio {
@@ -43,6 +47,8 @@ namespace besio { namespace chain { namespace resource_limits {
 
          void add_indices();
          void initialize_database();
+         void add_to_snapshot( snapshot_writer& snapshot )const;
+         void read_from_snapshot( snapshot_reader& snapshot );
          void initialize_account( const account_name& account );
          void set_block_parameters( const elastic_limit_parameters& cpu_limit_parameters, const elastic_limit_parameters& net_limit_parameters );
 
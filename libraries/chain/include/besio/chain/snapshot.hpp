@@ -0,0 +1,295 @@
+/**
+ *  @file
+ *  @copyright defined in bes/LICENSE.txt
+ */
+#pragma once
+
+#include <besio/chain/types.hpp>
+#include <besio/chain/exceptions.hpp>
+#include <besio/chain/producer_schedule.hpp>
+#include <chainbase/chainbase.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/interprocess/container.hpp>
+#include <fc/crypto/sha256.hpp>
+#include <softfloat.hpp>
+
+#include <boost/preprocessor/seq/for_each.hpp>
+#include <boost/preprocessor/stringize.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <iosfwd>
+#include <mutex>
+#include <thread>
+
+namespace besio { namespace chain {
+
+   /**
+    *  Describes how a chainbase object is stored in a snapshot.
+    *
+    *  Rows are declared field by field with BES_SNAPSHOT_ROW instead of being copied out of shared memory, so a
+    *  snapshot does not depend on the compiler, boost version or memory layout of the node that wrote it. Any change
+    *  to a declared row must bump snapshot_writer::current_version.
+    */
+   template<typename T>
+   struct snapshot_row {
+      static constexpr bool defined = false;
+   };
+
+   namespace snapshot_detail {
+      template<typename Stream, typename T>
+      void pack_field( Stream& s, const T& v );
+      template<typename Stream, typename T>
+      void unpack_field( Stream& s, T& v );
+
+      template<typename Stream, typename T>
+      void pack_field( Stream& s, const T& v, std::true_type ) { snapshot_row<T>::pack( s, v ); }
+      template<typename Stream, typename T>
+      void pack_field( Stream& s, const T& v, std::false_type ) { fc::raw::pack( s, v ); }
+      template<typename Stream, typename T>
+      void unpack_field( Stream& s, T& v, std::true_type ) { snapshot_row<T>::unpack( s, v ); }
+      template<typename Stream, typename T>
+      void unpack_field( Stream& s, T& v, std::false_type ) { fc::raw::unpack( s, v ); }
+
+      template<typename Stream, typename T>
+      void pack_field( Stream& s, const T& v ) {
+         pack_field( s, v, std::integral_constant<bool, snapshot_row<T>::defined>() );
+      }
+      template<typename Stream, typename T>
+      void unpack_field( Stream& s, T& v ) {
+         unpack_field( s, v, std::integral_constant<bool, snapshot_row<T>::defined>() );
+      }
+
+      /// shared strings are resized in place so they keep the allocator of the object that owns them
+      template<typename Stream>
+      void pack_field( Stream& s, const shared_string& v ) {
+         fc::raw::pack( s, unsigned_int( (uint32_t)v.size() ) );
+         if( v.size() ) s.write( v.data(), v.size() );
+      }
+      template<typename Stream>
+      void unpack_field( Stream& s, shared_string& v ) {
+         unsigned_int size;
+         fc::raw::unpack( s, size );
+         v.resize( size.value );
+         if( size.value ) s.read( &v[0], size.value );
+      }
+
+      template<typename Stream, typename T>
+      void pack_field( Stream& s, const chainbase::oid<T>& v ) { fc::raw::pack( s, v._id ); }
+      template<typename Stream, typename T>
+      void unpack_field( Stream& s, chainbase::oid<T>& v ) { fc::raw::unpack( s, v._id ); }
+
+      template<typename Stream, typename T, size_t N>
+      void pack_field( Stream& s, const std::array<T,N>& v ) { for( const auto& e : v ) pack_field( s, e ); }
+      template<typename Stream, typename T, size_t N>
+      void unpack_field( Stream& s, std::array<T,N>& v ) { for( auto& e : v ) unpack_field( s, e ); }
+
+      template<typename Stream>
+      void pack_field( Stream& s, const float64_t& v ) { fc::raw::pack( s, v.v ); }
+      template<typename Stream>
+      void unpack_field( Stream& s, float64_t& v ) { fc::raw::unpack( s, v.v ); }
+
+      template<typename Stream>
+      void pack_field( Stream& s, const float128_t& v ) { fc::raw::pack( s, v.v[0] ); fc::raw::pack( s, v.v[1] ); }
+      template<typename Stream>
+      void unpack_field( Stream& s, float128_t& v ) { fc::raw::unpack( s, v.v[0] ); fc::raw::unpack( s, v.v[1] ); }
+
+      template<typename Stream>
+      void pack_field( Stream& s, const shared_producer_schedule_type& v ) {
+         fc::raw::pack( s, producer_schedule_type( v ) );
+      }
+      template<typename Stream>
+      void unpack_field( Stream& s, shared_producer_schedule_type& v ) {
+         producer_schedule_type schedule;
+         fc::raw::unpack( s, schedule );
+         v = schedule;
+      }
+   }
+
+   /**
+    *  Streams a snapshot of the chain state to an std::ostream.
+    *
+    *  The stream is a header (magic, version, chain id) followed by sections. Each section names the object type it
+    *  holds, its row count and the next id of its chainbase index, then the rows themselves. An empty section name
+    *  ends the snapshot and is followed by the sha256 of everything before it.
+    *
+    *  Rows are packed on the calling thread into large buffers which a background thread hashes and writes out, so
+    *  walking the database overlaps with disk writes. By default the caller waits once a few buffers are queued; a
+    *  max_queued_chunks of 0 never holds the caller up and keeps whatever the stream has not taken yet in memory, for
+    *  callers that must not wait on disk and call finalize() from another thread.
+    */
+   class snapshot_writer {
+      public:
+         static const uint32_t magic_number;
+         static const uint32_t current_version;
+         static const size_t   default_max_queued_chunks;
+
+         snapshot_writer( std::ostream& out, const chain_id_type& chain_id, size_t max_queued_chunks = default_max_queued_chunks );
+         ~snapshot_writer();
+
+         void begin_section( const string& name, uint64_t row_count, int64_t next_id = 0 );
+         void end_section();
+
+         template<typename T>
+         void add_row( const T& row ) {
+            BES_ASSERT( rows_remaining > 0, snapshot_exception, "too many rows written to snapshot section ${s}", ("s", section) );
+            snapshot_detail::pack_field( *this, row );
+            --rows_remaining;
+         }
+
+         /// writes the end marker and checksum and waits until everything reached the stream
+         void finalize();
+
+         /// total number of bytes handed to the stream so far
+         uint64_t size()const { return bytes_written; }
+
+         // fc::raw stream interface
+         void write( const char* d, size_t s );
+         bool put( char c ) { write( &c, 1 ); return true; }
+
+      private:
+         void flush_buffer();
+         void write_loop();
+         void stop();
+
+         std::ostream&               out;
+         const size_t                max_queued_chunks;
+         vector<char>                buffer;
+         string                      section;
+         uint64_t                    rows_remaining = 0;
+         uint64_t                    bytes_written = 0;
+         bool                        finalized = false;
+
+         std::mutex                  mtx;
+         std::condition_variable     cond;
+         std::deque<vector<char>>    pending;
+         bool                        done = false;
+         std::exception_ptr          write_error;
+         fc::sha256::encoder         checksum;
+         std::thread                 thread;
+   };
+
+   /**
+    *  Reads a snapshot written by snapshot_writer from an std::istream.
+    *
+    *  Sections have to be read in the order they were written. A background thread reads ahead and hashes the
+    *  stream in large chunks while rows are unpacked on the calling thread; finalize() verifies the checksum.
+    */
+   class snapshot_reader {
+      public:
+         struct section_header {
+            string   name;
+            uint64_t row_count = 0;
+            int64_t  next_id = 0;
+         };
+
+         explicit snapshot_reader( std::istream& in );
+         ~snapshot_reader();
+
+         chain_id_type get_chain_id()const { return chain_id_type( chain_id.data(), chain_id.data_size() ); }
+
+         section_header begin_section( const string& name );
+         void end_section();
+
+         template<typename T>
+         void read_row( T& row ) {
+            BES_ASSERT( rows_remaining > 0, snapshot_exception, "too many rows read from snapshot section ${s}", ("s", section) );
+            snapshot_detail::unpack_field( *this, row );
+            --rows_remaining;
+         }
+
+         /// reads the end marker and verifies the checksum
+         void finalize();
+
+         /// total number of bytes consumed from the stream so far
+         uint64_t size()const { return bytes_read; }
+
+         // fc::raw stream interface
+         void read( char* d, size_t s );
+         bool get( unsigned char& c ) { read( reinterpret_cast<char*>(&c), 1 ); return true; }
+         bool get( char& c ) { read( &c, 1 ); return true; }
+
+      private:
+         void next_chunk();
+         void read_loop();
+         void stop();
+
+         std::istream&               in;
+         fc::sha256                  chain_id;
+         vector<char>                chunk;
+         size_t                      chunk_pos = 0;
+         string                      section;
+         uint64_t                    rows_remaining = 0;
+         uint64_t                    bytes_read = 0;
+
+         std::mutex                  mtx;
+         std::condition_variable     cond;
+         std::deque<vector<char>>    ready;
+         bool                        eof = false;
+         bool                        done = false;
+         std::exception_ptr          read_error;
+         fc::sha256::encoder         checksum;
+         fc::sha256                  expected_checksum;
+         std::thread                 thread;
+   };
+
+   /**
+    *  Writes every row of a chainbase index, in id order, as one snapshot section.
+    */
+   template<typename Index>
+   void add_index_to_snapshot( const chainbase::database& db, snapshot_writer& snapshot ) {
+      using value_type = typename Index::value_type;
+      static_assert( snapshot_row<value_type>::defined, "snapshot row is not declared for this object" );
+
+      const auto& index = db.get_index<Index>();
+      snapshot.begin_section( snapshot_row<value_type>::section_name(), index.indices().size(), index.next_id()._id );
+      for( const auto& row : index.indices() )
+         snapshot.add_row( row );
+      snapshot.end_section();
+   }
+
+   /**
+    *  Recreates the rows of an empty chainbase index from a snapshot section, keeping their original ids.
+    */
+   template<typename Index>
+   void read_index_from_snapshot( chainbase::database& db, snapshot_reader& snapshot ) {
+      using value_type = typename Index::value_type;
+      static_assert( snapshot_row<value_type>::defined, "snapshot row is not declared for this object" );
+
+      auto header = snapshot.begin_section( snapshot_row<value_type>::section_name() );
+      auto& index = db.get_mutable_index<Index>();
+      BES_ASSERT( index.indices().empty(), snapshot_exception,
+                  "cannot load snapshot section ${s} into a database that already has rows", ("s", header.name) );
+
+      for( uint64_t i = 0; i < header.row_count; ++i ) {
+         db.create<value_type>( [&]( auto& row ) {
+            snapshot.read_row( row );
+         });
+      }
+      index.set_next_id( typename value_type::id_type( header.next_id ) );
+      snapshot.end_section();
+   }
+
+} } // besio::chain
+
+#define BES_SNAPSHOT_ROW_PACK_FIELD( r, OBJ, FIELD ) besio::chain::snapshot_detail::pack_field( s, OBJ.FIELD );
+#define BES_SNAPSHOT_ROW_UNPACK_FIELD( r, OBJ, FIELD ) besio::chain::snapshot_detail::unpack_field( s, OBJ.FIELD );
+
+/**
+ *  Declares the snapshot representation of TYPE as the sequence of FIELDS, e.g. (id)(name)(code).
+ *  Must be used at global scope with a fully qualified TYPE.
+ */
+#define BES_SNAPSHOT_ROW( TYPE, FIELDS ) \
+namespace besio { namespace chain { \
+   template<> struct snapshot_row<TYPE> { \
+      static constexpr bool defined = true; \
+      static const char* section_name() { return BOOST_PP_STRINGIZE( TYPE ); } \
+      template<typename Stream> static void pack( Stream& s, const TYPE& v ) { \
+         BOOST_PP_SEQ_FOR_EACH( BES_SNAPSHOT_ROW_PACK_FIELD, v, FIELDS ) \
+      } \
+      template<typename Stream> static void unpack( Stream& s, TYPE& v ) { \
+         BOOST_PP_SEQ_FOR_EACH( BES_SNAPSHOT_ROW_UNPACK_FIELD, v, FIELDS ) \
+      } \
+   }; \
+} }
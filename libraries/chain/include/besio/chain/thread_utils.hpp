@@ -0,0 +1,25 @@
+/**
+ *  @file
+ *  @copyright defined in bes/LICENSE.txt
+ */
+#pragma once
+
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/post.hpp>
+#include <future>
+#include <memory>
+
+namespace besio { namespace chain {
+
+   /**
+    *  Posts f to the thread pool and returns a future that becomes ready once f has run.
+    *  Exceptions thrown by f are rethrown from future::get().
+    */
+   template<typename F>
+   auto async_thread_pool( boost::asio::thread_pool& thread_pool, F&& f ) {
+      auto task = std::make_shared<std::packaged_task<decltype( f() )()>>( std::forward<F>( f ) );
+      boost::asio::post( thread_pool, [task]() { (*task)(); } );
+      return task->get_future();
+   }
+
+} } // besio::chain
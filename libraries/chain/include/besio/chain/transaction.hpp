@@ -7,6 +7,10 @@
 #include <besio/chain/action.hpp>
 #include <numeric>
 
+namespace boost { namespace asio {
+   class thread_pool;
+}}
+
 namespace besio { namespace chain {
 
    /**
@@ -186,6 +190,24 @@ namespace besio { namespace chain {
 
    uint128_t transaction_id_to_sender_id( const transaction_id_type& tid );
 
+   /**
+    *  Recovers the public key of each (signature, digest) pair; the key of signatures[i] is at index i of the result.
+    *  Keys of recently seen pairs come from a cache shared by all threads when use_cache is set. Given a thread_pool,
+    *  larger batches are recovered across its threads as well as the calling one, which must not be one of them.
+    */
+   vector<public_key_type> recover_public_keys( const vector<std::pair<signature_type, digest_type>>& signatures,
+                                               boost::asio::thread_pool* thread_pool = nullptr, bool use_cache = true );
+
+   /// The number of public keys recover_public_keys recovered from their signatures, rather than found in its cache
+   uint64_t recovered_public_key_count();
+
+   /**
+    *  The keys in [first, last) as the signing keys of one transaction; fails with tx_duplicate_sig if a key repeats,
+    *  unless allow_duplicate_keys is set.
+    */
+   flat_set<public_key_type> signature_key_set( vector<public_key_type>::const_iterator first,
+                                               vector<public_key_type>::const_iterator last, bool allow_duplicate_keys = false );
+
 } } /// namespace besio::chain
 
 FC_REFLECT( besio::chain::transaction_header, (expiration)(ref_block_num)(ref_block_prefix)
@@ -0,0 +1,131 @@
+/**
+ *  @file
+ *  @copyright defined in bes/LICENSE.txt
+ */
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace besio { namespace chain {
+
+   /**
+    *  Monotonic memory arena owned by a transaction_context.
+    *
+    *  The containers an apply_context keeps while an action runs (iterator caches, the notified accounts, queued
+    *  inline actions) all die with the transaction, so rather than handing every node back to the heap they are
+    *  carved out of this arena: allocation bumps a pointer and deallocation does nothing. The first chunk lives
+    *  inside the arena itself, further chunks are taken from the heap and grow geometrically. Everything is
+    *  released at once when the arena is destroyed.
+    */
+   class transaction_arena : private boost::noncopyable {
+      public:
+         transaction_arena() = default;
+
+         ~transaction_arena() {
+            release();
+         }
+
+         void* allocate( size_t size, size_t align = alignof(std::max_align_t) ) {
+            auto p = reinterpret_cast<uintptr_t>( _cur );
+            auto aligned = (p + align - 1) & ~(uintptr_t( align ) - 1);
+            if( aligned + size > reinterpret_cast<uintptr_t>( _end ) )
+               return allocate_chunk( size, align );
+            _cur = reinterpret_cast<char*>( aligned + size );
+            return reinterpret_cast<void*>( aligned );
+         }
+
+         /// Frees every chunk taken from the heap and makes the inline chunk available again
+         void release() {
+            while( _chunks ) {
+               auto next = _chunks->next;
+               ::operator delete( _chunks );
+               _chunks = next;
+            }
+            _cur = _inline;
+            _end = _inline + inline_size;
+            _next_chunk_size = first_chunk_size;
+            _heap_bytes = 0;
+         }
+
+         /// Number of bytes taken from the heap beyond the inline chunk
+         size_t heap_bytes()const { return _heap_bytes; }
+
+         static constexpr size_t inline_size      = 8 * 1024;
+         static constexpr size_t first_chunk_size = 32 * 1024;
+         static constexpr size_t max_chunk_size   = 1024 * 1024;
+
+      private:
+         struct chunk {
+            chunk* next;
+         };
+
+         void* allocate_chunk( size_t size, size_t align ) {
+            size_t header = (sizeof(chunk) + align - 1) & ~(align - 1);
+            size_t chunk_size = std::max( _next_chunk_size, header + size );
+            auto c = static_cast<chunk*>( ::operator new( chunk_size ) );
+            c->next = _chunks;
+            _chunks = c;
+            _heap_bytes += chunk_size;
+            _next_chunk_size = std::min( _next_chunk_size * 2, size_t(max_chunk_size) );
+
+            char* begin = reinterpret_cast<char*>( c ) + header;
+            _cur = begin + size;
+            _end = reinterpret_cast<char*>( c ) + chunk_size;
+            return begin;
+         }
+
+         alignas(std::max_align_t) char _inline[inline_size];
+         char*    _cur = _inline;
+         char*    _end = _inline + inline_size;
+         chunk*   _chunks = nullptr;
+         size_t   _next_chunk_size = first_chunk_size;
+         size_t   _heap_bytes = 0;
+   };
+
+   /**
+    *  Standard allocator drawing from a transaction_arena. Deallocation is a no-op, so containers using it must not
+    *  outlive the arena.
+    */
+   template<typename T>
+   class arena_allocator {
+      public:
+         typedef T value_type;
+
+         explicit arena_allocator( transaction_arena& a ) : _arena( &a ) {}
+
+         template<typename U>
+         arena_allocator( const arena_allocator<U>& other ) : _arena( other._arena ) {}
+
+         T* allocate( size_t n ) {
+            if( n > size_t(-1) / sizeof(T) )
+               throw std::bad_alloc();
+            return static_cast<T*>( _arena->allocate( n * sizeof(T), alignof(T) ) );
+         }
+
+         void deallocate( T*, size_t ) {}
+
+         template<typename U>
+         bool operator == ( const arena_allocator<U>& other )const { return _arena == other._arena; }
+         template<typename U>
+         bool operator != ( const arena_allocator<U>& other )const { return _arena != other._arena; }
+
+      private:
+         template<typename U> friend class arena_allocator;
+
+         transaction_arena* _arena;
+   };
+
+   template<typename T>
+   using arena_vector = std::vector<T, arena_allocator<T>>;
+
+   template<typename K, typename V>
+   using arena_map = std::map<K, V, std::less<K>, arena_allocator<std::pair<const K, V>>>;
+
+} } // besio::chain
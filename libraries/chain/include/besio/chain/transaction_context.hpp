@@ -1,6 +1,8 @@
 #pragma once
 #include <besio/chain/controller.hpp>
 #include <besio/chain/trace.hpp>
+#include <besio/chain/transaction_arena.hpp>
+#include <besio/chain/deadline_timer.hpp>
 
 namespace besio { namespace chain {
 
@@ -70,6 +72,9 @@ namespace besio { namespace chain {
 
          fc::time_point                published;
 
+         /// backs the short lived containers of the apply_contexts of this transaction; released with the transaction
+         transaction_arena             arena;
+
 
          vector<action_receipt>        executed;
          flat_set<account_name>        bill_to_accounts;
@@ -103,6 +108,7 @@ namespace besio { namespace chain {
          fc::microseconds              initial_objective_duration_limit;
          fc::microseconds              objective_duration_limit;
          fc::time_point                _deadline = fc::time_point::maximum();
+         mutable deadline_timer        _deadline_timer; ///< armed with _deadline so checktime does not read the clock
          int64_t                       deadline_exception_code = block_cpu_usage_exceeded::code_value;
          int64_t                       billing_timer_exception_code = block_cpu_usage_exceeded::code_value;
          fc::time_point                pseudo_start;
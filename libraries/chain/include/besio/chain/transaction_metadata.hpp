@@ -6,9 +6,20 @@
 #include <besio/chain/transaction.hpp>
 #include <besio/chain/block.hpp>
 #include <besio/chain/trace.hpp>
+#include <functional>
+#include <future>
+
+namespace boost { namespace asio {
+   class thread_pool;
+}}
 
 namespace besio { namespace chain {
 
+class transaction_metadata;
+using transaction_metadata_ptr = std::shared_ptr<transaction_metadata>;
+using signing_keys_future_value_type = std::pair<chain_id_type, flat_set<public_key_type>>;
+using signing_keys_future_type = std::shared_future<signing_keys_future_value_type>;
+
 /**
  *  This data structure should store context-free cached data about a transaction such as
  *  packed/unpacked/compressed and recovered keys
@@ -19,7 +30,7 @@ class transaction_metadata {
       transaction_id_type                                        signed_id;
       signed_transaction                                         trx;
       packed_transaction                                         packed_trx;
-      optional<pair<chain_id_type, flat_set<public_key_type>>>   signing_keys;
+      signing_keys_future_type                                   signing_keys_future;
       bool                                                       accepted = false;
       bool                                                       implicit = false;
       bool                                                       scheduled = false;
@@ -38,15 +49,32 @@ class transaction_metadata {
          signed_id = digest_type::hash(packed_trx);
       }
 
-      const flat_set<public_key_type>& recover_keys( const chain_id_type& chain_id ) {
-         if( !signing_keys || signing_keys->first != chain_id ) // Unlikely for more than one chain_id to be used in one nodbes instance
-            signing_keys = std::make_pair( chain_id, trx.get_signature_keys( chain_id ) );
-         return signing_keys->second;
-      }
+      /**
+       *  Returns the keys recovered from the signatures of this transaction, waiting on signing_keys_future
+       *  if recovery was started on a worker thread. Recovers in the calling thread otherwise.
+       */
+      const flat_set<public_key_type>& recover_keys( const chain_id_type& chain_id );
+
+      /**
+       *  Starts recovering the signing keys of mtrx on thread_pool; does nothing if recovery for chain_id has
+       *  already been started. Later calls to recover_keys only wait on the result.
+       *
+       *  next, if given, is called on the worker thread once the keys are ready, so a caller can continue with
+       *  the transaction without blocking a thread on the future. It is called right away if recovery had
+       *  already been started.
+       */
+      static void create_signing_keys_future( const transaction_metadata_ptr& mtrx, boost::asio::thread_pool& thread_pool,
+                                              const chain_id_type& chain_id, std::function<void()> next = {} );
+
+      /**
+       *  Starts recovering the signing keys of all of mtrxs on thread_pool, in batches of a few transactions each, in
+       *  the order of mtrxs; every transaction's keys, or its error, are in its signing_keys_future once its batch is
+       *  done. Transactions whose recovery was already started are left alone.
+       */
+      static void recover_signing_keys( const vector<transaction_metadata_ptr>& mtrxs, boost::asio::thread_pool& thread_pool,
+                                        const chain_id_type& chain_id );
 
       uint32_t total_actions()const { return trx.context_free_actions.size() + trx.actions.size(); }
 };
 
-using transaction_metadata_ptr = std::shared_ptr<transaction_metadata>;
-
 } } // besio::chain
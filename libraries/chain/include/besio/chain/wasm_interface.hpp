@@ -56,7 +56,9 @@ namespace besio { namespace chain {
             binaryen,
          };
 
-         wasm_interface(vm_type vm);
+         //tiered_compile: when running WAVM, execute newly seen contracts on the binaryen interpreter until their
+         //WAVM compile, done on a background thread, completes
+         wasm_interface(vm_type vm, uint32_t max_cache_size, bool tiered_compile = false);
          ~wasm_interface();
 
          //validates code -- does a WASM validation pass and checks the wasm against BESIO specific constraints
@@ -65,6 +67,13 @@ namespace besio { namespace chain {
          //Calls apply or error on a given code
          void apply(const digest_type& code_id, const shared_string& code, apply_context& context);
 
+         //Queues code to be instantiated on a background thread ahead of its first apply, so the compile cost is
+         //not paid while applying a block; an apply that needs it sooner waits for that compile
+         void warm_up(const digest_type& code_id, const shared_string& code, account_name receiver);
+
+         //Returns (receiver, code_id) for every cached module, least recently used first
+         vector<pair<account_name, digest_type>> get_cached_modules()const;
+
       private:
          unique_ptr<struct wasm_interface_impl> my;
          friend class besio::chain::webassembly::common::intrinsics_accessor;
@@ -7,8 +7,14 @@
 #include <besio/chain/wasm_besio_injection.hpp>
 #include <besio/chain/transaction_context.hpp>
 #include <besio/chain/exceptions.hpp>
+#include <besio/chain/thread_utils.hpp>
 #include <fc/scoped_exit.hpp>
 
+#include <besio/chain/multi_index_includes.hpp>
+
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+
 #include "IR/Module.h"
 #include "Runtime/Intrinsics.h"
 #include "Platform/Platform.h"
@@ -22,14 +28,51 @@ using namespace Runtime;
 
 namespace besio { namespace chain {
 
+   /**
+    *  An instantiated module together with the account that most recently executed it; the account is what
+    *  allows the module to be located again (and its code_version re-checked) when warming the cache on startup.
+    */
+   struct wasm_cache_entry {
+      digest_type                                                  code_id;
+      mutable account_name                                         receiver;
+      mutable std::unique_ptr<wasm_instantiated_module_interface>  module;
+   };
+
+   struct by_code_id;
+   typedef bmi::multi_index_container<
+      wasm_cache_entry,
+      indexed_by<
+         bmi::sequenced<>,
+         bmi::hashed_unique<tag<by_code_id>, member<wasm_cache_entry, digest_type, &wasm_cache_entry::code_id>>
+      >
+   > wasm_cache_index;
+
    struct wasm_interface_impl {
-      wasm_interface_impl(wasm_interface::vm_type vm) {
+      wasm_interface_impl(wasm_interface::vm_type vm, uint32_t max_cache_size, bool tiered_compile) : max_cache_size(max_cache_size) {
+         BES_ASSERT(max_cache_size > 0, wasm_exception, "wasm instantiation cache must hold at least one module");
          if(vm == wasm_interface::vm_type::wavm)
             runtime_interface = std::make_unique<webassembly::wavm::wavm_runtime>();
          else if(vm == wasm_interface::vm_type::binaryen)
             runtime_interface = std::make_unique<webassembly::binaryen::binaryen_runtime>();
          else
             BES_THROW(wasm_exception, "wasm_interface_impl fall through");
+
+         // only WAVM has a compile step worth hiding behind the interpreter
+         if(tiered_compile && vm == wasm_interface::vm_type::wavm) {
+            tiered = true;
+            interpreter_runtime = std::make_unique<webassembly::binaryen::binaryen_runtime>();
+            compile_thread = std::make_unique<boost::asio::thread_pool>(1);
+         }
+      }
+
+      ~wasm_interface_impl() {
+         if(compile_thread) {
+            compile_thread->stop();
+            compile_thread->join();
+         }
+         pending_compiles.clear();
+         warm_ups.clear();
+         instantiation_cache.clear();
       }
 
       std::vector<uint8_t> parse_initial_memory(const Module& module) {
@@ -50,47 +93,206 @@ namespace besio { namespace chain {
          return mem_image;
       }
 
+      struct prepared_module {
+         std::vector<U8>      bytes;
+         std::vector<uint8_t> initial_memory;
+      };
+
+      /// decodes the contract, applies the BESIO injections and re-encodes it for consumption by a runtime
+      prepared_module prepare_module( const char* code, size_t code_size ) {
+         IR::Module module;
+         try {
+            Serialization::MemoryInputStream stream((const U8*)code, code_size);
+            WASM::serialize(stream, module);
+            module.userSections.clear();
+         } catch(const Serialization::FatalSerializationException& e) {
+            BES_ASSERT(false, wasm_serialization_error, e.message.c_str());
+         } catch(const IR::ValidationException& e) {
+            BES_ASSERT(false, wasm_serialization_error, e.message.c_str());
+         }
+
+         wasm_injections::wasm_binary_injection injector(module);
+         injector.inject();
+
+         prepared_module prepared;
+         try {
+            Serialization::ArrayOutputStream outstream;
+            WASM::serialize(outstream, module);
+            prepared.bytes = outstream.getBytes();
+         } catch(const Serialization::FatalSerializationException& e) {
+            BES_ASSERT(false, wasm_serialization_error, e.message.c_str());
+         } catch(const IR::ValidationException& e) {
+            BES_ASSERT(false, wasm_serialization_error, e.message.c_str());
+         }
+         prepared.initial_memory = parse_initial_memory(module);
+         return prepared;
+      }
+
+      std::unique_ptr<wasm_instantiated_module_interface> instantiate_module( const shared_string& code ) {
+         auto prepared = prepare_module(code.data(), code.size());
+         return runtime_interface->instantiate_module((const char*)prepared.bytes.data(), prepared.bytes.size(), std::move(prepared.initial_memory));
+      }
+
+      /**
+       *  Instantiates the contract on the interpreter, which is cheap, and queues the WAVM compile of the same
+       *  module on the background compile thread; swap_compiled_modules later replaces the interpreted module.
+       */
+      std::unique_ptr<wasm_instantiated_module_interface> instantiate_module_tiered( const digest_type& code_id, const shared_string& code ) {
+         auto prepared = std::make_shared<prepared_module>( prepare_module(code.data(), code.size()) );
+         auto interpreted = interpreter_runtime->instantiate_module((const char*)prepared->bytes.data(), prepared->bytes.size(), prepared->initial_memory);
+
+         if( !pending_compiles.count(code_id) ) {
+            pending_compiles.emplace( code_id, async_thread_pool( get_compile_thread(), [this, prepared]() {
+               return runtime_interface->instantiate_module((const char*)prepared->bytes.data(), prepared->bytes.size(), std::move(prepared->initial_memory));
+            } ) );
+         }
+         return interpreted;
+      }
+
+      /**
+       *  Queues the compile of a contract nothing has executed yet on the compile thread. The module is put in the
+       *  cache by swap_compiled_modules or wait_for_compile like any other background compile; warm_ups remembers
+       *  the account it is cached for, since no cache entry exists for it until then.
+       */
+      void queue_warm_up( const digest_type& code_id, const shared_string& code, account_name receiver ) {
+         if( instantiation_cache.get<by_code_id>().count(code_id) || pending_compiles.count(code_id) )
+            return;
+         // the code lives in the state database, which the main thread goes on modifying
+         auto copy = std::make_shared<std::string>( code.data(), code.size() );
+         pending_compiles.emplace( code_id, async_thread_pool( get_compile_thread(), [this, copy]() {
+            auto prepared = prepare_module( copy->data(), copy->size() );
+            return runtime_interface->instantiate_module((const char*)prepared.bytes.data(), prepared.bytes.size(), std::move(prepared.initial_memory));
+         } ) );
+         warm_ups.emplace( code_id, receiver );
+      }
+
+      /// the compile thread, started on first use when tiered compilation is off
+      boost::asio::thread_pool& get_compile_thread() {
+         if( !compile_thread )
+            compile_thread = std::make_unique<boost::asio::thread_pool>(1);
+         return *compile_thread;
+      }
+
+      /**
+       *  Moves finished background compiles into the instantiation cache. Called only between actions, so the
+       *  interpreted module being replaced is never executing.
+       */
+      void swap_compiled_modules() {
+         auto& by_code = instantiation_cache.get<by_code_id>();
+         for( auto itr = pending_compiles.begin(); itr != pending_compiles.end(); ) {
+            if( itr->second.wait_for( std::chrono::seconds(0) ) != std::future_status::ready ) {
+               ++itr;
+               continue;
+            }
+            auto it = by_code.find( itr->first );
+            auto warm_up = warm_ups.find( itr->first );
+            try {
+               auto compiled = itr->second.get();
+               // a module evicted while it was being compiled is dropped
+               if( it != by_code.end() )
+                  it->module = std::move(compiled);
+               else if( warm_up != warm_ups.end() )
+                  insert_module( itr->first, warm_up->second, std::move(compiled) );
+            } catch( const fc::exception& e ) {
+               // drop the interpreted module too; blocks must never be validated on it
+               wlog( "background compile of ${id} failed: ${e}", ("id", itr->first)("e", e.to_detail_string()) );
+               if( it != by_code.end() )
+                  by_code.erase(it);
+            } catch( ... ) {
+               wlog( "background compile of ${id} failed", ("id", itr->first) );
+               if( it != by_code.end() )
+                  by_code.erase(it);
+            }
+            if( warm_up != warm_ups.end() )
+               warm_ups.erase( warm_up );
+            itr = pending_compiles.erase(itr);
+         }
+      }
+
+      /**
+       *  Blocks until the background compile of code_id has finished and puts its module in the cache, replacing
+       *  the interpreted one. A failed compile throws here, as instantiating the module synchronously would have,
+       *  and the interpreted module is dropped so the next lookup compiles it again.
+       */
+      void wait_for_compile( const digest_type& code_id, account_name receiver ) {
+         auto itr = pending_compiles.find( code_id );
+         auto compile = std::move(itr->second);
+         pending_compiles.erase(itr);
+         warm_ups.erase( code_id );
+
+         auto& by_code = instantiation_cache.get<by_code_id>();
+         auto it = by_code.find( code_id );
+         std::unique_ptr<wasm_instantiated_module_interface> compiled;
+         try {
+            compiled = compile.get();
+         } catch( ... ) {
+            if( it != by_code.end() )
+               by_code.erase(it);
+            throw;
+         }
+         if( it != by_code.end() )
+            it->module = std::move(compiled);
+         else
+            insert_module( code_id, receiver, std::move(compiled) );
+      }
+
+      /**
+       *  Inserts a freshly instantiated module at the most recently used end of the cache and evicts from the
+       *  least recently used end until the cache is back within max_cache_size.
+       */
+      const wasm_cache_entry& insert_module( const digest_type& code_id, account_name receiver,
+                                             std::unique_ptr<wasm_instantiated_module_interface>&& module ) {
+         auto res = instantiation_cache.emplace_front( wasm_cache_entry{ code_id, receiver, std::move(module) } );
+         while( instantiation_cache.size() > max_cache_size && instantiation_cache.size() > 1 )
+            instantiation_cache.pop_back();
+         return *res.first;
+      }
+
       std::unique_ptr<wasm_instantiated_module_interface>& get_instantiated_module( const digest_type& code_id,
                                                                                     const shared_string& code,
+                                                                                    account_name receiver,
                                                                                     transaction_context& trx_context )
       {
-         auto it = instantiation_cache.find(code_id);
-         if(it == instantiation_cache.end()) {
+         if( !pending_compiles.empty() )
+            swap_compiled_modules();
+
+         // Only speculative and produced blocks run on the interpreter. Blocks are validated on compiled code so
+         // an interpreted action can never exceed the CPU time a validator allows for it.
+         const bool interpret = tiered && trx_context.control.is_producing_block();
+         if( !interpret && pending_compiles.count(code_id) ) {
             auto timer_pause = fc::make_scoped_exit([&](){
                trx_context.resume_billing_timer();
             });
             trx_context.pause_billing_timer();
-            IR::Module module;
-            try {
-               Serialization::MemoryInputStream stream((const U8*)code.data(), code.size());
-               WASM::serialize(stream, module);
-               module.userSections.clear();
-            } catch(const Serialization::FatalSerializationException& e) {
-               BES_ASSERT(false, wasm_serialization_error, e.message.c_str());
-            } catch(const IR::ValidationException& e) {
-               BES_ASSERT(false, wasm_serialization_error, e.message.c_str());
-            }
-
-            wasm_injections::wasm_binary_injection injector(module);
-            injector.inject();
+            wait_for_compile( code_id, receiver );
+         }
 
-            std::vector<U8> bytes;
-            try {
-               Serialization::ArrayOutputStream outstream;
-               WASM::serialize(outstream, module);
-               bytes = outstream.getBytes();
-            } catch(const Serialization::FatalSerializationException& e) {
-               BES_ASSERT(false, wasm_serialization_error, e.message.c_str());
-            } catch(const IR::ValidationException& e) {
-               BES_ASSERT(false, wasm_serialization_error, e.message.c_str());
-            }
-            it = instantiation_cache.emplace(code_id, runtime_interface->instantiate_module((const char*)bytes.data(), bytes.size(), parse_initial_memory(module))).first;
+         auto& by_code = instantiation_cache.get<by_code_id>();
+         auto it = by_code.find(code_id);
+         if(it != by_code.end()) {
+            auto seq_it = instantiation_cache.project<0>(it);
+            instantiation_cache.relocate( instantiation_cache.begin(), seq_it );
+            it->receiver = receiver;
+            return it->module;
          }
-         return it->second;
+
+         auto timer_pause = fc::make_scoped_exit([&](){
+            trx_context.resume_billing_timer();
+         });
+         trx_context.pause_billing_timer();
+         if( interpret )
+            return insert_module( code_id, receiver, instantiate_module_tiered(code_id, code) ).module;
+         return insert_module( code_id, receiver, instantiate_module(code) ).module;
       }
 
       std::unique_ptr<wasm_runtime_interface> runtime_interface;
-      map<digest_type, std::unique_ptr<wasm_instantiated_module_interface>> instantiation_cache;
+      std::unique_ptr<wasm_runtime_interface> interpreter_runtime; ///< first tier when tiered compilation is enabled
+      std::unique_ptr<boost::asio::thread_pool> compile_thread;
+      bool                                    tiered = false;
+      map<digest_type, std::future<std::unique_ptr<wasm_instantiated_module_interface>>> pending_compiles;
+      map<digest_type, account_name>          warm_ups; ///< pending compiles queued by warm_up, with the account to cache them for
+      wasm_cache_index                        instantiation_cache;
+      uint32_t                                max_cache_size = std::numeric_limits<uint32_t>::max();
    };
 
 #define _REGISTER_INTRINSIC_EXPLICIT(CLS, MOD, METHOD, WASM_SIG, NAME, SIG)\
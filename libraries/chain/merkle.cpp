@@ -1,4 +1,5 @@
 #include <besio/chain/merkle.hpp>
+#include <besio/chain/thread_utils.hpp>
 #include <fc/io/raw.hpp>
 
 namespace besio { namespace chain {
@@ -31,19 +32,66 @@ bool is_canonical_right(const digest_type& val) {
    return (val._hash[0] & 0x0000000000000080ULL) != 0;
 }
 
+namespace {
 
-digest_type merkle(vector<digest_type> ids) {
+   const size_t parallel_merkle_pairs = 4096; ///< levels with fewer pairs are hashed on the calling thread only
+   const size_t merkle_pairs_per_task = 2048;
+
+   const size_t pairs_per_batch = 64;
+
+   /**
+    * out[i] = hash of the canonical pair in[2*i], in[2*i+1], for i < n
+    *
+    * A canonical pair packs to its two digests, so the pairs are laid out in a buffer and hashed as 64 byte messages
+    * with sha256::hash_many. Each batch is copied before it is hashed, so out may be in.
+    */
+   void hash_pairs( const digest_type* in, digest_type* out, size_t n ) {
+      digest_type canonical[2 * pairs_per_batch];
+      const char* data[pairs_per_batch];
+      uint32_t sizes[pairs_per_batch];
+      for( size_t first = 0; first < n; first += pairs_per_batch ) {
+         const size_t batch = std::min( pairs_per_batch, n - first );
+         for( size_t i = 0; i < batch; ++i ) {
+            canonical[2 * i]     = make_canonical_left( in[2 * (first + i)] );
+            canonical[2 * i + 1] = make_canonical_right( in[2 * (first + i) + 1] );
+            data[i]  = canonical[2 * i].data();
+            sizes[i] = 2 * sizeof(digest_type);
+         }
+         digest_type::hash_many( data, sizes, out + first, batch );
+      }
+   }
+
+}
+
+digest_type merkle(vector<digest_type> ids, boost::asio::thread_pool* thread_pool) {
    if( 0 == ids.size() ) { return digest_type(); }
 
+   vector<std::future<void>> tasks;
    while( ids.size() > 1 ) {
       if( ids.size() % 2 )
          ids.push_back(ids.back());
 
-      for (int i = 0; i < ids.size() / 2; i++) {
-         ids[i] = digest_type::hash(make_canonical_pair(ids[2 * i], ids[(2 * i) + 1]));
+      // hashed in order, a level can be hashed in place as ids[i] is only written once ids[2*i] and ids[2*i+1] have
+      // been read; split across threads, a part would overwrite the input of another, so a new level is filled
+      const size_t pairs = ids.size() / 2;
+      if( thread_pool && pairs >= parallel_merkle_pairs ) {
+         vector<digest_type> next( pairs );
+         const digest_type* in = ids.data();
+         for( size_t first = merkle_pairs_per_task; first < pairs; first += merkle_pairs_per_task ) {
+            auto n = std::min( merkle_pairs_per_task, pairs - first );
+            tasks.emplace_back( async_thread_pool( *thread_pool, [in, out = next.data(), first, n]() {
+               hash_pairs( in + 2 * first, out + first, n );
+            } ) );
+         }
+         hash_pairs( in, next.data(), merkle_pairs_per_task );
+         for( auto& t : tasks )
+            t.get();
+         tasks.clear();
+         ids = std::move( next );
+      } else {
+         hash_pairs( ids.data(), ids.data(), pairs );
+         ids.resize( pairs );
       }
-
-      ids.resize(ids.size() / 2);
    }
 
    return ids.front();
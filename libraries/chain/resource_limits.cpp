@@ -3,10 +3,33 @@
 #include <besio/chain/resource_limits_private.hpp>
 #include <besio/chain/transaction_metadata.hpp>
 #include <besio/chain/transaction.hpp>
+#include <besio/chain/database_utils.hpp>
 #include <algorithm>
 
+BES_SNAPSHOT_ROW( besio::chain::resource_limits::ratio, (numerator)(denominator) )
+BES_SNAPSHOT_ROW( besio::chain::resource_limits::elastic_limit_parameters,
+                  (target)(max)(periods)(max_multiplier)(contract_rate)(expand_rate) )
+BES_SNAPSHOT_ROW( besio::chain::resource_limits::usage_accumulator, (last_ordinal)(value_ex)(consumed) )
+
+BES_SNAPSHOT_ROW( besio::chain::resource_limits::resource_limits_object,
+                  (id)(owner)(pending)(net_weight)(cpu_weight)(ram_bytes) )
+BES_SNAPSHOT_ROW( besio::chain::resource_limits::resource_usage_object,
+                  (id)(owner)(net_usage)(cpu_usage)(ram_usage) )
+BES_SNAPSHOT_ROW( besio::chain::resource_limits::resource_limits_state_object,
+                  (id)(average_block_net_usage)(average_block_cpu_usage)(pending_net_usage)(pending_cpu_usage)
+                  (total_net_weight)(total_cpu_weight)(total_ram_bytes)(virtual_net_limit)(virtual_cpu_limit) )
+BES_SNAPSHOT_ROW( besio::chain::resource_limits::resource_limits_config_object,
+                  (id)(cpu_limit_parameters)(net_limit_parameters)(account_cpu_usage_average_window)(account_net_usage_average_window) )
+
 namespace besio { namespace chain { namespace resource_limits {
 
+using resource_index_set = index_set<
+   resource_limits_index,
+   resource_usage_index,
+   resource_limits_state_index,
+   resource_limits_config_index
+>;
+
 static_assert( config::rate_limiting_precision > 0, "config::rate_limiting_precision must be positive" );
 
 static uint64_t update_elastic_limit(uint64_t current_limit, uint64_t average_usage, const elastic_limit_parameters& params) {
@@ -39,10 +62,7 @@ void resource_limits_state_object::update_virtual_net_limit( const resource_limi
 }
 
 void resource_limits_manager::add_indices() {
-   _db.add_index<resource_limits_index>();
-   _db.add_index<resource_usage_index>();
-   _db.add_index<resource_limits_state_index>();
-   _db.add_index<resource_limits_config_index>();
+   resource_index_set::add_indices( _db );
 }
 
 void resource_limits_manager::initialize_database() {
@@ -59,6 +79,14 @@ void resource_limits_manager::initialize_database() {
    });
 }
 
+void resource_limits_manager::add_to_snapshot( snapshot_writer& snapshot )const {
+   resource_index_set::add_to_snapshot( _db, snapshot );
+}
+
+void resource_limits_manager::read_from_snapshot( snapshot_reader& snapshot ) {
+   resource_index_set::read_from_snapshot( _db, snapshot );
+}
+
 void resource_limits_manager::initialize_account(const account_name& account) {
    _db.create<resource_limits_object>([&]( resource_limits_object& bl ) {
       bl.owner = account;
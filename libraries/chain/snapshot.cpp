@@ -0,0 +1,284 @@
+/**
+ *  @file
+ *  @copyright defined in bes/LICENSE.txt
+ */
+#include <besio/chain/snapshot.hpp>
+
+#include <istream>
+#include <ostream>
+
+namespace besio { namespace chain {
+
+   namespace {
+      const size_t   snapshot_chunk_size   = 4*1024*1024; ///< bytes handed between the stream thread and the caller at once
+      const size_t   max_read_ahead_chunks = 8;           ///< bounds the memory used while the slower side catches up
+      const size_t   checksum_size         = sizeof(fc::sha256);
+   }
+
+   const uint32_t snapshot_writer::magic_number    = 0x50414e53; // "SNAP"
+   const uint32_t snapshot_writer::current_version = 1;
+   const size_t   snapshot_writer::default_max_queued_chunks = 8;
+
+   snapshot_writer::snapshot_writer( std::ostream& out, const chain_id_type& chain_id, size_t max_queued_chunks )
+   :out(out)
+   ,max_queued_chunks(max_queued_chunks)
+   {
+      buffer.reserve( snapshot_chunk_size );
+      thread = std::thread( [this]() { write_loop(); } );
+
+      fc::raw::pack( *this, magic_number );
+      fc::raw::pack( *this, current_version );
+      fc::raw::pack( *this, chain_id );
+   }
+
+   snapshot_writer::~snapshot_writer() {
+      stop();
+   }
+
+   void snapshot_writer::stop() {
+      {
+         std::lock_guard<std::mutex> g( mtx );
+         done = true;
+      }
+      cond.notify_all();
+      if( thread.joinable() )
+         thread.join();
+   }
+
+   void snapshot_writer::begin_section( const string& name, uint64_t row_count, int64_t next_id ) {
+      BES_ASSERT( !finalized, snapshot_exception, "snapshot has already been finalized" );
+      BES_ASSERT( section.empty(), snapshot_exception, "snapshot section ${s} has not been ended", ("s", section) );
+      BES_ASSERT( !name.empty(), snapshot_exception, "snapshot sections must be named" );
+
+      section = name;
+      rows_remaining = row_count;
+      fc::raw::pack( *this, name );
+      fc::raw::pack( *this, row_count );
+      fc::raw::pack( *this, next_id );
+   }
+
+   void snapshot_writer::end_section() {
+      BES_ASSERT( rows_remaining == 0, snapshot_exception, "snapshot section ${s} is missing ${n} rows",
+                  ("s", section)("n", rows_remaining) );
+      section.clear();
+   }
+
+   void snapshot_writer::write( const char* d, size_t s ) {
+      buffer.insert( buffer.end(), d, d + s );
+      bytes_written += s;
+      if( buffer.size() >= snapshot_chunk_size )
+         flush_buffer();
+   }
+
+   void snapshot_writer::flush_buffer() {
+      if( buffer.empty() )
+         return;
+
+      {
+         std::unique_lock<std::mutex> lock( mtx );
+         cond.wait( lock, [this]() { return max_queued_chunks == 0 || pending.size() < max_queued_chunks || write_error; } );
+         if( write_error )
+            std::rethrow_exception( write_error );
+         pending.emplace_back( std::move( buffer ) );
+      }
+      cond.notify_all();
+
+      buffer = vector<char>();
+      buffer.reserve( snapshot_chunk_size );
+   }
+
+   void snapshot_writer::write_loop() {
+      try {
+         while( true ) {
+            vector<char> chunk;
+            {
+               std::unique_lock<std::mutex> lock( mtx );
+               cond.wait( lock, [this]() { return !pending.empty() || done; } );
+               if( pending.empty() )
+                  return;
+               chunk = std::move( pending.front() );
+               pending.pop_front();
+            }
+            cond.notify_all();
+
+            checksum.write( chunk.data(), chunk.size() );
+            out.write( chunk.data(), chunk.size() );
+            BES_ASSERT( out.good(), snapshot_exception, "failed to write snapshot" );
+         }
+      } catch( ... ) {
+         {
+            std::lock_guard<std::mutex> g( mtx );
+            write_error = std::current_exception();
+         }
+         cond.notify_all();
+      }
+   }
+
+   void snapshot_writer::finalize() {
+      BES_ASSERT( !finalized, snapshot_exception, "snapshot has already been finalized" );
+      BES_ASSERT( section.empty(), snapshot_exception, "snapshot section ${s} has not been ended", ("s", section) );
+
+      fc::raw::pack( *this, string() );
+      flush_buffer();
+      stop();
+      if( write_error )
+         std::rethrow_exception( write_error );
+
+      auto digest = checksum.result();
+      out.write( digest.data(), digest.data_size() );
+      out.flush();
+      BES_ASSERT( out.good(), snapshot_exception, "failed to write snapshot" );
+      bytes_written += digest.data_size();
+      finalized = true;
+   }
+
+   snapshot_reader::snapshot_reader( std::istream& in )
+   :in(in)
+   {
+      thread = std::thread( [this]() { read_loop(); } );
+
+      try {
+         uint32_t magic = 0;
+         uint32_t version = 0;
+         fc::raw::unpack( *this, magic );
+         BES_ASSERT( magic == snapshot_writer::magic_number, snapshot_exception, "stream does not contain a snapshot" );
+         fc::raw::unpack( *this, version );
+         BES_ASSERT( version == snapshot_writer::current_version, snapshot_exception,
+                     "unsupported snapshot version ${v}, this node reads version ${c}",
+                     ("v", version)("c", snapshot_writer::current_version) );
+         fc::raw::unpack( *this, chain_id );
+      } catch( ... ) {
+         stop();
+         throw;
+      }
+   }
+
+   snapshot_reader::~snapshot_reader() {
+      stop();
+   }
+
+   void snapshot_reader::stop() {
+      {
+         std::lock_guard<std::mutex> g( mtx );
+         done = true;
+      }
+      cond.notify_all();
+      if( thread.joinable() )
+         thread.join();
+   }
+
+   snapshot_reader::section_header snapshot_reader::begin_section( const string& name ) {
+      BES_ASSERT( section.empty(), snapshot_exception, "snapshot section ${s} has not been ended", ("s", section) );
+
+      section_header header;
+      fc::raw::unpack( *this, header.name );
+      BES_ASSERT( header.name == name, snapshot_exception, "expected snapshot section ${e} but found ${f}",
+                  ("e", name)("f", header.name) );
+      fc::raw::unpack( *this, header.row_count );
+      fc::raw::unpack( *this, header.next_id );
+
+      section = name;
+      rows_remaining = header.row_count;
+      return header;
+   }
+
+   void snapshot_reader::end_section() {
+      BES_ASSERT( rows_remaining == 0, snapshot_exception, "${n} rows of snapshot section ${s} were not read",
+                  ("s", section)("n", rows_remaining) );
+      section.clear();
+   }
+
+   void snapshot_reader::read( char* d, size_t s ) {
+      while( s > 0 ) {
+         if( chunk_pos == chunk.size() )
+            next_chunk();
+         size_t n = std::min( s, chunk.size() - chunk_pos );
+         memcpy( d, chunk.data() + chunk_pos, n );
+         chunk_pos += n;
+         d += n;
+         s -= n;
+         bytes_read += n;
+      }
+   }
+
+   void snapshot_reader::next_chunk() {
+      {
+         std::unique_lock<std::mutex> lock( mtx );
+         cond.wait( lock, [this]() { return !ready.empty() || eof || read_error; } );
+         if( ready.empty() ) {
+            if( read_error )
+               std::rethrow_exception( read_error );
+            BES_THROW( snapshot_exception, "unexpected end of snapshot" );
+         }
+         chunk = std::move( ready.front() );
+         ready.pop_front();
+         chunk_pos = 0;
+      }
+      cond.notify_all();
+   }
+
+   /**
+    *  Reads the stream ahead of the caller. The last checksum_size bytes are always held back, so that once the
+    *  stream ends they are the expected checksum and everything handed out before them has been hashed.
+    */
+   void snapshot_reader::read_loop() {
+      try {
+         vector<char> held;
+         while( true ) {
+            vector<char> data( std::move( held ) );
+            size_t start = data.size();
+            data.resize( start + snapshot_chunk_size );
+            in.read( data.data() + start, snapshot_chunk_size );
+            data.resize( start + in.gcount() );
+            BES_ASSERT( !in.bad() && (in.good() || in.eof()), snapshot_exception, "failed to read snapshot" );
+
+            size_t keep = std::min( data.size(), checksum_size );
+            held.assign( data.end() - keep, data.end() );
+            data.resize( data.size() - keep );
+
+            if( !data.empty() ) {
+               checksum.write( data.data(), data.size() );
+               std::unique_lock<std::mutex> lock( mtx );
+               cond.wait( lock, [this]() { return ready.size() < max_read_ahead_chunks || done; } );
+               if( done )
+                  return;
+               ready.emplace_back( std::move( data ) );
+               lock.unlock();
+               cond.notify_all();
+            }
+
+            if( in.eof() ) {
+               BES_ASSERT( held.size() == checksum_size, snapshot_exception, "snapshot is truncated" );
+               std::lock_guard<std::mutex> g( mtx );
+               expected_checksum = fc::sha256( held.data(), held.size() );
+               eof = true;
+               break;
+            }
+         }
+      } catch( ... ) {
+         std::lock_guard<std::mutex> g( mtx );
+         read_error = std::current_exception();
+      }
+      cond.notify_all();
+   }
+
+   void snapshot_reader::finalize() {
+      BES_ASSERT( section.empty(), snapshot_exception, "snapshot section ${s} has not been ended", ("s", section) );
+
+      string end_marker;
+      fc::raw::unpack( *this, end_marker );
+      BES_ASSERT( end_marker.empty(), snapshot_exception, "unexpected snapshot section ${s}", ("s", end_marker) );
+
+      {
+         std::unique_lock<std::mutex> lock( mtx );
+         cond.wait( lock, [this]() { return eof || read_error || !ready.empty(); } );
+         if( read_error )
+            std::rethrow_exception( read_error );
+         BES_ASSERT( chunk_pos == chunk.size() && ready.empty(), snapshot_exception, "snapshot has trailing data" );
+      }
+      stop();
+
+      BES_ASSERT( checksum.result() == expected_checksum, snapshot_exception, "snapshot checksum does not match its contents" );
+   }
+
+} } // besio::chain
@@ -6,6 +6,9 @@
 #include <fc/bitutil.hpp>
 #include <fc/smart_ref_impl.hpp>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
 
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/multi_index_container.hpp>
@@ -19,13 +22,14 @@
 #include <besio/chain/config.hpp>
 #include <besio/chain/exceptions.hpp>
 #include <besio/chain/transaction.hpp>
+#include <besio/chain/thread_utils.hpp>
 
 namespace besio { namespace chain {
 
 using namespace boost::multi_index;
 
 struct cached_pub_key {
-   transaction_id_type trx_id;
+   digest_type digest;
    public_key_type pub_key;
    signature_type sig;
    cached_pub_key(const cached_pub_key&) = delete;
@@ -48,6 +52,134 @@ typedef multi_index_container<
    >
 > recovery_cache_type;
 
+namespace {
+
+   /**
+    * Keys recovered from recent signatures. Keys are recovered concurrently from the controller thread pool, so the
+    * cache is split into shards by signature, each with its own lock, and threads recovering different signatures
+    * rarely wait on each other. Each shard drops its oldest entries once it is full.
+    */
+   class recovery_cache {
+      public:
+         bool find( const signature_type& sig, const digest_type& digest, public_key_type& key ) {
+            auto& s = shard_of( sig );
+            std::lock_guard<std::mutex> lock( s.mtx );
+            auto it = s.keys.get<by_sig>().find( sig );
+            if( it == s.keys.get<by_sig>().end() || it->digest != digest )
+               return false;
+            key = it->pub_key;
+            return true;
+         }
+
+         void insert( const signature_type& sig, const digest_type& digest, const public_key_type& key ) {
+            auto& s = shard_of( sig );
+            std::lock_guard<std::mutex> lock( s.mtx );
+            s.keys.emplace_back( cached_pub_key{digest, key, sig} ); //could fail on dup signatures; not a problem
+            while( s.keys.size() > keys_per_shard )
+               s.keys.erase( s.keys.begin() );
+         }
+
+      private:
+         static constexpr size_t shard_count    = 16;
+         static constexpr size_t keys_per_shard = 64;
+
+         struct shard {
+            std::mutex          mtx;
+            recovery_cache_type keys;
+         };
+
+         shard& shard_of( const signature_type& sig ) {
+            return shards[hash_value( sig ) % shard_count];
+         }
+
+         std::array<shard, shard_count> shards;
+   };
+
+   recovery_cache& get_recovery_cache() {
+      static recovery_cache cache;
+      return cache;
+   }
+
+   const size_t parallel_recovery_keys = 64; ///< fewer keys are recovered on the calling thread only
+   const size_t recovery_keys_per_task = 32;
+
+   std::atomic<uint64_t> recovered_keys{0};
+
+}
+
+vector<public_key_type> recover_public_keys( const vector<std::pair<signature_type, digest_type>>& signatures,
+                                            boost::asio::thread_pool* thread_pool, bool use_cache )
+{
+   vector<public_key_type> keys( signatures.size() );
+
+   // indexes of the signatures the cache does not know
+   vector<size_t> missing;
+   missing.reserve( signatures.size() );
+   for( size_t i = 0; i < signatures.size(); ++i ) {
+      if( !use_cache || !get_recovery_cache().find( signatures[i].first, signatures[i].second, keys[i] ) )
+         missing.push_back( i );
+   }
+
+   auto recover = [&]( size_t first, size_t n ) {
+      for( size_t j = first; j < first + n; ++j ) {
+         const auto& p = signatures[missing[j]];
+         keys[missing[j]] = public_key_type( p.first, p.second );
+         ++recovered_keys;
+         if( use_cache )
+            get_recovery_cache().insert( p.first, p.second, keys[missing[j]] );
+      }
+   };
+
+   if( thread_pool && missing.size() >= parallel_recovery_keys ) {
+      // the secp256k1 context and its precomputed tables are shared by every thread, each task only writes its own keys
+      vector<std::future<void>> tasks;
+      for( size_t first = recovery_keys_per_task; first < missing.size(); first += recovery_keys_per_task ) {
+         auto n = std::min( recovery_keys_per_task, missing.size() - first );
+         tasks.emplace_back( async_thread_pool( *thread_pool, [&recover, first, n]() { recover( first, n ); } ) );
+      }
+      // the tasks refer to this frame, so all of them are waited on before an error is rethrown
+      std::exception_ptr error;
+      try {
+         recover( 0, recovery_keys_per_task );
+      } catch( ... ) {
+         error = std::current_exception();
+      }
+      for( auto& t : tasks ) {
+         try {
+            t.get();
+         } catch( ... ) {
+            if( !error ) error = std::current_exception();
+         }
+      }
+      if( error )
+         std::rethrow_exception( error );
+   } else {
+      recover( 0, missing.size() );
+   }
+
+   return keys;
+}
+
+uint64_t recovered_public_key_count() {
+   return recovered_keys;
+}
+
+flat_set<public_key_type> signature_key_set( vector<public_key_type>::const_iterator first,
+                                            vector<public_key_type>::const_iterator last, bool allow_duplicate_keys )
+{
+   flat_set<public_key_type> recovered_pub_keys;
+   recovered_pub_keys.reserve( last - first );
+   for( ; first != last; ++first ) {
+      bool successful_insertion = false;
+      std::tie(std::ignore, successful_insertion) = recovered_pub_keys.insert(*first);
+      BES_ASSERT( allow_duplicate_keys || successful_insertion, tx_duplicate_sig,
+                  "transaction includes more than one signature signed using the same key associated with public key: ${key}",
+                  ("key", *first)
+               );
+   }
+   return recovered_pub_keys;
+}
+
 void transaction_header::set_reference_block( const block_id_type& reference_block ) {
    ref_block_num    = fc::endian_reverse_u32(reference_block._hash[0]);
    ref_block_prefix = reference_block._hash[1];
@@ -84,40 +216,15 @@ digest_type transaction::sig_digest( const chain_id_type& chain_id, const vector
 flat_set<public_key_type> transaction::get_signature_keys( const vector<signature_type>& signatures,
       const chain_id_type& chain_id, const vector<bytes>& cfd, bool allow_duplicate_keys, bool use_cache )const
 { try {
-   using boost::adaptors::transformed;
-
-   constexpr size_t recovery_cache_size = 1000;
-   static recovery_cache_type recovery_cache;
    const digest_type digest = sig_digest(chain_id, cfd);
 
-   flat_set<public_key_type> recovered_pub_keys;
-   for(const signature_type& sig : signatures) {
-      public_key_type recov;
-      if( use_cache ) {
-         recovery_cache_type::index<by_sig>::type::iterator it = recovery_cache.get<by_sig>().find( sig );
-         if( it == recovery_cache.get<by_sig>().end() || it->trx_id != id()) {
-            recov = public_key_type( sig, digest );
-            recovery_cache.emplace_back(cached_pub_key{id(), recov, sig} ); //could fail on dup signatures; not a problem
-         } else {
-            recov = it->pub_key;
-         }
-      } else {
-         recov = public_key_type( sig, digest );
-      }
-      bool successful_insertion = false;
-      std::tie(std::ignore, successful_insertion) = recovered_pub_keys.insert(recov);
-      BES_ASSERT( allow_duplicate_keys || successful_insertion, tx_duplicate_sig,
-                  "transaction includes more than one signature signed using the same key associated with public key: ${key}",
-                  ("key", recov)
-               );
-   }
+   vector<std::pair<signature_type, digest_type>> sig_digests;
+   sig_digests.reserve( signatures.size() );
+   for( const signature_type& sig : signatures )
+      sig_digests.emplace_back( sig, digest );
 
-   if( use_cache ) {
-      while ( recovery_cache.size() > recovery_cache_size )
-         recovery_cache.erase( recovery_cache.begin() );
-   }
-
-   return recovered_pub_keys;
+   const auto keys = recover_public_keys( sig_digests, nullptr, use_cache );
+   return signature_key_set( keys.begin(), keys.end(), allow_duplicate_keys );
 } FC_CAPTURE_AND_RETHROW() }
 
 
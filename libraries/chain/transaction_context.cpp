@@ -127,6 +127,7 @@ namespace besio { namespace chain {
       if( initial_net_usage > 0 )
          add_net_usage( initial_net_usage );  // Fail early if current net usage is already greater than the calculated limit
 
+      _deadline_timer.start( _deadline );
       checktime(); // Fail early if deadline has already been exceeded
 
       is_initialized = true;
@@ -289,6 +290,9 @@ namespace besio { namespace chain {
    }
 
    void transaction_context::checktime()const {
+      // Called from every loop of a contract: until the timer thread has seen the deadline pass there is nothing to check
+      if( BOOST_LIKELY( !_deadline_timer.expired() ) ) return;
+
       if (!control.skip_trx_checks()) {
          auto now = fc::time_point::now();
          if( BOOST_UNLIKELY( now > _deadline ) ) {
@@ -317,6 +321,8 @@ namespace besio { namespace chain {
             }
             BES_ASSERT( false,  transaction_exception, "unexpected deadline exception code" );
          }
+         // the timer went off for a deadline that has since been moved later, arm it for the current one
+         _deadline_timer.start( _deadline );
       }
    }
 
@@ -341,6 +347,7 @@ namespace besio { namespace chain {
          _deadline = deadline;
          deadline_exception_code = deadline_exception::code_value;
       }
+      _deadline_timer.start( _deadline );
    }
 
    void transaction_context::validate_cpu_usage_to_bill( int64_t billed_us, bool check_minimum )const {
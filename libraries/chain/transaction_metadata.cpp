@@ -0,0 +1,123 @@
+/**
+ *  @file
+ *  @copyright defined in bes/LICENSE.txt
+ */
+#include <besio/chain/transaction_metadata.hpp>
+#include <besio/chain/thread_utils.hpp>
+
+namespace besio { namespace chain {
+
+const flat_set<public_key_type>& transaction_metadata::recover_keys( const chain_id_type& chain_id ) {
+   // Unlikely for more than one chain_id to be used in one nodbes instance
+   if( signing_keys_future.valid() ) {
+      const signing_keys_future_value_type& sig_keys = signing_keys_future.get();
+      if( sig_keys.first == chain_id ) {
+         return sig_keys.second;
+      }
+   }
+
+   // signing_keys_future not created or different chain_id
+   std::promise<signing_keys_future_value_type> p;
+   p.set_value( std::make_pair( chain_id, trx.get_signature_keys( chain_id ) ) );
+   signing_keys_future = p.get_future().share();
+
+   return signing_keys_future.get().second;
+}
+
+void transaction_metadata::create_signing_keys_future( const transaction_metadata_ptr& mtrx,
+                                                       boost::asio::thread_pool& thread_pool,
+                                                       const chain_id_type& chain_id,
+                                                       std::function<void()> next ) {
+   if( mtrx->signing_keys_future.valid() ) { // already started
+      if( next ) next();
+      return;
+   }
+
+   std::weak_ptr<transaction_metadata> mtrx_wp = mtrx;
+   auto task = std::make_shared<std::packaged_task<signing_keys_future_value_type()>>( [chain_id, mtrx_wp]() {
+      auto mtrx = mtrx_wp.lock();
+      return std::make_pair( chain_id, mtrx ? mtrx->trx.get_signature_keys( chain_id ) : flat_set<public_key_type>() );
+   } );
+   mtrx->signing_keys_future = task->get_future().share();
+   // next runs after the task has stored its result, so the future is ready by the time next looks at it
+   boost::asio::post( thread_pool, [task, next{std::move(next)}]() {
+      (*task)();
+      if( next ) next();
+   } );
+}
+
+namespace {
+
+   const size_t signing_keys_per_task = 32; ///< transactions are added to a task until it has at least this many signatures
+
+   using signing_keys_promise = std::promise<signing_keys_future_value_type>;
+
+   /// Recovers the keys of all of mtrxs in one batch and hands each transaction its own share of them
+   void recover_signing_keys_task( const vector<transaction_metadata_ptr>& mtrxs, vector<signing_keys_promise>& promises,
+                                   const chain_id_type& chain_id ) {
+      vector<std::pair<signature_type, digest_type>> sig_digests;
+      for( const auto& mtrx : mtrxs ) {
+         const digest_type digest = mtrx->trx.sig_digest( chain_id, mtrx->trx.context_free_data );
+         for( const auto& sig : mtrx->trx.signatures )
+            sig_digests.emplace_back( sig, digest );
+      }
+
+      vector<public_key_type> keys;
+      try {
+         keys = recover_public_keys( sig_digests );
+      } catch( ... ) {
+         // a signature no key can be recovered from fails only the transaction that carries it
+         for( size_t i = 0; i < mtrxs.size(); ++i ) {
+            try {
+               promises[i].set_value( std::make_pair( chain_id, mtrxs[i]->trx.get_signature_keys( chain_id ) ) );
+            } catch( ... ) {
+               promises[i].set_exception( std::current_exception() );
+            }
+         }
+         return;
+      }
+
+      auto first = keys.cbegin();
+      for( size_t i = 0; i < mtrxs.size(); ++i ) {
+         auto last = first + mtrxs[i]->trx.signatures.size();
+         try {
+            promises[i].set_value( std::make_pair( chain_id, signature_key_set( first, last ) ) );
+         } catch( ... ) {
+            promises[i].set_exception( std::current_exception() );
+         }
+         first = last;
+      }
+   }
+
+}
+
+void transaction_metadata::recover_signing_keys( const vector<transaction_metadata_ptr>& mtrxs,
+                                                 boost::asio::thread_pool& thread_pool,
+                                                 const chain_id_type& chain_id ) {
+   vector<transaction_metadata_ptr> task_mtrxs;
+   vector<signing_keys_promise> task_promises;
+   size_t task_signatures = 0;
+
+   auto post_task = [&]() {
+      boost::asio::post( thread_pool, [mtrxs = std::move(task_mtrxs), promises = std::move(task_promises), chain_id]() mutable {
+         recover_signing_keys_task( mtrxs, promises, chain_id );
+      } );
+      task_mtrxs.clear();
+      task_promises.clear();
+      task_signatures = 0;
+   };
+
+   for( const auto& mtrx : mtrxs ) {
+      if( mtrx->signing_keys_future.valid() ) continue;
+      task_promises.emplace_back();
+      mtrx->signing_keys_future = task_promises.back().get_future().share();
+      task_mtrxs.push_back( mtrx );
+      task_signatures += mtrx->trx.signatures.size();
+      if( task_signatures >= signing_keys_per_task )
+         post_task();
+   }
+   if( !task_mtrxs.empty() )
+      post_task();
+}
+
+} } // besio::chain
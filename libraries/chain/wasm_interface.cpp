@@ -27,7 +27,8 @@ namespace besio { namespace chain {
    using namespace webassembly;
    using namespace webassembly::common;
 
-   wasm_interface::wasm_interface(vm_type vm) : my( new wasm_interface_impl(vm) ) {}
+   wasm_interface::wasm_interface(vm_type vm, uint32_t max_cache_size, bool tiered_compile)
+   : my( new wasm_interface_impl(vm, max_cache_size, tiered_compile) ) {}
 
    wasm_interface::~wasm_interface() {}
 
@@ -54,7 +55,22 @@ namespace besio { namespace chain {
 	 }
 
    void wasm_interface::apply( const digest_type& code_id, const shared_string& code, apply_context& context ) {
-      my->get_instantiated_module(code_id, code, context.trx_context)->apply(context);
+      my->get_instantiated_module(code_id, code, context.receiver, context.trx_context)->apply(context);
+   }
+
+   void wasm_interface::warm_up( const digest_type& code_id, const shared_string& code, account_name receiver ) {
+      my->queue_warm_up( code_id, code, receiver );
+   }
+
+   vector<pair<account_name, digest_type>> wasm_interface::get_cached_modules()const {
+      vector<pair<account_name, digest_type>> result;
+      result.reserve( my->warm_ups.size() + my->instantiation_cache.size() );
+      // contracts still being warmed up have not been used since the last startup
+      for( const auto& w : my->warm_ups )
+         result.emplace_back( w.second, w.first );
+      for( auto itr = my->instantiation_cache.rbegin(); itr != my->instantiation_cache.rend(); ++itr )
+         result.emplace_back( itr->receiver, itr->code_id );
+      return result;
    }
 
    wasm_instantiated_module_interface::~wasm_instantiated_module_interface() {}
@@ -4,6 +4,8 @@
 #include <besio/chain/apply_context.hpp>
 #include <besio/chain/exceptions.hpp>
 
+#include <fc/scoped_exit.hpp>
+
 #include "IR/Module.h"
 #include "Platform/Platform.h"
 #include "WAST/WAST.h"
@@ -13,6 +15,7 @@
 #include "Runtime/Intrinsics.h"
 
 #include <mutex>
+#include <set>
 
 using namespace IR;
 using namespace Runtime;
@@ -21,13 +24,50 @@ namespace besio { namespace chain { namespace webassembly { namespace wavm {
 
 running_instance_context the_running_instance_context;
 
+static std::mutex __runtime_guard_lock;
+//WAVM compiles with one global LLVM context and creates the objects of a module, which its garbage collector does
+// not know are in use yet, while it compiles. With tiered compilation a module may be instantiated on a background
+// compile thread, so instantiation, the compile of new invoke thunks and garbage collection hold this lock. Running
+// a module does not: the thunks apply and start functions are invoked through are compiled up front
+static std::mutex __compile_lock;
+//guards __live_instances and __collect_pending; held only briefly, never while compiling
+static std::mutex __runtime_lock;
+//every ModuleInstance still owned by a wavm_instantiated_module, across all wavm_runtimes; these are the
+// roots handed to WAVM's garbage collector when an evicted module's instance is reclaimed
+static std::set<ObjectInstance*> __live_instances;
+//set when a module was evicted while a compile held __compile_lock; the compile collects once it is done
+static bool __collect_pending = false;
+//the types of the functions call() invokes, whose thunks runtime_guard compiles
+static const FunctionType* __start_function_type = nullptr;
+static const FunctionType* __apply_function_type = nullptr;
+
+//frees the objects no live module references; requires __compile_lock and __runtime_lock
+static void __collect_unreferenced_objects() {
+   __collect_pending = false;
+   Runtime::freeUnreferencedObjects(std::vector<ObjectInstance*>(__live_instances.begin(), __live_instances.end()));
+}
+
 class wavm_instantiated_module : public wasm_instantiated_module_interface {
    public:
       wavm_instantiated_module(ModuleInstance* instance, std::unique_ptr<Module> module, std::vector<uint8_t> initial_mem) :
          _initial_memory(initial_mem),
          _instance(instance),
          _module(std::move(module))
-      {}
+      {
+         std::lock_guard<std::mutex> l(__runtime_lock);
+         __live_instances.insert(asObject(_instance));
+      }
+
+      ~wavm_instantiated_module() {
+         std::lock_guard<std::mutex> l(__runtime_lock);
+         __live_instances.erase(asObject(_instance));
+         //a background compile must not be waited on here; it collects when it finishes instead
+         std::unique_lock<std::mutex> compile(__compile_lock, std::try_to_lock);
+         if(compile.owns_lock())
+            __collect_unreferenced_objects();
+         else
+            __collect_pending = true;
+      }
 
       void apply(apply_context& context) override {
          vector<Value> args = {Value(uint64_t(context.receiver)),
@@ -46,6 +86,11 @@ class wavm_instantiated_module : public wasm_instantiated_module_interface {
 
             BES_ASSERT( getFunctionType(call)->parameters.size() == args.size(), wasm_exception, "" );
 
+            //a function of any other type may need its invoke thunk compiled, which uses the LLVM context
+            std::unique_lock<std::mutex> compile(__compile_lock, std::defer_lock);
+            if(getFunctionType(call) != __apply_function_type)
+               compile.lock();
+
             //The memory instance is reused across all wavm_instantiated_modules, but for wasm instances
             // that didn't declare "memory", getDefaultMemory() won't see it
             MemoryInstance* default_mem = getDefaultMemory(_instance);
@@ -76,7 +121,7 @@ class wavm_instantiated_module : public wasm_instantiated_module_interface {
 
       std::vector<uint8_t>     _initial_memory;
       //naked pointer because ModuleInstance is opaque
-      //_instance is deleted via WAVM's object garbage collection when wavm_rutime is deleted
+      //_instance is deleted via WAVM's object garbage collection once this module is evicted or destroyed
       ModuleInstance*          _instance;
       std::unique_ptr<Module>  _module;
 };
@@ -85,15 +130,21 @@ class wavm_instantiated_module : public wasm_instantiated_module_interface {
 wavm_runtime::runtime_guard::runtime_guard() {
    // TODO clean this up
    //check_wasm_opcode_dispositions();
+   std::lock_guard<std::mutex> l(__compile_lock);
    Runtime::init();
+   __start_function_type = FunctionType::get();
+   __apply_function_type = FunctionType::get(ResultType::none, {ValueType::i64, ValueType::i64, ValueType::i64});
+   Runtime::prepareInvokeThunk(__start_function_type);
+   Runtime::prepareInvokeThunk(__apply_function_type);
 }
 
 wavm_runtime::runtime_guard::~runtime_guard() {
+   std::lock_guard<std::mutex> l(__compile_lock);
+   std::lock_guard<std::mutex> r(__runtime_lock);
    Runtime::freeUnreferencedObjects({});
 }
 
 static weak_ptr<wavm_runtime::runtime_guard> __runtime_guard_ptr;
-static std::mutex __runtime_guard_lock;
 
 wavm_runtime::wavm_runtime() {
    std::lock_guard<std::mutex> l(__runtime_guard_lock);
@@ -109,6 +160,13 @@ wavm_runtime::~wavm_runtime() {
 }
 
 std::unique_ptr<wasm_instantiated_module_interface> wavm_runtime::instantiate_module(const char* code_bytes, size_t code_size, std::vector<uint8_t> initial_memory) {
+   std::lock_guard<std::mutex> l(__compile_lock);
+   //collects what was evicted during the compile, once the new module is rooted or the compile failed
+   auto collect = fc::make_scoped_exit([]() {
+      std::lock_guard<std::mutex> r(__runtime_lock);
+      if(__collect_pending)
+         __collect_unreferenced_objects();
+   });
    std::unique_ptr<Module> module = std::make_unique<Module>();
    try {
       Serialization::MemoryInputStream stream((const U8*)code_bytes, code_size);
@@ -0,0 +1,153 @@
+/**
+ *  Compares a boost::multi_index_container and a btree_multi_index_container holding the same contract table like
+ *  rows: the memory each row takes in the database, the time to walk an index and to look rows up, and the time to
+ *  step from a row to the next one through iterator_to as db_next does.
+ *
+ *  usage: chainbase_index_benchmark [rows]
+ */
+#include <chainbase/chainbase.hpp>
+#include <chainbase/btree_index.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/composite_key.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace chainbase;
+using namespace boost::multi_index;
+
+template<uint16_t TypeNumber>
+struct row : public chainbase::object<TypeNumber, row<TypeNumber>> {
+   template<typename Constructor, typename Allocator>
+   row( Constructor&& c, Allocator&& a ) {
+      c(*this);
+   }
+
+   typename chainbase::object<TypeNumber, row<TypeNumber>>::id_type id;
+   uint64_t table = 0;
+   uint64_t primary_key = 0;
+   uint64_t secondary_key = 0;
+};
+
+struct by_primary;
+struct by_secondary;
+
+template<typename Row>
+using row_indices = indexed_by<
+   ordered_unique< member<Row,typename Row::id_type,&Row::id> >,
+   ordered_unique< tag<by_primary>,
+      composite_key< Row,
+         member<Row,uint64_t,&Row::table>,
+         member<Row,uint64_t,&Row::primary_key>
+      >
+   >,
+   ordered_unique< tag<by_secondary>,
+      composite_key< Row,
+         member<Row,uint64_t,&Row::table>,
+         member<Row,uint64_t,&Row::secondary_key>,
+         member<Row,uint64_t,&Row::primary_key>
+      >
+   >
+>;
+
+typedef row<0> tree_row;
+typedef row<1> btree_row;
+typedef shared_multi_index_container<tree_row, row_indices<tree_row>> tree_row_index;
+typedef shared_btree_multi_index_container<btree_row, row_indices<btree_row>> btree_row_index;
+
+CHAINBASE_SET_INDEX_TYPE( tree_row, tree_row_index )
+CHAINBASE_SET_INDEX_TYPE( btree_row, btree_row_index )
+
+namespace {
+   const uint64_t tables = 64;
+   const uint64_t lookups = 2000000;
+
+   template<typename F>
+   double ns_per( uint64_t count, F&& f ) {
+      auto start = std::chrono::steady_clock::now();
+      f();
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count();
+      return double(ns) / count;
+   }
+
+   template<typename Index>
+   void run( const std::string& label, uint64_t rows ) {
+      typedef typename Index::value_type row_type;
+
+      auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+      {
+         database db( dir, database::read_write, rows * 512 + 64*1024*1024 );
+         db.add_index<Index>();
+         auto free_before = db.get_segment_manager()->get_free_memory();
+
+         std::mt19937_64 rng( 42 );
+         std::vector<std::pair<uint64_t,uint64_t>> keys;
+         keys.reserve( rows );
+         for( uint64_t i = 0; i < rows; ++i ) {
+            uint64_t table = rng() % tables, primary_key = rng();
+            if( db.find<row_type,by_primary>( boost::make_tuple( table, primary_key ) ) ) continue;
+            db.create<row_type>( [&]( row_type& r ) {
+               r.table = table;
+               r.primary_key = primary_key;
+               r.secondary_key = rng();
+            });
+            keys.emplace_back( table, primary_key );
+         }
+         double bytes_per_row = double(free_before - db.get_segment_manager()->get_free_memory()) / keys.size();
+
+         const auto& by_pk = db.get_index<Index,by_primary>();
+         const auto& by_sk = db.get_index<Index,by_secondary>();
+         uint64_t sum = 0;
+         double walk_primary = ns_per( keys.size(), [&]() {
+            for( const auto& r : by_pk ) sum += r.primary_key;
+         });
+         double walk_secondary = ns_per( keys.size(), [&]() {
+            for( auto itr = by_sk.lower_bound( boost::make_tuple( 0 ) ); itr != by_sk.end(); ++itr ) sum += itr->secondary_key;
+         });
+
+         // like a contract calling db_idx_next, which only keeps a pointer to the row it returned, and reading rows
+         double step_secondary = ns_per( keys.size(), [&]() {
+            const row_type* r = &*by_sk.begin();
+            for( uint64_t i = 1; i < keys.size(); ++i ) {
+               sum += r->secondary_key;
+               auto itr = by_sk.iterator_to( *r );
+               r = &*++itr;
+            }
+         });
+
+         std::vector<uint64_t> order( lookups );
+         for( auto& o : order )
+            o = rng() % keys.size();
+         uint64_t found = 0;
+         double lookup = ns_per( lookups, [&]() {
+            for( auto o : order )
+               found += by_pk.find( boost::make_tuple( keys[o].first, keys[o].second ) ) != by_pk.end();
+         });
+         if( found != lookups )
+            std::cerr << "only " << found << " of " << lookups << " lookups found a row" << std::endl;
+
+         std::cout << label << ": " << keys.size() << " rows, " << bytes_per_row << " bytes per row, "
+                   << walk_primary << " ns per row walking the primary index, "
+                   << walk_secondary << " ns per row walking the secondary index, "
+                   << step_secondary << " ns per row stepping through the secondary index with iterator_to, "
+                   << lookup << " ns per lookup" << (sum ? "" : " ") << std::endl;
+      }
+      boost::filesystem::remove_all( dir );
+   }
+}
+
+int main( int argc, char** argv ) {
+   try {
+      uint64_t rows = argc > 1 ? std::stoull( argv[1] ) : 2000000;
+      run<tree_row_index>( "multi_index", rows );
+      run<btree_row_index>( "btree", rows );
+   } catch( const std::exception& e ) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ *  Measures the latency of random lookups through the id and secondary indices of a chainbase database, with the
+ *  database mapped from its file and, when a hugetlbfs mount is given, held in hugepages.
+ *
+ *  usage: chainbase_lookup_benchmark [rows] [hugepage dir] [numa node]
+ */
+#include <chainbase/chainbase.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/member.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace chainbase;
+using namespace boost::multi_index;
+
+struct row : public chainbase::object<0, row> {
+   template<typename Constructor, typename Allocator>
+   row( Constructor&& c, Allocator&& a ) {
+      c(*this);
+   }
+
+   id_type  id;
+   uint64_t key = 0;
+   uint64_t payload[6] = {};
+};
+
+struct by_key;
+typedef multi_index_container<
+   row,
+   indexed_by<
+      ordered_unique< member<row,row::id_type,&row::id> >,
+      ordered_unique< tag<by_key>, member<row,uint64_t,&row::key> >
+   >,
+   chainbase::allocator<row>
+> row_index;
+
+CHAINBASE_SET_INDEX_TYPE( row, row_index )
+
+namespace {
+   const uint64_t lookups = 2000000;
+
+   template<typename F>
+   double ns_per_lookup( F&& f ) {
+      auto start = std::chrono::steady_clock::now();
+      uint64_t found = 0;
+      for( uint64_t i = 0; i < lookups; ++i )
+         found += f( i );
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count();
+      if( found != lookups )
+         std::cerr << "only " << found << " of " << lookups << " lookups found a row" << std::endl;
+      return double(ns) / lookups;
+   }
+
+   void run( const std::string& label, uint64_t rows, const database::map_options& options ) {
+      auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+      {
+         uint64_t size = rows * 256 + 64*1024*1024;
+         database db( dir, database::read_write, size, false, options );
+         db.add_index<row_index>();
+
+         std::mt19937_64 rng( 42 );
+         std::vector<uint64_t> keys;
+         keys.reserve( rows );
+         for( uint64_t i = 0; i < rows; ++i ) {
+            uint64_t key = rng();
+            if( !db.find<row,by_key>( key ) ) {
+               db.create<row>( [&]( row& r ) { r.key = key; } );
+               keys.push_back( key );
+            }
+         }
+
+         std::vector<uint64_t> order( lookups );
+         for( auto& o : order )
+            o = rng() % keys.size();
+
+         double by_id = ns_per_lookup( [&]( uint64_t i ) {
+            return db.find<row>( row::id_type( order[i] ) ) != nullptr;
+         });
+         double by_secondary = ns_per_lookup( [&]( uint64_t i ) {
+            return db.find<row,by_key>( keys[order[i]] ) != nullptr;
+         });
+
+         std::cout << label << ": " << keys.size() << " rows, "
+                   << by_id << " ns per id lookup, " << by_secondary << " ns per secondary key lookup" << std::endl;
+      }
+      boost::filesystem::remove_all( dir );
+   }
+}
+
+int main( int argc, char** argv ) {
+   try {
+      uint64_t rows = argc > 1 ? std::stoull( argv[1] ) : 4000000;
+      database::map_options options;
+      if( argc > 3 )
+         options.numa_node = std::stoi( argv[3] );
+
+      run( "mapped file", rows, options );
+      if( argc > 2 ) {
+         options.hugepage_dir = argv[2];
+         run( "hugepages", rows, options );
+      }
+   } catch( const std::exception& e ) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+   }
+   return 0;
+}
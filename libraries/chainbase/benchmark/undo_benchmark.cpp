@@ -0,0 +1,96 @@
+/**
+ *  Measures the undo session cycle the chain runs for every transaction: a session is started inside the session of
+ *  the pending block, a few rows are modified, created and removed, and the session is then squashed into the block
+ *  (or, for a failed transaction, undone). Blocks are pushed and committed as they become irreversible.
+ *
+ *  usage: chainbase_undo_benchmark [transactions] [row size] [rows modified per transaction]
+ */
+#include <chainbase/chainbase.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/member.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace chainbase;
+using namespace boost::multi_index;
+
+struct row : public chainbase::object<0, row> {
+   template<typename Constructor, typename Allocator>
+   row( Constructor&& c, Allocator&& a ):value( a ) {
+      c(*this);
+   }
+
+   id_type        id;
+   uint64_t       key = 0;
+   shared_string  value;
+};
+
+struct by_key;
+typedef multi_index_container<
+   row,
+   indexed_by<
+      ordered_unique< member<row,row::id_type,&row::id> >,
+      ordered_unique< tag<by_key>, member<row,uint64_t,&row::key> >
+   >,
+   chainbase::allocator<row>
+> row_index;
+
+CHAINBASE_SET_INDEX_TYPE( row, row_index )
+
+int main( int argc, char** argv ) {
+   try {
+      uint64_t transactions = argc > 1 ? std::stoull( argv[1] ) : 200000;
+      uint64_t row_size     = argc > 2 ? std::stoull( argv[2] ) : 1024;
+      uint64_t modified     = argc > 3 ? std::stoull( argv[3] ) : 4;
+      const uint64_t rows = 100000, transactions_per_block = 100, reversible_blocks = 12, failed_every = 20;
+
+      auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+      {
+         database db( dir, database::read_write, rows * (row_size + 256) * 2 + 256*1024*1024 );
+         db.add_index<row_index>();
+
+         std::string blob( row_size, 'x' );
+         for( uint64_t i = 0; i < rows; ++i )
+            db.create<row>( [&]( row& r ) { r.key = i; r.value.assign( blob.data(), blob.size() ); } );
+
+         std::mt19937_64 rng( 42 );
+         uint64_t next_key = rows;
+         auto start = std::chrono::steady_clock::now();
+         int64_t block_num = db.revision();
+
+         for( uint64_t t = 0; t < transactions; ) {
+            auto block = db.start_undo_session( true );
+            for( uint64_t i = 0; i < transactions_per_block && t < transactions; ++i, ++t ) {
+               auto trx = db.start_undo_session( true );
+               for( uint64_t m = 0; m < modified; ++m ) {
+                  const auto* r = db.find<row,by_key>( rng() % next_key );
+                  if( !r ) continue;
+                  db.modify( *r, [&]( row& r ) { r.value[rng() % row_size] = 'y'; } );
+               }
+               db.create<row>( [&]( row& r ) { r.key = next_key++; r.value.assign( blob.data(), blob.size() ); } );
+               if( const auto* r = db.find<row,by_key>( rng() % next_key ) )
+                  db.remove( *r );
+
+               if( t % failed_every == 0 ) trx.undo();
+               else                        trx.squash();
+            }
+            block.push();
+            ++block_num;
+            db.commit( block_num - reversible_blocks );
+         }
+
+         auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count();
+         std::cout << transactions << " transactions modifying " << modified << " rows of " << row_size << " bytes: "
+                   << double(ns) / transactions << " ns per transaction" << std::endl;
+      }
+      boost::filesystem::remove_all( dir );
+   } catch( const std::exception& e ) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,914 @@
+#pragma once
+
+#include <chainbase/chainbase.hpp>
+
+#include <boost/interprocess/offset_ptr.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/mpl/at.hpp>
+#include <boost/mpl/contains.hpp>
+#include <boost/mpl/size.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace chainbase {
+
+   /**
+    *  @file btree_index.hpp
+    *
+    *  A drop in replacement for the subset of boost::multi_index_container that generic_index and the code reading
+    *  chainbase indices rely on, for containers whose indices are all ordered_unique.
+    *
+    *  Every index is a B+-tree whose leaves hold offset pointers to the rows and are linked to their neighbours, so
+    *  walking an index reads consecutive pointers out of a few cache lines instead of chasing a red-black tree node
+    *  per row. Each row is allocated together with a pointer to the leaf holding it in every index, so an index
+    *  costs 16 to 24 bytes per row, compared to the 24 bytes of an ordered_index node. Rows never move, so references
+    *  to them stay valid exactly as with multi_index.
+    *
+    *  Inner nodes do not copy keys; the separator in front of each child is a pointer to the first row below that
+    *  child, which keeps arbitrary (composite) keys out of the tree at the price of one dereference per comparison.
+    *
+    *  Unlike multi_index, iterators are invalidated by any insert, erase or modify. iterator_to follows the row's
+    *  leaf pointer and scans that one leaf for the row, so it costs no key comparisons.
+    */
+
+   namespace btree_detail {
+
+      namespace bip = boost::interprocess;
+
+      static const uint16_t leaf_capacity  = 64;
+      static const uint16_t inner_capacity = 64;
+
+      template<typename Value>
+      struct node {
+         explicit node( bool leaf ):is_leaf(leaf){}
+
+         bip::offset_ptr<node>  parent;
+         uint16_t               size = 0;
+         bool                   is_leaf;
+      };
+
+      template<typename Value>
+      struct leaf : public node<Value> {
+         leaf():node<Value>(true){}
+
+         bip::offset_ptr<leaf>   prev;
+         bip::offset_ptr<leaf>   next;
+         bip::offset_ptr<Value>  rows[leaf_capacity];
+      };
+
+      template<typename Value>
+      struct inner : public node<Value> {
+         inner():node<Value>(false){}
+
+         /// keys[i] is the first row below children[i], keys[0] is not used
+         bip::offset_ptr<const Value>  keys[inner_capacity];
+         bip::offset_ptr<node<Value>>  children[inner_capacity];
+      };
+
+      /**
+       *  What a container allocates for each row: the row, followed by the leaf that holds it in each index. A leaf
+       *  pointer only changes when a split, merge or rebalance moves the row to another leaf.
+       */
+      template<typename Value, int IndexCount>
+      struct row_node : public Value {
+         template<typename... Args>
+         explicit row_node( Args&&... args ):Value( std::forward<Args>( args )... ){}
+
+         static row_node* from( const Value* v ) { return static_cast<row_node*>( const_cast<Value*>( v ) ); }
+
+         bip::offset_ptr<leaf<Value>>  leaves[IndexCount];
+      };
+
+      /**
+       *  A position in a tree; slot may equal the size of the leaf while inserting, the leaf is null at the end.
+       */
+      template<typename Value>
+      struct cursor {
+         leaf<Value>*  l    = nullptr;
+         uint16_t      slot = 0;
+      };
+
+      template<typename Value>
+      class tree_base {
+         public:
+            std::size_t size()const { return _size; }
+
+            cursor<Value> first()const {
+               cursor<Value> c;
+               c.l = _first.get();
+               return c;
+            }
+
+            /// moves a cursor past the last row of its leaf onto the first row of the next leaf
+            static cursor<Value> normalize( cursor<Value> c ) {
+               if( c.l && c.slot == c.l->size ) {
+                  c.l = c.l->next.get();
+                  c.slot = 0;
+               }
+               return c;
+            }
+
+            /**
+             *  Finds the first row for which before() is false, before() must be true for a prefix of the index.
+             *  The cursor is not normalized, so it can be used as an insert position.
+             */
+            template<typename Before>
+            cursor<Value> descend( Before&& before )const {
+               cursor<Value> c;
+               node<Value>* n = _root.get();
+               if( !n ) return c;
+
+               while( !n->is_leaf ) {
+                  auto* in = static_cast<inner<Value>*>( n );
+                  uint16_t lo = 1, hi = in->size;
+                  while( lo < hi ) {
+                     uint16_t mid = (lo + hi) / 2;
+                     if( before( *in->keys[mid] ) ) lo = mid + 1;
+                     else                           hi = mid;
+                  }
+                  n = in->children[lo - 1].get();
+               }
+
+               c.l = static_cast<leaf<Value>*>( n );
+               uint16_t lo = 0, hi = c.l->size;
+               while( lo < hi ) {
+                  uint16_t mid = (lo + hi) / 2;
+                  if( before( *c.l->rows[mid] ) ) lo = mid + 1;
+                  else                            hi = mid;
+               }
+               c.slot = lo;
+               return c;
+            }
+
+         protected:
+            template<typename V> friend class iterator;
+
+            bip::offset_ptr<node<Value>>  _root;
+            bip::offset_ptr<leaf<Value>>  _first;
+            bip::offset_ptr<leaf<Value>>  _last;
+            std::size_t                   _size = 0;
+      };
+
+      template<typename Value>
+      class iterator {
+         public:
+            typedef std::bidirectional_iterator_tag  iterator_category;
+            typedef Value                            value_type;
+            typedef std::ptrdiff_t                   difference_type;
+            typedef const Value*                     pointer;
+            typedef const Value&                     reference;
+
+            iterator(){}
+            iterator( const tree_base<Value>* t, cursor<Value> c ):_tree(t),_leaf(c.l),_slot(c.slot){}
+
+            reference operator*()const  { return *_leaf->rows[_slot]; }
+            pointer   operator->()const { return _leaf->rows[_slot].get(); }
+
+            iterator& operator++() {
+               if( ++_slot == _leaf->size ) {
+                  _leaf = _leaf->next.get();
+                  _slot = 0;
+               }
+               return *this;
+            }
+
+            iterator& operator--() {
+               if( !_leaf ) {
+                  _leaf = _tree->_last.get();
+                  _slot = _leaf->size;
+               } else if( !_slot ) {
+                  _leaf = _leaf->prev.get();
+                  _slot = _leaf->size;
+               }
+               --_slot;
+               return *this;
+            }
+
+            iterator operator++(int) { iterator tmp( *this ); ++*this; return tmp; }
+            iterator operator--(int) { iterator tmp( *this ); --*this; return tmp; }
+
+            friend bool operator==( const iterator& a, const iterator& b ) { return a._leaf == b._leaf && a._slot == b._slot; }
+            friend bool operator!=( const iterator& a, const iterator& b ) { return !(a == b); }
+
+         private:
+            const tree_base<Value>*  _tree = nullptr;
+            const leaf<Value>*       _leaf = nullptr;
+            uint16_t                 _slot = 0;
+      };
+
+      /**
+       *  The shape of a B+-tree of row pointers, index N of IndexCount; what orders the rows is left to the caller
+       *  of descend().
+       */
+      template<typename Value, typename Allocator, int IndexCount, int N>
+      class tree : public tree_base<Value> {
+         public:
+            typedef leaf<Value>                                              leaf_type;
+            typedef inner<Value>                                             inner_type;
+            typedef node<Value>                                              node_type;
+            typedef row_node<Value,IndexCount>                               row_node_type;
+            typedef typename Allocator::template rebind<leaf_type>::other   leaf_allocator;
+            typedef typename Allocator::template rebind<inner_type>::other  inner_allocator;
+
+            explicit tree( const Allocator& a ):_leaf_alloc(a),_inner_alloc(a){}
+            tree( const tree& ) = delete;
+            tree& operator=( const tree& ) = delete;
+            ~tree() { clear(); }
+
+            /// inserts a row at a position found by descend(), returns where it ended up
+            cursor<Value> insert( cursor<Value> c, Value* row ) {
+               if( !this->_root ) {
+                  c.l = new_leaf();
+                  c.slot = 0;
+                  this->_root = this->_first = this->_last = c.l;
+               }
+
+               leaf_type* l = c.l;
+               if( l->size == leaf_capacity ) {
+                  const uint16_t half = leaf_capacity / 2;
+                  leaf_type* r = new_leaf();
+                  for( uint16_t i = half; i < leaf_capacity; ++i )
+                     move_row( r, i - half, l->rows[i].get() );
+                  r->size = leaf_capacity - half;
+                  l->size = half;
+
+                  r->next = l->next;
+                  if( r->next ) r->next->prev = r;
+                  else          this->_last = r;
+                  r->prev = l;
+                  l->next = r;
+
+                  if( c.slot > half ) {
+                     c.l = r;
+                     c.slot -= half;
+                  }
+                  insert_row( c, row );
+                  insert_child( l, r, r->rows[0].get() );
+               } else {
+                  insert_row( c, row );
+               }
+
+               ++this->_size;
+               return c;
+            }
+
+            /// removes the row under a normalized cursor
+            void erase( cursor<Value> c ) {
+               leaf_type* l = c.l;
+               for( uint16_t i = c.slot + 1; i < l->size; ++i )
+                  l->rows[i - 1] = l->rows[i];
+               --l->size;
+               --this->_size;
+
+               if( l == this->_root.get() ) {
+                  if( !l->size ) {
+                     free_leaf( l );
+                     this->_root = nullptr;
+                     this->_first = this->_last = nullptr;
+                  }
+                  return;
+               }
+
+               if( c.slot == 0 )
+                  replace_separator( l, l->rows[0].get() );
+               if( l->size < leaf_capacity / 2 )
+                  rebalance( l );
+            }
+
+            void clear() {
+               if( this->_root ) free_node( this->_root.get() );
+               this->_root = nullptr;
+               this->_first = this->_last = nullptr;
+               this->_size = 0;
+            }
+
+            /// where a row of this tree is, without comparing keys
+            static cursor<Value> locate( const Value& v ) {
+               cursor<Value> c;
+               c.l = row_node_type::from( &v )->leaves[N].get();
+               while( c.l->rows[c.slot].get() != &v ) ++c.slot;
+               return c;
+            }
+
+         private:
+            leaf_type* new_leaf() {
+               leaf_type* l = &*_leaf_alloc.allocate( 1 );
+               new (l) leaf_type();
+               return l;
+            }
+
+            inner_type* new_inner() {
+               inner_type* in = &*_inner_alloc.allocate( 1 );
+               new (in) inner_type();
+               return in;
+            }
+
+            void free_leaf( leaf_type* l ) {
+               l->~leaf_type();
+               _leaf_alloc.deallocate( typename leaf_allocator::pointer( l ), 1 );
+            }
+
+            void free_inner( inner_type* in ) {
+               in->~inner_type();
+               _inner_alloc.deallocate( typename inner_allocator::pointer( in ), 1 );
+            }
+
+            void free_node( node_type* n ) {
+               if( n->is_leaf ) return free_leaf( static_cast<leaf_type*>( n ) );
+               auto* in = static_cast<inner_type*>( n );
+               for( uint16_t i = 0; i < in->size; ++i )
+                  free_node( in->children[i].get() );
+               free_inner( in );
+            }
+
+            static uint16_t index_of( const inner_type* p, const node_type* child ) {
+               uint16_t i = 0;
+               while( p->children[i].get() != child ) ++i;
+               return i;
+            }
+
+            static void insert_row( cursor<Value> c, Value* row ) {
+               for( uint16_t i = c.l->size; i > c.slot; --i )
+                  c.l->rows[i] = c.l->rows[i - 1];
+               move_row( c.l, c.slot, row );
+               ++c.l->size;
+            }
+
+            /// stores row at slot of l, which becomes the leaf the row refers back to
+            static void move_row( leaf_type* l, uint16_t slot, Value* row ) {
+               l->rows[slot] = row;
+               row_node_type::from( row )->leaves[N] = l;
+            }
+
+            /// links right into the parent of left, directly after left; first is the first row below right
+            void insert_child( node_type* left, node_type* right, const Value* first ) {
+               auto* p = static_cast<inner_type*>( left->parent.get() );
+               if( !p ) {
+                  auto* root = new_inner();
+                  root->children[0] = left;
+                  root->children[1] = right;
+                  root->keys[1] = first;
+                  root->size = 2;
+                  left->parent = right->parent = root;
+                  this->_root = root;
+                  return;
+               }
+
+               inner_type* in = p;
+               uint16_t pos = index_of( p, left ) + 1;
+               inner_type* split = nullptr;
+               const Value* split_first = nullptr;
+
+               if( p->size == inner_capacity ) {
+                  const uint16_t half = inner_capacity / 2;
+                  split = new_inner();
+                  split_first = p->keys[half].get();
+                  for( uint16_t i = half; i < inner_capacity; ++i ) {
+                     split->keys[i - half] = p->keys[i];
+                     split->children[i - half] = p->children[i];
+                     split->children[i - half]->parent = split;
+                  }
+                  split->size = inner_capacity - half;
+                  p->size = half;
+
+                  if( pos > half ) {
+                     in = split;
+                     pos -= half;
+                  }
+               }
+
+               for( uint16_t i = in->size; i > pos; --i ) {
+                  in->keys[i] = in->keys[i - 1];
+                  in->children[i] = in->children[i - 1];
+               }
+               in->keys[pos] = first;
+               in->children[pos] = right;
+               right->parent = in;
+               ++in->size;
+
+               if( split )
+                  insert_child( p, split, split_first );
+            }
+
+            /// the first row below n changed, so does the separator in front of the subtree it starts
+            static void replace_separator( node_type* n, const Value* first ) {
+               while( n->parent ) {
+                  auto* p = static_cast<inner_type*>( n->parent.get() );
+                  uint16_t i = index_of( p, n );
+                  if( i ) {
+                     p->keys[i] = first;
+                     return;
+                  }
+                  n = p;
+               }
+            }
+
+            void unlink( leaf_type* l ) {
+               if( l->prev ) l->prev->next = l->next;
+               else          this->_first = l->next;
+               if( l->next ) l->next->prev = l->prev;
+               else          this->_last = l->prev;
+            }
+
+            /// takes a row from a sibling, or merges with it when both are at half capacity
+            void rebalance( leaf_type* l ) {
+               const uint16_t min = leaf_capacity / 2;
+               auto* p = static_cast<inner_type*>( l->parent.get() );
+               uint16_t i = index_of( p, l );
+
+               if( i + 1 < p->size ) {
+                  auto* r = static_cast<leaf_type*>( p->children[i + 1].get() );
+                  if( r->size > min ) {
+                     move_row( l, l->size++, r->rows[0].get() );
+                     for( uint16_t j = 1; j < r->size; ++j )
+                        r->rows[j - 1] = r->rows[j];
+                     --r->size;
+                     p->keys[i + 1] = r->rows[0];
+                     return;
+                  }
+                  for( uint16_t j = 0; j < r->size; ++j )
+                     move_row( l, l->size + j, r->rows[j].get() );
+                  l->size += r->size;
+                  unlink( r );
+                  free_leaf( r );
+                  remove_child( p, i + 1 );
+                  return;
+               }
+
+               auto* f = static_cast<leaf_type*>( p->children[i - 1].get() );
+               if( f->size > min ) {
+                  for( uint16_t j = l->size; j > 0; --j )
+                     l->rows[j] = l->rows[j - 1];
+                  move_row( l, 0, f->rows[--f->size].get() );
+                  ++l->size;
+                  p->keys[i] = l->rows[0];
+                  return;
+               }
+               for( uint16_t j = 0; j < l->size; ++j )
+                  move_row( f, f->size + j, l->rows[j].get() );
+               f->size += l->size;
+               unlink( l );
+               free_leaf( l );
+               remove_child( p, i );
+            }
+
+            void rebalance( inner_type* n ) {
+               const uint16_t min = inner_capacity / 2;
+               auto* p = static_cast<inner_type*>( n->parent.get() );
+               uint16_t i = index_of( p, n );
+
+               if( i + 1 < p->size ) {
+                  auto* r = static_cast<inner_type*>( p->children[i + 1].get() );
+                  if( r->size > min ) {
+                     n->keys[n->size] = p->keys[i + 1];
+                     n->children[n->size] = r->children[0];
+                     n->children[n->size]->parent = n;
+                     ++n->size;
+                     p->keys[i + 1] = r->keys[1];
+                     for( uint16_t j = 1; j < r->size; ++j ) {
+                        r->keys[j - 1] = r->keys[j];
+                        r->children[j - 1] = r->children[j];
+                     }
+                     --r->size;
+                     return;
+                  }
+                  append( n, p->keys[i + 1].get(), r );
+                  remove_child( p, i + 1 );
+                  return;
+               }
+
+               auto* f = static_cast<inner_type*>( p->children[i - 1].get() );
+               if( f->size > min ) {
+                  for( uint16_t j = n->size; j > 0; --j ) {
+                     n->keys[j] = n->keys[j - 1];
+                     n->children[j] = n->children[j - 1];
+                  }
+                  n->keys[1] = p->keys[i];
+                  --f->size;
+                  n->children[0] = f->children[f->size];
+                  n->children[0]->parent = n;
+                  p->keys[i] = f->keys[f->size];
+                  ++n->size;
+                  return;
+               }
+               append( f, p->keys[i].get(), n );
+               remove_child( p, i );
+            }
+
+            /// moves the children of from to the end of to, first being the first row below from
+            void append( inner_type* to, const Value* first, inner_type* from ) {
+               for( uint16_t j = 0; j < from->size; ++j ) {
+                  to->keys[to->size + j] = j ? from->keys[j].get() : first;
+                  to->children[to->size + j] = from->children[j];
+                  to->children[to->size + j]->parent = to;
+               }
+               to->size += from->size;
+               free_inner( from );
+            }
+
+            /// drops the (already freed) child at position i, which is never the first child
+            void remove_child( inner_type* p, uint16_t i ) {
+               for( uint16_t j = i + 1; j < p->size; ++j ) {
+                  p->keys[j - 1] = p->keys[j];
+                  p->children[j - 1] = p->children[j];
+               }
+               --p->size;
+
+               if( p == this->_root.get() ) {
+                  if( p->size == 1 ) {
+                     this->_root = p->children[0];
+                     this->_root->parent = nullptr;
+                     free_inner( p );
+                  }
+                  return;
+               }
+               if( p->size < inner_capacity / 2 )
+                  rebalance( p );
+            }
+
+            leaf_allocator   _leaf_alloc;
+            inner_allocator  _inner_alloc;
+      };
+
+      template<typename IndexSpecifier>
+      struct is_ordered_unique : std::false_type {};
+
+      template<typename Arg1, typename Arg2, typename Arg3>
+      struct is_ordered_unique< boost::multi_index::ordered_unique<Arg1,Arg2,Arg3> > : std::true_type {};
+
+      /// the position of the first index tagged with Tag
+      template<typename IndexSpecifierList, typename Tag, int N = 0, int Size = boost::mpl::size<IndexSpecifierList>::value>
+      struct tag_position : std::conditional<
+         boost::mpl::contains< typename boost::mpl::at_c<IndexSpecifierList,N>::type::tag_list_type, Tag >::value,
+         std::integral_constant<int,N>,
+         tag_position<IndexSpecifierList,Tag,N+1,Size>
+      >::type {};
+
+      template<typename IndexSpecifierList, typename Tag, int Size>
+      struct tag_position<IndexSpecifierList,Tag,Size,Size>; ///< no index is tagged with Tag
+
+      template<typename Value, typename IndexSpecifierList, typename Allocator, int N = 0, int Size = boost::mpl::size<IndexSpecifierList>::value>
+      struct index_list;
+
+   } // namespace btree_detail
+
+   template<typename Value, typename IndexSpecifierList, typename Allocator>
+   class btree_multi_index_container;
+
+   /**
+    *  The read side of index N of the IndexCount indices of a btree_multi_index_container, mirroring boost's
+    *  ordered_unique index.
+    */
+   template<typename Value, typename IndexSpecifier, typename Allocator, int IndexCount, int N>
+   class btree_ordered_index {
+      static_assert( btree_detail::is_ordered_unique<IndexSpecifier>::value, "btree indices must be ordered_unique" );
+
+      public:
+         typedef typename IndexSpecifier::key_from_value_type  key_from_value;
+         typedef typename IndexSpecifier::compare_type         key_compare;
+         typedef Value                                         value_type;
+         typedef btree_detail::iterator<Value>                 iterator;
+         typedef iterator                                      const_iterator;
+         typedef std::reverse_iterator<iterator>               reverse_iterator;
+         typedef reverse_iterator                              const_reverse_iterator;
+         typedef std::size_t                                   size_type;
+
+         struct value_compare {
+            bool operator()( const Value& a, const Value& b )const { return comp( key( a ), key( b ) ); }
+
+            key_from_value  key;
+            key_compare     comp;
+         };
+
+         explicit btree_ordered_index( const Allocator& a ):_tree(a){}
+
+         key_from_value key_extractor()const { return _key; }
+         key_compare key_comp()const         { return _comp; }
+         value_compare value_comp()const     { return value_compare{ _key, _comp }; }
+
+         iterator begin()const { return make_iterator( _tree.first() ); }
+         iterator end()const   { return iterator( &_tree, cursor() ); }
+         reverse_iterator rbegin()const { return reverse_iterator( end() ); }
+         reverse_iterator rend()const   { return reverse_iterator( begin() ); }
+
+         size_type size()const { return _tree.size(); }
+         bool empty()const     { return !_tree.size(); }
+
+         template<typename CompatibleKey>
+         iterator lower_bound( const CompatibleKey& k )const {
+            return make_iterator( _tree.normalize( _tree.descend( [&]( const Value& row ) {
+               return _comp( _key( row ), k );
+            })));
+         }
+
+         template<typename CompatibleKey>
+         iterator upper_bound( const CompatibleKey& k )const {
+            return make_iterator( _tree.normalize( _tree.descend( [&]( const Value& row ) {
+               return !_comp( k, _key( row ) );
+            })));
+         }
+
+         template<typename CompatibleKey>
+         iterator find( const CompatibleKey& k )const {
+            auto itr = lower_bound( k );
+            if( itr == end() || _comp( k, _key( *itr ) ) ) return end();
+            return itr;
+         }
+
+         template<typename CompatibleKey>
+         std::pair<iterator,iterator> equal_range( const CompatibleKey& k )const {
+            return std::make_pair( lower_bound( k ), upper_bound( k ) );
+         }
+
+         /// v must be a row of the container
+         iterator iterator_to( const Value& v )const {
+            return make_iterator( tree_type::locate( v ) );
+         }
+
+      private:
+         template<typename V, typename L, typename A> friend class btree_multi_index_container;
+         template<typename V, typename L, typename A, int I, int S> friend struct btree_detail::index_list;
+
+         typedef btree_detail::cursor<Value>                              cursor;
+         typedef btree_detail::tree<Value,Allocator,IndexCount,N>         tree_type;
+
+         iterator make_iterator( cursor c )const { return iterator( &_tree, c ); }
+
+         /// finds where v belongs, returning the row whose key it duplicates if there is one
+         const Value* insert_position( const Value& v, cursor& c )const {
+            c = _tree.descend( [&]( const Value& row ) {
+               return _comp( _key( row ), _key( v ) );
+            });
+            cursor n = _tree.normalize( c );
+            if( n.l && !_comp( _key( v ), _key( *n.l->rows[n.slot] ) ) )
+               return n.l->rows[n.slot].get();
+            return nullptr;
+         }
+
+         /// whether the row under c still sorts between its neighbours
+         bool in_order( cursor c )const {
+            const Value& v = *c.l->rows[c.slot];
+            if( c.slot > 0 ) {
+               if( !_comp( _key( *c.l->rows[c.slot - 1] ), _key( v ) ) ) return false;
+            } else if( c.l->prev ) {
+               if( !_comp( _key( *c.l->prev->rows[c.l->prev->size - 1] ), _key( v ) ) ) return false;
+            }
+            if( c.slot + 1 < c.l->size ) {
+               if( !_comp( _key( v ), _key( *c.l->rows[c.slot + 1] ) ) ) return false;
+            } else if( c.l->next ) {
+               if( !_comp( _key( v ), _key( *c.l->next->rows[0] ) ) ) return false;
+            }
+            return true;
+         }
+
+         tree_type       _tree;
+         key_from_value  _key;
+         key_compare     _comp;
+   };
+
+   namespace btree_detail {
+
+      /**
+       *  The indices of a container, applying each operation to index N and then to the ones after it.
+       */
+      template<typename Value, typename IndexSpecifierList, typename Allocator, int N, int Size>
+      struct index_list {
+         typedef btree_ordered_index<Value, typename boost::mpl::at_c<IndexSpecifierList,N>::type, Allocator, Size, N>  index_type;
+         typedef index_list<Value, IndexSpecifierList, Allocator, N + 1, Size>                                           next_type;
+
+         explicit index_list( const Allocator& a ):index(a),next(a){}
+
+         const index_type& get( std::integral_constant<int,N> )const { return index; }
+
+         template<int I>
+         using index_at = btree_ordered_index<Value, typename boost::mpl::at_c<IndexSpecifierList,I>::type, Allocator, Size, I>;
+
+         template<int I>
+         const index_at<I>& get( std::integral_constant<int,I> i )const { return next.get( i ); }
+
+         const Value* insert_positions( const Value& v, cursor<Value>* c )const {
+            if( const Value* duplicate = index.insert_position( v, c[N] ) ) return duplicate;
+            return next.insert_positions( v, c );
+         }
+
+         void insert( Value* v, cursor<Value>* c ) {
+            c[N] = index._tree.insert( c[N], v );
+            next.insert( v, c );
+         }
+
+         void locate( const Value& v, cursor<Value>* c )const {
+            c[N] = index_type::tree_type::locate( v );
+            next.locate( v, c );
+         }
+
+         void erase( cursor<Value>* c ) {
+            index._tree.erase( c[N] );
+            next.erase( c );
+         }
+
+         /// takes a modified row out of the indices in which it no longer sorts where it is
+         void unlink_moved( cursor<Value>* c, bool* moved ) {
+            moved[N] = !index.in_order( c[N] );
+            if( moved[N] ) index._tree.erase( c[N] );
+            next.unlink_moved( c, moved );
+         }
+
+         const Value* insert_positions( const Value& v, cursor<Value>* c, const bool* moved )const {
+            if( moved[N] )
+               if( const Value* duplicate = index.insert_position( v, c[N] ) ) return duplicate;
+            return next.insert_positions( v, c, moved );
+         }
+
+         void insert( Value* v, cursor<Value>* c, const bool* moved ) {
+            if( moved[N] ) c[N] = index._tree.insert( c[N], v );
+            next.insert( v, c, moved );
+         }
+
+         void erase( cursor<Value>* c, const bool* moved ) {
+            if( !moved[N] ) index._tree.erase( c[N] );
+            next.erase( c, moved );
+         }
+
+         void clear() {
+            index._tree.clear();
+            next.clear();
+         }
+
+         index_type  index;
+         next_type   next;
+      };
+
+      template<typename Value, typename IndexSpecifierList, typename Allocator, int Size>
+      struct index_list<Value, IndexSpecifierList, Allocator, Size, Size> {
+         explicit index_list( const Allocator& ){}
+
+         const Value* insert_positions( const Value&, cursor<Value>* )const { return nullptr; }
+         void insert( Value*, cursor<Value>* ) {}
+         void locate( const Value&, cursor<Value>* )const {}
+         void erase( cursor<Value>* ) {}
+         void unlink_moved( cursor<Value>*, bool* ) {}
+         const Value* insert_positions( const Value&, cursor<Value>*, const bool* )const { return nullptr; }
+         void insert( Value*, cursor<Value>*, const bool* ) {}
+         void erase( cursor<Value>*, const bool* ) {}
+         void clear() {}
+      };
+
+   } // namespace btree_detail
+
+   /**
+    *  A container of rows indexed by B+-trees, usable as the MultiIndexType of a generic_index in place of a
+    *  boost::multi_index_container with the same indexed_by<> list. The container itself acts as its first index.
+    *
+    *  Like multi_index, modify() and emplace() fail rather than violate a uniqueness constraint, and a failed modify
+    *  erases the row.
+    */
+   template<typename Value, typename IndexSpecifierList, typename Allocator = std::allocator<Value>>
+   class btree_multi_index_container {
+      typedef btree_detail::index_list<Value, IndexSpecifierList, Allocator>  index_list;
+      typedef btree_detail::cursor<Value>                                    cursor;
+      static const int index_count = boost::mpl::size<IndexSpecifierList>::value;
+
+      public:
+         typedef Value                                                      value_type;
+         typedef btree_detail::row_node<Value,index_count>                  node_type;
+         typedef Allocator                                                  allocator_type;
+         typedef typename Allocator::template rebind<node_type>::other     node_allocator;
+         typedef typename index_list::index_type               primary_index_type;
+         typedef typename primary_index_type::iterator         iterator;
+         typedef iterator                                      const_iterator;
+         typedef typename primary_index_type::reverse_iterator reverse_iterator;
+         typedef reverse_iterator                              const_reverse_iterator;
+         typedef std::size_t                                   size_type;
+
+         template<typename Tag>
+         struct index {
+            static const int position = btree_detail::tag_position<IndexSpecifierList,Tag>::value;
+            typedef btree_ordered_index<Value, typename boost::mpl::at_c<IndexSpecifierList, position>::type,
+                                        Allocator, index_count, position> type;
+         };
+
+         explicit btree_multi_index_container( const Allocator& a = Allocator() ):_alloc(a),_node_alloc(a),_indices(a){}
+         btree_multi_index_container( const btree_multi_index_container& ) = delete;
+         btree_multi_index_container& operator=( const btree_multi_index_container& ) = delete;
+         ~btree_multi_index_container() { clear(); }
+
+         template<typename Tag>
+         const typename index<Tag>::type& get()const {
+            return _indices.get( std::integral_constant<int, btree_detail::tag_position<IndexSpecifierList,Tag>::value>() );
+         }
+
+         template<typename Tag>
+         iterator project( iterator itr )const {
+            if( itr == end() ) return get<Tag>().end();
+            return get<Tag>().iterator_to( *itr );
+         }
+
+         iterator begin()const          { return primary().begin(); }
+         iterator end()const            { return primary().end(); }
+         reverse_iterator rbegin()const { return primary().rbegin(); }
+         reverse_iterator rend()const   { return primary().rend(); }
+         size_type size()const          { return primary().size(); }
+         bool empty()const              { return primary().empty(); }
+
+         template<typename CompatibleKey>
+         iterator find( const CompatibleKey& k )const { return primary().find( k ); }
+
+         template<typename CompatibleKey>
+         iterator lower_bound( const CompatibleKey& k )const { return primary().lower_bound( k ); }
+
+         template<typename CompatibleKey>
+         iterator upper_bound( const CompatibleKey& k )const { return primary().upper_bound( k ); }
+
+         template<typename CompatibleKey>
+         std::pair<iterator,iterator> equal_range( const CompatibleKey& k )const { return primary().equal_range( k ); }
+
+         iterator iterator_to( const Value& v )const { return primary().iterator_to( v ); }
+
+         allocator_type get_allocator()const { return _alloc; }
+
+         template<typename... Args>
+         std::pair<iterator,bool> emplace( Args&&... args ) {
+            node_type* n = &*_node_alloc.allocate( 1 );
+            try {
+               new (n) node_type( std::forward<Args>( args )... );
+            } catch( ... ) {
+               _node_alloc.deallocate( typename node_allocator::pointer( n ), 1 );
+               throw;
+            }
+            Value* v = n;
+
+            cursor c[index_count];
+            if( const Value* duplicate = _indices.insert_positions( *v, c ) ) {
+               destroy( v );
+               return std::make_pair( iterator_to( *duplicate ), false );
+            }
+            _indices.insert( v, c );
+            return std::make_pair( primary().make_iterator( c[0] ), true );
+         }
+
+         template<typename Modifier>
+         bool modify( iterator position, Modifier mod ) {
+            Value* v = const_cast<Value*>( &*position );
+            cursor c[index_count];
+            _indices.locate( *v, c );
+
+            try {
+               mod( *v );
+            } catch( ... ) {
+               _indices.erase( c );
+               destroy( v );
+               throw;
+            }
+
+            bool moved[index_count];
+            _indices.unlink_moved( c, moved );
+            if( _indices.insert_positions( *v, c, moved ) ) {
+               _indices.erase( c, moved );
+               destroy( v );
+               return false;
+            }
+            _indices.insert( v, c, moved );
+            return true;
+         }
+
+         iterator erase( iterator position ) {
+            Value* v = const_cast<Value*>( &*position );
+            const Value* next = ++position == end() ? nullptr : &*position;
+
+            cursor c[index_count];
+            _indices.locate( *v, c );
+            _indices.erase( c );
+            destroy( v );
+            return next ? iterator_to( *next ) : end();
+         }
+
+         void clear() {
+            for( auto itr = begin(); itr != end(); ) {
+               Value* v = const_cast<Value*>( &*itr++ );
+               destroy( v );
+            }
+            _indices.clear();
+         }
+
+      private:
+         const primary_index_type& primary()const { return _indices.index; }
+
+         void destroy( Value* v ) {
+            node_type* n = node_type::from( v );
+            n->~node_type();
+            _node_alloc.deallocate( typename node_allocator::pointer( n ), 1 );
+         }
+
+         allocator_type  _alloc;
+         node_allocator  _node_alloc;
+         index_list      _indices;
+   };
+
+   template<typename Object, typename... Args>
+   using shared_btree_multi_index_container = btree_multi_index_container<Object, Args..., chainbase::allocator<Object> >;
+
+}  // namespace chainbase
@@ -20,6 +20,7 @@
 #include <boost/thread.hpp>
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <fstream>
@@ -128,28 +129,203 @@ namespace chainbase {
    template<typename Constructor, typename Allocator> \
    OBJECT_TYPE( Constructor&& c, Allocator&&  ) { c(*this); }
 
+   /**
+    *  The changes made to an index during one undo session.
+    *
+    *  Objects created during the session are not recorded: ids are handed out in increasing order, so they are
+    *  exactly the objects whose id is not below old_next_id. The before-images of modified and removed objects are
+    *  appended to a journal held in a few large blocks, and are found again by id through a linear scan while the
+    *  journal is short and through an open addressing table once it grows. Blocks are released all at once when
+    *  the session ends, and the index keeps a few of them around for the sessions that follow.
+    */
    template< typename value_type >
    class undo_state
    {
       public:
-         typedef typename value_type::id_type                      id_type;
-         typedef allocator< std::pair<const id_type, value_type> > id_value_allocator_type;
-         typedef allocator< id_type >                              id_allocator_type;
+         typedef typename value_type::id_type id_type;
+
+         struct entry {
+            template<typename V>
+            entry( bool r, V&& v ):removed(r),value( std::forward<V>( v ) ){}
+
+            bool        removed; ///< the object was removed, rather than only modified, during the session
+            value_type  value;
+         };
+
+         struct block {
+            explicit block( uint32_t c ):capacity(c){}
+
+            static size_t header_size() { return (sizeof(block) + alignof(entry) - 1) / alignof(entry) * alignof(entry); }
+            entry* entries() { return reinterpret_cast<entry*>( reinterpret_cast<char*>( this ) + header_size() ); }
+
+            bip::offset_ptr<block>  next;
+            uint32_t                size = 0;
+            uint32_t                capacity;
+         };
+
+         /**
+          *  Blocks of the initial size kept by an index after its sessions end, so that the short lived session of
+          *  a transaction does not have to allocate its journal.
+          */
+         struct block_pool {
+            bip::offset_ptr<block>  head;
+            uint32_t                size = 0;
+         };
 
          template<typename T>
          undo_state( allocator<T> al )
-         :old_values( id_value_allocator_type( al.get_segment_manager() ) ),
-          removed_values( id_value_allocator_type( al.get_segment_manager() ) ),
-          new_ids( id_allocator_type( al.get_segment_manager() ) ){}
+         :_alloc( al.get_segment_manager() ){}
+
+         undo_state( undo_state&& mv )
+         :old_next_id(mv.old_next_id),revision(mv.revision),_alloc(mv._alloc),_first(mv._first),_last(mv._last),
+          _size(mv._size),_table(mv._table),_table_bits(mv._table_bits) {
+            mv._first = mv._last = nullptr;
+            mv._table = nullptr;
+            mv._size = 0;
+         }
+
+         undo_state( const undo_state& ) = delete;
+         undo_state& operator=( const undo_state& ) = delete;
+
+         ~undo_state() { release( nullptr ); }
+
+         bool is_new( const value_type& v )const { return !(v.id < old_next_id); }
+
+         /** the before-image recorded for an object, if any */
+         entry* find( id_type id )const {
+            if( !_table ) {
+               for( block* b = _first.get(); b; b = b->next.get() )
+                  for( uint32_t i = 0; i < b->size; ++i )
+                     if( b->entries()[i].value.id == id ) return b->entries() + i;
+               return nullptr;
+            }
+            const uint64_t mask = (uint64_t(1) << _table_bits) - 1;
+            for( uint64_t slot = hash( id ); ; slot = (slot + 1) & mask ) {
+               entry* e = _table[slot].get();
+               if( !e || e->value.id == id ) return e;
+            }
+         }
+
+         template<typename V>
+         void append( block_pool& pool, bool removed, V&& v ) {
+            if( !_last || _last->size == _last->capacity ) {
+               block* b = new_block( pool );
+               if( _last ) _last->next = b;
+               else        _first = b;
+               _last = b;
+            }
+            entry* e = new (_last->entries() + _last->size) entry( removed, std::forward<V>( v ) );
+            ++_last->size;
+            ++_size;
+
+            if( _size > linear_scan_limit ) {
+               if( !_table || _size * 2 > (uint64_t(1) << _table_bits) ) rebuild_table();
+               else                                                        insert_into_table( e );
+            }
+         }
 
-         typedef boost::interprocess::map< id_type, value_type, std::less<id_type>, id_value_allocator_type >  id_value_type_map;
-         typedef boost::interprocess::set< id_type, std::less<id_type>, id_allocator_type >                    id_type_set;
+         template<typename Function>
+         void for_each( Function&& f ) {
+            for( block* b = _first.get(); b; b = b->next.get() )
+               for( uint32_t i = 0; i < b->size; ++i )
+                  f( b->entries()[i] );
+         }
+
+         /**
+          *  Destroys the journal. Blocks of the initial size are handed to the pool while it is not full, the rest
+          *  are freed.
+          */
+         void release( block_pool* pool ) {
+            for( block* b = _first.get(); b; ) {
+               block* next = b->next.get();
+               for( uint32_t i = 0; i < b->size; ++i )
+                  b->entries()[i].~entry();
+               b->size = 0;
+               if( pool && b->capacity == initial_capacity() && pool->size < max_pooled_blocks ) {
+                  b->next = pool->head;
+                  pool->head = b;
+                  ++pool->size;
+               } else {
+                  free_block( b );
+               }
+               b = next;
+            }
+            _first = _last = nullptr;
+            _size = 0;
+            free_table();
+         }
 
-         id_value_type_map            old_values;
-         id_value_type_map            removed_values;
-         id_type_set                  new_ids;
          id_type                      old_next_id = 0;
          int64_t                      revision = 0;
+
+      private:
+         typedef bip::offset_ptr<entry> table_slot;
+
+         static const uint32_t linear_scan_limit = 16;
+         static const uint32_t max_pooled_blocks = 8;
+         static const size_t   initial_block_size = 4096;
+         static const size_t   max_block_size = 1024*1024;
+
+         static uint32_t entries_in( size_t block_size ) {
+            return std::max<size_t>( (block_size - block::header_size()) / sizeof(entry), 4 );
+         }
+         static uint32_t initial_capacity() { return entries_in( initial_block_size ); }
+
+         block* new_block( block_pool& pool ) {
+            if( !_last && pool.head ) {
+               block* b = pool.head.get();
+               pool.head = b->next;
+               --pool.size;
+               b->next = nullptr;
+               return b;
+            }
+            uint32_t capacity = _last ? std::min( std::max( initial_capacity(), _size ), entries_in( max_block_size ) )
+                                      : initial_capacity();
+            char* raw = &*_alloc.allocate( block::header_size() + capacity * sizeof(entry) );
+            return new (raw) block( capacity );
+         }
+
+         void free_block( block* b ) {
+            size_t bytes = block::header_size() + b->capacity * sizeof(entry);
+            b->~block();
+            _alloc.deallocate( typename allocator<char>::pointer( reinterpret_cast<char*>( b ) ), bytes );
+         }
+
+         uint64_t hash( id_type id )const {
+            return (uint64_t(id._id) * 0x9E3779B97F4A7C15ull) >> (64 - _table_bits);
+         }
+
+         void insert_into_table( entry* e ) {
+            const uint64_t mask = (uint64_t(1) << _table_bits) - 1;
+            uint64_t slot = hash( e->value.id );
+            while( _table[slot] ) slot = (slot + 1) & mask;
+            _table[slot] = e;
+         }
+
+         void rebuild_table() {
+            free_table();
+            _table_bits = 6;
+            while( (uint64_t(1) << _table_bits) < uint64_t(_size) * 4 ) ++_table_bits;
+            allocator<table_slot> alloc( _alloc.get_segment_manager() );
+            _table = &*alloc.allocate( size_t(1) << _table_bits );
+            for( size_t i = 0; i < (size_t(1) << _table_bits); ++i )
+               new (&_table[i]) table_slot();
+            for_each( [&]( entry& e ) { insert_into_table( &e ); } );
+         }
+
+         void free_table() {
+            if( !_table ) return;
+            allocator<table_slot> alloc( _alloc.get_segment_manager() );
+            alloc.deallocate( typename allocator<table_slot>::pointer( _table.get() ), size_t(1) << _table_bits );
+            _table = nullptr;
+         }
+
+         allocator<char>              _alloc;
+         bip::offset_ptr<block>       _first;
+         bip::offset_ptr<block>       _last;
+         uint32_t                     _size = 0;
+         bip::offset_ptr<table_slot>  _table;
+         uint32_t                     _table_bits = 0;
    };
 
    /**
@@ -201,7 +377,7 @@ namespace chainbase {
 
          /**
           * Construct a new element in the multi_index_container.
-          * Set the ID to the next available ID, then increment _next_id and fire off on_create().
+          * Set the ID to the next available ID, then increment _next_id.
           */
          template<typename Constructor>
          const value_type& emplace( Constructor&& c ) {
@@ -219,7 +395,6 @@ namespace chainbase {
             }
 
             ++_next_id;
-            on_create( *insert_result.first );
             return *insert_result.first;
          }
 
@@ -251,6 +426,23 @@ namespace chainbase {
 
          const index_type& indices()const { return _indices; }
 
+         /**
+          * The id the next emplaced object will receive.
+          */
+         typename value_type::id_type next_id()const { return _next_id; }
+
+         /**
+          * Restores the id counter after objects were recreated with their original ids, e.g. when loading a
+          * snapshot. It cannot be moved at or below an existing id, nor while undo sessions are active.
+          */
+         void set_next_id( typename value_type::id_type next_id ) {
+            if( _stack.size() )
+               BOOST_THROW_EXCEPTION( std::logic_error( "cannot set the next id while undo sessions are active" ) );
+            if( _indices.size() && !(_indices.rbegin()->id < next_id) )
+               BOOST_THROW_EXCEPTION( std::logic_error( "next id must be greater than every existing id" ) );
+            _next_id = next_id;
+         }
+
          class session {
             public:
                session( session&& mv )
@@ -312,26 +504,27 @@ namespace chainbase {
          void undo() {
             if( !enabled() ) return;
 
-            const auto& head = _stack.back();
+            auto& head = _stack.back();
+
+            for( auto itr = _indices.lower_bound( head.old_next_id ); itr != _indices.end(); )
+               itr = _indices.erase( itr );
+            _next_id = head.old_next_id;
 
-            for( auto& item : head.old_values ) {
-               auto ok = _indices.modify( _indices.find( item.second.id ), [&]( value_type& v ) {
-                  v = std::move( item.second );
+            head.for_each( [&]( typename undo_state_type::entry& e ) {
+               if( e.removed ) return;
+               auto ok = _indices.modify( _indices.find( e.value.id ), [&]( value_type& v ) {
+                  v = std::move( e.value );
                });
                if( !ok ) BOOST_THROW_EXCEPTION( std::logic_error( "Could not modify object, most likely a uniqueness constraint was violated" ) );
-            }
-
-            for( auto id : head.new_ids )
-            {
-               _indices.erase( _indices.find( id ) );
-            }
-            _next_id = head.old_next_id;
+            });
 
-            for( auto& item : head.removed_values ) {
-               bool ok = _indices.emplace( std::move( item.second ) ).second;
+            head.for_each( [&]( typename undo_state_type::entry& e ) {
+               if( !e.removed ) return;
+               bool ok = _indices.emplace( std::move( e.value ) ).second;
                if( !ok ) BOOST_THROW_EXCEPTION( std::logic_error( "Could not restore object, most likely a uniqueness constraint was violated" ) );
-            }
+            });
 
+            head.release( &_undo_blocks );
             _stack.pop_back();
             --_revision;
          }
@@ -346,6 +539,7 @@ namespace chainbase {
          {
             if( !enabled() ) return;
             if( _stack.size() == 1 ) {
+               _stack.front().release( &_undo_blocks );
                _stack.pop_front();
                return;
             }
@@ -354,9 +548,9 @@ namespace chainbase {
             auto& prev_state = _stack[_stack.size()-2];
 
             // An object's relationship to a state can be:
-            // in new_ids            : new
-            // in old_values (was=X) : upd(was=X)
-            // in removed (was=X)    : del(was=X)
+            // id >= old_next_id     : new
+            // journaled (was=X)     : upd(was=X)
+            // journaled removed (X) : del(was=X)
             // not in any of above   : nop
             //
             // When merging A=prev_state and B=state we have a 4x4 matrix of all possibilities:
@@ -375,71 +569,33 @@ namespace chainbase {
             // \ | nop        | new       B| upd(was=Y)B| del(was=Y)B| nop      AB|
             //   +------------+------------+------------+------------+------------+
             //
-            // Each entry was composed by labelling what should occur in the given case.
-            //
             // Type A means the composition of states contains the same entry as the first of the two merged states for that object.
             // Type B means the composition of states contains the same entry as the second of the two merged states for that object.
             // Type C means the composition of states contains an entry different from either of the merged states for that object.
             // Type N/A means the composition of states violates causal timing.
             // Type AB means both type A and type B simultaneously.
             //
-            // The merge() operation is defined as modifying prev_state in-place to be the state object which represents the composition of
-            // state A and B.
-            //
-            // Type A (and AB) can be implemented as a no-op; prev_state already contains the correct value for the merged state.
-            // Type B (and AB) can be implemented by copying from state to prev_state.
-            // Type C needs special case-by-case logic.
-            // Type N/A can be ignored or assert(false) as it can only occur if prev_state and state have illegal values
-            // (a serious logic error which should never happen).
-            //
-
-            // We can only be outside type A/AB (the nop path) if B is not nop, so it suffices to iterate through B's three containers.
-
-            for( const auto& item : state.old_values )
-            {
-               if( prev_state.new_ids.find( item.second.id ) != prev_state.new_ids.end() )
-               {
-                  // new+upd -> new, type A
-                  continue;
-               }
-               if( prev_state.old_values.find( item.second.id ) != prev_state.old_values.end() )
-               {
-                  // upd(was=X) + upd(was=Y) -> upd(was=X), type A
-                  continue;
+            // Objects new in B have ids at or above B's old_next_id, which is at or above A's, so they are new in A
+            // without any work (nop+new -> new, type B). new+del -> nop is just as free: the object no longer exists
+            // for undo to erase. Everything else is decided by walking B's journal.
+
+            state.for_each( [&]( typename undo_state_type::entry& e ) {
+               if( prev_state.is_new( e.value ) ) {
+                  // new+upd -> new, type A; new+del -> nop, type C
+                  return;
                }
-               // del+upd -> N/A
-               assert( prev_state.removed_values.find(item.second.id) == prev_state.removed_values.end() );
-               // nop+upd(was=Y) -> upd(was=Y), type B
-               prev_state.old_values.emplace( std::move(item) );
-            }
-
-            // *+new, but we assume the N/A cases don't happen, leaving type B nop+new -> new
-            for( auto id : state.new_ids )
-               prev_state.new_ids.insert(id);
-
-            // *+del
-            for( auto& obj : state.removed_values )
-            {
-               if( prev_state.new_ids.find(obj.second.id) != prev_state.new_ids.end() )
-               {
-                  // new + del -> nop (type C)
-                  prev_state.new_ids.erase(obj.second.id);
-                  continue;
+               if( auto* prev = prev_state.find( e.value.id ) ) {
+                  // del+* -> N/A
+                  assert( !prev->removed );
+                  // upd(was=X) + upd(was=Y) -> upd(was=X), type A; upd(was=X) + del(was=Y) -> del(was=X), type C
+                  prev->removed = e.removed;
+                  return;
                }
-               auto it = prev_state.old_values.find(obj.second.id);
-               if( it != prev_state.old_values.end() )
-               {
-                  // upd(was=X) + del(was=Y) -> del(was=X)
-                  prev_state.removed_values.emplace( std::move(*it) );
-                  prev_state.old_values.erase(obj.second.id);
-                  continue;
-               }
-               // del + del -> N/A
-               assert( prev_state.removed_values.find( obj.second.id ) == prev_state.removed_values.end() );
-               // nop + del(was=Y) -> del(was=Y)
-               prev_state.removed_values.emplace( std::move(obj) ); //[obj.second->id] = std::move(obj.second);
-            }
+               // nop+upd(was=Y) -> upd(was=Y), nop+del(was=Y) -> del(was=Y), type B
+               prev_state.append( _undo_blocks, e.removed, std::move( e.value ) );
+            });
 
+            state.release( &_undo_blocks );
             _stack.pop_back();
             --_revision;
          }
@@ -485,43 +641,25 @@ namespace chainbase {
 
             auto& head = _stack.back();
 
-            if( head.new_ids.find( v.id ) != head.new_ids.end() )
-               return;
-
-            auto itr = head.old_values.find( v.id );
-            if( itr != head.old_values.end() )
+            if( head.is_new( v ) || head.find( v.id ) )
                return;
 
-            head.old_values.emplace( std::pair< typename value_type::id_type, const value_type& >( v.id, v ) );
+            head.append( _undo_blocks, false, v );
          }
 
          void on_remove( const value_type& v ) {
             if( !enabled() ) return;
 
             auto& head = _stack.back();
-            if( head.new_ids.count(v.id) ) {
-               head.new_ids.erase( v.id );
+            if( head.is_new( v ) )
                return;
-            }
 
-            auto itr = head.old_values.find( v.id );
-            if( itr != head.old_values.end() ) {
-               head.removed_values.emplace( std::move( *itr ) );
-               head.old_values.erase( v.id );
+            if( auto* e = head.find( v.id ) ) {
+               e->removed = true;
                return;
             }
 
-            if( head.removed_values.count( v.id ) )
-               return;
-
-            head.removed_values.emplace( std::pair< typename value_type::id_type, const value_type& >( v.id, v ) );
-         }
-
-         void on_create( const value_type& v ) {
-            if( !enabled() ) return;
-            auto& head = _stack.back();
-
-            head.new_ids.insert( v.id );
+            head.append( _undo_blocks, true, v );
          }
 
          boost::interprocess::deque< undo_state_type, allocator<undo_state_type> > _stack;
@@ -534,6 +672,7 @@ namespace chainbase {
           */
          int64_t                         _revision = 0;
          typename value_type::id_type    _next_id = 0;
+         typename undo_state_type::block_pool _undo_blocks;
          index_type                      _indices;
          uint32_t                        _size_of_value_type = 0;
          uint32_t                        _size_of_this = 0;
@@ -663,7 +802,21 @@ namespace chainbase {
 
          using database_index_row_count_multiset = std::multiset<std::pair<unsigned, std::string>>;
 
-         database(const bfs::path& dir, open_flags write = read_only, uint64_t shared_file_size = 0, bool allow_dirty = false);
+         /**
+          * By default shared_memory.bin is mapped directly. With a hugepage_dir, which must be a hugetlbfs mount (2MB or
+          * 1GB pages), a read/write database is copied at open into a file there and copied back on flush and close, so
+          * that walks over large indices use hugepage TLB entries. A numa_node that is not negative binds the memory of
+          * the database to that NUMA node.
+          */
+         struct map_options {
+            map_options() : numa_node(-1) {}
+
+            bfs::path   hugepage_dir;
+            int         numa_node;
+         };
+
+         database(const bfs::path& dir, open_flags write = read_only, uint64_t shared_file_size = 0, bool allow_dirty = false,
+                  const map_options& options = map_options());
          ~database();
          database(database&&) = default;
          database& operator=(database&&) = default;
@@ -951,6 +1104,7 @@ namespace chainbase {
       private:
          unique_ptr<bip::managed_mapped_file>                        _segment;
          unique_ptr<bip::managed_mapped_file>                        _meta;
+         unique_ptr<bip::managed_mapped_file>                        _file_segment; ///< shared_memory.bin while _segment lives on hugepages
          read_write_mutex_manager*                                   _rw_manager = nullptr;
          bool                                                        _read_only = false;
          bip::file_lock                                              _flock;
@@ -972,6 +1126,8 @@ namespace chainbase {
          bool                                                        _enable_require_locking = false;
 
          void                                                        _msync_database();
+         void                                                        _move_to_hugepages( const map_options& options );
+         void                                                        _write_back_hugepages();
    };
 
    template<typename Object, typename... Args>
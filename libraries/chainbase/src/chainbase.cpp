@@ -5,8 +5,36 @@
 
 #include <sys/mman.h>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/statfs.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
 namespace chainbase {
 
+   namespace {
+      const long hugetlbfs_magic = 0x958458f6;
+
+      void bind_to_numa_node( void* addr, size_t size, int node ) {
+#ifdef __linux__
+         unsigned long mask[16] = {};
+         const int bits_per_word = 8 * sizeof(unsigned long);
+         if( node >= int(sizeof(mask) * 8) )
+            BOOST_THROW_EXCEPTION( std::runtime_error( "NUMA node " + std::to_string(node) + " is out of range" ) );
+         mask[node / bits_per_word] |= 1ul << (node % bits_per_word);
+         if( syscall( SYS_mbind, addr, size, MPOL_BIND, mask, sizeof(mask) * 8, MPOL_MF_MOVE ) != 0 ) {
+            std::cerr << "CHAINBASE:   Failed to bind chainbase shared memory to NUMA node " << node << ": "
+                      << strerror(errno) << ". Performance degradation is possible." << std::endl;
+         }
+#else
+         std::cerr << "CHAINBASE:   Binding chainbase shared memory to a NUMA node is not supported on this platform." << std::endl;
+#endif
+      }
+   }
+
    struct environment_check {
       environment_check() {
          memset( &compiler_version, 0, sizeof( compiler_version ) );
@@ -34,9 +62,13 @@ namespace chainbase {
       uint32_t                boost_version;
    };
 
-   database::database(const bfs::path& dir, open_flags flags, uint64_t shared_file_size, bool allow_dirty ) {
+   database::database(const bfs::path& dir, open_flags flags, uint64_t shared_file_size, bool allow_dirty,
+                      const map_options& options ) {
       bool write = flags & database::read_write;
 
+      if( !options.hugepage_dir.empty() && !write )
+         BOOST_THROW_EXCEPTION( std::runtime_error( "only a read/write database can be backed by hugepages" ) );
+
       if (!bfs::exists(dir)) {
          if(!write) BOOST_THROW_EXCEPTION( std::runtime_error( "database file not found at " + dir.native() ) );
       }
@@ -114,7 +146,8 @@ namespace chainbase {
          _segment->find_or_construct< environment_check >( "environment" )();
 
 #ifndef _WIN32
-         int r = mlock( _segment->get_address(), _segment->get_size() );
+         // a hugepage backed segment is pinned anyway, and locking the file mapping would only hold a second copy
+         int r = options.hugepage_dir.empty() ? mlock( _segment->get_address(), _segment->get_size() ) : 0;
          if (r != 0 ) {
             //we cannot use fc library here, which means that this message doesn't go to graylog even if you have configure it
             //also it doesn't looks as nice as warnings generated by fc
@@ -175,18 +208,90 @@ namespace chainbase {
 
          *db_is_dirty = *meta_is_dirty = true;
          _msync_database();
+
+         // shared_memory.bin now stays marked dirty until the hugepage copy is written back at close
+         if( !options.hugepage_dir.empty() )
+            _move_to_hugepages( options );
+      }
+
+      if( options.numa_node >= 0 && options.hugepage_dir.empty() )
+         bind_to_numa_node( _segment->get_address(), _segment->get_size(), options.numa_node );
+   }
+
+   void database::_move_to_hugepages( const map_options& options ) {
+#ifdef __linux__
+      struct statfs fs;
+      if( statfs( options.hugepage_dir.generic_string().c_str(), &fs ) != 0 || fs.f_type != hugetlbfs_magic )
+         BOOST_THROW_EXCEPTION( std::runtime_error( options.hugepage_dir.generic_string() + " is not a hugetlbfs mount" ) );
+
+      const size_t size = _segment->get_size();
+      const size_t page_size = fs.f_bsize;
+      const size_t mapped_size = (size + page_size - 1) / page_size * page_size;
+      auto huge_path = options.hugepage_dir / bfs::unique_path( "chainbase-%%%%-%%%%-%%%%-%%%%" );
+
+      int fd = open( huge_path.generic_string().c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR );
+      if( fd < 0 )
+         BOOST_THROW_EXCEPTION( std::runtime_error( "could not create " + huge_path.generic_string() + ": " + strerror(errno) ) );
+
+      try {
+         void* addr = MAP_FAILED;
+         if( ftruncate( fd, mapped_size ) == 0 )
+            addr = mmap( nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0 );
+         close( fd );
+         if( addr == MAP_FAILED )
+            BOOST_THROW_EXCEPTION( std::runtime_error( "could not allocate " + std::to_string(mapped_size / page_size) + " hugepages of "
+                                                       + std::to_string(page_size) + " bytes, check vm.nr_hugepages" ) );
+
+         // bind before copying so that the pages are placed on the node when they are first touched
+         if( options.numa_node >= 0 )
+            bind_to_numa_node( addr, mapped_size, options.numa_node );
+         memcpy( addr, _segment->get_address(), size );
+         munmap( addr, mapped_size );
+
+         _file_segment = std::move( _segment );
+         _segment.reset( new bip::managed_mapped_file( bip::open_only, huge_path.generic_string().c_str() ) );
+         bfs::remove( huge_path ); // the pages live as long as the mapping does
+      } catch( ... ) {
+         if( _file_segment && !_segment )
+            _segment = std::move( _file_segment );
+         boost::system::error_code ec;
+         bfs::remove( huge_path, ec );
+         throw;
       }
+
+      madvise( _file_segment->get_address(), size, MADV_DONTNEED );
+#else
+      BOOST_THROW_EXCEPTION( std::runtime_error( "hugepage backed databases are not supported on this platform" ) );
+#endif
+   }
+
+   void database::_write_back_hugepages() {
+      const size_t size = _file_segment->get_size();
+      memcpy( _file_segment->get_address(), _segment->get_address(), size );
+#ifndef _WIN32
+      if( msync( _file_segment->get_address(), size, MS_SYNC ) )
+         perror( "Failed to msync DB file" );
+      madvise( _file_segment->get_address(), size, MADV_DONTNEED );
+#else
+      _file_segment->flush();
+#endif
    }
 
    database::~database()
    {
       if(!_read_only) {
+         // the copy written back from hugepages still carries the set dirty flag, so a crash while it is being
+         // written leaves shared_memory.bin marked dirty
+         if( _file_segment )
+            _write_back_hugepages();
          _msync_database();
-         *_segment->get_segment_manager()->find<bool>(_db_dirty_flag_string).first = false;
+         bip::managed_mapped_file& file = _file_segment ? *_file_segment : *_segment;
+         *file.get_segment_manager()->find<bool>(_db_dirty_flag_string).first = false;
          *_meta->get_segment_manager()->find<bool>(_db_dirty_flag_string).first = false;
          _msync_database();
       }
       _segment.reset();
+      _file_segment.reset();
       _meta.reset();
       _index_list.clear();
       _index_map.clear();
@@ -194,7 +299,9 @@ namespace chainbase {
    }
 
    void database::flush() {
-      if( _segment )
+      if( _file_segment )
+         _write_back_hugepages();
+      else if( _segment )
          _segment->flush();
       if( _meta )
          _meta->flush();
@@ -204,7 +311,9 @@ namespace chainbase {
 #ifdef _WIN32
 #warning Safe database dirty handling not implemented on WIN32
 #else
-         if(msync(_segment->get_address(), _segment->get_size(), MS_SYNC))
+         // while the database lives on hugepages, shared_memory.bin is the file segment
+         bip::managed_mapped_file& file = _file_segment ? *_file_segment : *_segment;
+         if(msync(file.get_address(), file.get_size(), MS_SYNC))
             perror("Failed to msync DB file");
          if(msync(_meta->get_address(), _meta->get_size(), MS_SYNC))
             perror("Failed to msync DB metadata file");
@@ -2,12 +2,16 @@
 
 #include <boost/test/unit_test.hpp>
 #include <chainbase/chainbase.hpp>
+#include <chainbase/btree_index.hpp>
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/member.hpp>
+#include <boost/multi_index/composite_key.hpp>
 
 #include <iostream>
+#include <map>
+#include <random>
 
 using namespace chainbase;
 using namespace boost::multi_index;
@@ -38,6 +42,40 @@ typedef multi_index_container<
 
 CHAINBASE_SET_INDEX_TYPE( book, book_index )
 
+template<uint16_t TypeNumber>
+struct entry : public chainbase::object<TypeNumber, entry<TypeNumber>> {
+   template<typename Constructor, typename Allocator>
+   entry( Constructor&& c, Allocator&& a ) {
+      c(*this);
+   }
+
+   typename chainbase::object<TypeNumber, entry<TypeNumber>>::id_type id;
+   uint32_t table = 0;
+   uint64_t key = 0;
+   uint64_t value = 0;
+};
+
+struct by_table_key;
+
+template<typename Entry>
+using entry_indices = indexed_by<
+   ordered_unique< member<Entry,typename Entry::id_type,&Entry::id> >,
+   ordered_unique< tag<by_table_key>,
+      composite_key< Entry,
+         member<Entry,uint32_t,&Entry::table>,
+         member<Entry,uint64_t,&Entry::key>
+      >
+   >
+>;
+
+typedef entry<1> tree_entry;
+typedef entry<2> btree_entry;
+typedef shared_multi_index_container<tree_entry, entry_indices<tree_entry>> tree_entry_index;
+typedef shared_btree_multi_index_container<btree_entry, entry_indices<btree_entry>> btree_entry_index;
+
+CHAINBASE_SET_INDEX_TYPE( tree_entry, tree_entry_index )
+CHAINBASE_SET_INDEX_TYPE( btree_entry, btree_entry_index )
+
 
 BOOST_AUTO_TEST_CASE( open_and_create ) {
    boost::filesystem::path temp = boost::filesystem::unique_path();
@@ -131,4 +169,214 @@ BOOST_AUTO_TEST_CASE( open_and_create ) {
    }
 }
 
+/**
+ * Nest, modify, squash, undo and commit sessions at random and check the database against a copy of the expected
+ * rows kept for every open session
+ */
+BOOST_AUTO_TEST_CASE( undo_journal ) {
+   boost::filesystem::path temp = boost::filesystem::unique_path();
+   try {
+      chainbase::database db(temp, database::read_write, 1024*1024*32);
+      db.add_index< book_index >();
+      const auto& books = db.get_index< book_index >().indices();
+
+      typedef std::map<int64_t, std::pair<int,int>> rows;
+      rows expected;
+      std::vector<rows> saved;
+      std::vector<chainbase::database::session> sessions;
+
+      auto require_expected = [&]() {
+         BOOST_REQUIRE_EQUAL( books.size(), expected.size() );
+         auto e = expected.begin();
+         for( const auto& b : books ) {
+            BOOST_REQUIRE( b.id._id == e->first && b.a == e->second.first && b.b == e->second.second );
+            ++e;
+         }
+      };
+
+      std::mt19937_64 rng( 11 );
+      auto random_book = [&]() -> const book* {
+         if( expected.empty() ) return nullptr;
+         auto itr = expected.lower_bound( int64_t( rng() % (expected.rbegin()->first + 1) ) );
+         return &db.get( book::id_type( itr->first ) );
+      };
+
+      for( int step = 0; step < 3000; ++step ) {
+         if( sessions.size() < 6 && rng() % 3 == 0 ) {
+            sessions.emplace_back( db.start_undo_session( true ) );
+            saved.push_back( expected );
+         }
+
+         for( int i = rng() % 40; i > 0; --i ) {
+            switch( rng() % 3 ) {
+               case 0: {
+                  int a = rng() % 1000, b = rng() % 1000;
+                  const auto& n = db.create<book>( [&]( book& nb ) { nb.a = a; nb.b = b; } );
+                  expected[n.id._id] = std::make_pair( a, b );
+                  break;
+               }
+               case 1:
+                  if( const book* m = random_book() ) {
+                     int a = rng() % 1000;
+                     db.modify( *m, [&]( book& mb ) { mb.a = a; ++mb.b; } );
+                     expected[m->id._id] = std::make_pair( m->a, m->b );
+                  }
+                  break;
+               default:
+                  if( const book* r = random_book() ) {
+                     expected.erase( r->id._id );
+                     db.remove( *r );
+                  }
+            }
+         }
+
+         if( !sessions.empty() ) {
+            switch( rng() % 4 ) {
+               case 0:
+                  sessions.back().undo();
+                  expected = saved.back();
+                  sessions.pop_back();
+                  saved.pop_back();
+                  break;
+               case 1:
+                  if( sessions.size() > 1 ) {
+                     sessions.back().squash();
+                     sessions.pop_back();
+                     saved.pop_back();
+                  }
+                  break;
+               case 2:
+                  if( sessions.size() == 6 ) {
+                     for( auto& s : sessions ) s.push();
+                     db.commit( db.revision() );
+                     sessions.clear();
+                     saved.clear();
+                  }
+                  break;
+            }
+         }
+         require_expected();
+      }
+
+      while( !sessions.empty() ) {
+         sessions.back().undo();
+         expected = saved.back();
+         sessions.pop_back();
+         saved.pop_back();
+         require_expected();
+      }
+   } catch ( ... ) {
+      bfs::remove_all( temp );
+      throw;
+   }
+   bfs::remove_all( temp );
+}
+
+/**
+ * Drive a multi_index and a btree index through the same random creates, modifies, removes and undo sessions and
+ * require that both always hold the same rows in the same order
+ */
+BOOST_AUTO_TEST_CASE( btree_matches_multi_index ) {
+   boost::filesystem::path temp = boost::filesystem::unique_path();
+   try {
+      chainbase::database db(temp, database::read_write, 1024*1024*64);
+      db.add_index< tree_entry_index >();
+      db.add_index< btree_entry_index >();
+
+      const auto& tree = db.get_index< tree_entry_index >().indices();
+      const auto& btree = db.get_index< btree_entry_index >().indices();
+
+      auto require_same = [&]() {
+         BOOST_REQUIRE_EQUAL( tree.size(), btree.size() );
+         auto b = btree.begin();
+         for( const auto& t : tree ) {
+            BOOST_REQUIRE( t.id._id == b->id._id && t.table == b->table && t.key == b->key && t.value == b->value );
+            ++b;
+         }
+         BOOST_REQUIRE( b == btree.end() );
+
+         const auto& by_key = tree.get<by_table_key>();
+         auto rb = btree.get<by_table_key>().rbegin();
+         for( auto r = by_key.rbegin(); r != by_key.rend(); ++r, ++rb )
+            BOOST_REQUIRE( r->id._id == rb->id._id );
+         BOOST_REQUIRE( rb == btree.get<by_table_key>().rend() );
+
+         // every row leads back to its position in each index
+         for( auto itr = btree.begin(); itr != btree.end(); ++itr )
+            BOOST_REQUIRE( btree.iterator_to( *itr ) == itr );
+         const auto& btree_by_key = btree.get<by_table_key>();
+         for( auto itr = btree_by_key.begin(); itr != btree_by_key.end(); ++itr )
+            BOOST_REQUIRE( btree_by_key.iterator_to( *itr ) == itr );
+      };
+
+      std::mt19937_64 rng( 7 );
+      auto random_key = [&]() { return std::make_pair( uint32_t(rng() % 8), rng() % 20000 ); };
+
+      for( int round = 0; round < 40; ++round ) {
+         auto session = db.start_undo_session( true );
+         for( int i = 0; i < 1000; ++i ) {
+            auto k = random_key();
+            const auto* t = db.find<tree_entry,by_table_key>( boost::make_tuple( k.first, k.second ) );
+            const auto* b = db.find<btree_entry,by_table_key>( boost::make_tuple( k.first, k.second ) );
+            BOOST_REQUIRE( !t == !b );
+
+            switch( rng() % 4 ) {
+               case 0:
+               case 1:
+                  if( !t ) {
+                     uint64_t value = rng();
+                     db.create<tree_entry>( [&]( tree_entry& e ) { e.table = k.first; e.key = k.second; e.value = value; } );
+                     db.create<btree_entry>( [&]( btree_entry& e ) { e.table = k.first; e.key = k.second; e.value = value; } );
+                  }
+                  break;
+               case 2:
+                  if( t ) {
+                     auto to = random_key();
+                     if( db.find<tree_entry,by_table_key>( boost::make_tuple( to.first, to.second ) ) )
+                        break;
+                     auto move = [&]( uint32_t& table, uint64_t& key, uint64_t& value ) {
+                        table = to.first; key = to.second; ++value;
+                     };
+                     db.modify( *t, [&]( tree_entry& e ) { move( e.table, e.key, e.value ); } );
+                     db.modify( *b, [&]( btree_entry& e ) { move( e.table, e.key, e.value ); } );
+                  }
+                  break;
+               default:
+                  if( t ) {
+                     db.remove( *t );
+                     db.remove( *b );
+                  }
+            }
+         }
+
+         auto k = random_key();
+         auto lower = btree.get<by_table_key>().lower_bound( boost::make_tuple( k.first ) );
+         BOOST_REQUIRE( (lower == btree.get<by_table_key>().end()) == (tree.get<by_table_key>().lower_bound( boost::make_tuple( k.first ) ) == tree.get<by_table_key>().end()) );
+         auto upper = btree.get<by_table_key>().upper_bound( boost::make_tuple( k.first, k.second ) );
+         auto tree_upper = tree.get<by_table_key>().upper_bound( boost::make_tuple( k.first, k.second ) );
+         BOOST_REQUIRE( (upper == btree.get<by_table_key>().end()) == (tree_upper == tree.get<by_table_key>().end()) );
+         if( tree_upper != tree.get<by_table_key>().end() )
+            BOOST_REQUIRE_EQUAL( upper->id._id, tree_upper->id._id );
+         if( tree_upper != tree.get<by_table_key>().begin() )
+            BOOST_REQUIRE_EQUAL( (--upper)->id._id, (--tree_upper)->id._id );
+
+         require_same();
+         if( round % 3 == 0 ) {
+            session.undo();
+            require_same();
+         } else {
+            session.push();
+         }
+      }
+
+      db.undo_all();
+      require_same();
+      BOOST_REQUIRE( btree.empty() );
+   } catch ( ... ) {
+      bfs::remove_all( temp );
+      throw;
+   }
+   bfs::remove_all( temp );
+}
+
 // BOOST_AUTO_TEST_SUITE_END()
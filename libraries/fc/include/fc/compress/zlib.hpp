@@ -7,4 +7,7 @@ namespace fc
 
   string zlib_compress(const string& in);
 
+  /// inflates the output of zlib_compress, throws if it is not a valid zlib stream
+  string zlib_decompress(const string& in);
+
 } // namespace fc
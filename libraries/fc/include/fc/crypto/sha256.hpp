@@ -24,6 +24,12 @@ class sha256
     static sha256 hash( const string& );
     static sha256 hash( const sha256& );
 
+    /**
+     * out[i] = hash( data[i], sizes[i] ) for i < n; where the CPU has AVX2 but not the SHA extensions, messages
+     * padding to the same number of blocks are hashed eight at a time
+     */
+    static void hash_many( const char* const* data, const uint32_t* sizes, sha256* out, size_t n );
+
     template<typename T>
     static sha256 hash( const T& t ) 
     { 
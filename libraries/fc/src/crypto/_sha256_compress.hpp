@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/* SHA-256 compression functions behind fc::sha256
+ */
+namespace fc { namespace detail {
+    /// Runs the SHA-256 compression function over nblocks consecutive 64 byte blocks
+    typedef void (*sha256_compress_func)( uint32_t state[8], const uint8_t* blocks, size_t nblocks );
+
+    void sha256_compress_scalar( uint32_t state[8], const uint8_t* blocks, size_t nblocks );
+    /// Only to be called when sha256_has_shani()
+    void sha256_compress_shani( uint32_t state[8], const uint8_t* blocks, size_t nblocks );
+    /// One block for each of 8 states, state[k][j] being word k of lane j; only to be called when sha256_has_avx2()
+    void sha256_compress8_avx2( uint32_t state[8][8], const uint8_t* const blocks[8] );
+
+    bool sha256_has_shani();
+    bool sha256_has_avx2();
+
+    /// The compression function best suited to this CPU
+    sha256_compress_func sha256_compress();
+
+    extern const uint32_t sha256_initial_state[8];
+}}
@@ -1,13 +1,14 @@
 #include <fc/crypto/hex.hpp>
 #include <fc/crypto/hmac.hpp>
 #include <fc/fwd_impl.hpp>
-#include <openssl/sha.h>
 #include <string.h>
+#include <algorithm>
 #include <cmath>
 #include <fc/crypto/sha256.hpp>
 #include <fc/variant.hpp>
 #include <fc/exception/exception.hpp>
 #include "_digest_common.hpp"
+#include "_sha256_compress.hpp"
 
 namespace fc {
 
@@ -29,8 +30,38 @@ namespace fc {
     char* sha256::data()const { return (char*)&_hash[0]; }
 
 
+    namespace {
+       /**
+        * Pads the last rem bytes of a message of total bytes into one or two blocks at tail, returns how many
+        */
+       size_t pad_tail( uint8_t tail[128], const uint8_t* rest, size_t rem, uint64_t total ) {
+          const size_t nblocks = rem < 56 ? 1 : 2;
+          memcpy( tail, rest, rem );
+          tail[rem] = 0x80;
+          memset( tail + rem + 1, 0, nblocks * 64 - rem - 1 );
+          const uint64_t bits = total * 8;
+          for( int i = 0; i < 8; ++i )
+             tail[nblocks * 64 - 1 - i] = uint8_t( bits >> (8 * i) );
+          return nblocks;
+       }
+
+       void store_state( const uint32_t state[8], sha256& h ) {
+          uint8_t* out = (uint8_t*)h.data();
+          for( int i = 0; i < 8; ++i ) {
+             out[4*i]   = uint8_t( state[i] >> 24 );
+             out[4*i+1] = uint8_t( state[i] >> 16 );
+             out[4*i+2] = uint8_t( state[i] >> 8 );
+             out[4*i+3] = uint8_t( state[i] );
+          }
+       }
+
+       size_t padded_blocks( uint32_t size ) { return (size_t(size) + 9 + 63) / 64; }
+    }
+
     struct sha256::encoder::impl {
-       SHA256_CTX ctx;
+       uint32_t state[8];
+       uint8_t  buffer[64];
+       uint64_t total;
     };
 
     sha256::encoder::~encoder() {}
@@ -53,16 +84,85 @@ namespace fc {
         return hash( s.data(), sizeof( s._hash ) );
     }
 
+    void sha256::hash_many( const char* const* data, const uint32_t* sizes, sha256* out, size_t n ) {
+      if( !fc::detail::sha256_has_avx2() || fc::detail::sha256_has_shani() ) {
+         // one message at a time is already as fast as it gets with the SHA extensions
+         for( size_t i = 0; i < n; ++i )
+            out[i] = hash( data[i], sizes[i] );
+         return;
+      }
+
+      size_t i = 0;
+      while( i < n ) {
+         // eight lanes can only be hashed together if their padded messages have the same number of blocks
+         const size_t nblocks = padded_blocks( sizes[i] );
+         size_t lanes = 1;
+         while( lanes < 8 && i + lanes < n && padded_blocks( sizes[i + lanes] ) == nblocks )
+            ++lanes;
+         if( lanes < 8 ) {
+            for( size_t j = 0; j < lanes; ++j )
+               out[i + j] = hash( data[i + j], sizes[i + j] );
+            i += lanes;
+            continue;
+         }
+
+         uint8_t  tails[8][128];
+         size_t   full[8];
+         uint32_t state[8][8];
+         for( size_t j = 0; j < 8; ++j ) {
+            const uint8_t* msg = (const uint8_t*)data[i + j];
+            full[j] = sizes[i + j] / 64;
+            pad_tail( tails[j], msg + full[j] * 64, sizes[i + j] % 64, sizes[i + j] );
+            for( int k = 0; k < 8; ++k )
+               state[k][j] = fc::detail::sha256_initial_state[k];
+         }
+         for( size_t b = 0; b < nblocks; ++b ) {
+            const uint8_t* blocks[8];
+            for( size_t j = 0; j < 8; ++j )
+               blocks[j] = b < full[j] ? (const uint8_t*)data[i + j] + b * 64 : tails[j] + (b - full[j]) * 64;
+            fc::detail::sha256_compress8_avx2( state, blocks );
+         }
+         for( size_t j = 0; j < 8; ++j ) {
+            uint32_t lane[8];
+            for( int k = 0; k < 8; ++k )
+               lane[k] = state[k][j];
+            store_state( lane, out[i + j] );
+         }
+         i += 8;
+      }
+    }
+
     void sha256::encoder::write( const char* d, uint32_t dlen ) {
-      SHA256_Update( &my->ctx, d, dlen); 
+      const uint8_t* in = (const uint8_t*)d;
+      size_t buffered = my->total % 64;
+      my->total += dlen;
+      if( buffered ) {
+         size_t n = std::min<size_t>( 64 - buffered, dlen );
+         memcpy( my->buffer + buffered, in, n );
+         in += n;
+         dlen -= n;
+         if( buffered + n < 64 )
+            return;
+         fc::detail::sha256_compress()( my->state, my->buffer, 1 );
+      }
+      if( dlen >= 64 ) {
+         fc::detail::sha256_compress()( my->state, in, dlen / 64 );
+         in += dlen & ~uint32_t(63);
+         dlen %= 64;
+      }
+      memcpy( my->buffer, in, dlen );
     }
     sha256 sha256::encoder::result() {
+      uint8_t tail[128];
+      size_t nblocks = pad_tail( tail, my->buffer, my->total % 64, my->total );
+      fc::detail::sha256_compress()( my->state, tail, nblocks );
       sha256 h;
-      SHA256_Final((uint8_t*)h.data(), &my->ctx );
+      store_state( my->state, h );
       return h;
     }
     void sha256::encoder::reset() {
-      SHA256_Init( &my->ctx);  
+      memcpy( my->state, fc::detail::sha256_initial_state, sizeof(my->state) );
+      my->total = 0;
     }
 
     sha256 operator << ( const sha256& h1, uint32_t i ) {
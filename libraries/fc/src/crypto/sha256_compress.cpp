@@ -0,0 +1,199 @@
+#include "_sha256_compress.hpp"
+
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#include <immintrin.h>
+#define FC_SHA256_X86
+#endif
+
+namespace fc { namespace detail {
+
+    namespace {
+       const uint32_t k[64] = {
+          0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+          0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+          0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+          0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+          0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+          0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+          0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+          0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+       };
+
+       inline uint32_t load_be32( const uint8_t* p ) {
+          return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+       }
+
+       inline uint32_t rotr( uint32_t x, int n ) {
+          return (x >> n) | (x << (32 - n));
+       }
+    }
+
+    const uint32_t sha256_initial_state[8] = {
+       0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    void sha256_compress_scalar( uint32_t state[8], const uint8_t* blocks, size_t nblocks ) {
+       for( ; nblocks > 0; --nblocks, blocks += 64 ) {
+          uint32_t w[64];
+          for( int t = 0; t < 16; ++t )
+             w[t] = load_be32( blocks + 4 * t );
+          for( int t = 16; t < 64; ++t ) {
+             uint32_t s0 = rotr( w[t-15], 7 ) ^ rotr( w[t-15], 18 ) ^ (w[t-15] >> 3);
+             uint32_t s1 = rotr( w[t-2], 17 ) ^ rotr( w[t-2], 19 ) ^ (w[t-2] >> 10);
+             w[t] = w[t-16] + s0 + w[t-7] + s1;
+          }
+
+          uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+          uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+          for( int t = 0; t < 64; ++t ) {
+             uint32_t t1 = h + (rotr( e, 6 ) ^ rotr( e, 11 ) ^ rotr( e, 25 )) + ((e & f) ^ (~e & g)) + k[t] + w[t];
+             uint32_t t2 = (rotr( a, 2 ) ^ rotr( a, 13 ) ^ rotr( a, 22 )) + ((a & (b ^ c)) ^ (b & c));
+             h = g; g = f; f = e;
+             e = d + t1;
+             d = c; c = b; b = a;
+             a = t1 + t2;
+          }
+          state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+          state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+       }
+    }
+
+#ifdef FC_SHA256_X86
+
+    bool sha256_has_shani() {
+       unsigned int eax, ebx, ecx, edx;
+       if( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+          return false;
+       const bool ssse3_sse41 = (ecx & bit_SSSE3) && (ecx & bit_SSE4_1);
+       if( !__get_cpuid_count( 7, 0, &eax, &ebx, &ecx, &edx ) )
+          return false;
+       return ssse3_sse41 && (ebx & (1u << 29)); // SHA extensions
+    }
+
+    bool sha256_has_avx2() {
+       return __builtin_cpu_supports( "avx2" );
+    }
+
+    __attribute__((target("sha,sse4.1,ssse3")))
+    void sha256_compress_shani( uint32_t state[8], const uint8_t* blocks, size_t nblocks ) {
+       const __m128i byte_swap = _mm_set_epi64x( 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL );
+
+       // the sha256rnds2 instruction works on the state arranged as ABEF and CDGH
+       __m128i tmp    = _mm_shuffle_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( &state[0] ) ), 0xB1 ); // CDAB
+       __m128i state1 = _mm_shuffle_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( &state[4] ) ), 0x1B ); // EFGH
+       __m128i state0 = _mm_alignr_epi8( tmp, state1, 8 );    // ABEF
+       state1 = _mm_blend_epi16( state1, tmp, 0xF0 );         // CDGH
+
+       for( ; nblocks > 0; --nblocks, blocks += 64 ) {
+          const __m128i abef = state0;
+          const __m128i cdgh = state1;
+          __m128i msg[4];
+
+          // four rounds at a time; the message schedule is extended four words ahead of the rounds using it
+#pragma GCC unroll 16
+          for( int i = 0; i < 16; ++i ) {
+             if( i < 4 )
+                msg[i] = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( blocks + 16 * i ) ), byte_swap );
+             __m128i m = _mm_add_epi32( msg[i % 4], _mm_loadu_si128( reinterpret_cast<const __m128i*>( &k[4 * i] ) ) );
+             state1 = _mm_sha256rnds2_epu32( state1, state0, m );
+             if( i >= 3 && i < 15 ) {
+                __m128i& next = msg[(i + 1) % 4];
+                next = _mm_add_epi32( next, _mm_alignr_epi8( msg[i % 4], msg[(i + 3) % 4], 4 ) );
+                next = _mm_sha256msg2_epu32( next, msg[i % 4] );
+             }
+             m = _mm_shuffle_epi32( m, 0x0E );
+             state0 = _mm_sha256rnds2_epu32( state0, state1, m );
+             if( i >= 1 && i < 13 )
+                msg[(i + 3) % 4] = _mm_sha256msg1_epu32( msg[(i + 3) % 4], msg[i % 4] );
+          }
+
+          state0 = _mm_add_epi32( state0, abef );
+          state1 = _mm_add_epi32( state1, cdgh );
+       }
+
+       tmp    = _mm_shuffle_epi32( state0, 0x1B );    // FEBA
+       state1 = _mm_shuffle_epi32( state1, 0xB1 );    // DCHG
+       state0 = _mm_blend_epi16( tmp, state1, 0xF0 ); // DCBA
+       state1 = _mm_alignr_epi8( state1, tmp, 8 );    // HGFE
+       _mm_storeu_si128( reinterpret_cast<__m128i*>( &state[0] ), state0 );
+       _mm_storeu_si128( reinterpret_cast<__m128i*>( &state[4] ), state1 );
+    }
+
+    namespace {
+       __attribute__((target("avx2")))
+       inline __m256i rotr8( __m256i x, int n ) {
+          return _mm256_or_si256( _mm256_srli_epi32( x, n ), _mm256_slli_epi32( x, 32 - n ) );
+       }
+    }
+
+    __attribute__((target("avx2")))
+    void sha256_compress8_avx2( uint32_t state[8][8], const uint8_t* const blocks[8] ) {
+       // word t of the block of lane j at words[t][j]
+       alignas(32) uint32_t words[16][8];
+       for( int j = 0; j < 8; ++j )
+          for( int t = 0; t < 16; ++t )
+             words[t][j] = load_be32( blocks[j] + 4 * t );
+
+       __m256i w[64];
+       for( int t = 0; t < 16; ++t )
+          w[t] = _mm256_load_si256( reinterpret_cast<const __m256i*>( words[t] ) );
+       for( int t = 16; t < 64; ++t ) {
+          __m256i s0 = _mm256_xor_si256( _mm256_xor_si256( rotr8( w[t-15], 7 ), rotr8( w[t-15], 18 ) ), _mm256_srli_epi32( w[t-15], 3 ) );
+          __m256i s1 = _mm256_xor_si256( _mm256_xor_si256( rotr8( w[t-2], 17 ), rotr8( w[t-2], 19 ) ), _mm256_srli_epi32( w[t-2], 10 ) );
+          w[t] = _mm256_add_epi32( _mm256_add_epi32( w[t-16], s0 ), _mm256_add_epi32( w[t-7], s1 ) );
+       }
+
+       __m256i s[8];
+       for( int i = 0; i < 8; ++i )
+          s[i] = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( state[i] ) );
+
+       __m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+       for( int t = 0; t < 64; ++t ) {
+          __m256i kw  = _mm256_add_epi32( w[t], _mm256_set1_epi32( k[t] ) );
+          __m256i s1  = _mm256_xor_si256( _mm256_xor_si256( rotr8( e, 6 ), rotr8( e, 11 ) ), rotr8( e, 25 ) );
+          __m256i ch  = _mm256_xor_si256( _mm256_and_si256( e, f ), _mm256_andnot_si256( e, g ) );
+          __m256i t1  = _mm256_add_epi32( _mm256_add_epi32( h, s1 ), _mm256_add_epi32( ch, kw ) );
+          __m256i s0  = _mm256_xor_si256( _mm256_xor_si256( rotr8( a, 2 ), rotr8( a, 13 ) ), rotr8( a, 22 ) );
+          __m256i maj = _mm256_xor_si256( _mm256_and_si256( a, _mm256_xor_si256( b, c ) ), _mm256_and_si256( b, c ) );
+          h = g; g = f; f = e;
+          e = _mm256_add_epi32( d, t1 );
+          d = c; c = b; b = a;
+          a = _mm256_add_epi32( t1, _mm256_add_epi32( s0, maj ) );
+       }
+       s[0] = _mm256_add_epi32( s[0], a ); s[1] = _mm256_add_epi32( s[1], b );
+       s[2] = _mm256_add_epi32( s[2], c ); s[3] = _mm256_add_epi32( s[3], d );
+       s[4] = _mm256_add_epi32( s[4], e ); s[5] = _mm256_add_epi32( s[5], f );
+       s[6] = _mm256_add_epi32( s[6], g ); s[7] = _mm256_add_epi32( s[7], h );
+
+       for( int i = 0; i < 8; ++i )
+          _mm256_storeu_si256( reinterpret_cast<__m256i*>( state[i] ), s[i] );
+    }
+
+#else
+
+    bool sha256_has_shani() { return false; }
+    bool sha256_has_avx2() { return false; }
+
+    void sha256_compress_shani( uint32_t state[8], const uint8_t* blocks, size_t nblocks ) {
+       sha256_compress_scalar( state, blocks, nblocks );
+    }
+
+    void sha256_compress8_avx2( uint32_t state[8][8], const uint8_t* const blocks[8] ) {
+       for( int j = 0; j < 8; ++j ) {
+          uint32_t lane[8];
+          for( int i = 0; i < 8; ++i ) lane[i] = state[i][j];
+          sha256_compress_scalar( lane, blocks[j], 1 );
+          for( int i = 0; i < 8; ++i ) state[i][j] = lane[i];
+       }
+    }
+
+#endif
+
+    sha256_compress_func sha256_compress() {
+       static const sha256_compress_func compress = sha256_has_shani() ? &sha256_compress_shani : &sha256_compress_scalar;
+       return compress;
+    }
+
+}}
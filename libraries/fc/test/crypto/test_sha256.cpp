@@ -0,0 +1,176 @@
+#define BOOST_TEST_MODULE sha256
+#include <boost/test/unit_test.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/exception/exception.hpp>
+#include <fc/time.hpp>
+
+#include <openssl/sha.h>
+
+#include "_sha256_compress.hpp"
+
+#include <string.h>
+#include <vector>
+
+using namespace fc;
+
+namespace {
+
+   /// deterministic message bytes, so failures reproduce
+   std::vector<char> make_message( size_t size, uint32_t seed ) {
+      std::vector<char> msg( size );
+      uint32_t x = seed * 2654435761u + 1;
+      for( auto& c : msg ) {
+         x = x * 1103515245u + 12345u;
+         c = char( x >> 24 );
+      }
+      return msg;
+   }
+
+   sha256 openssl_sha256( const char* d, size_t size ) {
+      sha256 h;
+      SHA256( (const unsigned char*)d, size, (unsigned char*)h.data() );
+      return h;
+   }
+
+   sha256 hash_with( fc::detail::sha256_compress_func compress, const std::vector<char>& msg ) {
+      // the padding is written out here so the compression functions are checked apart from the encoder
+      std::vector<uint8_t> padded( msg.begin(), msg.end() );
+      padded.push_back( 0x80 );
+      while( padded.size() % 64 != 56 )
+         padded.push_back( 0 );
+      const uint64_t bits = uint64_t( msg.size() ) * 8;
+      for( int i = 7; i >= 0; --i )
+         padded.push_back( uint8_t( bits >> (8 * i) ) );
+
+      uint32_t state[8];
+      memcpy( state, fc::detail::sha256_initial_state, sizeof(state) );
+      compress( state, padded.data(), padded.size() / 64 );
+
+      sha256 h;
+      uint8_t* out = (uint8_t*)h.data();
+      for( int i = 0; i < 8; ++i )
+         for( int b = 0; b < 4; ++b )
+            out[4 * i + b] = uint8_t( state[i] >> (24 - 8 * b) );
+      return h;
+   }
+
+}
+
+BOOST_AUTO_TEST_SUITE(sha256_tests)
+
+BOOST_AUTO_TEST_CASE(known_answers) try {
+   BOOST_CHECK_EQUAL( sha256::hash( "", 0 ).str(), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" );
+   BOOST_CHECK_EQUAL( sha256::hash( "abc", 3 ).str(), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" );
+   BOOST_CHECK_EQUAL( sha256::hash( std::string( "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq" ) ).str(),
+                      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" );
+} FC_LOG_AND_RETHROW();
+
+BOOST_AUTO_TEST_CASE(matches_openssl) try {
+   for( size_t size = 0; size <= 300; ++size ) {
+      auto msg = make_message( size, size );
+      auto expected = openssl_sha256( msg.data(), msg.size() );
+      BOOST_REQUIRE_EQUAL( sha256::hash( msg.data(), msg.size() ), expected );
+
+      // written in pieces, so the buffering of partial blocks is exercised
+      for( size_t piece : {1, 7, 63, 64, 65} ) {
+         sha256::encoder e;
+         for( size_t pos = 0; pos < size; pos += piece )
+            e.write( msg.data() + pos, std::min( piece, size - pos ) );
+         BOOST_REQUIRE_EQUAL( e.result(), expected );
+      }
+
+      BOOST_REQUIRE_EQUAL( hash_with( &fc::detail::sha256_compress_scalar, msg ), expected );
+      if( fc::detail::sha256_has_shani() )
+         BOOST_REQUIRE_EQUAL( hash_with( &fc::detail::sha256_compress_shani, msg ), expected );
+   }
+} FC_LOG_AND_RETHROW();
+
+BOOST_AUTO_TEST_CASE(hash_many) try {
+   // runs of equal sizes hash in lanes of eight, the odd sizes in between do not
+   std::vector<size_t> sizes;
+   for( size_t size : {0, 1, 55, 56, 64, 119, 120, 200} )
+      sizes.insert( sizes.end(), 9, size );
+   for( size_t size = 0; size < 150; size += 13 )
+      sizes.push_back( size );
+   sizes.insert( sizes.end(), 17, 64 );
+
+   std::vector<std::vector<char>> msgs;
+   std::vector<const char*> data;
+   std::vector<uint32_t> lengths;
+   for( size_t i = 0; i < sizes.size(); ++i )
+      msgs.emplace_back( make_message( sizes[i], i ) );
+   for( const auto& msg : msgs ) {
+      data.push_back( msg.data() );
+      lengths.push_back( msg.size() );
+   }
+
+   std::vector<sha256> out( msgs.size() );
+   sha256::hash_many( data.data(), lengths.data(), out.data(), out.size() );
+   for( size_t i = 0; i < msgs.size(); ++i )
+      BOOST_REQUIRE_EQUAL( out[i], openssl_sha256( msgs[i].data(), msgs[i].size() ) );
+
+   if( fc::detail::sha256_has_avx2() ) {
+      uint32_t state[8][8];
+      const uint8_t* blocks[8];
+      uint8_t block[8][64];
+      for( int j = 0; j < 8; ++j ) {
+         auto msg = make_message( 64, j );
+         memcpy( block[j], msg.data(), 64 );
+         blocks[j] = block[j];
+         for( int k = 0; k < 8; ++k )
+            state[k][j] = fc::detail::sha256_initial_state[k];
+      }
+      fc::detail::sha256_compress8_avx2( state, blocks );
+      for( int j = 0; j < 8; ++j ) {
+         uint32_t lane[8];
+         memcpy( lane, fc::detail::sha256_initial_state, sizeof(lane) );
+         fc::detail::sha256_compress_scalar( lane, block[j], 1 );
+         for( int k = 0; k < 8; ++k )
+            BOOST_REQUIRE_EQUAL( state[k][j], lane[k] );
+      }
+   }
+} FC_LOG_AND_RETHROW();
+
+/**
+ *  Throughput of OpenSSL against fc::sha256 for the message sizes the chain hashes most: 64 byte merkle pairs,
+ *  transactions of a few hundred bytes and larger action data.
+ */
+BOOST_AUTO_TEST_CASE(benchmark) try {
+   BOOST_TEST_MESSAGE( "sha256 with the SHA extensions: " << fc::detail::sha256_has_shani()
+                       << ", with AVX2: " << fc::detail::sha256_has_avx2() );
+
+   for( size_t size : {64, 256, 4096} ) {
+      const size_t count = (64 << 20) / size / 4;
+      std::vector<std::vector<char>> msgs;
+      std::vector<const char*> data;
+      std::vector<uint32_t> lengths( count, size );
+      for( size_t i = 0; i < count; ++i )
+         msgs.emplace_back( make_message( size, i ) );
+      for( const auto& msg : msgs )
+         data.push_back( msg.data() );
+      std::vector<sha256> expected( count ), out( count );
+
+      auto start = fc::time_point::now();
+      for( size_t i = 0; i < count; ++i )
+         expected[i] = openssl_sha256( data[i], size );
+      auto openssl_time = fc::time_point::now() - start;
+
+      start = fc::time_point::now();
+      for( size_t i = 0; i < count; ++i )
+         out[i] = sha256::hash( data[i], size );
+      auto hash_time = fc::time_point::now() - start;
+      BOOST_REQUIRE( out == expected );
+
+      start = fc::time_point::now();
+      sha256::hash_many( data.data(), lengths.data(), out.data(), count );
+      auto hash_many_time = fc::time_point::now() - start;
+      BOOST_REQUIRE( out == expected );
+
+      auto mb_per_s = [&]( const fc::microseconds& t ) { return double( count * size ) / std::max<int64_t>( t.count(), 1 ); };
+      BOOST_TEST_MESSAGE( size << " byte messages, MB/s: openssl " << mb_per_s( openssl_time )
+                          << ", sha256::hash " << mb_per_s( hash_time ) << ", sha256::hash_many " << mb_per_s( hash_many_time ) );
+   }
+} FC_LOG_AND_RETHROW();
+
+BOOST_AUTO_TEST_SUITE_END()
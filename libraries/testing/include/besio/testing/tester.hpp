@@ -85,8 +85,9 @@ namespace besio { namespace testing {
          void              init(controller::config config);
 
          void              close();
-         void              open();
+         void              open( const std::shared_ptr<snapshot_reader>& snapshot = nullptr );
          bool              is_same_chain( base_tester& other );
+         const controller::config& get_config()const { return cfg; }
 
          virtual signed_block_ptr produce_block( fc::microseconds skip_time = fc::milliseconds(config::block_interval_ms), uint32_t skip_flag = 0/*skip_missed_block_penalty*/ ) = 0;
          virtual signed_block_ptr produce_empty_block( fc::microseconds skip_time = fc::milliseconds(config::block_interval_ms), uint32_t skip_flag = 0/*skip_missed_block_penalty*/ ) = 0;
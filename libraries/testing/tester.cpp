@@ -123,9 +123,9 @@ namespace besio { namespace testing {
    }
 
 
-   void base_tester::open() {
+   void base_tester::open( const std::shared_ptr<snapshot_reader>& snapshot ) {
       control.reset( new controller(cfg) );
-      control->startup();
+      control->startup( snapshot );
       chain_transactions.clear();
       control->accepted_block.connect([this]( const block_state_ptr& block_state ){
         FC_ASSERT( block_state->block );
@@ -124,6 +124,10 @@ namespace Runtime
 	// Throws a Runtime::Exception if a trap occurs.
 	RUNTIME_API Result invokeFunction(FunctionInstance* function,const std::vector<Value>& parameters);
 
+	// Creates the thunk invokeFunction calls functions of the given type through, so that invoking them later
+	// does not have to compile it.
+	RUNTIME_API void prepareInvokeThunk(const IR::FunctionType* functionType);
+
 	// Returns the type of a FunctionInstance.
 	RUNTIME_API const IR::FunctionType* getFunctionType(FunctionInstance* function);
 
@@ -1,6 +1,7 @@
 #include "Types.h"
 
 #include <map>
+#include <mutex>
 
 namespace IR
 {
@@ -22,9 +23,13 @@ namespace IR
 		}
 	};
 
+	// Modules may be decoded on a background compile thread while the main thread decodes others.
+	static std::mutex typeMapMutex;
+
 	template<typename Key,typename Value,typename CreateValueThunk>
 	Value findExistingOrCreateNew(std::map<Key,Value>& map,Key&& key,CreateValueThunk createValueThunk)
 	{
+		std::lock_guard<std::mutex> mapLock(typeMapMutex);
 		auto mapIt = map.find(key);
 		if(mapIt != map.end()) { return mapIt->second; }
 		else
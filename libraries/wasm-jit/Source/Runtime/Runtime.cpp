@@ -83,6 +83,11 @@ namespace Runtime
 	}
 
 
+	void prepareInvokeThunk(const FunctionType* functionType)
+	{
+		LLVMJIT::getInvokeThunk(functionType);
+	}
+
 	Result invokeFunction(FunctionInstance* function,const std::vector<Value>& parameters)
 	{
 		const FunctionType* functionType = function->type;
@@ -14,6 +14,7 @@
 #include <besio/chain/reversible_block_object.hpp>
 #include <besio/chain/controller.hpp>
 #include <besio/chain/generated_transaction_object.hpp>
+#include <besio/chain/snapshot.hpp>
 
 #include <besio/chain/besio_contract.hpp>
 
@@ -27,6 +28,7 @@
 
 #include <fc/io/json.hpp>
 #include <fc/variant.hpp>
+#include <fstream>
 #include <signal.h>
 
 namespace besio {
@@ -157,6 +159,7 @@ public:
    bfs::path                        blocks_dir;
    bool                             readonly = false;
    flat_map<uint32_t,block_id_type> loaded_checkpoints;
+   fc::optional<bfs::path>          snapshot_path;
 
    fc::optional<fork_database>      fork_db;
    fc::optional<block_log>          block_logger;
@@ -166,6 +169,7 @@ public:
    //txn_msg_rate_limits              rate_limits;
    fc::optional<vm_type>            wasm_runtime;
    fc::microseconds                 abi_serializer_max_time_ms;
+   uint32_t                         table_rows_max_bytes = chain_apis::read_only::default_table_rows_max_bytes;
 
 
    // retained references to channels for easy publication
@@ -213,12 +217,45 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "the location of the blocks directory (absolute path or relative to application data dir)")
          ("checkpoint", bpo::value<vector<string>>()->composing(), "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
          ("wasm-runtime", bpo::value<besio::chain::wasm_interface::vm_type>()->value_name("wavm/binaryen"), "Override default WASM runtime")
+         ("wasm-cache-size", bpo::value<uint32_t>()->default_value(config::default_wasm_cache_size),
+          "Maximum number of instantiated contracts kept in memory; least recently used contracts are evicted beyond this")
+         ("wasm-tiered-compile", bpo::bool_switch()->default_value(false),
+          "With the wavm runtime, run contracts in speculative and produced blocks on the binaryen interpreter while they are compiled on a background thread; received blocks always run compiled code")
          ("abi-serializer-max-time-ms", bpo::value<uint32_t>()->default_value(config::default_abi_serializer_max_time_ms),
           "Override default maximum ABI serialization time allowed in ms")
+         ("abi-cache-size", bpo::value<uint32_t>()->default_value(config::default_abi_cache_size),
+          "Maximum number of contract ABI serializers shared by the API and history plugins; least recently used ABIs are evicted beyond this, 0 disables caching")
+         ("get-table-rows-max-bytes", bpo::value<uint32_t>()->default_value(chain_apis::read_only::default_table_rows_max_bytes),
+          "Maximum number of bytes of table rows returned by a single get_table_rows call; the rest is available through its continuation")
          ("chain-state-db-size-mb", bpo::value<uint64_t>()->default_value(config::default_state_size / (1024  * 1024)), "Maximum size (in MiB) of the chain state database")
+         ("chain-state-db-hugepage-path", bpo::value<bfs::path>(),
+          "hugetlbfs mount (2MB or 1GB pages) to hold the chain state database in while the node runs; it is loaded from and written back to the state directory at startup and shutdown")
+         ("chain-state-db-numa-node", bpo::value<int32_t>()->default_value(-1),
+          "NUMA node to bind the memory of the chain state database to (-1 for no binding)")
          ("chain-state-db-guard-size-mb", bpo::value<uint64_t>()->default_value(config::default_state_guard_size / (1024  * 1024)), "Safely shut down node when free space remaining in the chain state database drops below this size (in MiB).")
          ("reversible-blocks-db-size-mb", bpo::value<uint64_t>()->default_value(config::default_reversible_cache_size / (1024  * 1024)), "Maximum size (in MiB) of the reversible blocks database")
          ("reversible-blocks-db-guard-size-mb", bpo::value<uint64_t>()->default_value(config::default_reversible_guard_size / (1024  * 1024)), "Safely shut down node when free space remaining in the reverseible blocks database drops below this size (in MiB).")
+         ("block-log-chunk-blocks", bpo::value<uint32_t>()->default_value(0),
+          "Number of blocks compressed together in each chunk of a newly created block log (0 for the uncompressed format); an existing block log keeps its format")
+         ("block-log-prune-blocks", bpo::value<uint32_t>()->default_value(0),
+          "In a chunked block log, drop the transactions of blocks this many blocks behind the head and keep only their headers (0 to keep every block)")
+         ("block-log-segment-blocks", bpo::value<uint32_t>()->default_value(0),
+          "Seal the block log into a numbered segment file every this many blocks and start a new one (0 to keep a single block log)")
+         ("block-log-archive-dir", bpo::value<bfs::path>(),
+          "Directory sealed block log segments are moved to in the background (absolute or relative to the blocks dir); they stay readable from there")
+         ("fork-db-memory-budget-mb", bpo::value<uint64_t>()->default_value(config::default_fork_db_memory_budget / (1024  * 1024)),
+          "Maximum size (in MiB) of the reversible blocks the fork database keeps in memory; older validated blocks are spilled to disk beyond this (0 for no limit)")
+         ("chain-threads", bpo::value<uint16_t>()->default_value(config::default_controller_thread_pool_size),
+          "Number of worker threads in controller thread pool")
+         ("replay-read-ahead", bpo::value<uint32_t>()->default_value(config::default_replay_read_ahead),
+          "Number of blocks unpacked and prepared on the controller thread pool ahead of the block being applied during a replay")
+         ("trusted-replay-until-block", bpo::value<uint32_t>()->default_value(0),
+          "Replay blocks of the block log up to this number without signature, authorization or merkle checks; block ids are "
+          "still verified. Only use with a block log this node produced or otherwise trusts")
+         ("replay-checkpoint-interval", bpo::value<uint32_t>()->default_value(config::default_replay_checkpoint_interval),
+          "Number of blocks between checkpoints of the chain state written while replaying (0 to disable). If a replay is "
+          "interrupted, restarting with --replay-blockchain and a non zero interval resumes from the latest checkpoint; "
+          "with an interval of 0 a checkpoint left behind is ignored")
          ("contracts-console", bpo::bool_switch()->default_value(false),
           "print contract's output to console")
          ("actor-whitelist", boost::program_options::value<vector<string>>()->composing()->multitoken(),
@@ -283,6 +320,9 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "replace reversible block database with blocks imported from specified file and then exit")
          ("export-reversible-blocks", bpo::value<bfs::path>(),
            "export reversible block database in portable format into specified file and then exit")
+         ("snapshot", bpo::value<bfs::path>(),
+          "load chain state from the specified snapshot file instead of replaying the block log; requires an empty state "
+          "database and a block log that contains the snapshot block")
          ;
 
 }
@@ -383,6 +423,9 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
 
       if(options.count("abi-serializer-max-time-ms"))
          my->abi_serializer_max_time_ms = fc::microseconds(options.at("abi-serializer-max-time-ms").as<uint32_t>() * 1000);
+      my->table_rows_max_bytes = options.at("get-table-rows-max-bytes").as<uint32_t>();
+      BES_ASSERT( my->table_rows_max_bytes > 0, plugin_config_exception,
+                  "get-table-rows-max-bytes ${num} must be greater than 0", ("num", my->table_rows_max_bytes) );
 
       my->chain_config->blocks_dir = my->blocks_dir;
       my->chain_config->state_dir = app().data_dir() / config::default_state_dir_name;
@@ -394,6 +437,12 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
       if( options.count( "chain-state-db-guard-size-mb" ))
          my->chain_config->state_guard_size = options.at( "chain-state-db-guard-size-mb" ).as<uint64_t>() * 1024 * 1024;
 
+      if( options.count( "chain-state-db-hugepage-path" )) {
+         BES_ASSERT( !my->readonly, plugin_config_exception, "chain-state-db-hugepage-path cannot be used in read-only mode" );
+         my->chain_config->state_hugepage_dir = options.at( "chain-state-db-hugepage-path" ).as<bfs::path>();
+      }
+      my->chain_config->state_numa_node = options.at( "chain-state-db-numa-node" ).as<int32_t>();
+
       if( options.count( "reversible-blocks-db-size-mb" ))
          my->chain_config->reversible_cache_size =
                options.at( "reversible-blocks-db-size-mb" ).as<uint64_t>() * 1024 * 1024;
@@ -401,9 +450,43 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
       if( options.count( "reversible-blocks-db-guard-size-mb" ))
          my->chain_config->reversible_guard_size = options.at( "reversible-blocks-db-guard-size-mb" ).as<uint64_t>() * 1024 * 1024;
 
+      if( options.count( "block-log-chunk-blocks" ))
+         my->chain_config->block_log_chunk_blocks = options.at( "block-log-chunk-blocks" ).as<uint32_t>();
+
+      if( options.count( "block-log-prune-blocks" ))
+         my->chain_config->block_log_prune_blocks = options.at( "block-log-prune-blocks" ).as<uint32_t>();
+
+      if( options.count( "block-log-segment-blocks" ))
+         my->chain_config->block_log_segment_blocks = options.at( "block-log-segment-blocks" ).as<uint32_t>();
+
+      if( options.count( "block-log-archive-dir" ))
+         my->chain_config->block_log_archive_dir = options.at( "block-log-archive-dir" ).as<bfs::path>();
+
+      if( options.count( "fork-db-memory-budget-mb" ))
+         my->chain_config->fork_db_memory_budget = options.at( "fork-db-memory-budget-mb" ).as<uint64_t>() * 1024 * 1024;
+
       if( my->wasm_runtime )
          my->chain_config->wasm_runtime = *my->wasm_runtime;
 
+      my->chain_config->wasm_tiered_compile = options.at( "wasm-tiered-compile" ).as<bool>();
+      my->chain_config->wasm_cache_size = options.at( "wasm-cache-size" ).as<uint32_t>();
+      BES_ASSERT( my->chain_config->wasm_cache_size > 0, plugin_config_exception,
+                  "wasm-cache-size ${num} must be greater than 0", ("num", my->chain_config->wasm_cache_size) );
+
+      my->chain_config->abi_cache_size = options.at( "abi-cache-size" ).as<uint32_t>();
+
+      my->chain_config->thread_pool_size = options.at( "chain-threads" ).as<uint16_t>();
+      BES_ASSERT( my->chain_config->thread_pool_size > 0, plugin_config_exception,
+                  "chain-threads ${num} must be greater than 0", ("num", my->chain_config->thread_pool_size) );
+
+      my->chain_config->trusted_replay_block_num = options.at( "trusted-replay-until-block" ).as<uint32_t>();
+      my->chain_config->replay_checkpoint_interval = options.at( "replay-checkpoint-interval" ).as<uint32_t>();
+      my->chain_config->replay_checkpoint_file = app().data_dir() / config::replay_checkpoint_filename;
+
+      my->chain_config->replay_read_ahead = options.at( "replay-read-ahead" ).as<uint32_t>();
+      BES_ASSERT( my->chain_config->replay_read_ahead > 0, plugin_config_exception,
+                  "replay-read-ahead ${num} must be greater than 0", ("num", my->chain_config->replay_read_ahead) );
+
       my->chain_config->force_all_checks = options.at( "force-all-checks" ).as<bool>();
       my->chain_config->disable_replay_opts = options.at( "disable-replay-opts" ).as<bool>();
       my->chain_config->contracts_console = options.at( "contracts-console" ).as<bool>();
@@ -452,6 +535,12 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
          BES_THROW( node_management_success, "exported reversible blocks" );
       }
 
+      if( options.at( "delete-all-blocks" ).as<bool>() || options.at( "hard-replay-blockchain" ).as<bool>()) {
+         // the block log is about to change, so a checkpoint of an earlier replay may no longer match it
+         if( fc::exists( my->chain_config->replay_checkpoint_file ))
+            fc::remove( my->chain_config->replay_checkpoint_file );
+      }
+
       if( options.at( "delete-all-blocks" ).as<bool>()) {
          ilog( "Deleting state database and blocks" );
          if( options.at( "truncate-at-block" ).as<uint32_t>() > 0 )
@@ -516,6 +605,32 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
          wlog("The --import-reversible-blocks option should be used by itself.");
       }
 
+      if( options.count( "snapshot" )) {
+         auto snapshot_file = options.at( "snapshot" ).as<bfs::path>();
+         if( snapshot_file.is_relative()) {
+            snapshot_file = bfs::current_path() / snapshot_file;
+         }
+
+         BES_ASSERT( fc::is_regular_file( snapshot_file ), plugin_config_exception,
+                     "Specified snapshot file '${snapshot}' does not exist.", ("snapshot", snapshot_file.generic_string()));
+         BES_ASSERT( !fc::exists( my->chain_config->state_dir / "shared_memory.bin" ), plugin_config_exception,
+                     "A snapshot can only be loaded into an empty state database; remove '${state}' or use --replay-blockchain.",
+                     ("state", my->chain_config->state_dir.generic_string()));
+
+         my->snapshot_path = snapshot_file;
+      } else if( fc::is_regular_file( my->chain_config->replay_checkpoint_file ) &&
+                 !fc::exists( my->chain_config->state_dir / "shared_memory.bin" )) {
+         // resuming is part of opting in to checkpoints, a replay asked for without them starts from genesis
+         if( my->chain_config->replay_checkpoint_interval > 0 ) {
+            ilog( "Resuming an interrupted replay from checkpoint '${checkpoint}'",
+                  ("checkpoint", my->chain_config->replay_checkpoint_file.generic_string()) );
+            my->snapshot_path = my->chain_config->replay_checkpoint_file;
+         } else {
+            ilog( "Ignoring replay checkpoint '${checkpoint}' because replay-checkpoint-interval is 0",
+                  ("checkpoint", my->chain_config->replay_checkpoint_file.generic_string()) );
+         }
+      }
+
       if( options.count( "genesis-json" )) {
          BES_ASSERT( !fc::exists( my->blocks_dir / "blocks.log" ),
                      plugin_config_exception,
@@ -636,7 +751,15 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
 void chain_plugin::plugin_startup()
 { try {
    try {
-      my->chain->startup();
+      if( my->snapshot_path ) {
+         ilog( "Loading chain state from snapshot '${snapshot}'", ("snapshot", my->snapshot_path->generic_string()) );
+         std::ifstream snapshot_file( my->snapshot_path->generic_string(), std::ios::in | std::ios::binary );
+         BES_ASSERT( snapshot_file.good(), plugin_config_exception, "Unable to open snapshot file '${snapshot}'",
+                     ("snapshot", my->snapshot_path->generic_string()) );
+         my->chain->startup( std::make_shared<snapshot_reader>( snapshot_file ) );
+      } else {
+         my->chain->startup();
+      }
    } catch (const database_guard_exception& e) {
       log_guard_exception(e);
       // make sure to properly close the db
@@ -909,6 +1032,10 @@ fc::microseconds chain_plugin::get_abi_serializer_max_time() const {
    return my->abi_serializer_max_time_ms;
 }
 
+uint32_t chain_plugin::get_table_rows_max_bytes() const {
+   return my->table_rows_max_bytes;
+}
+
 void chain_plugin::log_guard_exception(const chain::guard_exception&e ) const {
    if (e.code() == chain::database_guard_exception::code_value) {
       elog("Database has reached an unsafe level of usage, shutting down to avoid corrupting the database.  "
@@ -931,6 +1058,7 @@ void chain_plugin::handle_guard_exception(const chain::guard_exception& e) const
 namespace chain_apis {
 
 const string read_only::KEYi64 = "i64";
+const uint32_t read_only::default_table_rows_max_bytes;
 
 read_only::get_info_results read_only::get_info(const read_only::get_info_params&) const {
    const auto& rm = db.get_resource_limits_manager();
@@ -1027,65 +1155,62 @@ uint64_t convert_to_type(const string& str, const string& desc) {
    return value;
 }
 
-abi_def get_abi( const controller& db, const name& account ) {
-   const auto &d = db.db();
-   const account_object *code_accnt = d.find<account_object, by_name>(account);
+/// the shared serializer of account, an account without an ABI yields a serializer that knows no tables
+abi_serializer_ptr get_abi_serializer( const controller& db, const name& account, const fc::microseconds& abi_serializer_max_time ) {
+   const account_object *code_accnt = db.db().find<account_object, by_name>(account);
    BES_ASSERT(code_accnt != nullptr, chain::account_query_exception, "Fail to retrieve account for ${account}", ("account", account) );
-   abi_def abi;
-   abi_serializer::to_abi(code_accnt->abi, abi);
-   return abi;
+   if( auto abis = db.get_abi_serializer( account, abi_serializer_max_time ) )
+      return abis;
+   return std::make_shared<const abi_serializer>();
 }
 
-string get_table_type( const abi_def& abi, const name& table_name ) {
-   for( const auto& t : abi.tables ) {
-      if( t.name == table_name ){
-         return t.index_type;
-      }
-   }
-   BES_ASSERT( false, chain::contract_table_query_exception, "Table ${table} is not specified in the ABI", ("table",table_name) );
+string get_table_type( const abi_serializer& abis, const name& table_name ) {
+   BES_ASSERT( !abis.get_table_type( table_name ).empty(), chain::contract_table_query_exception, "Table ${table} is not specified in the ABI", ("table",table_name) );
+   return abis.get_table_index_type( table_name );
 }
 
 read_only::get_table_rows_result read_only::get_table_rows( const read_only::get_table_rows_params& p )const {
-   const abi_def abi = besio::chain_apis::get_abi( db, p.code );
+   const auto abis_ptr = besio::chain_apis::get_abi_serializer( db, p.code, abi_serializer_max_time );
+   const abi_serializer& abis = *abis_ptr;
 
    bool primary = false;
    auto table_with_index = get_table_index_name( p, primary );
    if( primary ) {
       BES_ASSERT( p.table == table_with_index, chain::contract_table_query_exception, "Invalid table name ${t}", ( "t", p.table ));
-      auto table_type = get_table_type( abi, p.table );
+      auto table_type = get_table_type( abis, p.table );
       if( table_type == KEYi64 || p.key_type == "i64" || p.key_type == "name" ) {
-         return get_table_rows_ex<key_value_index>(p,abi);
+         return get_table_rows_ex<key_value_index>(p,abis);
       }
-      BES_ASSERT( false, chain::contract_table_query_exception,  "Invalid table type ${type}", ("type",table_type)("abi",abi));
+      BES_ASSERT( false, chain::contract_table_query_exception,  "Invalid table type ${type}", ("type",table_type));
    } else {
       BES_ASSERT( !p.key_type.empty(), chain::contract_table_query_exception, "key type required for non-primary index" );
 
       if (p.key_type == chain_apis::i64 || p.key_type == "name") {
-         return get_table_rows_by_seckey<index64_index, uint64_t>(p, abi, [](uint64_t v)->uint64_t {
+         return get_table_rows_by_seckey<index64_index, uint64_t>(p, abis, [](uint64_t v)->uint64_t {
             return v;
          });
       }
       else if (p.key_type == chain_apis::i128) {
-         return get_table_rows_by_seckey<index128_index, uint128_t>(p, abi, [](uint128_t v)->uint128_t {
+         return get_table_rows_by_seckey<index128_index, uint128_t>(p, abis, [](uint128_t v)->uint128_t {
             return v;
          });
       }
       else if (p.key_type == chain_apis::i256) {
          if ( p.encode_type == chain_apis::hex) {
             using  conv = keytype_converter<chain_apis::sha256,chain_apis::hex>;
-            return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+            return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abis, conv::function());
          }
          using  conv = keytype_converter<chain_apis::i256>;
-         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abis, conv::function());
       }
       else if (p.key_type == chain_apis::float64) {
-         return get_table_rows_by_seckey<index_double_index, double>(p, abi, [](double v)->float64_t {
+         return get_table_rows_by_seckey<index_double_index, double>(p, abis, [](double v)->float64_t {
             float64_t f = *(float64_t *)&v;
             return f;
          });
       }
       else if (p.key_type == chain_apis::float128) {
-         return get_table_rows_by_seckey<index_long_double_index, double>(p, abi, [](double v)->float128_t{
+         return get_table_rows_by_seckey<index_long_double_index, double>(p, abis, [](double v)->float128_t{
             float64_t f = *(float64_t *)&v;
             float128_t f128;
             f64_to_f128M(f, &f128);
@@ -1094,11 +1219,11 @@ read_only::get_table_rows_result read_only::get_table_rows( const read_only::get
       }
       else if (p.key_type == chain_apis::sha256) {
          using  conv = keytype_converter<chain_apis::sha256,chain_apis::hex>;
-         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abis, conv::function());
       }
       else if(p.key_type == chain_apis::ripemd160) {
          using  conv = keytype_converter<chain_apis::ripemd160,chain_apis::hex>;
-         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abis, conv::function());
       }
       BES_ASSERT(false, chain::contract_table_query_exception,  "Unsupported secondary index type: ${t}", ("t", p.key_type));
    }
@@ -1106,8 +1231,8 @@ read_only::get_table_rows_result read_only::get_table_rows( const read_only::get
 
 vector<asset> read_only::get_currency_balance( const read_only::get_currency_balance_params& p )const {
 
-   const abi_def abi = besio::chain_apis::get_abi( db, p.code );
-   auto table_type = get_table_type( abi, "accounts" );
+   const auto abis = besio::chain_apis::get_abi_serializer( db, p.code, abi_serializer_max_time );
+   auto table_type = get_table_type( *abis, "accounts" );
 
    vector<asset> results;
    walk_key_value_table(p.code, p.account, N(accounts), [&](const key_value_object& obj){
@@ -1133,8 +1258,8 @@ vector<asset> read_only::get_currency_balance( const read_only::get_currency_bal
 fc::variant read_only::get_currency_stats( const read_only::get_currency_stats_params& p )const {
    fc::mutable_variant_object results;
 
-   const abi_def abi = besio::chain_apis::get_abi( db, p.code );
-   auto table_type = get_table_type( abi, "stat" );
+   const auto abis = besio::chain_apis::get_abi_serializer( db, p.code, abi_serializer_max_time );
+   auto table_type = get_table_type( *abis, "stat" );
 
    uint64_t scope = ( besio::chain::string_to_symbol( 0, boost::algorithm::to_upper_copy(p.symbol).c_str() ) >> 8 );
 
@@ -1161,8 +1286,8 @@ static float64_t to_softfloat64( double d ) {
    return *reinterpret_cast<float64_t*>(&d);
 }
 
-static fc::variant get_global_row( const database& db, const abi_def& abi, const abi_serializer& abis, const fc::microseconds& abi_serializer_max_time_ms ) {
-   const auto table_type = get_table_type(abi, N(global));
+static fc::variant get_global_row( const database& db, const abi_serializer& abis, const fc::microseconds& abi_serializer_max_time_ms ) {
+   const auto table_type = get_table_type(abis, N(global));
    BES_ASSERT(table_type == read_only::KEYi64, chain::contract_table_query_exception, "Invalid table type ${type} for table global", ("type",table_type));
 
    const auto* const table_id = db.find<chain::table_id_object, chain::by_code_scope_table>(boost::make_tuple(config::system_account_name, config::system_account_name, N(global)));
@@ -1178,9 +1303,9 @@ static fc::variant get_global_row( const database& db, const abi_def& abi, const
 }
 
 read_only::get_producers_result read_only::get_producers( const read_only::get_producers_params& p ) const {
-   const abi_def abi = besio::chain_apis::get_abi(db, config::system_account_name);
-   const auto table_type = get_table_type(abi, N(producers));
-   const abi_serializer abis{ abi, abi_serializer_max_time };
+   const auto abis_ptr = besio::chain_apis::get_abi_serializer(db, config::system_account_name, abi_serializer_max_time);
+   const abi_serializer& abis = *abis_ptr;
+   const auto table_type = get_table_type(abis, N(producers));
    BES_ASSERT(table_type == KEYi64, chain::contract_table_query_exception, "Invalid table type ${type} for table producers", ("type",table_type));
 
    const auto& d = db.db();
@@ -1224,7 +1349,7 @@ read_only::get_producers_result read_only::get_producers( const read_only::get_p
          result.rows.emplace_back(fc::variant(data));
    }
 
-   result.total_activated_votes = get_global_row(d, abi, abis, abi_serializer_max_time)["total_activated_votes"].as_int64();
+   result.total_activated_votes = get_global_row(d, abis, abi_serializer_max_time)["total_activated_votes"].as_int64();
    return result;
 }
 
@@ -1242,16 +1367,13 @@ read_only::get_producer_schedule_result read_only::get_producer_schedule( const
 template<typename Api>
 struct resolver_factory {
    static auto make(const Api* api, const fc::microseconds& max_serialization_time) {
-      return [api, max_serialization_time](const account_name &name) -> optional<abi_serializer> {
+      return [api, max_serialization_time](const account_name &name) -> abi_serializer_ptr {
          const auto* accnt = api->db.db().template find<account_object, by_name>(name);
          if (accnt != nullptr) {
-            abi_def abi;
-            if (abi_serializer::to_abi(accnt->abi, abi)) {
-               return abi_serializer(abi, max_serialization_time);
-            }
+            return api->db.get_abi_serializer(name, max_serialization_time);
          }
 
-         return optional<abi_serializer>();
+         return abi_serializer_ptr();
       };
    }
 };
@@ -1553,11 +1675,8 @@ read_only::get_account_results read_only::get_account( const get_account_params&
       ++perm;
    }
 
-   const auto& code_account = db.db().get<account_object,by_name>( config::system_account_name );
-
-   abi_def abi;
-   if( abi_serializer::to_abi(code_account.abi, abi) ) {
-      abi_serializer abis( abi, abi_serializer_max_time );
+   if( const auto abis_ptr = db.get_abi_serializer( config::system_account_name, abi_serializer_max_time ) ) {
+      const abi_serializer& abis = *abis_ptr;
 
       const auto token_code = N(besio.token);
 
@@ -1627,11 +1746,10 @@ read_only::get_account_results read_only::get_account( const get_account_params&
    return result;
 }
 
-static variant action_abi_to_variant( const abi_def& abi, type_name action_type ) {
+static variant action_abi_to_variant( const abi_serializer& abis, type_name action_type ) {
    variant v;
-   auto it = std::find_if(abi.structs.begin(), abi.structs.end(), [&](auto& x){return x.name == action_type;});
-   if( it != abi.structs.end() )
-      to_variant( it->fields,  v );
+   if( abis.is_struct(action_type) )
+      to_variant( abis.get_struct(action_type).fields,  v );
    return v;
 };
 
@@ -1640,16 +1758,15 @@ read_only::abi_json_to_bin_result read_only::abi_json_to_bin( const read_only::a
    const auto code_account = db.db().find<account_object,by_name>( params.code );
    BES_ASSERT(code_account != nullptr, contract_query_exception, "Contract can't be found ${contract}", ("contract", params.code));
 
-   abi_def abi;
-   if( abi_serializer::to_abi(code_account->abi, abi) ) {
-      abi_serializer abis( abi, abi_serializer_max_time );
+   if( const auto abis_ptr = db.get_abi_serializer( params.code, abi_serializer_max_time ) ) {
+      const abi_serializer& abis = *abis_ptr;
       auto action_type = abis.get_action_type(params.action);
       BES_ASSERT(!action_type.empty(), action_validate_exception, "Unknown action ${action} in contract ${contract}", ("action", params.action)("contract", params.code));
       try {
          result.binargs = abis.variant_to_binary(action_type, params.args, abi_serializer_max_time);
       } BES_RETHROW_EXCEPTIONS(chain::invalid_action_args_exception,
                                 "'${args}' is invalid args for action '${action}' code '${code}'. expected '${proto}'",
-                                ("args", params.args)("action", params.action)("code", params.code)("proto", action_abi_to_variant(abi, action_type)))
+                                ("args", params.args)("action", params.action)("code", params.code)("proto", action_abi_to_variant(abis, action_type)))
    } else {
       BES_ASSERT(false, abi_not_found_exception, "No ABI found for ${contract}", ("contract", params.code));
    }
@@ -1659,11 +1776,9 @@ read_only::abi_json_to_bin_result read_only::abi_json_to_bin( const read_only::a
 
 read_only::abi_bin_to_json_result read_only::abi_bin_to_json( const read_only::abi_bin_to_json_params& params )const {
    abi_bin_to_json_result result;
-   const auto& code_account = db.db().get<account_object,by_name>( params.code );
-   abi_def abi;
-   if( abi_serializer::to_abi(code_account.abi, abi) ) {
-      abi_serializer abis( abi, abi_serializer_max_time );
-      result.args = abis.binary_to_variant( abis.get_action_type( params.action ), params.binargs, abi_serializer_max_time );
+   db.db().get<account_object,by_name>( params.code );
+   if( const auto abis = db.get_abi_serializer( params.code, abi_serializer_max_time ) ) {
+      result.args = abis->binary_to_variant( abis->get_action_type( params.action ), params.binargs, abi_serializer_max_time );
    } else {
       BES_ASSERT(false, abi_not_found_exception, "No ABI found for ${contract}", ("contract", params.code));
    }
@@ -20,6 +20,7 @@
 #include <boost/multiprecision/cpp_int.hpp>
 
 #include <fc/static_variant.hpp>
+#include <fc/crypto/hex.hpp>
 
 namespace fc { class variant; }
 
@@ -41,6 +42,7 @@ namespace besio {
    using chain::action_name;
    using chain::abi_def;
    using chain::abi_serializer;
+   using chain::abi_serializer_ptr;
 
 namespace chain_apis {
 struct empty{};
@@ -68,12 +70,15 @@ uint64_t convert_to_type(const string& str, const string& desc);
 class read_only {
    const controller& db;
    const fc::microseconds abi_serializer_max_time;
+   const uint32_t table_rows_max_bytes;
 
 public:
    static const string KEYi64;
+   static const uint32_t default_table_rows_max_bytes = 4*1024*1024;
 
-   read_only(const controller& db, const fc::microseconds& abi_serializer_max_time)
-      : db(db), abi_serializer_max_time(abi_serializer_max_time) {}
+   read_only(const controller& db, const fc::microseconds& abi_serializer_max_time,
+             uint32_t table_rows_max_bytes = default_table_rows_max_bytes)
+      : db(db), abi_serializer_max_time(abi_serializer_max_time), table_rows_max_bytes(table_rows_max_bytes) {}
 
    void validate() const {}
 
@@ -241,11 +246,13 @@ public:
       string      key_type;  // type of key specified by index_position
       string      index_position; // 1 - primary (first), 2 - secondary index (in order defined by multi_index), 3 - third index, etc
       string      encode_type{"dec"}; //dec, hex , default=dec
+      string      continuation; ///< continuation from a previous result; resumes the scan exactly where it stopped, lower_bound is ignored
     };
 
    struct get_table_rows_result {
       vector<fc::variant> rows; ///< one row per item, either encoded as hex String or JSON object
       bool                more = false; ///< true if last element in data is not the end and sizeof data() < limit
+      string              continuation; ///< opaque position of the next row when more is true
    };
 
    get_table_rows_result get_table_rows( const get_table_rows_params& params )const;
@@ -336,15 +343,83 @@ public:
 
    static uint64_t get_table_index_name(const read_only::get_table_rows_params& p, bool& primary);
 
+   /**
+    *  A continuation is the hex encoding of the raw index key of the next row: the secondary key (if any) followed
+    *  by the primary key. Resuming from it is a single seek, and unlike re-seeking from the secondary key passed as
+    *  lower_bound it neither repeats nor skips rows sharing a secondary key.
+    */
+   static string make_continuation( uint64_t primary ) {
+      return fc::to_hex( (const char*)&primary, sizeof(primary) );
+   }
+
+   template<typename SecondaryKey>
+   static string make_continuation( const SecondaryKey& secondary, uint64_t primary ) {
+      char buffer[sizeof(SecondaryKey) + sizeof(uint64_t)];
+      memcpy( buffer, &secondary, sizeof(SecondaryKey) );
+      memcpy( buffer + sizeof(SecondaryKey), &primary, sizeof(uint64_t) );
+      return fc::to_hex( buffer, sizeof(buffer) );
+   }
+
+   /// a float128_t key is written as its two words, so the continuation never depends on the layout of the struct
+   static string make_continuation( const float128_t& secondary, uint64_t primary ) {
+      const uint64_t words[3] = { secondary.v[0], secondary.v[1], primary };
+      return fc::to_hex( (const char*)words, sizeof(words) );
+   }
+
+   static void parse_continuation( const string& continuation, char* buffer, size_t size ) {
+      bool valid = continuation.size() == 2 * size;
+      if( valid ) {
+         try {
+            valid = fc::from_hex( continuation, buffer, size ) == size;
+         } catch( ... ) {
+            valid = false;
+         }
+      }
+      BES_ASSERT( valid, chain::contract_table_query_exception, "Invalid continuation: ${c}", ("c", continuation) );
+   }
+
+   static void parse_continuation( const string& continuation, uint64_t& primary ) {
+      parse_continuation( continuation, (char*)&primary, sizeof(primary) );
+   }
+
+   template<typename SecondaryKey>
+   static void parse_continuation( const string& continuation, SecondaryKey& secondary, uint64_t& primary ) {
+      char buffer[sizeof(SecondaryKey) + sizeof(uint64_t)];
+      parse_continuation( continuation, buffer, sizeof(buffer) );
+      memcpy( &secondary, buffer, sizeof(SecondaryKey) );
+      memcpy( &primary, buffer + sizeof(SecondaryKey), sizeof(uint64_t) );
+   }
+
+   static void parse_continuation( const string& continuation, float128_t& secondary, uint64_t& primary ) {
+      uint64_t words[3];
+      parse_continuation( continuation, (char*)words, sizeof(words) );
+      secondary.v[0] = words[0];
+      secondary.v[1] = words[1];
+      primary = words[2];
+   }
+
+   /// a lower bound past the upper bound yields an empty range instead of a walk off the end of the table
+   template<typename Index, typename Iterator>
+   static void clamp_range( const Index& idx, Iterator& lower, const Iterator& upper ) {
+      if( upper != idx.end() && ( lower == idx.end() || !idx.value_comp()( *lower, *upper ) ) )
+         lower = upper;
+   }
+
+   fc::variant table_row_to_variant( const read_only::get_table_rows_params& p, const abi_serializer& abis,
+                                     const chain::key_value_object& obj, vector<char>& data )const {
+      if( !p.json )
+         return fc::variant( fc::to_hex( obj.value.data(), obj.value.size() ) );
+      copy_inline_row( obj, data );
+      return abis.binary_to_variant( abis.get_table_type(p.table), data, abi_serializer_max_time );
+   }
+
    template <typename IndexType, typename SecKeyType, typename ConvFn>
-   read_only::get_table_rows_result get_table_rows_by_seckey( const read_only::get_table_rows_params& p, const abi_def& abi, ConvFn conv )const {
+   read_only::get_table_rows_result get_table_rows_by_seckey( const read_only::get_table_rows_params& p, const abi_serializer& abis, ConvFn conv )const {
       read_only::get_table_rows_result result;
       const auto& d = db.db();
 
       uint64_t scope = convert_to_type<uint64_t>(p.scope, "scope");
 
-      abi_serializer abis;
-      abis.set_abi(abi, abi_serializer_max_time);
       bool primary = false;
       const uint64_t table_with_index = get_table_index_name(p, primary);
       const auto* t_id = d.find<chain::table_id_object, chain::by_code_scope_table>(boost::make_tuple(p.code, scope, p.table));
@@ -377,44 +452,49 @@ public:
             }
          }
 
+         if (p.continuation.size()) {
+            typename IndexType::value_type::secondary_key_type secondary_key;
+            uint64_t primary_key = 0;
+            parse_continuation( p.continuation, secondary_key, primary_key );
+            lower = secidx.lower_bound( boost::make_tuple( low_tid, secondary_key, primary_key ));
+         }
+         clamp_range( secidx, lower, upper );
+
          vector<char> data;
 
          auto end = fc::time_point::now() + fc::microseconds(1000 * 10); /// 10ms max time
 
          unsigned int count = 0;
+         size_t bytes = 0;
          auto itr = lower;
          for (; itr != upper; ++itr) {
-
             const auto* itr2 = d.find<chain::key_value_object, chain::by_scope_primary>(boost::make_tuple(t_id->id, itr->primary_key));
             if (itr2 == nullptr) continue;
-            copy_inline_row(*itr2, data);
 
-            if (p.json) {
-               result.rows.emplace_back(abis.binary_to_variant(abis.get_table_type(p.table), data, abi_serializer_max_time));
-            } else {
-               result.rows.emplace_back(fc::variant(data));
-            }
+            result.rows.emplace_back(table_row_to_variant(p, abis, *itr2, data));
+            bytes += itr2->value.size();
 
-            if (++count == p.limit || fc::time_point::now() > end) {
+            // every page holds at least one row, so following the continuations always makes progress
+            if (++count == p.limit || bytes >= table_rows_max_bytes || fc::time_point::now() > end) {
+               ++itr;
                break;
             }
          }
          if (itr != upper) {
             result.more = true;
+            result.continuation = make_continuation(itr->secondary_key, itr->primary_key);
          }
       }
       return result;
    }
 
    template <typename IndexType>
-   read_only::get_table_rows_result get_table_rows_ex( const read_only::get_table_rows_params& p, const abi_def& abi )const {
+   read_only::get_table_rows_result get_table_rows_ex( const read_only::get_table_rows_params& p, const abi_serializer& abis )const {
       read_only::get_table_rows_result result;
       const auto& d = db.db();
 
       uint64_t scope = convert_to_type<uint64_t>(p.scope, "scope");
 
-      abi_serializer abis;
-      abis.set_abi(abi, abi_serializer_max_time);
       const auto* t_id = d.find<chain::table_id_object, chain::by_code_scope_table>(boost::make_tuple(p.code, scope, p.table));
       if (t_id != nullptr) {
          const auto& idx = d.get_index<IndexType, chain::by_scope_primary>();
@@ -441,28 +521,33 @@ public:
             }
          }
 
+         if (p.continuation.size()) {
+            uint64_t primary_key = 0;
+            parse_continuation( p.continuation, primary_key );
+            lower = idx.lower_bound( boost::make_tuple( t_id->id, primary_key ));
+         }
+         clamp_range( idx, lower, upper );
+
          vector<char> data;
 
          auto end = fc::time_point::now() + fc::microseconds(1000 * 10); /// 10ms max time
 
          unsigned int count = 0;
+         size_t bytes = 0;
          auto itr = lower;
          for (; itr != upper; ++itr) {
-            copy_inline_row(*itr, data);
-
-            if (p.json) {
-               result.rows.emplace_back(abis.binary_to_variant(abis.get_table_type(p.table), data, abi_serializer_max_time));
-            } else {
-               result.rows.emplace_back(fc::variant(data));
-            }
+            result.rows.emplace_back(table_row_to_variant(p, abis, *itr, data));
+            bytes += itr->value.size();
 
-            if (++count == p.limit || fc::time_point::now() > end) {
+            // every page holds at least one row, so following the continuations always makes progress
+            if (++count == p.limit || bytes >= table_rows_max_bytes || fc::time_point::now() > end) {
                ++itr;
                break;
             }
          }
          if (itr != upper) {
             result.more = true;
+            result.continuation = make_continuation(itr->primary_key);
          }
       }
       return result;
@@ -570,7 +655,7 @@ public:
    void plugin_startup();
    void plugin_shutdown();
 
-   chain_apis::read_only get_read_only_api() const { return chain_apis::read_only(chain(), get_abi_serializer_max_time()); }
+   chain_apis::read_only get_read_only_api() const { return chain_apis::read_only(chain(), get_abi_serializer_max_time(), get_table_rows_max_bytes()); }
    chain_apis::read_write get_read_write_api();
 
    void accept_block( const chain::signed_block_ptr& block );
@@ -602,6 +687,7 @@ public:
 
    chain::chain_id_type get_chain_id() const;
    fc::microseconds get_abi_serializer_max_time() const;
+   uint32_t get_table_rows_max_bytes() const;
 
    void handle_guard_exception(const chain::guard_exception& e) const;
 private:
@@ -621,8 +707,8 @@ FC_REFLECT(besio::chain_apis::read_only::get_block_header_state_params, (block_n
 
 FC_REFLECT( besio::chain_apis::read_write::push_transaction_results, (transaction_id)(processed) )
 
-FC_REFLECT( besio::chain_apis::read_only::get_table_rows_params, (json)(code)(scope)(table)(table_key)(lower_bound)(upper_bound)(limit)(key_type)(index_position)(encode_type) )
-FC_REFLECT( besio::chain_apis::read_only::get_table_rows_result, (rows)(more) );
+FC_REFLECT( besio::chain_apis::read_only::get_table_rows_params, (json)(code)(scope)(table)(table_key)(lower_bound)(upper_bound)(limit)(key_type)(index_position)(encode_type)(continuation) )
+FC_REFLECT( besio::chain_apis::read_only::get_table_rows_result, (rows)(more)(continuation) );
 
 FC_REFLECT( besio::chain_apis::read_only::get_currency_balance_params, (code)(account)(symbol));
 FC_REFLECT( besio::chain_apis::read_only::get_currency_stats_params, (code)(symbol));
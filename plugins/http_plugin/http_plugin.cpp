@@ -108,6 +108,11 @@ namespace besio {
          bool                     validate_host;
          set<string>              valid_hosts;
 
+         uint16_t                                       thread_pool_size = 2;
+         optional<boost::asio::thread_pool>             thread_pool;
+         asio::io_context                               server_ioc;
+         optional<asio::executor_work_guard<asio::io_context::executor_type>> server_ioc_work;
+
          bool host_port_is_valid( const std::string& header_host_port, const string& endpoint_local_host_port ) {
             return !validate_host || header_host_port == endpoint_local_host_port || valid_hosts.find(header_host_port) != valid_hosts.end();
          }
@@ -196,6 +201,7 @@ namespace besio {
 
          template<class T>
          void handle_http_request(typename websocketpp::server<detail::asio_with_stub_log<T>>::connection_ptr con) {
+            bool deferred = false;
             try {
                bool is_secure = con->get_uri()->get_secure();
                const auto& local_endpoint = con->get_socket().lowest_layer().local_endpoint();
@@ -227,34 +233,63 @@ namespace besio {
                }
 
                con->append_header( "Content-type", "application/json" );
-               auto body = con->get_request_body();
-               auto resource = con->get_uri()->get_resource();
-               auto handler_itr = url_handlers.find( resource );
-               if( handler_itr != url_handlers.end()) {
-                  con->defer_http_response();
-                  handler_itr->second( resource, body, [con]( auto code, auto&& body ) {
-                     con->set_body( std::move( body ));
-                     con->set_status( websocketpp::http::status_code::value( code ));
-                     con->send_http_response();
-                  } );
-
-               } else {
-                  dlog( "404 - not found: ${ep}", ("ep", resource));
-                  error_results results{websocketpp::http::status_code::not_found,
-                                        "Not Found", error_results::error_info(fc::exception( FC_LOG_MESSAGE( error, "Unknown Endpoint" )), verbose_http_errors )};
-                  con->set_body( fc::json::to_string( results ));
-                  con->set_status( websocketpp::http::status_code::not_found );
-               }
+               con->defer_http_response();
+               deferred = true;
+
+               // url handlers, including the read only chain api calls, are owned by, and run on, the application
+               // thread; only the request parsing above and the JSON rendering of the response happen on the http threads.
+               // They run at low priority so a flood of requests cannot delay blocks and block production
+               app().post( priority::low, [this, con, body = con->get_request_body(), resource = con->get_uri()->get_resource()]() {
+                  try {
+                     auto handler_itr = url_handlers.find( resource );
+                     if( handler_itr != url_handlers.end()) {
+                        handler_itr->second( resource, body, [this, con]( int code, fc::variant response_body ) {
+                           send_response<T>( con, code, std::move( response_body ));
+                        } );
+                     } else {
+                        dlog( "404 - not found: ${ep}", ("ep", resource));
+                        error_results results{websocketpp::http::status_code::not_found,
+                                              "Not Found", error_results::error_info(fc::exception( FC_LOG_MESSAGE( error, "Unknown Endpoint" )), verbose_http_errors )};
+                        send_response<T>( con, websocketpp::http::status_code::not_found, fc::variant( results ));
+                     }
+                  } catch( ... ) {
+                     asio::post( *con->get_strand(), [con, e = std::current_exception()]() {
+                        try {
+                           std::rethrow_exception( e );
+                        } catch( ... ) {
+                           handle_exception<T>( con );
+                        }
+                        con->send_http_response();
+                     } );
+                  }
+               } );
             } catch( ... ) {
                handle_exception<T>( con );
+               // once deferred, websocketpp only sends the response when asked to
+               if( deferred )
+                  con->send_http_response();
             }
          }
 
+         /// renders the response on the connection's strand, which serializes it with the connection's own handlers
+         template<class T>
+         void send_response(typename websocketpp::server<detail::asio_with_stub_log<T>>::connection_ptr con, int code, fc::variant response_body) {
+            asio::post( *con->get_strand(), [con, code, response_body = std::move( response_body )]() {
+               try {
+                  con->set_body( fc::json::to_string( response_body ));
+                  con->set_status( websocketpp::http::status_code::value( code ));
+               } catch( ... ) {
+                  handle_exception<T>( con );
+               }
+               con->send_http_response();
+            } );
+         }
+
          template<class T>
          void create_server_for_endpoint(const tcp::endpoint& ep, websocketpp::server<detail::asio_with_stub_log<T>>& ws) {
             try {
                ws.clear_access_channels(websocketpp::log::alevel::all);
-               ws.init_asio(&app().get_io_service());
+               ws.init_asio(&server_ioc);
                ws.set_reuse_addr(true);
                ws.set_max_http_body_size(max_body_size);
                ws.set_http_handler([&](connection_hdl hdl) {
@@ -322,6 +357,8 @@ namespace besio {
             ("verbose-http-errors", bpo::bool_switch()->default_value(false), "Append the error log to HTTP responses")
             ("http-validate-host", boost::program_options::value<bool>()->default_value(true), "If set to false, then any incoming \"Host\" header is considered valid")
             ("http-alias", bpo::value<std::vector<string>>()->composing(), "Additionaly acceptable values for the \"Host\" header of incoming HTTP requests, can be specified multiple times.  Includes http/s_server_address by default.")
+            ("http-threads", bpo::value<uint16_t>()->default_value( my->thread_pool_size ),
+             "Number of worker threads in http thread pool; they parse requests and render responses as JSON, API calls still run on the main thread")
             ;
    }
 
@@ -386,6 +423,10 @@ namespace besio {
             }
          }
 
+         my->thread_pool_size = options.at( "http-threads" ).as<uint16_t>();
+         BES_ASSERT( my->thread_pool_size > 0, chain::plugin_config_exception,
+                     "http-threads ${num} must be greater than 0", ("num", my->thread_pool_size));
+
          my->max_body_size = options.at( "max-body-size" ).as<uint32_t>();
          verbose_http_errors = options.at( "verbose-http-errors" ).as<bool>();
 
@@ -394,6 +435,12 @@ namespace besio {
    }
 
    void http_plugin::plugin_startup() {
+      my->thread_pool.emplace( my->thread_pool_size );
+      my->server_ioc_work.emplace( asio::make_work_guard( my->server_ioc ));
+      for( uint16_t i = 0; i < my->thread_pool_size; ++i ) {
+         asio::post( *my->thread_pool, [&ioc = my->server_ioc]() { ioc.run(); } );
+      }
+
       if(my->listen_endpoint) {
          try {
             my->create_server_for_endpoint(*my->listen_endpoint, my->server);
@@ -441,6 +488,13 @@ namespace besio {
          my->server.stop_listening();
       if(my->https_server.is_listening())
          my->https_server.stop_listening();
+
+      if( my->thread_pool ) {
+         my->server_ioc_work.reset();
+         my->server_ioc.stop();
+         my->thread_pool->join();
+         my->thread_pool->stop();
+      }
    }
 
    void http_plugin::add_handler(const string& url, const url_handler& handler) {
@@ -456,18 +510,18 @@ namespace besio {
             throw;
          } catch (chain::unsatisfied_authorization& e) {
             error_results results{401, "UnAuthorized", error_results::error_info(e, verbose_http_errors)};
-            cb( 401, fc::json::to_string( results ));
+            cb( 401, fc::variant( results ));
          } catch (chain::tx_duplicate& e) {
             error_results results{409, "Conflict", error_results::error_info(e, verbose_http_errors)};
-            cb( 409, fc::json::to_string( results ));
+            cb( 409, fc::variant( results ));
          } catch (fc::eof_exception& e) {
             error_results results{422, "Unprocessable Entity", error_results::error_info(e, verbose_http_errors)};
-            cb( 422, fc::json::to_string( results ));
+            cb( 422, fc::variant( results ));
             elog( "Unable to parse arguments to ${api}.${call}", ("api", api_name)( "call", call_name ));
             dlog("Bad arguments: ${args}", ("args", body));
          } catch (fc::exception& e) {
             error_results results{500, "Internal Service Error", error_results::error_info(e, verbose_http_errors)};
-            cb( 500, fc::json::to_string( results ));
+            cb( 500, fc::variant( results ));
             if (e.code() != chain::greylist_net_usage_exceeded::code_value && e.code() != chain::greylist_cpu_usage_exceeded::code_value) {
                elog( "FC Exception encountered while processing ${api}.${call}",
                      ("api", api_name)( "call", call_name ));
@@ -475,14 +529,14 @@ namespace besio {
             }
          } catch (std::exception& e) {
             error_results results{500, "Internal Service Error", error_results::error_info(fc::exception( FC_LOG_MESSAGE( error, e.what())), verbose_http_errors)};
-            cb( 500, fc::json::to_string( results ));
+            cb( 500, fc::variant( results ));
             elog( "STD Exception encountered while processing ${api}.${call}",
                   ("api", api_name)( "call", call_name ));
             dlog( "Exception Details: ${e}", ("e", e.what()));
          } catch (...) {
             error_results results{500, "Internal Service Error",
                error_results::error_info(fc::exception( FC_LOG_MESSAGE( error, "Unknown Exception" )), verbose_http_errors)};
-            cb( 500, fc::json::to_string( results ));
+            cb( 500, fc::variant( results ));
             elog( "Unknown Exception encountered while processing ${api}.${call}",
                   ("api", api_name)( "call", call_name ));
          }
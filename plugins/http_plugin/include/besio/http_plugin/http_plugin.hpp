@@ -5,6 +5,7 @@
 #pragma once
 #include <appbase/application.hpp>
 #include <fc/exception/exception.hpp>
+#include <fc/variant.hpp>
 
 #include <fc/reflect/reflect.hpp>
 
@@ -15,9 +16,12 @@ namespace besio {
     * @brief A callback function provided to a URL handler to
     * allow it to specify the HTTP response code and body
     *
+    * The body is converted to JSON on an http thread, keeping
+    * the serialization of large responses off the main thread.
+    *
     * Arguments: response_code, response_body
     */
-   using url_response_callback = std::function<void(int,string)>;
+   using url_response_callback = std::function<void(int,fc::variant)>;
 
    /**
     * @brief Callback type for a URL handler
@@ -50,9 +54,9 @@ namespace besio {
     *  thread.  The callback can be called from any thread and will 
     *  automatically propagate the call to the http thread.
     *
-    *  The HTTP service will run in its own thread with its own io_service to
-    *  make sure that HTTP request processing does not interfer with other
-    *  plugins.  
+    *  The HTTP service will run in its own threads (http-threads) with its
+    *  own io_service to make sure that HTTP request processing does not
+    *  interfer with other plugins.  
     */
    class http_plugin : public appbase::plugin<http_plugin>
    {
@@ -69,7 +69,7 @@ void login_plugin::plugin_initialize(const variables_map& options) {
             if (body.empty())                                                                                          \
                body = "{}";                                                                                            \
             auto result = call_name(fc::json::from_string(body).as<login_plugin::call_name##_params>());               \
-            cb(http_response_code, fc::json::to_string(result));                                                       \
+            cb(http_response_code, fc::variant(result));                                                               \
          } catch (...) {                                                                                               \
             http_plugin::handle_exception("login", #call_name, body, cb);                                              \
          }                                                                                                             \
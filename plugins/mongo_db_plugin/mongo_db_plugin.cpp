@@ -8,13 +8,13 @@
 #include <besio/chain/exceptions.hpp>
 #include <besio/chain/transaction.hpp>
 #include <besio/chain/types.hpp>
+#include <besio/chain/thread_utils.hpp>
 
 #include <fc/io/json.hpp>
 #include <fc/utf8.hpp>
 #include <fc/variant.hpp>
 
 #include <boost/algorithm/string.hpp>
-#include <boost/chrono.hpp>
 #include <boost/signals2/connection.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/thread/mutex.hpp>
@@ -85,13 +85,16 @@ public:
    void process_irreversible_block(const chain::block_state_ptr&);
    void _process_irreversible_block(const chain::block_state_ptr&);
 
-   optional<abi_serializer> get_abi_serializer( account_name n );
+   abi_serializer_ptr get_abi_serializer( account_name n );
    template<typename T> fc::variant to_variant_with_abi( const T& obj );
 
    void purge_abi_cache();
 
-   bool add_action_trace( mongocxx::bulk_write& bulk_action_traces, const chain::action_trace& atrace,
-                          bool executed, const std::chrono::milliseconds& now );
+   bool add_action_trace( const chain::action_trace& atrace, bool executed, const std::chrono::milliseconds& now );
+
+   void execute_bulk_write( const std::string& collection, bool ordered,
+                            std::deque<std::future<mongocxx::model::write>>& writes, const char* desc );
+   void write_pending();
 
    void update_account(const chain::action& act);
 
@@ -131,8 +134,11 @@ public:
    mongocxx::collection accounts;
 
    size_t max_queue_size = 0;
-   int queue_sleep_time = 0;
    size_t abi_cache_size = 0;
+   // lag of the consume thread, guarded by mtx
+   size_t queue_high_water = 0;
+   uint64_t queue_overflows = 0;
+   fc::time_point last_backpressure_report;
    std::deque<chain::transaction_metadata_ptr> transaction_metadata_queue;
    std::deque<chain::transaction_metadata_ptr> transaction_metadata_process_queue;
    std::deque<chain::transaction_trace_ptr> transaction_trace_queue;
@@ -144,6 +150,17 @@ public:
    boost::mutex mtx;
    boost::condition_variable condition;
    boost::thread consume_thread;
+
+   /**
+    *  The consume thread resolves ABIs and updates accounts in order, then hands the JSON/BSON conversion of
+    *  each document to thread_pool. The resulting writes are gathered per batch taken from the queues and
+    *  executed as one bulk write per collection.
+    */
+   uint32_t thread_pool_size = 2;
+   std::unique_ptr<boost::asio::thread_pool> thread_pool;
+   std::deque<std::future<mongocxx::model::write>> pending_action_traces;
+   std::deque<std::future<mongocxx::model::write>> pending_transaction_traces;
+   std::deque<std::future<mongocxx::model::write>> pending_trans;
    std::atomic_bool done{false};
    std::atomic_bool startup{true};
    fc::optional<chain::chain_id_type> chain_id;
@@ -155,7 +172,7 @@ public:
    struct abi_cache {
       account_name                     account;
       fc::time_point                   last_accessed;
-      fc::optional<abi_serializer>     serializer;
+      abi_serializer_ptr               serializer;
    };
 
    typedef boost::multi_index_container<abi_cache,
@@ -232,20 +249,12 @@ bool mongo_db_plugin_impl::filter_include( const chain::action_trace& action_tra
 template<typename Queue, typename Entry>
 void mongo_db_plugin_impl::queue( Queue& queue, const Entry& e ) {
    boost::mutex::scoped_lock lock( mtx );
-   auto queue_size = queue.size();
-   if( queue_size > max_queue_size ) {
-      lock.unlock();
-      condition.notify_one();
-      queue_sleep_time += 10;
-      if( queue_sleep_time > 1000 )
-         wlog("queue size: ${q}", ("q", queue_size));
-      boost::this_thread::sleep_for( boost::chrono::milliseconds( queue_sleep_time ));
-      lock.lock();
-   } else {
-      queue_sleep_time -= 10;
-      if( queue_sleep_time < 0 ) queue_sleep_time = 0;
+   // never hold up block processing on MongoDB, a queue beyond max_queue_size is only counted and reported
+   if( queue.size() >= max_queue_size ) {
+      ++queue_overflows;
    }
    queue.emplace_back( e );
+   queue_high_water = std::max( queue_high_water, queue.size() );
    lock.unlock();
    condition.notify_one();
 }
@@ -344,8 +353,23 @@ void mongo_db_plugin_impl::consume_blocks() {
             irreversible_block_state_queue.clear();
          }
 
+         uint64_t overflows = 0;
+         size_t high_water = 0;
+         if( queue_overflows > 0 && fc::time_point::now() - last_backpressure_report > fc::seconds(10) ) {
+            overflows = queue_overflows;
+            high_water = queue_high_water;
+            queue_overflows = 0;
+            queue_high_water = 0;
+            last_backpressure_report = fc::time_point::now();
+         }
+
          lock.unlock();
 
+         if( overflows > 0 ) {
+            wlog( "mongo_db_plugin falling behind, ${o} entries queued beyond mongodb-queue-size ${m}, queue high water ${h}",
+                  ("o", overflows)("m", max_queue_size)("h", high_water) );
+         }
+
          if (done) {
             ilog("draining queue, size: ${q}", ("q", transaction_metadata_size + transaction_trace_size + block_state_size + irreversible_block_size));
          }
@@ -375,6 +399,15 @@ void mongo_db_plugin_impl::consume_blocks() {
          if( time > fc::microseconds(500000) ) // reduce logging, .5 secs
             ilog( "process_accepted_transaction, time per: ${p}, size: ${s}, time: ${t}", ("s", size)( "t", time )( "p", per ));
 
+         // bulk write traces and transactions, irreversible blocks below update transactions written here
+         start_time = fc::time_point::now();
+         size = pending_action_traces.size() + pending_transaction_traces.size() + pending_trans.size();
+         write_pending();
+         time = fc::time_point::now() - start_time;
+         per = size > 0 ? time.count()/size : 0;
+         if( time > fc::microseconds(500000) ) // reduce logging, .5 secs
+            ilog( "write_pending,                time per: ${p}, size: ${s}, time: ${t}", ("s", size)("t", time)("p", per) );
+
          // process blocks
          start_time = fc::time_point::now();
          size = block_state_process_queue.size();
@@ -477,6 +510,28 @@ void handle_mongo_exception( const std::string& desc, int line_num ) {
    }
 }
 
+/// appends the fields of v to doc, pruning invalid utf8 if MongoDB rejects the JSON of v
+void append_variant( bsoncxx::builder::basic::document& doc, const fc::variant& v, const char* desc ) {
+   using namespace bsoncxx::types;
+   using bsoncxx::builder::basic::kvp;
+
+   string json = fc::json::to_string( v );
+   try {
+      const auto& value = bsoncxx::from_json( json );
+      doc.append( bsoncxx::builder::concatenate_doc{value.view()} );
+   } catch( bsoncxx::exception& ) {
+      try {
+         json = fc::prune_invalid_utf8( json );
+         const auto& value = bsoncxx::from_json( json );
+         doc.append( bsoncxx::builder::concatenate_doc{value.view()} );
+         doc.append( kvp( "non-utf8-purged", b_bool{true} ) );
+      } catch( bsoncxx::exception& e ) {
+         elog( "Unable to convert ${d} JSON to MongoDB JSON: ${e}", ("d", desc)("e", e.what()) );
+         elog( "  JSON: ${j}", ("j", json) );
+      }
+   }
+}
+
 } // anonymous namespace
 
 void mongo_db_plugin_impl::purge_abi_cache() {
@@ -490,7 +545,7 @@ void mongo_db_plugin_impl::purge_abi_cache() {
    }
 }
 
-optional<abi_serializer> mongo_db_plugin_impl::get_abi_serializer( account_name n ) {
+abi_serializer_ptr mongo_db_plugin_impl::get_abi_serializer( account_name n ) {
    using bsoncxx::builder::basic::kvp;
    using bsoncxx::builder::basic::make_document;
    if( n.good()) {
@@ -514,7 +569,7 @@ optional<abi_serializer> mongo_db_plugin_impl::get_abi_serializer( account_name
                   abi = fc::json::from_string( bsoncxx::to_json( view["abi"].get_document())).as<abi_def>();
                } catch (...) {
                   ilog( "Unable to convert account abi to abi_def for ${n}", ( "n", n ));
-                  return optional<abi_serializer>();
+                  return abi_serializer_ptr();
                }
 
                purge_abi_cache(); // make room if necessary
@@ -551,14 +606,14 @@ optional<abi_serializer> mongo_db_plugin_impl::get_abi_serializer( account_name
                   }
                }
                abis.set_abi( abi, abi_serializer_max_time );
-               entry.serializer.emplace( std::move( abis ) );
+               entry.serializer = std::make_shared<const abi_serializer>( std::move( abis ) );
                abi_cache_index.insert( entry );
                return entry.serializer;
             }
          }
       } FC_CAPTURE_AND_LOG((n))
    }
-   return optional<abi_serializer>();
+   return abi_serializer_ptr();
 }
 
 template<typename T>
@@ -629,82 +684,66 @@ void mongo_db_plugin_impl::_process_accepted_transaction( const chain::transacti
    using namespace bsoncxx::types;
    using bsoncxx::builder::basic::kvp;
    using bsoncxx::builder::basic::make_document;
-   using bsoncxx::builder::basic::make_array;
-   namespace bbb = bsoncxx::builder::basic;
-
-   auto trans = mongo_conn[db_name][trans_col];
-   auto trans_doc = bsoncxx::builder::basic::document{};
 
    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
          std::chrono::microseconds{fc::time_point::now().time_since_epoch().count()} );
 
-   const auto& trx_id = t->id;
-   const auto trx_id_str = trx_id.str();
-   const auto& trx = t->trx;
+   // the abi cache reads the accounts collection so abi resolution stays on the consume thread
+   auto v = to_variant_with_abi( t->trx );
+   pending_trans.emplace_back( async_thread_pool( *thread_pool, [t, v = std::move( v ), chain_id = *chain_id, now]() {
+      auto trans_doc = bsoncxx::builder::basic::document{};
 
-   trans_doc.append( kvp( "trx_id", trx_id_str ) );
+      const auto& trx_id = t->id;
+      const auto trx_id_str = trx_id.str();
+      const auto& trx = t->trx;
 
-   auto v = to_variant_with_abi( trx );
-   string trx_json = fc::json::to_string( v );
+      trans_doc.append( kvp( "trx_id", trx_id_str ) );
+      append_variant( trans_doc, v, "transaction" );
 
-   try {
-      const auto& trx_value = bsoncxx::from_json( trx_json );
-      trans_doc.append( bsoncxx::builder::concatenate_doc{trx_value.view()} );
-   } catch( bsoncxx::exception& ) {
-      try {
-         trx_json = fc::prune_invalid_utf8( trx_json );
-         const auto& trx_value = bsoncxx::from_json( trx_json );
-         trans_doc.append( bsoncxx::builder::concatenate_doc{trx_value.view()} );
-         trans_doc.append( kvp( "non-utf8-purged", b_bool{true} ) );
-      } catch( bsoncxx::exception& e ) {
-         elog( "Unable to convert transaction JSON to MongoDB JSON: ${e}", ("e", e.what()) );
-         elog( "  JSON: ${j}", ("j", trx_json) );
+      chain::flat_set<chain::public_key_type> signing_keys;
+      bool recovered = false;
+      if( t->signing_keys_future.valid() ) {
+         try {
+            signing_keys = t->signing_keys_future.get().second;
+            recovered = true;
+         } catch( ... ) {
+            // the future carries the failure of the transaction (e.g. tx_duplicate_sig), still store its document
+         }
       }
-   }
-
-   string signing_keys_json;
-   if( t->signing_keys.valid() ) {
-      signing_keys_json = fc::json::to_string( t->signing_keys->second );
-   } else {
-      auto signing_keys = trx.get_signature_keys( *chain_id, false, false );
+      if( !recovered ) {
+         signing_keys = trx.get_signature_keys( chain_id, true, false );
+      }
+      string signing_keys_json;
       if( !signing_keys.empty() ) {
          signing_keys_json = fc::json::to_string( signing_keys );
       }
-   }
 
-   if( !signing_keys_json.empty() ) {
-      try {
-         const auto& keys_value = bsoncxx::from_json( signing_keys_json );
-         trans_doc.append( kvp( "signing_keys", keys_value ) );
-      } catch( bsoncxx::exception& e ) {
-         // should never fail, so don't attempt to remove invalid utf8
-         elog( "Unable to convert signing keys JSON to MongoDB JSON: ${e}", ("e", e.what()) );
-         elog( "  JSON: ${j}", ("j", signing_keys_json) );
+      if( !signing_keys_json.empty() ) {
+         try {
+            const auto& keys_value = bsoncxx::from_json( signing_keys_json );
+            trans_doc.append( kvp( "signing_keys", keys_value ) );
+         } catch( bsoncxx::exception& e ) {
+            // should never fail, so don't attempt to remove invalid utf8
+            elog( "Unable to convert signing keys JSON to MongoDB JSON: ${e}", ("e", e.what()) );
+            elog( "  JSON: ${j}", ("j", signing_keys_json) );
+         }
       }
-   }
-
-   trans_doc.append( kvp( "accepted", b_bool{t->accepted} ) );
-   trans_doc.append( kvp( "implicit", b_bool{t->implicit} ) );
-   trans_doc.append( kvp( "scheduled", b_bool{t->scheduled} ) );
 
-   trans_doc.append( kvp( "createdAt", b_date{now} ) );
+      trans_doc.append( kvp( "accepted", b_bool{t->accepted} ) );
+      trans_doc.append( kvp( "implicit", b_bool{t->implicit} ) );
+      trans_doc.append( kvp( "scheduled", b_bool{t->scheduled} ) );
 
-   try {
-      mongocxx::options::update update_opts{};
-      update_opts.upsert( true );
-      if( !trans.update_one( make_document( kvp( "trx_id", trx_id_str ) ),
-                             make_document( kvp( "$set", trans_doc.view() ) ), update_opts ) ) {
-         BES_ASSERT( false, chain::mongo_db_insert_fail, "Failed to insert trans ${id}", ("id", trx_id) );
-      }
-   } catch( ... ) {
-      handle_mongo_exception( "trans insert", __LINE__ );
-   }
+      trans_doc.append( kvp( "createdAt", b_date{now} ) );
 
+      mongocxx::model::update_one update_op{ make_document( kvp( "trx_id", trx_id_str ) ),
+                                             make_document( kvp( "$set", trans_doc.view() ) ) };
+      update_op.upsert( true );
+      return mongocxx::model::write{ std::move( update_op ) };
+   } ) );
 }
 
 bool
-mongo_db_plugin_impl::add_action_trace( mongocxx::bulk_write& bulk_action_traces, const chain::action_trace& atrace,
-                                        bool executed, const std::chrono::milliseconds& now )
+mongo_db_plugin_impl::add_action_trace( const chain::action_trace& atrace, bool executed, const std::chrono::milliseconds& now )
 {
    using namespace bsoncxx::types;
    using bsoncxx::builder::basic::kvp;
@@ -715,34 +754,20 @@ mongo_db_plugin_impl::add_action_trace( mongocxx::bulk_write& bulk_action_traces
 
    bool added = false;
    if( start_block_reached && store_action_traces && filter_include( atrace ) ) {
-      auto action_traces_doc = bsoncxx::builder::basic::document{};
       const chain::base_action_trace& base = atrace; // without inline action traces
 
       auto v = to_variant_with_abi( base );
-      string json = fc::json::to_string( v );
-      try {
-         const auto& value = bsoncxx::from_json( json );
-         action_traces_doc.append( bsoncxx::builder::concatenate_doc{value.view()} );
-      } catch( bsoncxx::exception& ) {
-         try {
-            json = fc::prune_invalid_utf8( json );
-            const auto& value = bsoncxx::from_json( json );
-            action_traces_doc.append( bsoncxx::builder::concatenate_doc{value.view()} );
-            action_traces_doc.append( kvp( "non-utf8-purged", b_bool{true} ) );
-         } catch( bsoncxx::exception& e ) {
-            elog( "Unable to convert action trace JSON to MongoDB JSON: ${e}", ("e", e.what()) );
-            elog( "  JSON: ${j}", ("j", json) );
-         }
-      }
-      action_traces_doc.append( kvp( "createdAt", b_date{now} ) );
-
-      mongocxx::model::insert_one insert_op{action_traces_doc.view()};
-      bulk_action_traces.append( insert_op );
+      pending_action_traces.emplace_back( async_thread_pool( *thread_pool, [v = std::move( v ), now]() {
+         auto action_traces_doc = bsoncxx::builder::basic::document{};
+         append_variant( action_traces_doc, v, "action trace" );
+         action_traces_doc.append( kvp( "createdAt", b_date{now} ) );
+         return mongocxx::model::write{ mongocxx::model::insert_one{ action_traces_doc.extract() } };
+      } ) );
       added = true;
    }
 
    for( const auto& iline_atrace : atrace.inline_traces ) {
-      added |= add_action_trace( bulk_action_traces, iline_atrace, executed, now );
+      added |= add_action_trace( iline_atrace, executed, now );
    }
 
    return added;
@@ -753,69 +778,74 @@ void mongo_db_plugin_impl::_process_applied_transaction( const chain::transactio
    using namespace bsoncxx::types;
    using bsoncxx::builder::basic::kvp;
 
-   auto trans_traces = mongo_conn[db_name][trans_traces_col];
-   auto action_traces = mongo_conn[db_name][action_traces_col];
-   auto trans_traces_doc = bsoncxx::builder::basic::document{};
-
    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
          std::chrono::microseconds{fc::time_point::now().time_since_epoch().count()});
 
-   mongocxx::options::bulk_write bulk_opts;
-   bulk_opts.ordered(false);
-   mongocxx::bulk_write bulk_action_traces = action_traces.create_bulk_write(bulk_opts);
    bool write_atraces = false;
    bool executed = t->receipt.valid() && t->receipt->status == chain::transaction_receipt_header::executed;
 
    for( const auto& atrace : t->action_traces ) {
       try {
-         write_atraces |= add_action_trace( bulk_action_traces, atrace, executed, now );
+         write_atraces |= add_action_trace( atrace, executed, now );
       } catch(...) {
          handle_mongo_exception("add action traces", __LINE__);
       }
    }
 
-   if( write_atraces ) {
-      try {
-         if( !bulk_action_traces.execute() ) {
-            BES_ASSERT( false, chain::mongo_db_insert_fail, "Bulk action traces insert failed for transaction trace: ${id}", ("id", t->id));
-         }
-      } catch(...) {
-         handle_mongo_exception("action traces insert", __LINE__);
-      }
-   }
-
    if( !start_block_reached || !store_transaction_traces ) return;
    if( !write_atraces ) return; //< do not insert transaction_trace if all action_traces filtered out
 
    // transaction trace insert
 
    auto v = to_variant_with_abi( *t );
-   string json = fc::json::to_string( v );
-   try {
-      const auto& value = bsoncxx::from_json( json );
-      trans_traces_doc.append( bsoncxx::builder::concatenate_doc{value.view()} );
-   } catch( bsoncxx::exception& ) {
+   pending_transaction_traces.emplace_back( async_thread_pool( *thread_pool, [v = std::move( v ), now]() {
+      auto trans_traces_doc = bsoncxx::builder::basic::document{};
+      append_variant( trans_traces_doc, v, "transaction trace" );
+      trans_traces_doc.append( kvp( "createdAt", b_date{now} ));
+      return mongocxx::model::write{ mongocxx::model::insert_one{ trans_traces_doc.extract() } };
+   } ) );
+}
+
+void mongo_db_plugin_impl::execute_bulk_write( const std::string& collection, bool ordered,
+                                               std::deque<std::future<mongocxx::model::write>>& writes, const char* desc )
+{
+   if( writes.empty() ) return;
+
+   mongocxx::options::bulk_write bulk_opts;
+   bulk_opts.ordered( ordered );
+   auto bulk = mongo_conn[db_name][collection].create_bulk_write( bulk_opts );
+
+   size_t count = 0;
+   for( ; !writes.empty(); writes.pop_front() ) {
       try {
-         json = fc::prune_invalid_utf8( json );
-         const auto& value = bsoncxx::from_json( json );
-         trans_traces_doc.append( bsoncxx::builder::concatenate_doc{value.view()} );
-         trans_traces_doc.append( kvp( "non-utf8-purged", b_bool{true} ));
-      } catch( bsoncxx::exception& e ) {
-         elog( "Unable to convert transaction JSON to MongoDB JSON: ${e}", ("e", e.what()));
-         elog( "  JSON: ${j}", ("j", json));
+         bulk.append( writes.front().get() );
+         ++count;
+      } catch (fc::exception& e) {
+         elog("FC Exception while converting ${d}: ${e}", ("d", desc)("e", e.to_detail_string()));
+      } catch (std::exception& e) {
+         elog("STD Exception while converting ${d}: ${e}", ("d", desc)("e", e.what()));
+      } catch (...) {
+         elog("Unknown exception while converting ${d}", ("d", desc));
       }
    }
-   trans_traces_doc.append( kvp( "createdAt", b_date{now} ));
 
+   if( count == 0 ) return;
    try {
-      if( !trans_traces.insert_one( trans_traces_doc.view())) {
-         BES_ASSERT( false, chain::mongo_db_insert_fail, "Failed to insert trans ${id}", ("id", t->id));
+      if( !bulk.execute() ) {
+         BES_ASSERT( false, chain::mongo_db_insert_fail, "Bulk ${d} failed for ${n} documents", ("d", desc)("n", count) );
       }
-   } catch(...) {
-      handle_mongo_exception("trans_traces insert: " + json, __LINE__);
+   } catch( ... ) {
+      handle_mongo_exception( desc, __LINE__ );
    }
 }
 
+void mongo_db_plugin_impl::write_pending() {
+   // plain inserts can be applied in any order, transactions are upserted and may be accepted more than once
+   execute_bulk_write( action_traces_col, false, pending_action_traces, "action traces insert" );
+   execute_bulk_write( trans_traces_col, false, pending_transaction_traces, "trans_traces insert" );
+   execute_bulk_write( trans_col, true, pending_trans, "trans insert" );
+}
+
 void mongo_db_plugin_impl::_process_accepted_block( const chain::block_state_ptr& bs ) {
    using namespace bsoncxx::types;
    using namespace bsoncxx::builder;
@@ -1216,6 +1246,9 @@ mongo_db_plugin_impl::~mongo_db_plugin_impl() {
          condition.notify_one();
 
          consume_thread.join();
+         if( thread_pool ) {
+            thread_pool->join();
+         }
       } catch( std::exception& e ) {
          elog( "Exception on mongo_db_plugin shutdown of consume thread: ${e}", ("e", e.what()));
       }
@@ -1309,6 +1342,7 @@ void mongo_db_plugin_impl::init() {
 
    ilog("starting db plugin thread");
 
+   thread_pool = std::make_unique<boost::asio::thread_pool>( thread_pool_size );
    consume_thread = boost::thread([this] { consume_blocks(); });
 
    startup = false;
@@ -1331,7 +1365,9 @@ void mongo_db_plugin::set_program_options(options_description& cli, options_desc
 {
    cfg.add_options()
          ("mongodb-queue-size,q", bpo::value<uint32_t>()->default_value(1024),
-         "The target queue size between nodbes and MongoDB plugin thread.")
+         "The queue size between nodbes and MongoDB plugin thread beyond which falling behind is reported. Block processing never waits on the MongoDB plugin thread, the queue grows instead.")
+         ("mongodb-threads", bpo::value<uint32_t>()->default_value(2),
+         "Number of worker threads converting transactions and traces to BSON for the MongoDB plugin thread.")
          ("mongodb-abi-cache-size", bpo::value<uint32_t>()->default_value(2048),
           "The maximum size of the abi cache for serializing data.")
          ("mongodb-wipe", bpo::bool_switch()->default_value(false),
@@ -1384,6 +1420,11 @@ void mongo_db_plugin::plugin_initialize(const variables_map& options)
 
          if( options.count( "mongodb-queue-size" )) {
             my->max_queue_size = options.at( "mongodb-queue-size" ).as<uint32_t>();
+            BES_ASSERT( my->max_queue_size > 0, chain::plugin_config_exception, "mongodb-queue-size > 0 required" );
+         }
+         if( options.count( "mongodb-threads" )) {
+            my->thread_pool_size = options.at( "mongodb-threads" ).as<uint32_t>();
+            BES_ASSERT( my->thread_pool_size > 0, chain::plugin_config_exception, "mongodb-threads > 0 required" );
          }
          if( options.count( "mongodb-abi-cache-size" )) {
             my->abi_cache_size = options.at( "mongodb-abi-cache-size" ).as<uint32_t>();
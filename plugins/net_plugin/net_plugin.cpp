@@ -568,6 +568,7 @@ namespace besio {
       void stop_send();
 
       void enqueue( const net_message &msg, bool trigger_send = true );
+      void enqueue_serialized_block( const char* data, size_t size, bool trigger_send );
       void cancel_sync(go_away_reason);
       void flush_queues();
       bool enqueue_sync_block();
@@ -1067,6 +1068,12 @@ namespace besio {
          peer_requested.reset();
       }
       try {
+         // irreversible blocks are forwarded as stored in the block log instead of being unpacked and packed again
+         auto serialized = cc.fetch_serialized_block_by_number(num);
+         if(serialized.first) {
+            enqueue_serialized_block( serialized.first, serialized.second, trigger_send );
+            return true;
+         }
          signed_block_ptr sb = cc.fetch_block_by_number(num);
          if(sb) {
             enqueue( *sb, trigger_send);
@@ -1110,6 +1117,25 @@ namespace besio {
                   });
    }
 
+   void connection::enqueue_serialized_block( const char* data, size_t size, bool trigger_send ) {
+      const unsigned_int which( net_message::tag<signed_block>::value );
+      uint32_t payload_size = fc::raw::pack_size( which ) + size;
+      size_t header_size = sizeof(payload_size);
+
+      auto send_buffer = std::make_shared<vector<char>>(header_size + payload_size);
+      fc::datastream<char*> ds( send_buffer->data(), send_buffer->size() );
+      ds.write( reinterpret_cast<char*>(&payload_size), header_size );
+      fc::raw::pack( ds, which );
+      ds.write( data, size );
+      connection_wptr weak_this = shared_from_this();
+      queue_write(send_buffer,trigger_send,
+                  [weak_this](boost::system::error_code ec, std::size_t ) {
+                     if (!weak_this.lock()) {
+                        fc_wlog(logger, "connection expired before enqueued block called callback!");
+                     }
+                  });
+   }
+
    void connection::cancel_wait() {
       if (response_expected)
          response_expected->cancel();
@@ -2072,9 +2098,11 @@ namespace besio {
             }
          };
 
+         // messages are read at high priority so blocks are applied ahead of queued api requests; the transactions
+         // they carry are handed to the producer, which executes them at medium priority
          boost::asio::async_read(*conn->socket,
             conn->pending_message_buffer.get_buffer_sequence_for_boost_async_read(), completion_handler,
-            [this,weak_conn]( boost::system::error_code ec, std::size_t bytes_transferred ) {
+            app().get_priority_queue().wrap( priority::high, [this,weak_conn]( boost::system::error_code ec, std::size_t bytes_transferred ) {
                auto conn = weak_conn.lock();
                if (!conn) {
                   return;
@@ -2152,7 +2180,7 @@ namespace besio {
                   elog( "Undefined exception hanlding the read data from connection ${p}",( "p",pname));
                   close( conn );
                }
-            } );
+            } ) );
       } catch (...) {
          string pname = conn ? conn->peer_name() : "no connection name";
          elog( "Undefined exception handling reading ${p}",("p",pname) );
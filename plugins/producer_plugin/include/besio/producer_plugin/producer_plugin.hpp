@@ -40,6 +40,21 @@ public:
       std::vector<account_name> accounts;
    };
 
+   struct snapshot_information {
+      chain::block_id_type head_block_id;
+      std::string          snapshot_name;
+   };
+
+   /// State of the handlers waiting on the application thread with one priority, see appbase::priority
+   struct queue_stats {
+      int32_t  priority = 0;
+      uint64_t depth = 0;
+      uint64_t max_depth = 0;
+      uint64_t executed = 0;
+      uint64_t average_latency_us = 0;
+      uint64_t max_latency_us = 0;
+   };
+
    producer_plugin();
    virtual ~producer_plugin();
 
@@ -67,7 +82,14 @@ public:
 
    whitelist_blacklist get_whitelist_blacklist() const;
    void set_whitelist_blacklist(const whitelist_blacklist& params);
-   
+
+   /**
+    *  Snapshots the head block state. next is called once the snapshot is on disk and its block is irreversible,
+    *  or with the error that prevented that, e.g. the block being forked out.
+    */
+   void create_snapshot(chain::plugin_interface::next_function<snapshot_information> next);
+
+   std::vector<queue_stats> get_queue_stats() const;
 
    signal<void(const chain::producer_confirmation&)> confirmed_block;
 private:
@@ -78,6 +100,8 @@ private:
 
 FC_REFLECT(besio::producer_plugin::runtime_options, (max_transaction_time)(max_irreversible_block_age)(produce_time_offset_us)(last_block_time_offset_us)(subjective_cpu_leeway_us)(incoming_defer_ratio));
 FC_REFLECT(besio::producer_plugin::greylist_params, (accounts));
+FC_REFLECT(besio::producer_plugin::snapshot_information, (head_block_id)(snapshot_name))
+FC_REFLECT(besio::producer_plugin::queue_stats, (priority)(depth)(max_depth)(executed)(average_latency_us)(max_latency_us))
 FC_REFLECT(besio::producer_plugin::whitelist_blacklist, (actor_whitelist)(actor_blacklist)(contract_whitelist)(contract_blacklist)(action_blacklist)(key_blacklist) )
 
 
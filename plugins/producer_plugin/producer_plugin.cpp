@@ -7,6 +7,7 @@
 #include <besio/chain/plugin_interface.hpp>
 #include <besio/chain/global_property_object.hpp>
 #include <besio/chain/transaction_object.hpp>
+#include <besio/chain/snapshot.hpp>
 
 #include <fc/io/json.hpp>
 #include <fc/smart_ref_impl.hpp>
@@ -15,6 +16,7 @@
 #include <boost/asio.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+#include <fstream>
 #include <iostream>
 #include <algorithm>
 #include <boost/range/adaptor/map.hpp>
@@ -135,6 +137,21 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       int32_t                                                   _last_block_time_offset_us = 0;
       fc::time_point                                            _irreversible_block_time;
       fc::microseconds                                          _kbesd_provider_timeout_us;
+      bfs::path                                                 _snapshots_dir;
+
+      /// a snapshot of a block that is not irreversible yet, or whose file is still being written
+      struct pending_snapshot {
+         block_id_type                                                block_id;
+         uint32_t                                                     block_num = 0;
+         bfs::path                                                    pending_path;
+         bfs::path                                                    final_path;
+         bool                                                         written = false;
+         fc::exception_ptr                                            error;
+         vector<next_function<producer_plugin::snapshot_information>> next;
+      };
+      vector<std::shared_ptr<pending_snapshot>>                 _pending_snapshots;
+      fc::optional<boost::asio::thread_pool>                    _snapshot_thread_pool;
+      uint32_t                                                  _irreversible_block_num = 0;
 
       time_point _last_signed_block_time;
       time_point _start_time = fc::time_point::now();
@@ -236,6 +253,55 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
 
       void on_irreversible_block( const signed_block_ptr& lib ) {
          _irreversible_block_time = lib->timestamp.to_time_point();
+         _irreversible_block_num = lib->block_num();
+         if( !_pending_snapshots.empty() )
+            finalize_pending_snapshots();
+      }
+
+      /**
+       *  Publishes every written snapshot whose block is now irreversible under the name create_snapshot
+       *  returns, and fails those that could not be written or whose block was forked out.
+       */
+      void finalize_pending_snapshots() {
+         chain::controller& chain = app().get_plugin<chain_plugin>().chain();
+
+         auto itr = _pending_snapshots.begin();
+         while( itr != _pending_snapshots.end() ) {
+            auto ps = *itr;
+            if( !ps->error && ( !ps->written || ps->block_num > _irreversible_block_num ) ) {
+               ++itr;
+               continue;
+            }
+            itr = _pending_snapshots.erase( itr );
+
+            fc::exception_ptr error = ps->error;
+            auto set_error = [&error]( const fc::exception_ptr& e ) { error = e; };
+            if( !error ) {
+               try {
+                  auto block = chain.fetch_block_by_number( ps->block_num );
+                  BES_ASSERT( block && block->id() == ps->block_id, snapshot_finalization_exception,
+                              "block ${id} of the snapshot was forked out before it became irreversible", ("id", ps->block_id) );
+
+                  boost::system::error_code ec;
+                  bfs::rename( ps->pending_path, ps->final_path, ec );
+                  BES_ASSERT( !ec, snapshot_finalization_exception,
+                              "unable to finalize valid snapshot for block ${id}: [code: ${ec}] ${message}",
+                              ("id", ps->block_id)("ec", ec.value())("message", ec.message()) );
+               } CATCH_AND_CALL( set_error );
+            }
+
+            if( error ) {
+               boost::system::error_code ec;
+               bfs::remove( ps->pending_path, ec );
+               for( const auto& next : ps->next )
+                  next( error );
+            } else {
+               ilog( "snapshot of irreversible block ${n} is ${name}", ("n", ps->block_num)("name", ps->final_path.generic_string()) );
+               const producer_plugin::snapshot_information info{ ps->block_id, ps->final_path.generic_string() };
+               for( const auto& next : ps->next )
+                  next( info );
+            }
+         }
       }
 
       template<typename Type, typename Channel, typename F>
@@ -331,12 +397,24 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          }
       }
 
-      std::deque<std::tuple<packed_transaction_ptr, bool, next_function<transaction_trace_ptr>>> _pending_incoming_transactions;
+      std::deque<std::tuple<transaction_metadata_ptr, packed_transaction_ptr, bool, next_function<transaction_trace_ptr>>> _pending_incoming_transactions;
 
       void on_incoming_transaction_async(const packed_transaction_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
+         chain::controller& chain = app().get_plugin<chain_plugin>().chain();
+         auto mtrx = std::make_shared<transaction_metadata>(*trx);
+         // once the signing keys are recovered on the thread pool, hand the transaction back to the main thread
+         transaction_metadata::create_signing_keys_future( mtrx, chain.get_thread_pool(), chain.get_chain_id(),
+               [self = this, mtrx, trx, persist_until_expired, next]() {
+            app().post( priority::medium, [self, mtrx, trx, persist_until_expired, next]() {
+               self->process_incoming_transaction_async( mtrx, trx, persist_until_expired, next );
+            });
+         });
+      }
+
+      void process_incoming_transaction_async(const transaction_metadata_ptr& mtrx, const packed_transaction_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
          chain::controller& chain = app().get_plugin<chain_plugin>().chain();
          if (!chain.pending_block_state()) {
-            _pending_incoming_transactions.emplace_back(trx, persist_until_expired, next);
+            _pending_incoming_transactions.emplace_back(mtrx, trx, persist_until_expired, next);
             return;
          }
 
@@ -370,10 +448,10 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          }
 
          try {
-            auto trace = chain.push_transaction(std::make_shared<transaction_metadata>(*trx), deadline);
+            auto trace = chain.push_transaction(mtrx, deadline);
             if (trace->except) {
                if (failure_is_subjective(*trace->except, deadline_is_subjective)) {
-                  _pending_incoming_transactions.emplace_back(trx, persist_until_expired, next);
+                  _pending_incoming_transactions.emplace_back(mtrx, trx, persist_until_expired, next);
                } else {
                   auto e_ptr = trace->except->dynamic_copy_exception();
                   send_response(e_ptr);
@@ -488,6 +566,8 @@ void producer_plugin::set_program_options(
           "offset of last block producing time in micro second. Negative number results in blocks to go out sooner, and positive number results in blocks to go out later")
          ("incoming-defer-ratio", bpo::value<double>()->default_value(1.0),
           "ratio between incoming transations and deferred transactions when both are exhausted")
+         ("snapshots-dir", bpo::value<bfs::path>()->default_value("snapshots"),
+          "the location of the snapshots directory (absolute path or relative to application data dir)")
          ;
    config_file_options.add(producer_options);
 }
@@ -639,6 +719,12 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
       add_greylist_accounts(param);
    }
 
+   auto sd = options.at( "snapshots-dir" ).as<bfs::path>();
+   if( sd.is_relative() )
+      my->_snapshots_dir = app().data_dir() / sd;
+   else
+      my->_snapshots_dir = sd;
+
 } FC_LOG_AND_RETHROW() }
 
 void producer_plugin::plugin_startup()
@@ -668,6 +754,8 @@ void producer_plugin::plugin_startup()
       my->_irreversible_block_time = fc::time_point::maximum();
    }
 
+   my->_snapshot_thread_pool.emplace( 1 );
+
    if (!my->_producers.empty()) {
       ilog("Launching block production for ${n} producers at ${time}.", ("n", my->_producers.size())("time",fc::time_point::now()));
 
@@ -693,6 +781,10 @@ void producer_plugin::plugin_shutdown() {
 
    my->_accepted_block_connection.reset();
    my->_irreversible_block_connection.reset();
+
+   // let snapshots being written reach the disk, one whose block is not irreversible yet keeps its .pending- name
+   if( my->_snapshot_thread_pool )
+      my->_snapshot_thread_pool->join();
 }
 
 void producer_plugin::pause() {
@@ -807,6 +899,90 @@ void producer_plugin::set_whitelist_blacklist(const producer_plugin::whitelist_b
    if(params.key_blacklist.valid()) chain.set_key_blacklist(*params.key_blacklist);
 }
 
+void producer_plugin::create_snapshot(next_function<snapshot_information> next) {
+   chain::controller& chain = app().get_plugin<chain_plugin>().chain();
+
+   try {
+      // the snapshot is of the head block state, so the pending block is dropped while it is packed and production
+      // resumes from a fresh pending block afterwards
+      chain.abort_block();
+      auto reschedule = fc::make_scoped_exit([this](){
+         my->schedule_production_loop();
+      });
+
+      auto head_id = chain.head_block_id();
+      auto snapshot_path = my->_snapshots_dir / fc::format_string( "snapshot-${id}.bin", fc::mutable_variant_object()("id", head_id) );
+      auto temp_path     = my->_snapshots_dir / fc::format_string( ".pending-snapshot-${id}.bin", fc::mutable_variant_object()("id", head_id) );
+
+      BES_ASSERT( !fc::is_regular_file( snapshot_path ), snapshot_exists_exception,
+                  "snapshot named ${name} already exists", ("name", snapshot_path.generic_string()) );
+
+      for( const auto& ps : my->_pending_snapshots ) {
+         if( ps->block_id == head_id ) {
+            ps->next.emplace_back( next );
+            return;
+         }
+      }
+
+      if( !fc::is_directory( my->_snapshots_dir ) )
+         fc::create_directories( my->_snapshots_dir );
+
+      auto ps = std::make_shared<producer_plugin_impl::pending_snapshot>();
+      ps->block_id     = head_id;
+      ps->block_num    = chain.head_block_num();
+      ps->pending_path = temp_path;
+      ps->final_path   = snapshot_path;
+      ps->next.emplace_back( next );
+
+      // rows are packed into memory here, the only place the database is not changing underneath them; hashing,
+      // writing and waiting for the disk happen on the snapshot thread
+      auto out    = std::make_shared<std::ofstream>( temp_path.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc );
+      auto writer = std::make_shared<chain::snapshot_writer>( *out, chain.get_chain_id(), 0 );
+      auto start  = fc::time_point::now();
+      chain.write_snapshot( *writer );
+      ilog( "packed snapshot of block ${n} (${bytes} bytes) in ${ms} ms",
+            ("n", ps->block_num)("bytes", writer->size())("ms", (fc::time_point::now() - start).count() / 1000) );
+
+      my->_pending_snapshots.emplace_back( ps );
+      boost::asio::post( *my->_snapshot_thread_pool, [self = my, ps, out, writer]() mutable {
+         fc::exception_ptr error;
+         auto set_error = [&error]( const fc::exception_ptr& e ) { error = e; };
+         try {
+            auto start = fc::time_point::now();
+            writer->finalize();
+            out->close();
+            BES_ASSERT( !out->fail(), snapshot_finalization_exception, "failed to write snapshot ${name}",
+                        ("name", ps->pending_path.generic_string()) );
+            ilog( "wrote snapshot of block ${n} (${bytes} bytes) in ${ms} ms",
+                  ("n", ps->block_num)("bytes", writer->size())("ms", (fc::time_point::now() - start).count() / 1000) );
+         } CATCH_AND_CALL( set_error );
+         // the writer still refers to the stream
+         writer.reset();
+         out.reset();
+
+         app().post( priority::medium, [self, ps, error]() {
+            ps->written = true;
+            ps->error = error;
+            self->finalize_pending_snapshots();
+         });
+      });
+   } CATCH_AND_CALL( next );
+}
+
+std::vector<producer_plugin::queue_stats> producer_plugin::get_queue_stats() const {
+   std::vector<queue_stats> result;
+   for( const auto& s : app().get_priority_queue().get_stats() ) {
+      queue_stats q;
+      q.priority = s.first;
+      q.depth = s.second.depth;
+      q.max_depth = s.second.max_depth;
+      q.executed = s.second.executed;
+      q.average_latency_us = s.second.executed ? s.second.total_latency.count() / s.second.executed : 0;
+      q.max_latency_us = s.second.max_latency.count();
+      result.emplace_back( q );
+   }
+   return result;
+}
 
 optional<fc::time_point> producer_plugin_impl::calculate_next_block_time(const account_name& producer_name, const block_timestamp_type& current_block_time) const {
    chain::controller& chain = app().get_plugin<chain_plugin>().chain();
@@ -1067,7 +1243,7 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block(bool
                   _pending_incoming_transactions.pop_front();
                   --orig_pending_txn_size;
                   _incoming_trx_weight -= 1.0;
-                  on_incoming_transaction_async(std::get<0>(e), std::get<1>(e), std::get<2>(e));
+                  process_incoming_transaction_async(std::get<0>(e), std::get<1>(e), std::get<2>(e), std::get<3>(e));
                }
 
                if (block_time <= fc::time_point::now()) {
@@ -1116,7 +1292,7 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block(bool
                auto e = _pending_incoming_transactions.front();
                _pending_incoming_transactions.pop_front();
                --orig_pending_txn_size;
-               on_incoming_transaction_async(std::get<0>(e), std::get<1>(e), std::get<2>(e));
+               process_incoming_transaction_async(std::get<0>(e), std::get<1>(e), std::get<2>(e), std::get<3>(e));
                if (block_time <= fc::time_point::now()) return start_block_result::exhausted;
             }
             return start_block_result::succeeded;
@@ -1145,12 +1321,12 @@ void producer_plugin_impl::schedule_production_loop() {
       _timer.expires_from_now( boost::posix_time::microseconds( config::block_interval_us  / 10 ));
 
       // we failed to start a block, so try again later?
-      _timer.async_wait([weak_this,cid=++_timer_corelation_id](const boost::system::error_code& ec) {
+      _timer.async_wait( app().get_priority_queue().wrap( priority::high, [weak_this,cid=++_timer_corelation_id](const boost::system::error_code& ec) {
          auto self = weak_this.lock();
          if (self && ec != boost::asio::error::operation_aborted && cid == self->_timer_corelation_id) {
             self->schedule_production_loop();
          }
-      });
+      } ) );
    } else if (result == start_block_result::waiting){
       if (!_producers.empty() && !production_disabled_by_policy()) {
          fc_dlog(_log, "Waiting till another block is received and scheduling Speculative/Production Change");
@@ -1183,7 +1359,7 @@ void producer_plugin_impl::schedule_production_loop() {
          }
       }
 
-      _timer.async_wait([&chain,weak_this,cid=++_timer_corelation_id](const boost::system::error_code& ec) {
+      _timer.async_wait( app().get_priority_queue().wrap( priority::high, [&chain,weak_this,cid=++_timer_corelation_id](const boost::system::error_code& ec) {
          auto self = weak_this.lock();
          if (self && ec != boost::asio::error::operation_aborted && cid == self->_timer_corelation_id) {
             // pending_block_state expected, but can't assert inside async_wait
@@ -1191,7 +1367,7 @@ void producer_plugin_impl::schedule_production_loop() {
             auto res = self->maybe_produce_block();
             fc_dlog(_log, "Producing Block #${num} returned: ${res}", ("num", block_num)("res", res));
          }
-      });
+      } ) );
    } else if (_pending_block_mode == pending_block_mode::speculating && !_producers.empty() && !production_disabled_by_policy()){
       fc_dlog(_log, "Specualtive Block Created; Scheduling Speculative/Production Change");
       BES_ASSERT( chain.pending_block_state(), missing_pending_block_state, "speculating without pending_block_state" );
@@ -1222,12 +1398,12 @@ void producer_plugin_impl::schedule_delayed_production_loop(const std::weak_ptr<
       fc_dlog(_log, "Scheduling Speculative/Production Change at ${time}", ("time", wake_up_time));
       static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
       _timer.expires_at(epoch + boost::posix_time::microseconds(wake_up_time->time_since_epoch().count()));
-      _timer.async_wait([weak_this,cid=++_timer_corelation_id](const boost::system::error_code& ec) {
+      _timer.async_wait( app().get_priority_queue().wrap( priority::high, [weak_this,cid=++_timer_corelation_id](const boost::system::error_code& ec) {
          auto self = weak_this.lock();
          if (self && ec != boost::asio::error::operation_aborted && cid == self->_timer_corelation_id) {
             self->schedule_production_loop();
          }
-      });
+      } ) );
    } else {
       fc_dlog(_log, "Not Scheduling Speculative/Production, no local producers had valid wake up times");
    }
@@ -44,7 +44,7 @@ using namespace besio::chain;
           try { \
              if (body.empty()) body = "{}"; \
              INVOKE \
-             cb(http_response_code, fc::json::to_string(result)); \
+             cb(http_response_code, fc::variant(result)); \
           } catch (...) { \
              http_plugin::handle_exception(#api_name, #call_name, body, cb); \
           } \
@@ -76,7 +76,7 @@ using namespace besio::chain;
                http_plugin::handle_exception(#api_name, #call_name, body, cb);\
             }\
          } else {\
-            cb(http_response_code, fc::json::to_string(besio::detail::txn_test_gen_empty())); \
+            cb(http_response_code, fc::variant(besio::detail::txn_test_gen_empty())); \
          }\
       };\
       INVOKE \
@@ -2006,6 +2006,7 @@ int main( int argc, char** argv ) {
    bool binary = false;
    uint32_t limit = 10;
    string index_position;
+   string continuation;
    auto getTable = get->add_subcommand( "table", localized("Retrieve the contents of a database table"), false);
    getTable->add_option( "contract", code, localized("The contract who owns the table") )->required();
    getTable->add_option( "scope", scope, localized("The scope within the contract in which the table is found") )->required();
@@ -2024,6 +2025,8 @@ int main( int argc, char** argv ) {
    getTable->add_option( "--encode-type", encode_type,
                          localized("The encoding type of key_type (i64 , i128 , float64, float128) only support decimal encoding e.g. 'dec'"
                                     "i256 - supports both 'dec' and 'hex', ripemd160 and sha256 is 'hex' only\n"));
+   getTable->add_option( "--continuation", continuation,
+                         localized("Resume from the continuation returned by a previous call that reported more rows; overrides --lower"));
 
 
    getTable->set_callback([&] {
@@ -2038,6 +2041,7 @@ int main( int argc, char** argv ) {
                          ("key_type",key_type)
                          ("index_position", index_position)
                          ("encode_type", encode_type)
+                         ("continuation", continuation)
                          );
 
       std::cout << fc::json::to_pretty_string(result)
@@ -10,6 +10,7 @@
 
 #include <fc/log/logger_config.hpp>
 #include <fc/exception/exception.hpp>
+#include <fc/variant_object.hpp>
 
 #include <boost/exception/diagnostic_information.hpp>
 
@@ -43,7 +44,7 @@ int main(int argc, char** argv)
       if(!app().initialize<wallet_plugin, wallet_api_plugin, http_plugin>(argc, argv))
          return -1;
       auto& http = app().get_plugin<http_plugin>();
-      http.add_handler("/v1/kbesd/stop", [](string, string, url_response_callback cb) { cb(200, "{}"); std::raise(SIGTERM); } );
+      http.add_handler("/v1/kbesd/stop", [](string, string, url_response_callback cb) { cb(200, fc::variant(fc::variant_object())); std::raise(SIGTERM); } );
       app().startup();
       app().exec();
    } catch (const fc::exception& e) {
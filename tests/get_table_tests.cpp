@@ -0,0 +1,250 @@
+/**
+ *  @file
+ *  @copyright defined in bes/LICENSE.txt
+ */
+#include <boost/test/unit_test.hpp>
+#include <besio/testing/tester.hpp>
+#include <besio/chain/contract_table_objects.hpp>
+#include <besio/chain/exceptions.hpp>
+#include <besio/chain_plugin/chain_plugin.hpp>
+
+#include <fc/io/json.hpp>
+
+#include <algorithm>
+
+using namespace besio;
+using namespace besio::chain;
+using namespace besio::testing;
+using namespace besio::chain_apis;
+
+namespace {
+
+   const char* rows_abi = R"=====(
+   {
+      "version": "besio::abi/1.0",
+      "types": [],
+      "structs": [{
+         "name": "row",
+         "base": "",
+         "fields": [
+            {"name": "id",  "type": "uint64"},
+            {"name": "sec", "type": "uint64"}
+         ]
+      }],
+      "actions": [],
+      "tables": [{
+         "name": "rows",
+         "index_type": "i64",
+         "key_names": ["id"],
+         "key_types": ["uint64"],
+         "type": "row"
+      }],
+      "ricardian_clauses": [],
+      "abi_extensions": []
+   }
+   )=====";
+
+   /**
+    *  A table whose rows are written straight into the state database, with a secondary index on which runs of
+    *  four rows share a key, in the opposite order of the primary keys.
+    */
+   class table_tester : public tester {
+      public:
+         table_tester() {
+            produce_blocks(2);
+            create_accounts( {N(tbl)} );
+            set_abi( N(tbl), rows_abi );
+            produce_block();
+         }
+
+         static uint64_t secondary_of( uint64_t id ) { return (1000 - id) / 4; }
+
+         void add_rows( uint64_t count ) {
+            auto& db = control->db();
+            const auto* t = db.find<table_id_object, by_code_scope_table>( boost::make_tuple( N(tbl), N(tbl), N(rows) ) );
+            if( t == nullptr ) {
+               t = &db.create<table_id_object>( []( auto& t ) {
+                  t.code  = N(tbl);
+                  t.scope = N(tbl);
+                  t.table = N(rows);
+                  t.payer = N(tbl);
+               } );
+            }
+            for( uint64_t id = 0; id < count; ++id ) {
+               auto data = fc::raw::pack( std::make_pair( id, secondary_of( id ) ) );
+               db.create<key_value_object>( [&]( auto& o ) {
+                  o.t_id        = t->id;
+                  o.primary_key = id;
+                  o.payer       = N(tbl);
+                  o.value.assign( data.data(), data.size() );
+               } );
+               db.create<index64_object>( [&]( auto& o ) {
+                  o.t_id          = t->id;
+                  o.primary_key   = id;
+                  o.payer         = N(tbl);
+                  o.secondary_key = secondary_of( id );
+               } );
+               db.create<index_long_double_object>( [&]( auto& o ) {
+                  o.t_id          = t->id;
+                  o.primary_key   = id;
+                  o.payer         = N(tbl);
+                  o.secondary_key = ui64_to_f128( secondary_of( id ) );
+               } );
+            }
+         }
+
+         void remove_row( uint64_t id ) {
+            auto& db = control->db();
+            const auto& t = db.get<table_id_object, by_code_scope_table>( boost::make_tuple( N(tbl), N(tbl), N(rows) ) );
+            db.remove( db.get<key_value_object, by_scope_primary>( boost::make_tuple( t.id, id ) ) );
+            db.remove( db.get<index64_object, by_primary>( boost::make_tuple( t.id, id ) ) );
+            db.remove( db.get<index_long_double_object, by_primary>( boost::make_tuple( t.id, id ) ) );
+         }
+
+         void remove_table() {
+            auto& db = control->db();
+            const auto& t = db.get<table_id_object, by_code_scope_table>( boost::make_tuple( N(tbl), N(tbl), N(rows) ) );
+            const auto& rows = db.get_index<key_value_index, by_scope_primary>();
+            for( auto itr = rows.lower_bound( boost::make_tuple( t.id ) ); itr != rows.end() && itr->t_id == t.id; itr = rows.lower_bound( boost::make_tuple( t.id ) ) )
+               remove_row( itr->primary_key );
+            db.remove( t );
+         }
+
+         read_only get_api( uint32_t table_rows_max_bytes = read_only::default_table_rows_max_bytes ) {
+            return read_only( *control, abi_serializer_max_time, table_rows_max_bytes );
+         }
+   };
+
+   read_only::get_table_rows_params rows_params( bool secondary, uint32_t limit, const string& key_type = "i64" ) {
+      read_only::get_table_rows_params p;
+      p.json  = true;
+      p.code  = N(tbl);
+      p.scope = "tbl";
+      p.table = N(rows);
+      p.limit = limit;
+      if( secondary ) {
+         p.key_type       = key_type;
+         p.index_position = "secondary";
+      }
+      return p;
+   }
+
+   vector<uint64_t> ids_of( const read_only::get_table_rows_result& result ) {
+      vector<uint64_t> ids;
+      for( const auto& row : result.rows )
+         ids.push_back( row["id"].as_uint64() );
+      return ids;
+   }
+
+   /// the primary keys of the rows in the order the index walks them
+   vector<uint64_t> expected_ids( uint64_t count, bool secondary ) {
+      vector<uint64_t> ids( count );
+      for( uint64_t id = 0; id < count; ++id )
+         ids[id] = id;
+      if( secondary ) {
+         std::sort( ids.begin(), ids.end(), []( uint64_t a, uint64_t b ) {
+            return std::make_pair( table_tester::secondary_of( a ), a ) < std::make_pair( table_tester::secondary_of( b ), b );
+         } );
+      }
+      return ids;
+   }
+
+   /// follows the continuations until the whole range has been read, checking every page against its bound
+   vector<uint64_t> read_all( const read_only& api, read_only::get_table_rows_params p, uint32_t& pages ) {
+      vector<uint64_t> ids;
+      pages = 0;
+      while( true ) {
+         auto result = api.get_table_rows( p );
+         ++pages;
+         auto page = ids_of( result );
+         BOOST_REQUIRE_LE( page.size(), p.limit );
+         ids.insert( ids.end(), page.begin(), page.end() );
+         BOOST_REQUIRE_EQUAL( result.more, !result.continuation.empty() );
+         if( !result.more )
+            break;
+         p.continuation = result.continuation;
+      }
+      return ids;
+   }
+
+}
+
+BOOST_AUTO_TEST_SUITE(get_table_tests)
+
+BOOST_FIXTURE_TEST_CASE( continuation_reads_every_row_once, table_tester ) try {
+   add_rows( 50 );
+
+   for( bool secondary : {false, true} ) {
+      uint32_t pages = 0;
+      BOOST_CHECK( read_all( get_api(), rows_params( secondary, 7 ), pages ) == expected_ids( 50, secondary ) );
+      BOOST_CHECK_EQUAL( pages, 8 );
+
+      // a byte budget smaller than a row returns one row per page
+      BOOST_CHECK( read_all( get_api( 1 ), rows_params( secondary, 100 ), pages ) == expected_ids( 50, secondary ) );
+      BOOST_CHECK_EQUAL( pages, 50 );
+
+      // the last page of a range that fits carries no continuation
+      auto result = get_api().get_table_rows( rows_params( secondary, 100 ) );
+      BOOST_CHECK_EQUAL( result.rows.size(), 50 );
+      BOOST_CHECK( !result.more );
+      BOOST_CHECK( result.continuation.empty() );
+
+      // a limit of 0 does not limit the number of rows
+      result = get_api().get_table_rows( rows_params( secondary, 0 ) );
+      BOOST_CHECK( ids_of( result ) == expected_ids( 50, secondary ) );
+      BOOST_CHECK( !result.more );
+   }
+
+   // the continuation of a float128 index holds the two words of the key
+   uint32_t pages = 0;
+   BOOST_CHECK( read_all( get_api(), rows_params( true, 7, "float128" ), pages ) == expected_ids( 50, true ) );
+   BOOST_CHECK_EQUAL( pages, 8 );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( continuation_invalid, table_tester ) try {
+   add_rows( 10 );
+   auto api = get_api();
+
+   auto primary_continuation = api.get_table_rows( rows_params( false, 3 ) ).continuation;
+   auto secondary_continuation = api.get_table_rows( rows_params( true, 3 ) ).continuation;
+   BOOST_REQUIRE( !primary_continuation.empty() && !secondary_continuation.empty() );
+
+   for( bool secondary : {false, true} ) {
+      auto p = rows_params( secondary, 3 );
+      const auto& valid = secondary ? secondary_continuation : primary_continuation;
+      const auto& other = secondary ? primary_continuation : secondary_continuation;
+      for( const auto& bad : { string("zz"), valid.substr( 1 ), valid + "0", string( valid.size(), 'g' ), other } ) {
+         p.continuation = bad;
+         BOOST_CHECK_THROW( api.get_table_rows( p ), contract_table_query_exception );
+      }
+   }
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( continuation_after_rows_removed, table_tester ) try {
+   add_rows( 20 );
+   auto api = get_api();
+
+   for( bool secondary : {false, true} ) {
+      const auto expected = expected_ids( 20, secondary );
+      auto p = rows_params( secondary, 5 );
+      auto first = api.get_table_rows( p );
+      BOOST_REQUIRE( first.more );
+
+      // the row the continuation points at is gone; the scan resumes at the row after it
+      remove_row( expected[5] );
+      p.continuation = first.continuation;
+      auto second = api.get_table_rows( p );
+      BOOST_CHECK( ids_of( second ) == vector<uint64_t>( expected.begin() + 6, expected.begin() + 11 ) );
+
+      // the whole table is gone; the continuation finds nothing instead of failing
+      remove_table();
+      p.continuation = second.continuation;
+      auto third = api.get_table_rows( p );
+      BOOST_CHECK( third.rows.empty() );
+      BOOST_CHECK( !third.more );
+
+      add_rows( 20 );
+   }
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,109 @@
+/**
+ *  @file
+ *  @copyright defined in bes/LICENSE.txt
+ */
+#include <boost/test/unit_test.hpp>
+#include <besio/testing/tester.hpp>
+#include <besio/chain/abi_serializer.hpp>
+
+#include <besio.system/besio.system.abi.hpp>
+#include <besio.token/besio.token.abi.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+using namespace besio;
+using namespace besio::chain;
+using namespace besio::testing;
+
+using mvo = fc::mutable_variant_object;
+
+namespace {
+
+   const fc::microseconds max_serialization_time = fc::seconds(1); // some test machines are very slow
+   const uint32_t         benchmark_iterations = 5000;
+
+   /**
+    *  Encodes var as type once, then decodes and re-encodes it benchmark_iterations times.
+    *  Every round trip must reproduce the original bytes; throughput is reported as a test message.
+    */
+   void benchmark_round_trip( const abi_serializer& abis, const char* contract, const type_name& type, const fc::variant& var ) {
+      const bytes packed = abis.variant_to_binary( type, var, max_serialization_time );
+
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < benchmark_iterations; ++i ) {
+         auto decoded = abis.binary_to_variant( type, packed, max_serialization_time );
+         BOOST_REQUIRE( decoded.is_object() );
+      }
+      auto decode_time = fc::time_point::now() - start;
+
+      const auto decoded = abis.binary_to_variant( type, packed, max_serialization_time );
+      start = fc::time_point::now();
+      for( uint32_t i = 0; i < benchmark_iterations; ++i ) {
+         BOOST_REQUIRE( abis.variant_to_binary( type, decoded, max_serialization_time ) == packed );
+      }
+      auto encode_time = fc::time_point::now() - start;
+
+      auto per_second = []( const fc::microseconds& t ) {
+         return t.count() > 0 ? benchmark_iterations * 1000000ull / t.count() : 0ull;
+      };
+      BOOST_TEST_MESSAGE( contract << "::" << type << ": " << packed.size() << " bytes, "
+                          << per_second( decode_time ) << " decodes/s, "
+                          << per_second( encode_time ) << " encodes/s" );
+   }
+
+}
+
+BOOST_AUTO_TEST_SUITE(abi_benchmark_tests)
+
+BOOST_AUTO_TEST_CASE(token_actions)
+{ try {
+   abi_serializer abis( fc::json::from_string( besio_token_abi ).as<abi_def>(), max_serialization_time );
+
+   benchmark_round_trip( abis, "besio.token", "transfer", mvo()
+      ("from", "alice")
+      ("to", "bob")
+      ("quantity", "1.0000 TKN")
+      ("memo", "benchmark transfer memo") );
+
+   benchmark_round_trip( abis, "besio.token", "issue", mvo()
+      ("to", "alice")
+      ("quantity", "1000.0000 TKN")
+      ("memo", "") );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(system_actions)
+{ try {
+   abi_serializer abis( fc::json::from_string( besio_system_abi ).as<abi_def>(), max_serialization_time );
+
+   benchmark_round_trip( abis, "besio.system", "buyram", mvo()
+      ("payer", "alice")
+      ("receiver", "bob")
+      ("quant", "10.0000 TKN") );
+
+   benchmark_round_trip( abis, "besio.system", "delegatebw", mvo()
+      ("from", "alice")
+      ("receiver", "bob")
+      ("stake_net_quantity", "10.0000 TKN")
+      ("stake_cpu_quantity", "10.0000 TKN")
+      ("transfer", 0) );
+
+   benchmark_round_trip( abis, "besio.system", "voteproducer", mvo()
+      ("voter", "alice")
+      ("proxy", "")
+      ("producers", vector<account_name>{ N(produceraaaa), N(producerbbbb), N(producercccc), N(producerdddd) }) );
+
+   benchmark_round_trip( abis, "besio.system", "newaccount", mvo()
+      ("creator", "alice")
+      ("name", "carol")
+      ("owner", authority( base_tester::get_public_key( N(carol), "owner" ) ))
+      ("active", authority( base_tester::get_public_key( N(carol), "active" ) )) );
+
+   benchmark_round_trip( abis, "besio.system", "regproducer", mvo()
+      ("producer", "produceraaaa")
+      ("producer_key", base_tester::get_public_key( N(produceraaaa), "active" ))
+      ("url", "https://produceraaaa.example")
+      ("location", 1) );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
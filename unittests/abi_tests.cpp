@@ -34,6 +34,18 @@ BOOST_AUTO_TEST_SUITE(abi_tests)
 
 fc::microseconds max_serialization_time = fc::seconds(1); // some test machines are very slow
 
+// verify that the compiled serialization plans produce exactly what the type name based paths produce
+void verify_compiled_matches_legacy( const abi_serializer& abis, const type_name& type, const fc::variant& var )
+{
+   abi_serializer legacy = abis;
+   legacy.set_use_compiled_types(false);
+
+   auto bytes = abis.variant_to_binary(type, var, max_serialization_time);
+   BOOST_TEST( fc::to_hex(bytes) == fc::to_hex(legacy.variant_to_binary(type, var, max_serialization_time)) );
+   BOOST_TEST( fc::json::to_string(abis.binary_to_variant(type, bytes, max_serialization_time)) ==
+               fc::json::to_string(legacy.binary_to_variant(type, bytes, max_serialization_time)) );
+}
+
 // verify that round trip conversion, via bytes, reproduces the exact same data
 fc::variant verify_byte_round_trip_conversion( const abi_serializer& abis, const type_name& type, const fc::variant& var )
 {
@@ -47,6 +59,8 @@ fc::variant verify_byte_round_trip_conversion( const abi_serializer& abis, const
 
    BOOST_TEST( fc::to_hex(bytes) == fc::to_hex(bytes2) );
 
+   verify_compiled_matches_legacy(abis, type, var);
+
    return var2;
 }
 
@@ -3471,4 +3485,66 @@ BOOST_AUTO_TEST_CASE(abi_deep_structs_validate)
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE(abi_compiled_typedef_optional)
+{
+   try {
+      const char* abi_str = R"=====(
+      {
+        "types": [{
+            "new_type_name": "maybe_point",
+            "type": "point?"
+          },{
+            "new_type_name": "maybe_count",
+            "type": "uint32?"
+          }
+        ],
+        "structs": [
+          {
+            "name": "point",
+            "base": "",
+            "fields": [
+              {"name": "x", "type": "int32"},
+              {"name": "y", "type": "int32"}
+            ]
+          },
+          {
+            "name": "shape",
+            "base": "",
+            "fields": [
+              {"name": "count", "type": "maybe_count"},
+              {"name": "center", "type": "maybe_point"}
+            ]
+          }
+        ],
+        "actions": [],
+        "tables": []
+      }
+      )=====";
+
+      abi_serializer abis(fc::json::from_string(abi_str).as<abi_def>(), max_serialization_time);
+      abi_serializer legacy = abis;
+      legacy.set_use_compiled_types(false);
+
+      // an optional struct reached through a typedef is reported under its resolved name on both paths
+      auto shape = fc::json::from_string(R"({"count":3,"center":{"x":1,"y":2}})");
+      auto is_unknown_point = [](const fc::exception& e) -> bool {
+         return e.get_log().at(0).get_message() == "Unknown struct point?";
+      };
+      BOOST_CHECK_EXCEPTION( abis.variant_to_binary("shape", shape, max_serialization_time), invalid_type_inside_abi,
+                             is_unknown_point );
+      BOOST_CHECK_EXCEPTION( legacy.variant_to_binary("shape", shape, max_serialization_time), invalid_type_inside_abi,
+                             is_unknown_point );
+
+      // and unpacked the same way
+      bytes packed = { 1, 3, 0, 0, 0, 1, 1, 0, 0, 0, 2, 0, 0, 0 };
+      BOOST_CHECK_EQUAL( fc::json::to_string(abis.binary_to_variant("shape", packed, max_serialization_time)),
+                         fc::json::to_string(legacy.binary_to_variant("shape", packed, max_serialization_time)) );
+      BOOST_CHECK_EQUAL( fc::json::to_string(abis.binary_to_variant("shape", packed, max_serialization_time)),
+                         R"({"count":3,"center":{"x":1,"y":2}})" );
+
+      verify_compiled_matches_legacy(abis, "maybe_count", fc::variant());
+      verify_compiled_matches_legacy(abis, "maybe_count", fc::variant(7));
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
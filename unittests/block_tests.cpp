@@ -5,6 +5,13 @@
 
 #include <boost/test/unit_test.hpp>
 #include <besio/testing/tester.hpp>
+#include <besio/chain/snapshot.hpp>
+#include <besio/chain/block_log.hpp>
+
+#include <fc/io/fstream.hpp>
+
+#include <fstream>
+#include <thread>
 
 using namespace besio;
 using namespace testing;
@@ -50,4 +57,394 @@ BOOST_AUTO_TEST_CASE(block_with_invalid_tx_test)
   
 }
 
+BOOST_AUTO_TEST_CASE(block_log_random_access_test)
+{ try {
+   tester main;
+
+   main.create_account(N(newacc));
+   std::vector<signed_block_ptr> blocks;
+   for( int i = 0; i < 20; ++i )
+      blocks.push_back( main.produce_block() );
+
+   const auto lib = main.control->last_irreversible_block_num();
+   BOOST_REQUIRE( lib > blocks.front()->block_num() );
+
+   for( const auto& b : blocks ) {
+      auto serialized = main.control->fetch_serialized_block_by_number( b->block_num() );
+      if( b->block_num() > lib ) {
+         // reversible blocks are not in the block log yet
+         BOOST_REQUIRE( serialized.first == nullptr );
+         continue;
+      }
+
+      BOOST_REQUIRE( serialized.first != nullptr );
+      const auto packed = fc::raw::pack( *b );
+      BOOST_REQUIRE_EQUAL( serialized.second, packed.size() );
+      BOOST_REQUIRE( std::equal( packed.begin(), packed.end(), serialized.first ) );
+
+      auto read = main.control->fetch_block_by_number( b->block_num() );
+      BOOST_REQUIRE_EQUAL( read->id(), b->id() );
+   }
+
+   BOOST_REQUIRE( main.control->fetch_serialized_block_by_number( main.control->head_block_num() + 1 ).first == nullptr );
+} FC_LOG_AND_RETHROW() }
+
+/**
+ * Prove that a chunked block log serves pending and sealed blocks alike, survives reopening and repair,
+ * and keeps the headers of the blocks it prunes
+ */
+BOOST_AUTO_TEST_CASE(chunked_block_log_test)
+{ try {
+   tester main;
+   main.create_account(N(newacc));
+   main.produce_blocks(30);
+
+   std::vector<signed_block_ptr> blocks;
+   for( uint32_t n = 1; n <= main.control->last_irreversible_block_num(); ++n )
+      blocks.push_back( main.control->fetch_block_by_number( n ) );
+   BOOST_REQUIRE( blocks.size() > 20 );
+
+   fc::temp_directory tempdir;
+   auto dir = tempdir.path() / "blocks";
+   block_log_config cfg;
+   cfg.chunk_blocks = 4;
+
+   auto check_blocks = [&]( const block_log& log, uint32_t pruned_through ) {
+      BOOST_REQUIRE_EQUAL( log.head()->id(), blocks.back()->id() );
+      for( const auto& b : blocks ) {
+         auto header = log.read_block_header_by_num( b->block_num() );
+         BOOST_REQUIRE( header.valid() );
+         BOOST_REQUIRE_EQUAL( header->id(), b->id() );
+
+         auto serialized = log.read_serialized_block_by_num( b->block_num() );
+         if( b->block_num() <= pruned_through ) {
+            BOOST_REQUIRE( serialized.first == nullptr );
+            BOOST_REQUIRE( log.read_block_by_num( b->block_num() ) == nullptr );
+            continue;
+         }
+         const auto packed = fc::raw::pack( *b );
+         BOOST_REQUIRE_EQUAL( serialized.second, packed.size() );
+         BOOST_REQUIRE( std::equal( packed.begin(), packed.end(), serialized.first ) );
+         BOOST_REQUIRE_EQUAL( log.read_block_by_num( b->block_num() )->id(), b->id() );
+      }
+      BOOST_REQUIRE( log.read_block_by_num( blocks.back()->block_num() + 1 ) == nullptr );
+   };
+
+   {
+      block_log log( dir, cfg );
+      log.reset_to_genesis( main.get_config().genesis, blocks.front() );
+      for( size_t i = 1; i < blocks.size(); ++i ) {
+         auto pos = log.append( blocks[i] );
+         BOOST_REQUIRE_EQUAL( pos == block_log::npos, blocks[i]->block_num() % cfg.chunk_blocks != 0 );
+      }
+      check_blocks( log, 0 );
+   }
+   BOOST_REQUIRE_EQUAL( block_log::extract_genesis_state( dir ).initial_key, main.get_config().genesis.initial_key );
+
+   // the chunk format is kept however the log is reopened; its index is rebuilt if missing
+   fc::remove( dir / "blocks.index" );
+   {
+      block_log log( dir );
+      check_blocks( log, 0 );
+   }
+
+   auto backup_dir = block_log::repair_log( dir );
+   {
+      block_log log( dir );
+      check_blocks( log, 0 );
+   }
+   fc::remove_all( backup_dir );
+
+   // pruning takes effect once the next chunk is sealed
+   cfg.prune_blocks = 10;
+   blocks.push_back( main.produce_block() );
+   while( blocks.back()->block_num() % cfg.chunk_blocks != 0 )
+      blocks.push_back( main.produce_block() );
+   {
+      block_log log( dir, cfg );
+      for( auto b = blocks.end() - (blocks.back()->block_num() - log.head()->block_num()); b != blocks.end(); ++b )
+         log.append( *b );
+      uint32_t prune_through = blocks.back()->block_num() - cfg.prune_blocks;
+      check_blocks( log, prune_through - prune_through % cfg.chunk_blocks );
+   }
+} FC_LOG_AND_RETHROW() }
+
+/**
+ * Prove that a prune interrupted while rewriting a chunk in place is finished from its journal when the log is opened
+ */
+BOOST_AUTO_TEST_CASE(interrupted_prune_test)
+{ try {
+   tester main;
+   main.create_account(N(newacc));
+   main.produce_blocks(30);
+
+   std::vector<signed_block_ptr> blocks;
+   for( uint32_t n = 1; n <= main.control->last_irreversible_block_num(); ++n )
+      blocks.push_back( main.control->fetch_block_by_number( n ) );
+   BOOST_REQUIRE( blocks.size() > 20 );
+
+   // the same blocks in a log that prunes and in one that does not
+   fc::temp_directory tempdir;
+   auto pruned_dir = tempdir.path() / "pruned";
+   auto torn_dir = tempdir.path() / "torn";
+   block_log_config cfg;
+   cfg.chunk_blocks = 4;
+   for( const auto& dir : {pruned_dir, torn_dir} ) {
+      cfg.prune_blocks = dir == pruned_dir ? 8 : 0;
+      block_log log( dir, cfg );
+      log.reset_to_genesis( main.get_config().genesis, blocks.front() );
+      for( size_t i = 1; i < blocks.size(); ++i )
+         log.append( blocks[i] );
+   }
+   BOOST_REQUIRE( !fc::exists( pruned_dir / "blocks.log.prune" ) );
+
+   uint64_t pos;
+   string pruned_chunk;
+   {
+      block_log log( pruned_dir );
+      BOOST_REQUIRE( log.read_block_by_num( 1 ) == nullptr );
+      pos = log.get_block_pos( 1 );
+      BOOST_REQUIRE_EQUAL( pos, block_log( torn_dir ).get_block_pos( 1 ) );
+
+      // the pruned chunk as it is in the file: its header, whose payload_size is at offset 12, and its payload
+      string content;
+      fc::read_file_contents( pruned_dir / "blocks.log", content );
+      uint32_t payload_size;
+      memcpy( &payload_size, content.data() + pos + 12, sizeof(payload_size) );
+      pruned_chunk = content.substr( pos, 24 + payload_size );
+   }
+
+   // the prune of the first chunk was interrupted after its new header was written over the old payload
+   {
+      std::ofstream journal( (torn_dir / "blocks.log.prune").generic_string().c_str(), std::ios::binary );
+      journal.write( (const char*)&pos, sizeof(pos) );
+      journal.write( pruned_chunk.data(), pruned_chunk.size() );
+      std::fstream log( (torn_dir / "blocks.log").generic_string().c_str(), std::ios::in | std::ios::out | std::ios::binary );
+      log.seekp( pos );
+      log.write( pruned_chunk.data(), 24 );
+   }
+   // a journal that was never completed is dropped
+   fc::copy( torn_dir / "blocks.log.prune", torn_dir / "blocks.log.prune.tmp" );
+
+   {
+      block_log log( torn_dir );
+      BOOST_REQUIRE( !fc::exists( torn_dir / "blocks.log.prune" ) );
+      BOOST_REQUIRE( !fc::exists( torn_dir / "blocks.log.prune.tmp" ) );
+      for( const auto& b : blocks ) {
+         auto header = log.read_block_header_by_num( b->block_num() );
+         BOOST_REQUIRE( header.valid() );
+         BOOST_REQUIRE_EQUAL( header->id(), b->id() );
+         if( b->block_num() <= cfg.chunk_blocks )
+            BOOST_REQUIRE( log.read_block_by_num( b->block_num() ) == nullptr );
+         else
+            BOOST_REQUIRE_EQUAL( log.read_block_by_num( b->block_num() )->id(), b->id() );
+      }
+   }
+} FC_LOG_AND_RETHROW() }
+
+/**
+ * Prove that a rotating block log routes reads to its sealed segments wherever they are archived,
+ * and that a damaged segment index is rebuilt on its own
+ */
+BOOST_AUTO_TEST_CASE(rotating_block_log_test)
+{ try {
+   tester main;
+   main.produce_blocks(30);
+
+   std::vector<signed_block_ptr> blocks;
+   for( uint32_t n = 1; n <= main.control->last_irreversible_block_num(); ++n )
+      blocks.push_back( main.control->fetch_block_by_number( n ) );
+   BOOST_REQUIRE( blocks.size() > 20 );
+
+   for( uint32_t chunk_blocks : { 0, 4 } ) {
+      fc::temp_directory tempdir;
+      auto dir = tempdir.path() / "blocks";
+      block_log_config cfg;
+      cfg.chunk_blocks = chunk_blocks;
+      cfg.segment_blocks = 10;
+      cfg.archive_dir = "archive";
+
+      auto check_blocks = [&]( const block_log& log ) {
+         BOOST_REQUIRE_EQUAL( log.head()->id(), blocks.back()->id() );
+         BOOST_REQUIRE_EQUAL( log.read_head()->id(), blocks.back()->id() );
+         for( const auto& b : blocks ) {
+            const auto packed = fc::raw::pack( *b );
+            auto serialized = log.read_serialized_block_by_num( b->block_num() );
+            BOOST_REQUIRE_EQUAL( serialized.second, packed.size() );
+            BOOST_REQUIRE( std::equal( packed.begin(), packed.end(), serialized.first ) );
+            BOOST_REQUIRE_EQUAL( log.read_block_by_num( b->block_num() )->id(), b->id() );
+         }
+         BOOST_REQUIRE( log.read_block_by_num( blocks.back()->block_num() + 1 ) == nullptr );
+      };
+
+      auto segment = []( uint32_t first, uint32_t last, const char* ext ) {
+         char name[64];
+         snprintf( name, sizeof(name), "blocks-%010u-%010u.%s", first, last, ext );
+         return std::string( name );
+      };
+
+      {
+         block_log log( dir, cfg );
+         log.reset_to_genesis( main.get_config().genesis, blocks.front() );
+         for( size_t i = 1; i < blocks.size(); ++i )
+            log.append( blocks[i] );
+         check_blocks( log );
+
+         // the sealed segments are archived in the background and can be read all along
+         for( int i = 0; i < 500 && !fc::exists( dir / "archive" / segment( 11, 20, "log" ) ); ++i )
+            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+         BOOST_REQUIRE( fc::exists( dir / "archive" / segment( 1, 10, "log" ) ) );
+         BOOST_REQUIRE( fc::exists( dir / "archive" / segment( 11, 20, "index" ) ) );
+         BOOST_REQUIRE( !fc::exists( dir / segment( 1, 10, "log" ) ) );
+         check_blocks( log );
+      }
+      BOOST_REQUIRE_EQUAL( block_log::extract_genesis_state( dir ).initial_key, main.get_config().genesis.initial_key );
+
+      // only the damaged index is rebuilt
+      fc::resize_file( dir / "archive" / segment( 11, 20, "index" ), 16 );
+      {
+         block_log log( dir, cfg );
+         BOOST_REQUIRE_EQUAL( fc::file_size( dir / "archive" / segment( 11, 20, "index" ) ), 10 * sizeof(uint64_t) );
+         check_blocks( log );
+      }
+
+      // a crash right after blocks.log was sealed leaves no blocks.log behind
+      if( blocks.back()->block_num() % cfg.segment_blocks != 0 ) {
+         fc::remove( dir / "blocks.log" );
+         fc::remove( dir / "blocks.index" );
+         fc::remove( dir / "blocks.pending" );
+         block_log log( dir, cfg );
+         auto last_sealed = blocks.back()->block_num() - blocks.back()->block_num() % cfg.segment_blocks;
+         BOOST_REQUIRE_EQUAL( log.head()->block_num(), last_sealed );
+         BOOST_REQUIRE( log.read_block_by_num( last_sealed + 1 ) == nullptr );
+         for( uint32_t n = last_sealed + 1; n <= blocks.back()->block_num(); ++n )
+            log.append( blocks[n - 1] );
+         check_blocks( log );
+      }
+   }
+} FC_LOG_AND_RETHROW() }
+
+/**
+ * Prove that replaying through the read ahead pipeline, with signing keys recovered on the thread pool,
+ * rebuilds the chain that was produced
+ */
+BOOST_FIXTURE_TEST_CASE(pipelined_replay_test, tester)
+{ try {
+   for( int i = 0; i < 10; ++i ) {
+      create_account( name( string("replay") + char('a' + i) ) );
+      produce_block();
+   }
+   produce_blocks(5);
+
+   const auto lib = control->last_irreversible_block_num();
+   const auto lib_id = control->fetch_block_by_number( lib )->id();
+   BOOST_REQUIRE( lib > 10 );
+
+   close();
+   fc::remove_all( cfg.state_dir );
+   fc::remove_all( cfg.blocks_dir / config::reversible_blocks_dir_name );
+   cfg.replay_read_ahead = 3;
+   cfg.force_all_checks = true;
+   open();
+
+   BOOST_REQUIRE_EQUAL( control->head_block_num(), lib );
+   BOOST_REQUIRE_EQUAL( control->head_block_id(), lib_id );
+   BOOST_REQUIRE( (control->db().find<account_object,by_name>( N(replayj) ) != nullptr) );
+
+   create_account( N(afterreplay) );
+   produce_block();
+} FC_LOG_AND_RETHROW() }
+
+/**
+ * Prove that a trusted replay rebuilds the same chain, and that the checkpoints it writes can be resumed from
+ */
+BOOST_FIXTURE_TEST_CASE(trusted_replay_checkpoint_test, tester)
+{ try {
+   for( int i = 0; i < 10; ++i ) {
+      create_account( name( string("trusted") + char('a' + i) ) );
+      produce_block();
+   }
+   produce_blocks(5);
+
+   const auto lib = control->last_irreversible_block_num();
+   const auto lib_id = control->fetch_block_by_number( lib )->id();
+
+   // a transaction signature of a block replayed in trusted mode is damaged in the block log; the block id does not
+   // cover it, so the replay only gets past that block if signatures and merkle roots are really not checked
+   signed_block_ptr tampered;
+   for( uint32_t n = 2; n < lib - 2 && !tampered; ++n ) {
+      auto b = control->fetch_block_by_number( n );
+      if( !b->transactions.empty() && b->transactions.front().trx.contains<packed_transaction>() )
+         tampered = b;
+   }
+   BOOST_REQUIRE( tampered );
+   const auto& original_trx = tampered->transactions.front().trx.get<packed_transaction>();
+   const auto original_key = public_key_type( original_trx.signatures.front(),
+                                              original_trx.get_signed_transaction().sig_digest( control->get_chain_id() ) );
+   const auto packed_block = fc::raw::pack( *tampered );
+   const auto packed_sig = fc::raw::pack( original_trx.signatures.front() );
+   const auto sig_end = std::search( packed_block.begin(), packed_block.end(), packed_sig.begin(), packed_sig.end() )
+                        - packed_block.begin() + packed_sig.size();
+   BOOST_REQUIRE( sig_end <= packed_block.size() );
+
+   close();
+   {
+      uint64_t pos = 0;
+      std::ifstream index( (cfg.blocks_dir / "blocks.index").generic_string(), std::ios::in | std::ios::binary );
+      index.seekg( sizeof(pos) * (tampered->block_num() - 1) );
+      index.read( reinterpret_cast<char*>(&pos), sizeof(pos) );
+
+      std::fstream log( (cfg.blocks_dir / "blocks.log").generic_string(), std::ios::in | std::ios::out | std::ios::binary );
+      vector<char> on_disk( packed_block.size() );
+      log.seekg( pos );
+      log.read( on_disk.data(), on_disk.size() );
+      BOOST_REQUIRE( on_disk == packed_block );
+
+      char damaged = packed_block[sig_end - 2] ^ 0x01;
+      log.seekp( pos + sig_end - 2 );
+      log.write( &damaged, 1 );
+      BOOST_REQUIRE( log.good() );
+   }
+
+   fc::remove_all( cfg.state_dir );
+   fc::remove_all( cfg.blocks_dir / config::reversible_blocks_dir_name );
+   cfg.force_all_checks = true;
+   cfg.trusted_replay_block_num = lib - 2;
+   cfg.replay_checkpoint_interval = 5;
+   cfg.replay_checkpoint_file = tempdir.path() / "replay-checkpoint.bin";
+
+   // keep the first checkpoint, as if the replay had been interrupted right after it was written
+   auto saved = tempdir.path() / "saved-checkpoint.bin";
+   control.reset( new controller(cfg) );
+   control->irreversible_block.connect( [&]( const block_state_ptr& ) {
+      if( fc::exists( cfg.replay_checkpoint_file ) && !fc::exists( saved ) )
+         fc::copy( cfg.replay_checkpoint_file, saved );
+   });
+   control->startup();
+
+   BOOST_REQUIRE_EQUAL( control->head_block_id(), lib_id );
+   BOOST_REQUIRE( fc::exists( saved ) );
+   BOOST_REQUIRE( !fc::exists( cfg.replay_checkpoint_file ) );
+
+   // the replayed block carries the damaged signature, which no longer recovers the key that signed the transaction
+   auto replayed = control->fetch_block_by_number( tampered->block_num() );
+   BOOST_REQUIRE_EQUAL( replayed->id(), tampered->id() );
+   const auto& replayed_trx = replayed->transactions.front().trx.get<packed_transaction>();
+   BOOST_REQUIRE( replayed_trx.signatures.front() != original_trx.signatures.front() );
+   bool recovers_signer = false;
+   try {
+      recovers_signer = public_key_type( replayed_trx.signatures.front(),
+                                         replayed_trx.get_signed_transaction().sig_digest( control->get_chain_id() ) ) == original_key;
+   } catch( const fc::exception& ) {}
+   BOOST_REQUIRE( !recovers_signer );
+
+   close();
+   fc::remove_all( cfg.state_dir );
+   std::ifstream checkpoint( saved.generic_string(), std::ios::in | std::ios::binary );
+   open( std::make_shared<snapshot_reader>( checkpoint ) );
+
+   BOOST_REQUIRE_EQUAL( control->head_block_id(), lib_id );
+   BOOST_REQUIRE( (control->db().find<account_object,by_name>( N(trustedj) ) != nullptr) );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
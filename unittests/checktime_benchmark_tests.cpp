@@ -0,0 +1,145 @@
+/**
+ *  @file
+ *  @copyright defined in bes/LICENSE.txt
+ */
+#include <boost/test/unit_test.hpp>
+#include <besio/testing/tester.hpp>
+#include <besio/chain/deadline_timer.hpp>
+#include <besio/chain/exceptions.hpp>
+
+#include <infinite/infinite.wast.hpp>
+
+using namespace besio;
+using namespace besio::chain;
+using namespace besio::testing;
+
+namespace {
+
+   const uint64_t poll_iterations = 10000000;
+   const uint32_t loop_iterations = 5000000;
+
+   // every pass of the loop runs the checktime injected into it
+   const std::string tight_loop_wast = R"=====(
+(module
+  (export "apply" (func $apply))
+  (func $apply (param $0 i64) (param $1 i64) (param $2 i64)
+    (local $i i32)
+    (block $done
+      (loop $next
+        (br_if $done (i32.eq (get_local $i) (i32.const )=====" + std::to_string( loop_iterations ) + R"=====()))
+        (set_local $i (i32.add (get_local $i) (i32.const 1)))
+        (br $next)
+      )
+    )
+  )
+)
+)=====";
+
+   double nanoseconds_per( const fc::microseconds& t, uint64_t n ) {
+      return t.count() * 1000.0 / n;
+   }
+
+   /// Pushes an action without data to the contract of account and returns how long the transaction took to run
+   fc::microseconds push_timed( tester& t, account_name account, fc::time_point deadline ) {
+      signed_transaction trx;
+      trx.actions.emplace_back( vector<permission_level>{{account, config::active_name}}, account, N(), bytes() );
+      t.set_transaction_headers( trx );
+      trx.sign( t.get_private_key( account, "active" ), t.control->get_chain_id() );
+
+      auto start = fc::time_point::now();
+      t.push_transaction( trx, deadline );
+      auto elapsed = fc::time_point::now() - start;
+      t.produce_block();
+      return elapsed;
+   }
+
+}
+
+BOOST_AUTO_TEST_SUITE(checktime_benchmark_tests)
+
+/**
+ *  Compares what a checktime costs when it reads the clock against polling the flag of an armed deadline_timer,
+ *  and checks that the flag goes up after the deadline and not before.
+ */
+BOOST_AUTO_TEST_CASE(deadline_timer_polling)
+{ try {
+   const auto far_deadline = fc::time_point::now() + fc::seconds(3600);
+
+   uint64_t passed = 0;
+   auto start = fc::time_point::now();
+   for( uint64_t i = 0; i < poll_iterations; ++i ) {
+      if( fc::time_point::now() > far_deadline ) ++passed;
+   }
+   auto clock_time = fc::time_point::now() - start;
+
+   deadline_timer timer;
+   timer.start( far_deadline );
+   start = fc::time_point::now();
+   for( uint64_t i = 0; i < poll_iterations; ++i ) {
+      if( timer.expired() ) ++passed;
+   }
+   auto flag_time = fc::time_point::now() - start;
+   BOOST_REQUIRE_EQUAL( passed, 0u );
+
+   BOOST_TEST_MESSAGE( "checktime reading the clock: " << nanoseconds_per( clock_time, poll_iterations ) << " ns, "
+                       << "polling the deadline timer: " << nanoseconds_per( flag_time, poll_iterations ) << " ns" );
+
+   for( auto ms : {1, 10, 50} ) {
+      const auto deadline = fc::time_point::now() + fc::milliseconds(ms);
+      timer.start( deadline );
+      while( !timer.expired() ) {}
+      const auto now = fc::time_point::now();
+      BOOST_REQUIRE( now > deadline );
+      BOOST_TEST_MESSAGE( "deadline of " << ms << " ms noticed " << (now - deadline).count() << " us late" );
+   }
+
+   timer.start( fc::time_point::now() - fc::milliseconds(1) );
+   BOOST_REQUIRE( timer.expired() );
+   timer.stop();
+   BOOST_REQUIRE( !timer.expired() );
+} FC_LOG_AND_RETHROW() }
+
+/**
+ *  A contract looping without calling anything, so the checktime injected into the loop is most of its work.
+ */
+BOOST_AUTO_TEST_CASE(tight_loop_contract)
+{ try {
+   tester t;
+   t.produce_blocks(2);
+   t.create_account( N(tightloop) );
+   t.set_code( N(tightloop), tight_loop_wast.c_str() );
+   t.produce_block();
+
+   push_timed( t, N(tightloop), fc::time_point::maximum() ); // compiles and caches the contract
+
+   auto elapsed = push_timed( t, N(tightloop), fc::time_point::now() + fc::seconds(10) );
+   BOOST_TEST_MESSAGE( "tight loop: " << loop_iterations << " iterations in " << elapsed.count() << " us, "
+                       << nanoseconds_per( elapsed, loop_iterations ) << " ns per iteration" );
+} FC_LOG_AND_RETHROW() }
+
+/**
+ *  The infinite contract only ends when its deadline passes; how long after the deadline the transaction is
+ *  aborted shows how quickly the deadline is noticed.
+ */
+BOOST_AUTO_TEST_CASE(infinite_contract)
+{ try {
+   tester t;
+   t.produce_blocks(2);
+   t.create_account( N(infinite) );
+   t.set_code( N(infinite), infinite_wast );
+   t.produce_block();
+
+   // compiles and caches the contract
+   BOOST_REQUIRE_THROW( push_timed( t, N(infinite), fc::time_point::now() + fc::milliseconds(10) ), deadline_exception );
+   t.produce_block();
+
+   for( auto ms : {10, 50, 100} ) {
+      const auto deadline = fc::time_point::now() + fc::milliseconds(ms);
+      BOOST_REQUIRE_THROW( push_timed( t, N(infinite), deadline ), deadline_exception );
+      BOOST_TEST_MESSAGE( "infinite loop with a deadline of " << ms << " ms aborted "
+                          << (fc::time_point::now() - deadline).count() << " us after it" );
+      t.produce_block();
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
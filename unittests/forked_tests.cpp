@@ -28,6 +28,15 @@ void push_blocks( tester& from, tester& to ) {
    }
 }
 
+/// a tester whose fork database spills every validated block except the head
+struct spilling_tester : tester {
+   spilling_tester() {
+      close();
+      cfg.fork_db_memory_budget = 1;
+      open();
+   }
+};
+
 BOOST_AUTO_TEST_SUITE(forked_tests)
 
 BOOST_AUTO_TEST_CASE( irrblock ) try {
@@ -465,4 +474,36 @@ BOOST_AUTO_TEST_CASE( read_modes ) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_AUTO_TEST_CASE( fork_db_spill ) try {
+   spilling_tester c;
+   c.produce_blocks(10);
+   c.create_accounts( {N(dan),N(sam),N(pam)} );
+   c.produce_block();
+   c.set_producers( {N(dan),N(sam),N(pam)} );
+   c.produce_blocks(100);
+
+   auto spill_file = c.get_config().state_dir / config::forkdb_spill_filename;
+   BOOST_REQUIRE( c.control->head_block_num() > c.control->last_irreversible_block_num() + 10 );
+   BOOST_REQUIRE( fc::exists( spill_file ) );
+
+   // reversible blocks are served from the spill file, and blocks that became irreversible were read back from it
+   tester c2;
+   push_blocks( c, c2 );
+   BOOST_REQUIRE_EQUAL( c.control->head_block_id(), c2.control->head_block_id() );
+   BOOST_REQUIRE_EQUAL( c.control->last_irreversible_block_num(), c2.control->last_irreversible_block_num() );
+   auto lib = c.control->last_irreversible_block_num();
+   BOOST_REQUIRE_EQUAL( c.control->fetch_block_by_number( lib )->id(), c2.control->fetch_block_by_number( lib )->id() );
+
+   // the spilled blocks are written to forkdb.dat on shutdown
+   auto head_id = c.control->head_block_id();
+   c.close();
+   BOOST_REQUIRE( !fc::exists( spill_file ) );
+   c.open();
+   BOOST_REQUIRE_EQUAL( head_id, c.control->head_block_id() );
+   c.produce_blocks(50);
+   push_blocks( c, c2 );
+   BOOST_REQUIRE_EQUAL( c.control->head_block_id(), c2.control->head_block_id() );
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -7,8 +7,14 @@
 #include <besio/chain/authority.hpp>
 #include <besio/chain/types.hpp>
 #include <besio/chain/asset.hpp>
+#include <besio/chain/transaction_arena.hpp>
+#include <besio/chain/merkle.hpp>
+#include <besio/chain/thread_utils.hpp>
 #include <besio/testing/tester.hpp>
 
+#include <besio.system/besio.system.abi.hpp>
+#include <besio.token/besio.token.abi.hpp>
+
 #include <besio/utilities/key_conversion.hpp>
 #include <besio/utilities/rand.hpp>
 
@@ -645,6 +651,199 @@ BOOST_AUTO_TEST_CASE(transaction_test) { try {
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE(abi_serializer_cache) { try {
+
+   testing::TESTER test;
+   const auto max_time = test.abi_serializer_max_time;
+
+   test.create_accounts( { N(alice), N(bob) } );
+   BOOST_CHECK( !test.control->get_abi_serializer( N(alice), max_time ) );
+
+   test.set_abi( N(alice), besio_token_abi );
+   auto abis = test.control->get_abi_serializer( N(alice), max_time );
+   BOOST_REQUIRE( abis );
+   BOOST_CHECK_EQUAL( abis->get_action_type( N(transfer) ), "transfer" );
+   // served from the cache until the ABI changes
+   BOOST_CHECK( test.control->get_abi_serializer( N(alice), max_time ) == abis );
+   BOOST_CHECK( test.control->get_abi_serializer( N(bob), max_time ) == nullptr );
+
+   test.set_abi( N(alice), besio_system_abi );
+   auto abis2 = test.control->get_abi_serializer( N(alice), max_time );
+   BOOST_REQUIRE( abis2 );
+   BOOST_CHECK( abis2 != abis );
+   BOOST_CHECK_EQUAL( abis2->get_action_type( N(buyram) ), "buyram" );
+   BOOST_CHECK( abis2->get_action_type( N(transfer) ).empty() );
+
+   // the serializer handed out earlier stays usable after it is replaced
+   BOOST_CHECK_EQUAL( abis->get_action_type( N(transfer) ), "transfer" );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(transaction_arena_test) { try {
+   transaction_arena arena;
+
+   // small allocations are served from the inline chunk and respect alignment
+   arena_allocator<uint64_t> alloc( arena );
+   arena_vector<uint64_t> v( alloc );
+   for( uint64_t i = 0; i < 100; ++i ) v.push_back( i );
+   BOOST_CHECK_EQUAL( arena.heap_bytes(), 0u );
+   auto c = arena.allocate( 1, 1 );
+   auto d = arena.allocate( sizeof(long double), alignof(long double) );
+   BOOST_CHECK( c != d );
+   BOOST_CHECK_EQUAL( reinterpret_cast<uintptr_t>(d) % alignof(long double), 0u );
+
+   // growing past the inline chunk takes chunks from the heap, and larger requests get a chunk of their own
+   arena_map<uint64_t, uint64_t> m( alloc );
+   for( uint64_t i = 0; i < 10000; ++i ) m[i] = i * 2;
+   BOOST_CHECK( arena.heap_bytes() > 0u );
+   auto big = static_cast<char*>( arena.allocate( 4 * transaction_arena::max_chunk_size ) );
+   memset( big, 0xff, 4 * transaction_arena::max_chunk_size );
+   BOOST_CHECK( arena.heap_bytes() > 4 * transaction_arena::max_chunk_size );
+
+   for( uint64_t i = 0; i < 100; ++i ) BOOST_REQUIRE_EQUAL( v[i], i );
+   for( uint64_t i = 0; i < 10000; ++i ) BOOST_REQUIRE_EQUAL( m[i], i * 2 );
+
+   m.clear();
+   v.clear();
+   arena.release();
+   BOOST_CHECK_EQUAL( arena.heap_bytes(), 0u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(merkle_test) { try {
+   // one pair at a time, the way the root has always been computed
+   auto serial_merkle = []( vector<digest_type> ids ) {
+      if( ids.empty() ) return digest_type();
+      while( ids.size() > 1 ) {
+         if( ids.size() % 2 )
+            ids.push_back( ids.back() );
+         for( size_t i = 0; i < ids.size() / 2; ++i )
+            ids[i] = digest_type::hash( make_canonical_pair( ids[2 * i], ids[2 * i + 1] ) );
+         ids.resize( ids.size() / 2 );
+      }
+      return ids.front();
+   };
+
+   boost::asio::thread_pool thread_pool( 4 );
+   for( size_t n : {0, 1, 2, 3, 7, 8, 9, 16, 17, 33, 100, 1000, 8191, 8192, 20001} ) {
+      vector<digest_type> ids;
+      for( size_t i = 0; i < n; ++i )
+         ids.emplace_back( digest_type::hash( std::to_string( i ) ) );
+      auto expected = serial_merkle( ids );
+      BOOST_CHECK_EQUAL( merkle( ids ), expected );
+      BOOST_CHECK_EQUAL( merkle( ids, &thread_pool ), expected );
+   }
+   thread_pool.join();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(recover_public_keys_test) { try {
+   vector<private_key_type> keys;
+   for( int i = 0; i < 8; ++i )
+      keys.emplace_back( private_key_type::regenerate<fc::ecc::private_key_shim>( fc::sha256::hash( std::to_string( i ) ) ) );
+
+   vector<std::pair<signature_type, digest_type>> signatures;
+   vector<public_key_type> expected;
+   for( int i = 0; i < 300; ++i ) {
+      auto digest = digest_type::hash( std::string( "recover " ) + std::to_string( i ) );
+      const auto& key = keys[i % keys.size()];
+      signatures.emplace_back( key.sign( digest ), digest );
+      expected.emplace_back( key.get_public_key() );
+   }
+
+   boost::asio::thread_pool thread_pool( 4 );
+   BOOST_CHECK( recover_public_keys( signatures, nullptr, false ) == expected );
+   BOOST_CHECK( recover_public_keys( signatures, &thread_pool, false ) == expected );
+   // the second pass is served from the cache
+   BOOST_CHECK( recover_public_keys( signatures, &thread_pool ) == expected );
+   BOOST_CHECK( recover_public_keys( signatures, &thread_pool ) == expected );
+
+   // a cached key is only returned for the digest it was recovered from
+   auto other = signatures;
+   for( auto& p : other )
+      p.second = digest_type::hash( p.second );
+   auto other_keys = recover_public_keys( other, &thread_pool );
+   for( size_t i = 0; i < other.size(); ++i )
+      BOOST_CHECK( other_keys[i] != expected[i] );
+
+   // a signature no key can be recovered from fails the whole batch, wherever it is recovered
+   for( size_t bad : {0, 150, 299} ) {
+      auto broken = signatures;
+      broken[bad].first = signature_type();
+      BOOST_CHECK_THROW( recover_public_keys( broken, &thread_pool, false ), fc::exception );
+   }
+   thread_pool.join();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(signing_keys_continuation_test) { try {
+   auto key = private_key_type::regenerate<fc::ecc::private_key_shim>( fc::sha256::hash( std::string( "signer" ) ) );
+   chain_id_type chain_id( fc::sha256::hash( std::string( "chain" ) ) );
+   signed_transaction trx;
+   trx.sign( key, chain_id );
+   auto mtrx = std::make_shared<transaction_metadata>( trx );
+
+   boost::asio::thread_pool thread_pool( 2 );
+   std::promise<bool> ready;
+   transaction_metadata::create_signing_keys_future( mtrx, thread_pool, chain_id, [&]() {
+      // the keys are already recovered when the continuation runs
+      ready.set_value( mtrx->signing_keys_future.wait_for( std::chrono::seconds(0) ) == std::future_status::ready );
+   } );
+   BOOST_CHECK( ready.get_future().get() );
+   BOOST_CHECK( mtrx->recover_keys( chain_id ) == flat_set<public_key_type>{ key.get_public_key() } );
+
+   // started already, so the continuation runs right away
+   bool called = false;
+   transaction_metadata::create_signing_keys_future( mtrx, thread_pool, chain_id, [&]() { called = true; } );
+   BOOST_CHECK( called );
+   thread_pool.join();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(recover_signing_keys_test) { try {
+   auto key = private_key_type::regenerate<fc::ecc::private_key_shim>( fc::sha256::hash( std::string( "signer" ) ) );
+   chain_id_type chain_id( fc::sha256::hash( std::string( "chain" ) ) );
+
+   // enough signatures for the batch to be spread across the pool
+   vector<transaction_metadata_ptr> mtrxs;
+   for( uint16_t i = 0; i < 100; ++i ) {
+      signed_transaction trx;
+      trx.ref_block_num = i;
+      trx.sign( key, chain_id );
+      if( i == 10 ) trx.sign( key, chain_id );           // the same key twice
+      if( i == 20 ) trx.signatures.back() = signature_type(); // no key can be recovered
+      mtrxs.emplace_back( std::make_shared<transaction_metadata>( trx ) );
+   }
+   // already started, so left alone
+   mtrxs[30]->recover_keys( chain_id );
+   auto started = mtrxs[30]->signing_keys_future;
+
+   boost::asio::thread_pool thread_pool( 4 );
+   transaction_metadata::recover_signing_keys( mtrxs, thread_pool, chain_id );
+   for( size_t i = 0; i < mtrxs.size(); ++i ) {
+      BOOST_REQUIRE( mtrxs[i]->signing_keys_future.valid() );
+      if( i == 10 ) {
+         BOOST_CHECK_THROW( mtrxs[i]->recover_keys( chain_id ), tx_duplicate_sig );
+      } else if( i == 20 ) {
+         BOOST_CHECK_THROW( mtrxs[i]->recover_keys( chain_id ), fc::exception );
+      } else {
+         BOOST_CHECK( mtrxs[i]->recover_keys( chain_id ) == flat_set<public_key_type>{ key.get_public_key() } );
+      }
+   }
+   BOOST_CHECK( &mtrxs[30]->signing_keys_future.get() == &started.get() );
+
+   // more signatures than the recovery cache holds; each is recovered exactly once, the keys are handed over directly
+   mtrxs.clear();
+   for( uint16_t i = 0; i < 3000; ++i ) {
+      signed_transaction trx;
+      trx.ref_block_num = 1000 + i;
+      trx.sign( key, chain_id );
+      mtrxs.emplace_back( std::make_shared<transaction_metadata>( trx ) );
+   }
+   auto recovered = recovered_public_key_count();
+   transaction_metadata::recover_signing_keys( mtrxs, thread_pool, chain_id );
+   for( const auto& mtrx : mtrxs )
+      BOOST_CHECK( mtrx->recover_keys( chain_id ) == flat_set<public_key_type>{ key.get_public_key() } );
+   BOOST_CHECK_EQUAL( recovered_public_key_count() - recovered, mtrxs.size() );
+   thread_pool.join();
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace besio
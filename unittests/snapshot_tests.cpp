@@ -0,0 +1,128 @@
+/**
+ *  @file
+ *  @copyright defined in bes/LICENSE.txt
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <besio/testing/tester.hpp>
+#include <besio/chain/snapshot.hpp>
+
+#include <besio.token/besio.token.wast.hpp>
+#include <besio.token/besio.token.abi.hpp>
+
+#include <fc/variant_object.hpp>
+
+#include <sstream>
+#include <thread>
+
+using namespace besio;
+using namespace testing;
+using namespace chain;
+
+using mvo = fc::mutable_variant_object;
+
+namespace {
+   string write_snapshot( tester& chain ) {
+      std::ostringstream out;
+      snapshot_writer writer( out, chain.control->get_chain_id() );
+      chain.control->write_snapshot( writer );
+      writer.finalize();
+      return out.str();
+   }
+
+   /// drops the chain state and reversible blocks so the next open has to rebuild them
+   void wipe_state( tester& chain ) {
+      chain.close();
+      fc::remove_all( chain.get_config().state_dir );
+      fc::remove_all( chain.get_config().blocks_dir / config::reversible_blocks_dir_name );
+   }
+}
+
+BOOST_AUTO_TEST_SUITE(snapshot_tests)
+
+/**
+ * Prove that loading a snapshot and replaying the block log past it yields exactly the state of a full replay
+ */
+BOOST_AUTO_TEST_CASE(snapshot_round_trip_test) try {
+   tester chain;
+
+   chain.create_accounts( { N(besio.token) } );
+   chain.set_code( N(besio.token), besio_token_wast );
+   chain.set_abi( N(besio.token), besio_token_abi );
+   chain.produce_blocks();
+
+   chain.push_action( N(besio.token), N(create), N(besio.token), mvo()
+                      ("issuer", "besio.token")
+                      ("maximum_supply", "1000000.0000 TOK") );
+   chain.push_action( N(besio.token), N(issue), N(besio.token), mvo()
+                      ("to", "besio.token")
+                      ("quantity", "100000.0000 TOK")
+                      ("memo", "") );
+   chain.produce_blocks();
+
+   vector<account_name> accounts;
+   for( int i = 0; i < 100; ++i )
+      accounts.emplace_back( string("snap") + char('a' + i / 26) + char('a' + i % 26) );
+   chain.create_accounts( accounts );
+   chain.produce_blocks();
+
+   for( const auto& a : accounts ) {
+      chain.push_action( N(besio.token), N(transfer), N(besio.token), mvo()
+                         ("from", "besio.token")
+                         ("to", a)
+                         ("quantity", "10.0000 TOK")
+                         ("memo", "") );
+   }
+   chain.produce_blocks();
+
+   chain.control->abort_block();
+   auto snapshot_block = chain.control->head_block_num();
+   auto start = fc::time_point::now();
+   auto snapshot = write_snapshot( chain );
+   auto elapsed = std::max<int64_t>( (fc::time_point::now() - start).count(), 1 );
+   BOOST_TEST_MESSAGE( "wrote " << snapshot.size() << " byte snapshot at " << snapshot.size() * 1000000 / elapsed << " bytes/s" );
+
+   // the snapshot block has to be irreversible, and so in the block log, before the snapshot can be loaded
+   chain.produce_blocks( 10 );
+   BOOST_REQUIRE( chain.control->last_irreversible_block_num() >= snapshot_block );
+
+   wipe_state( chain );
+   chain.open();
+   auto replayed = write_snapshot( chain );
+
+   wipe_state( chain );
+   std::istringstream in( snapshot );
+   start = fc::time_point::now();
+   chain.open( std::make_shared<snapshot_reader>( in ) );
+   elapsed = std::max<int64_t>( (fc::time_point::now() - start).count(), 1 );
+   BOOST_TEST_MESSAGE( "loaded snapshot at " << snapshot.size() * 1000000 / elapsed << " bytes/s" );
+
+   auto loaded = write_snapshot( chain );
+   BOOST_REQUIRE_EQUAL( replayed.size(), loaded.size() );
+   BOOST_REQUIRE( replayed == loaded );
+
+   // an unbounded writer finalized on another thread, as the producer plugin uses it, writes the same snapshot
+   {
+      std::ostringstream out;
+      snapshot_writer writer( out, chain.control->get_chain_id(), 0 );
+      chain.control->write_snapshot( writer );
+      std::thread( [&writer]() { writer.finalize(); } ).join();
+      BOOST_REQUIRE( out.str() == loaded );
+   }
+
+   chain.push_action( N(besio.token), N(transfer), N(snapaa), mvo()
+                      ("from", "snapaa")
+                      ("to", "snapab")
+                      ("quantity", "1.0000 TOK")
+                      ("memo", "") );
+   chain.produce_blocks();
+
+   // a snapshot that does not match its checksum is rejected
+   wipe_state( chain );
+   snapshot.back() ^= 0x01;
+   std::istringstream damaged( snapshot );
+   BOOST_REQUIRE_THROW( chain.open( std::make_shared<snapshot_reader>( damaged ) ), snapshot_exception );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,144 @@
+/**
+ *  @file
+ *  @copyright defined in bes/LICENSE.txt
+ */
+#include <boost/test/unit_test.hpp>
+#include <besio/testing/tester.hpp>
+#include <besio/chain/abi_serializer.hpp>
+#include <besio/chain/exceptions.hpp>
+
+#include <besio.token/besio.token.wast.hpp>
+#include <besio.token/besio.token.abi.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+using namespace besio;
+using namespace besio::chain;
+using namespace besio::testing;
+using namespace fc;
+
+namespace {
+
+   const uint32_t transfers_per_round = 1000;
+   const uint32_t transfers_per_block = 100;
+   const uint32_t transfer_expiration = 600; ///< a round is built ahead of the blocks it is pushed in
+
+   class transfer_tester : public tester {
+      public:
+         transfer_tester()
+         :abi_ser( json::from_string( besio_token_abi ).as<abi_def>(), abi_serializer_max_time )
+         {
+            produce_blocks(2);
+            create_accounts( {N(besio.token), N(alice), N(bob)} );
+            set_code( N(besio.token), besio_token_wast );
+            produce_block();
+
+            push_token_action( N(besio.token), N(create), mutable_variant_object()
+                               ("issuer", "besio.token")
+                               ("maximum_supply", "1000000000.0000 CUR") );
+            push_token_action( N(besio.token), N(issue), mutable_variant_object()
+                               ("to", "alice")
+                               ("quantity", "1000000.0000 CUR")
+                               ("memo", "") );
+            produce_block();
+         }
+
+         signed_transaction make_transfer( uint32_t n ) {
+            signed_transaction trx;
+            trx.actions.emplace_back( make_token_action( N(alice), N(transfer), mutable_variant_object()
+                                                         ("from", "alice")
+                                                         ("to", "bob")
+                                                         ("quantity", "0.0001 CUR")
+                                                         ("memo", std::to_string( n )) ) );
+            set_transaction_headers( trx, transfer_expiration );
+            trx.sign( get_private_key( N(alice), "active" ), control->get_chain_id() );
+            return trx;
+         }
+
+         /**
+          * The unsigned onramusage transaction push_transaction used to build and push from within every input
+          * transaction; it never carried a signature, so its authorization check always failed.
+          */
+         signed_transaction make_onramusage( account_name actor ) {
+            signed_transaction trx;
+            trx.actions.emplace_back( vector<permission_level>{{actor, config::active_name}},
+                                      config::system_account_name, N(onramusage), fc::raw::pack( actor ) );
+            set_transaction_headers( trx, transfer_expiration );
+            return trx;
+         }
+
+         /// Pushes the transfers, and with each one the onramusage transaction when with_onramusage is set
+         fc::microseconds push_transfers( const vector<signed_transaction>& transfers, bool with_onramusage ) {
+            const auto onramusage = make_onramusage( N(alice) );
+            fc::microseconds elapsed;
+            for( uint32_t i = 0; i < transfers.size(); ++i ) {
+               auto start = fc::time_point::now();
+               auto trace = control->push_transaction( std::make_shared<transaction_metadata>( transfers[i] ), fc::time_point::maximum() );
+               if( with_onramusage ) {
+                  auto failed = control->push_transaction( std::make_shared<transaction_metadata>( onramusage ), fc::time_point::maximum() );
+                  BOOST_REQUIRE( failed->except && failed->except->code() == unsatisfied_authorization::code_value );
+               }
+               elapsed += fc::time_point::now() - start;
+               if( trace->except ) throw *trace->except;
+               if( (i + 1) % transfers_per_block == 0 )
+                  produce_block();
+            }
+            produce_block();
+            return elapsed;
+         }
+
+         abi_serializer abi_ser;
+
+      private:
+         action make_token_action( account_name signer, action_name name, const variant_object& data ) {
+            return action( vector<permission_level>{{signer, config::active_name}}, N(besio.token), name,
+                           abi_ser.variant_to_binary( abi_ser.get_action_type( name ), data, abi_serializer_max_time ) );
+         }
+
+         void push_token_action( account_name signer, action_name name, const variant_object& data ) {
+            signed_transaction trx;
+            trx.actions.emplace_back( make_token_action( signer, name, data ) );
+            set_transaction_headers( trx );
+            trx.sign( get_private_key( signer, "active" ), control->get_chain_id() );
+            push_transaction( trx );
+         }
+   };
+
+   double transactions_per_second( uint32_t n, const fc::microseconds& t ) {
+      return n * 1000000.0 / std::max<int64_t>( t.count(), 1 );
+   }
+
+}
+
+BOOST_AUTO_TEST_SUITE(transfer_benchmark_tests)
+
+/**
+ *  Throughput of besio.token transfers as input transactions are pushed now, against the same transfers each
+ *  followed by the failing onramusage transaction every input transaction used to push.
+ */
+BOOST_AUTO_TEST_CASE(transfer_tps)
+{ try {
+   transfer_tester t;
+
+   uint32_t n = 0;
+   auto next_round = [&]() {
+      vector<signed_transaction> transfers;
+      for( uint32_t i = 0; i < transfers_per_round; ++i )
+         transfers.emplace_back( t.make_transfer( n++ ) );
+      return transfers;
+   };
+
+   t.push_transfers( next_round(), false ); // warms up the wasm cache
+   auto with_onramusage = t.push_transfers( next_round(), true );
+   auto without_onramusage = t.push_transfers( next_round(), false );
+
+   BOOST_REQUIRE_EQUAL( t.get_currency_balance( N(besio.token), symbol(SY(4,CUR)), N(bob) ),
+                        asset( 3 * transfers_per_round, symbol(SY(4,CUR)) ) );
+
+   BOOST_TEST_MESSAGE( "transfers per second with the nested onramusage push: "
+                       << transactions_per_second( transfers_per_round, with_onramusage )
+                       << ", without: " << transactions_per_second( transfers_per_round, without_onramusage ) );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
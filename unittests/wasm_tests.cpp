@@ -164,6 +164,143 @@ BOOST_FIXTURE_TEST_CASE( prove_mem_reset, TESTER ) try {
 
 } FC_LOG_AND_RETHROW() /// prove_mem_reset
 
+/**
+ * Prove that contracts evicted from a size bounded instantiation cache are instantiated again on
+ * demand, and that the contracts cached at shutdown are instantiated again when the chain is reopened
+ */
+BOOST_FIXTURE_TEST_CASE( wasm_cache_eviction, tester ) try {
+   close();
+   cfg.wasm_cache_size = 1;
+   open();
+   produce_blocks(2);
+
+   create_accounts( {N(asserter), N(noop)} );
+   produce_block();
+
+   set_code(N(asserter), asserter_wast);
+   set_code(N(noop), noop_wast);
+   set_abi(N(noop), noop_abi);
+   produce_blocks(1);
+
+   auto push_noop = [&]() {
+      push_action(N(noop), N(anyaction), N(noop), mutable_variant_object()
+                  ("from", "noop")
+                  ("type", "some type")
+                  ("data", "some data goes here"));
+   };
+
+   // alternate between both contracts so that each action finds the other contract in the cache
+   for (int i = 0; i < 3; i++) {
+      signed_transaction trx;
+      trx.actions.emplace_back( vector<permission_level>{{N(asserter),config::active_name}},
+                                provereset {} );
+      set_transaction_headers(trx);
+      trx.sign( get_private_key( N(asserter), "active" ), control->get_chain_id() );
+      push_transaction( trx );
+      push_noop();
+      produce_blocks(1);
+   }
+
+   auto noop_code_version = control->db().get<account_object,by_name>(N(noop)).code_version;
+   auto cached = control->get_wasm_interface().get_cached_modules();
+   BOOST_REQUIRE_EQUAL( 1u, cached.size() );
+   BOOST_CHECK( cached.front().first == N(noop) );
+   BOOST_CHECK( cached.front().second == noop_code_version );
+
+   close();
+   open();
+
+   cached = control->get_wasm_interface().get_cached_modules();
+   BOOST_REQUIRE_EQUAL( 1u, cached.size() );
+   BOOST_CHECK( cached.front().first == N(noop) );
+
+   push_noop();
+   produce_blocks(1);
+} FC_LOG_AND_RETHROW() /// wasm_cache_eviction
+
+/**
+ * Prove that a contract keeps executing correctly while it moves from the interpreter to its WAVM compiled module
+ */
+BOOST_FIXTURE_TEST_CASE( wasm_tiered_compile, tester ) try {
+   close();
+   cfg.wasm_runtime = chain::wasm_interface::vm_type::wavm;
+   cfg.wasm_tiered_compile = true;
+   open();
+   produce_blocks(2);
+
+   create_accounts( {N(asserter)} );
+   produce_block();
+
+   set_code(N(asserter), asserter_wast);
+   produce_blocks(1);
+
+   for (int i = 0; i < 5; i++) {
+      signed_transaction trx;
+      trx.actions.emplace_back( vector<permission_level>{{N(asserter),config::active_name}},
+                                provereset {} );
+      set_transaction_headers(trx);
+      trx.sign( get_private_key( N(asserter), "active" ), control->get_chain_id() );
+      push_transaction( trx );
+      produce_blocks(1);
+      BOOST_REQUIRE_EQUAL(true, chain_has_transaction(trx.id()));
+      BOOST_CHECK_EQUAL(transaction_receipt::executed, get_transaction_receipt(trx.id()).status);
+   }
+} FC_LOG_AND_RETHROW() /// wasm_tiered_compile
+
+/**
+ * Prove that blocks produced while contracts are still being compiled in the background validate on a second node,
+ * which instantiates the same modules on its own thread while the producer's compiles are running
+ */
+BOOST_AUTO_TEST_CASE( wasm_tiered_compile_concurrent ) try {
+   struct tiered_tester : tester {
+      tiered_tester() {
+         close();
+         cfg.wasm_runtime = chain::wasm_interface::vm_type::wavm;
+         cfg.wasm_tiered_compile = true;
+         open();
+      }
+   };
+   auto push_blocks = []( tester& from, tester& to ) {
+      while( to.control->fork_db_head_block_num() < from.control->fork_db_head_block_num() )
+         to.push_block( from.control->fetch_block_by_number( to.control->fork_db_head_block_num() + 1 ) );
+   };
+
+   tiered_tester producer, validator;
+   producer.produce_blocks(2);
+
+   producer.create_accounts( {N(asserter), N(noop)} );
+   producer.produce_block();
+   producer.set_code(N(asserter), asserter_wast);
+   producer.set_code(N(noop), noop_wast);
+   producer.set_abi(N(noop), noop_abi);
+   producer.produce_block();
+   push_blocks(producer, validator);
+
+   for (int i = 0; i < 5; i++) {
+      signed_transaction trx;
+      trx.actions.emplace_back( vector<permission_level>{{N(asserter),config::active_name}},
+                                provereset {} );
+      producer.set_transaction_headers(trx);
+      trx.sign( producer.get_private_key( N(asserter), "active" ), producer.control->get_chain_id() );
+      producer.push_transaction( trx );
+      auto noop_trace = producer.push_action(N(noop), N(anyaction), N(noop), mutable_variant_object()
+                                             ("from", "noop")
+                                             ("type", "some type")
+                                             ("data", std::to_string(i)));
+
+      // the first round runs on the interpreter while the producer compiles both contracts, and the validator
+      // compiles them for the block at the same time
+      producer.produce_block();
+      push_blocks(producer, validator);
+
+      BOOST_REQUIRE_EQUAL(true, validator.chain_has_transaction(trx.id()));
+      BOOST_CHECK_EQUAL(transaction_receipt::executed, validator.get_transaction_receipt(trx.id()).status);
+      BOOST_REQUIRE_EQUAL(true, validator.chain_has_transaction(noop_trace->id));
+      BOOST_CHECK_EQUAL(transaction_receipt::executed, validator.get_transaction_receipt(noop_trace->id).status);
+   }
+   BOOST_REQUIRE_EQUAL(validator.control->head_block_id(), producer.control->head_block_id());
+} FC_LOG_AND_RETHROW() /// wasm_tiered_compile_concurrent
+
 /**
  * Prove the modifications to global variables are wiped between runs
  */